@@ -911,11 +911,22 @@ struct PolygonOffset {
     float constant = 0;     // units in GL-speak
 };
 
+//! Counters of the graphics pipeline cache, on backends that have one (currently Vulkan).
+struct PipelineCacheStats {
+    uint32_t pipelineCount = 0;     //!< pipelines currently in the cache
+    uint32_t hits = 0;              //!< draw calls that found their pipeline in the cache
+    uint32_t misses = 0;            //!< pipelines created, either to draw or to warm up
+    uint32_t evictions = 0;         //!< pipelines destroyed to keep the cache within budget
+    uint32_t descriptorSetCount = 0; //!< descriptor sets currently cached
+};
+
 
 using FrameScheduledCallback = void(*)(backend::PresentCallable callable, void* user);
 
 using FrameCompletedCallback = void(*)(void* user);
 
+using ProgramsCompiledCallback = void(*)(void* user);
+
 
 } // namespace backend
 } // namespace filament
@@ -23,6 +23,8 @@
 
 #include <utils/compiler.h>
 
+#include <stddef.h>
+
 namespace filament {
 namespace backend {
 
@@ -66,6 +68,60 @@ public:
      * thread, or if the platform does not need to perform any special processing.
      */
     virtual bool pumpEvents() noexcept { return false; }
+
+    /**
+     * Stores a blob in the application's persistent cache.
+     *
+     * @param key       key of the blob, the same key can be stored several times.
+     * @param keySize   size of the key in bytes.
+     * @param value     content of the blob.
+     * @param valueSize size of the content in bytes.
+     * @param user      user data given to setBlobFunc().
+     */
+    using InsertBlobFunc = void(*)(const void* key, size_t keySize,
+            const void* value, size_t valueSize, void* user);
+
+    /**
+     * Retrieves a blob from the application's persistent cache.
+     *
+     * @param key       key of the blob.
+     * @param keySize   size of the key in bytes.
+     * @param value     buffer that receives the content of the blob.
+     * @param valueSize size of the buffer in bytes.
+     * @param user      user data given to setBlobFunc().
+     *
+     * @return the size of the blob, or 0 if it isn't in the cache. If this is larger than
+     *         valueSize, \p value must be left untouched.
+     */
+    using RetrieveBlobFunc = size_t(*)(const void* key, size_t keySize,
+            void* value, size_t valueSize, void* user);
+
+    /**
+     * Sets the callbacks of a key/value cache that persists across runs, e.g. in a file. When set,
+     * backends use it to store compiled programs or pipelines, which speeds-up subsequent
+     * launches. This must be called before the Engine is created, and the callbacks can be
+     * called from the driver thread.
+     *
+     * @param insertBlob    callback storing a blob.
+     * @param retrieveBlob  callback retrieving a blob.
+     * @param user          user data passed to both callbacks.
+     */
+    void setBlobFunc(InsertBlobFunc insertBlob, RetrieveBlobFunc retrieveBlob,
+            void* user = nullptr) noexcept;
+
+    //! Whether the blob cache callbacks have been set.
+    bool hasBlobFunc() const noexcept;
+
+    //! Calls the InsertBlobFunc, if set.
+    void insertBlob(const void* key, size_t keySize, const void* value, size_t valueSize);
+
+    //! Calls the RetrieveBlobFunc, returns 0 if it isn't set.
+    size_t retrieveBlob(const void* key, size_t keySize, void* value, size_t valueSize);
+
+private:
+    InsertBlobFunc mInsertBlob = nullptr;
+    RetrieveBlobFunc mRetrieveBlob = nullptr;
+    void* mBlobUser = nullptr;
 };
 
 
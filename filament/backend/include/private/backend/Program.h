@@ -60,6 +60,10 @@ public:
     Program& diagnostics(utils::CString const& name, uint8_t variantKey = 0);
     Program& diagnostics(utils::CString&& name, uint8_t variantKey = 0) noexcept;
 
+    // identifies the program's sources for caching compiled programs across runs, the id must
+    // change whenever the sources or the layout of the program change. 0 disables caching.
+    Program& cacheId(uint64_t cacheId) noexcept;
+
     // sets one of the program's shader (e.g. vertex, fragment)
     Program& shader(Shader shader, void const* data, size_t size) noexcept;
 
@@ -97,6 +101,8 @@ public:
 
     uint8_t getVariant() const noexcept { return mVariant; }
 
+    uint64_t getCacheId() const noexcept { return mCacheId; }
+
     bool hasSamplers() const noexcept { return mHasSamplers; }
 
 private:
@@ -109,6 +115,7 @@ private:
     SamplerGroupInfo mSamplerGroups = {};
     std::array<std::vector<uint8_t>, SHADER_TYPE_COUNT> mShadersSource;
     utils::CString mName;
+    uint64_t mCacheId = 0;
     bool mHasSamplers = false;
     uint8_t mVariant;
 };
@@ -46,13 +46,18 @@ DriverBase::~DriverBase() noexcept {
 void DriverBase::purge() noexcept {
     std::vector<BufferDescriptor> buffersToPurge;
     std::vector<AcquiredImage> imagesToPurge;
+    std::vector<std::pair<void (*)(void*), void*>> callbacksToPurge;
     std::unique_lock<std::mutex> lock(mPurgeLock);
     std::swap(buffersToPurge, mBufferToPurge);
     std::swap(imagesToPurge, mImagesToPurge);
+    std::swap(callbacksToPurge, mCallbacksToPurge);
     lock.unlock(); // don't remove this, it ensures mBufferToPurge is destroyed without lock held
     for (auto& image : imagesToPurge) {
         image.callback(image.image, image.userData);
     }
+    for (auto& callback : callbacksToPurge) {
+        callback.first(callback.second);
+    }
     // When the BufferDescriptors go out of scope, their destructors invoke their callbacks.
 }
 
@@ -68,6 +73,11 @@ void DriverBase::scheduleRelease(AcquiredImage&& image) noexcept {
     mImagesToPurge.push_back(std::move(image));
 }
 
+void DriverBase::scheduleCallback(void (*callback)(void* user), void* user) noexcept {
+    std::lock_guard<std::mutex> lock(mPurgeLock);
+    mCallbacksToPurge.emplace_back(callback, user);
+}
+
 void DriverBase::debugCommandBegin(CommandStream* cmds, bool synchronous, const char* methodName) noexcept {
     if constexpr (bool(FILAMENT_DEBUG_COMMANDS > FILAMENT_DEBUG_COMMANDS_NONE)) {
         if constexpr (bool(FILAMENT_DEBUG_COMMANDS & FILAMENT_DEBUG_COMMANDS_LOG)) {
@@ -196,6 +196,9 @@ protected:
 
     void scheduleRelease(AcquiredImage&& image) noexcept;
 
+    // the callback is called on the user thread, at the next purge()
+    void scheduleCallback(void (*callback)(void* user), void* user) noexcept;
+
     void debugCommandBegin(CommandStream* cmds, bool synchronous, const char* methodName) noexcept override;
     void debugCommandEnd(CommandStream* cmds, bool synchronous, const char* methodName) noexcept override;
 
@@ -203,6 +206,7 @@ private:
     std::mutex mPurgeLock;
     std::vector<BufferDescriptor> mBufferToPurge;
     std::vector<AcquiredImage> mImagesToPurge;
+    std::vector<std::pair<void (*)(void*), void*>> mCallbacksToPurge;
 };
 
 
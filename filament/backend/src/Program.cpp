@@ -39,6 +39,11 @@ Program& Program::diagnostics(utils::CString&& name, uint8_t variant) noexcept {
     return *this;
 }
 
+Program& Program::cacheId(uint64_t cacheId) noexcept {
+    mCacheId = cacheId;
+    return *this;
+}
+
 Program& Program::shader(Program::Shader shader, void const* data, size_t size) noexcept {
     std::vector<uint8_t> blob(size);
     std::copy_n((const uint8_t *)data, size, blob.data());
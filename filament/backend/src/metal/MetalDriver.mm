@@ -666,6 +666,10 @@ bool MetalDriver::isFrameBufferFetchSupported() {
 #endif
 }
 
+PipelineCacheStats MetalDriver::getPipelineCacheStats() {
+    return {};
+}
+
 bool MetalDriver::isFrameTimeSupported() {
     // Frame time is calculated via hard fences, which are only available on iOS 12 and above.
     if (@available(macOS 10.14, iOS 12, *)) {
@@ -717,6 +721,12 @@ void MetalDriver::update2DImage(Handle<HwTexture> th, uint32_t level, uint32_t x
 }
 
 void MetalDriver::setMinMaxLevels(Handle<HwTexture> th, uint32_t minLevel, uint32_t maxLevel) {
+    // The range is applied as a LOD clamp on the sampler state in bindSamplers(), so it takes
+    // effect with the next draw. Uploading a level outside of it widens it again.
+    auto tex = handle_cast<MetalTexture>(mHandleMap, th);
+    const uint32_t lastLevel = uint32_t(tex->texture.mipmapLevelCount - 1);
+    tex->minLod = std::min(minLevel, lastLevel);
+    tex->maxLod = std::min(std::max(maxLevel, tex->minLod), lastLevel);
 }
 
 void MetalDriver::update3DImage(Handle<HwTexture> th, uint32_t level,
@@ -809,6 +819,13 @@ void MetalDriver::loadUniformBuffer(Handle<HwUniformBuffer> ubh,
     scheduleDestroy(std::move(data));
 }
 
+void MetalDriver::compilePrograms(backend::ProgramsCompiledCallback callback, void* user) {
+    // libraries are compiled synchronously by createProgram, there is nothing to wait for
+    if (callback) {
+        scheduleCallback(callback, user);
+    }
+}
+
 void MetalDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
         SamplerGroup&& samplerGroup) {
     auto sb = handle_cast<MetalSamplerGroup>(mHandleMap, sbh);
@@ -925,6 +942,9 @@ void MetalDriver::bindSamplers(size_t index, Handle<HwSamplerGroup> sbh) {
     mContext->samplerBindings[index] = sb;
 }
 
+void MetalDriver::setAsyncProgramCompilation(bool enabled) {
+}
+
 void MetalDriver::insertEventMarker(const char* string, size_t len) {
 
 }
@@ -1151,6 +1171,9 @@ void MetalDriver::blit(TargetBufferFlags buffers,
     mContext->blitter->blit(getPendingCommandBuffer(mContext), args);
 }
 
+void MetalDriver::warmUpPipeline(backend::PipelineState ps, Handle<HwRenderPrimitive> rph) {
+}
+
 void MetalDriver::draw(backend::PipelineState ps, Handle<HwRenderPrimitive> rph) {
     ASSERT_PRECONDITION(mContext->currentRenderPassEncoder != nullptr,
             "Attempted to draw without a valid command encoder.");
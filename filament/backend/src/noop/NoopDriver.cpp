@@ -167,6 +167,11 @@ bool NoopDriver::isFrameTimeSupported() {
     return true;
 }
 
+PipelineCacheStats NoopDriver::getPipelineCacheStats() {
+    const uint32_t count = mWarmedUpPipelineCount;
+    return { .pipelineCount = count, .misses = count };
+}
+
 math::float2 NoopDriver::getClipSpaceParams() {
     return math::float2{ -1.0f, 0.0f };
 }
@@ -243,6 +248,12 @@ void NoopDriver::loadUniformBuffer(Handle<HwUniformBuffer> ubh, BufferDescriptor
     scheduleDestroy(std::move(data));
 }
 
+void NoopDriver::compilePrograms(backend::ProgramsCompiledCallback callback, void* user) {
+    if (callback) {
+        scheduleCallback(callback, user);
+    }
+}
+
 void NoopDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
         SamplerGroup&& samplerGroup) {
 }
@@ -281,6 +292,9 @@ void NoopDriver::bindUniformBufferRange(size_t index, Handle<HwUniformBuffer> ub
 void NoopDriver::bindSamplers(size_t index, Handle<HwSamplerGroup> sbh) {
 }
 
+void NoopDriver::setAsyncProgramCompilation(bool enabled) {
+}
+
 void NoopDriver::insertEventMarker(char const* string, size_t len) {
 }
 
@@ -313,6 +327,10 @@ void NoopDriver::blit(TargetBufferFlags buffers,
         SamplerMagFilter filter) {
 }
 
+void NoopDriver::warmUpPipeline(PipelineState pipelineState, Handle<HwRenderPrimitive> rph) {
+    mWarmedUpPipelineCount++;
+}
+
 void NoopDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> rph) {
 }
 
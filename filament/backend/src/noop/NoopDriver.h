@@ -22,6 +22,8 @@
 
 #include <utils/compiler.h>
 
+#include <atomic>
+
 namespace filament {
 
 class NoopDriver final : public backend::DriverBase {
@@ -53,6 +55,10 @@ private:
     UTILS_ALWAYS_INLINE void methodName##R(RetType, paramsDecl) { }
 
 #include "private/backend/DriverAPI.inc"
+
+    // Pipelines are never created, but warm-up requests are counted as if they were, so that
+    // the engine's warm-up path can be tested without a GPU.
+    std::atomic<uint32_t> mWarmedUpPipelineCount{ 0 };
 };
 
 } // namespace filament
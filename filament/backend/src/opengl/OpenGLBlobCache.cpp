@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OpenGLBlobCache.h"
+
+#include "GLUtils.h"
+
+#include <backend/Platform.h>
+
+#include "private/backend/Program.h"
+
+#include <utils/Hash.h>
+#include <utils/Log.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+using namespace utils;
+
+namespace filament {
+
+using namespace backend;
+
+struct BlobHeader {
+    GLenum format;
+    uint32_t size;
+};
+
+OpenGLBlobCache::OpenGLBlobCache() noexcept {
+#if !defined(__EMSCRIPTEN__)
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    mSupported = formatCount > 0;
+    CHECK_GL_ERROR(utils::slog.e)
+#endif
+    if (!mSupported) {
+        return;
+    }
+
+    // Binaries can only be loaded by the driver that produced them, so the key must identify it.
+    std::string identity;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* const string = (const char*)glGetString(name);
+        identity.append(string ? string : "").append("\n");
+    }
+    std::vector<uint32_t> words((identity.size() + 3) / 4, 0);
+    memcpy(words.data(), identity.data(), identity.size());
+    mDriverId = hash::murmur3(words.data(), words.size(), 0);
+}
+
+bool OpenGLBlobCache::isCacheable(Platform& platform, Program const& program) const noexcept {
+    return mSupported && program.getCacheId() && platform.hasBlobFunc();
+}
+
+OpenGLBlobCache::Key OpenGLBlobCache::getKey(Program const& program) const noexcept {
+    Key key{};
+    key.cacheId = program.getCacheId();
+    key.driverId = mDriverId;
+    key.variant = program.getVariant();
+    return key;
+}
+
+GLuint OpenGLBlobCache::retrieve(Platform& platform, Program const& program) const noexcept {
+    if (!isCacheable(platform, program)) {
+        return 0;
+    }
+
+    const Key key = getKey(program);
+    const size_t size = platform.retrieveBlob(&key, sizeof(key), nullptr, 0);
+    if (size <= sizeof(BlobHeader)) {
+        return 0;
+    }
+
+    std::unique_ptr<uint8_t[]> blob(new uint8_t[size]);
+    if (platform.retrieveBlob(&key, sizeof(key), blob.get(), size) != size) {
+        return 0;
+    }
+
+    BlobHeader header;
+    memcpy(&header, blob.get(), sizeof(header));
+    if (header.size != size - sizeof(header)) {
+        return 0;
+    }
+
+    GLuint glProgram = glCreateProgram();
+    glProgramBinary(glProgram, header.format, blob.get() + sizeof(header), GLsizei(header.size));
+
+    // The binary is rejected if the driver changed since it was produced, in which case the
+    // program is simply compiled from the sources again.
+    GLint status = GL_FALSE;
+    glGetProgramiv(glProgram, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(glProgram);
+        glProgram = 0;
+    }
+    CHECK_GL_ERROR(utils::slog.e)
+    return glProgram;
+}
+
+void OpenGLBlobCache::insert(Platform& platform, Program const& program,
+        GLuint glProgram) const noexcept {
+    if (!isCacheable(platform, program)) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(glProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    const size_t size = sizeof(BlobHeader) + size_t(length);
+    std::unique_ptr<uint8_t[]> blob(new uint8_t[size]);
+    BlobHeader header{};
+    glGetProgramBinary(glProgram, length, &length, &header.format,
+            blob.get() + sizeof(header));
+    CHECK_GL_ERROR(utils::slog.e)
+    header.size = uint32_t(length);
+    memcpy(blob.get(), &header, sizeof(header));
+
+    const Key key = getKey(program);
+    platform.insertBlob(&key, sizeof(key), blob.get(), sizeof(header) + size_t(length));
+}
+
+} // namespace filament
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DRIVER_OPENGLBLOBCACHE_H
+#define TNT_FILAMENT_DRIVER_OPENGLBLOBCACHE_H
+
+#include "gl_headers.h"
+
+#include <stdint.h>
+
+namespace filament {
+
+namespace backend {
+class Platform;
+class Program;
+}
+
+/*
+ * Stores linked program binaries in the Platform's blob cache, so that programs don't need to be
+ * compiled again on subsequent runs. Entries are keyed by the program's cache id and variant,
+ * and by the identity of the GL driver, since binaries are only valid for the driver that
+ * produced them.
+ */
+class OpenGLBlobCache {
+public:
+    OpenGLBlobCache() noexcept;
+
+    // Returns a linked program created from a cached binary, or 0 if there is none.
+    GLuint retrieve(backend::Platform& platform, backend::Program const& program) const noexcept;
+
+    // Stores the binary of a successfully linked program.
+    void insert(backend::Platform& platform, backend::Program const& program,
+            GLuint glProgram) const noexcept;
+
+    // Whether the given program can go through the cache. When true, the program must be linked
+    // with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    bool isCacheable(backend::Platform& platform,
+            backend::Program const& program) const noexcept;
+
+private:
+    struct Key {
+        uint64_t cacheId;
+        uint32_t driverId;
+        uint8_t variant;
+        uint8_t padding[3];
+    };
+
+    Key getKey(backend::Program const& program) const noexcept;
+
+    uint32_t mDriverId = 0;
+    bool mSupported = false;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DRIVER_OPENGLBLOBCACHE_H
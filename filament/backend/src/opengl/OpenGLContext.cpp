@@ -259,6 +259,7 @@ void OpenGLContext::initExtensionsGLES(GLint major, GLint minor, ExtentionSet co
     ext.EXT_texture_filter_anisotropic = hasExtension(exts, "GL_EXT_texture_filter_anisotropic");
     ext.GOOGLE_cpp_style_line_directive = hasExtension(exts, "GL_GOOGLE_cpp_style_line_directive");
     ext.KHR_debug = hasExtension(exts, "GL_KHR_debug");
+    ext.KHR_parallel_shader_compile = hasExtension(exts, "GL_KHR_parallel_shader_compile");
     ext.OES_EGL_image_external_essl3 = hasExtension(exts, "GL_OES_EGL_image_external_essl3");
     ext.QCOM_tiled_rendering = hasExtension(exts, "GL_QCOM_tiled_rendering");
     ext.WEBGL_texture_compression_s3tc = hasExtension(exts, "WEBGL_compressed_texture_s3tc");
@@ -280,6 +281,8 @@ void OpenGLContext::initExtensionsGL(GLint major, GLint minor, ExtentionSet cons
     ext.EXT_texture_sRGB = hasExtension(exts, "GL_EXT_texture_sRGB");
     ext.GOOGLE_cpp_style_line_directive = hasExtension(exts, "GL_GOOGLE_cpp_style_line_directive");
     ext.KHR_debug = major >= 4 && minor >= 3;
+    ext.KHR_parallel_shader_compile = hasExtension(exts, "GL_KHR_parallel_shader_compile") ||
+            hasExtension(exts, "GL_ARB_parallel_shader_compile");
     ext.OES_EGL_image_external_essl3 = hasExtension(exts, "GL_OES_EGL_image_external_essl3");
     ext.WEBGL_texture_compression_s3tc = hasExtension(exts, "GL_EXT_texture_compression_s3tc");
 }
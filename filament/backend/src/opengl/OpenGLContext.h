@@ -141,6 +141,7 @@ public:
         bool EXT_multisampled_render_to_texture = false;
         bool EXT_multisampled_render_to_texture2 = false;
         bool KHR_debug = false;
+        bool KHR_parallel_shader_compile = false;
         bool EXT_texture_sRGB = false;
         bool EXT_texture_compression_s3tc_srgb = false;
         bool EXT_disjoint_timer_query = false;
@@ -31,6 +31,8 @@
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
 #endif
@@ -221,11 +223,22 @@ void OpenGLDriver::bindTexture(GLuint unit, GLTexture const* t) noexcept {
 }
 
 void OpenGLDriver::useProgram(OpenGLProgram* p) noexcept {
+    if (UTILS_UNLIKELY(!p->isInitialized())) {
+        initializeProgram(p);
+    }
     mContext.useProgram(p->gl.program);
     // set-up textures and samplers in the proper TMUs (as specified in setSamplers)
     p->use(this);
 }
 
+void OpenGLDriver::initializeProgram(OpenGLProgram* p) noexcept {
+    p->initialize(this);
+    auto& v = mPendingPrograms;
+    v.erase(std::remove_if(v.begin(), v.end(), [p](auto const& item) {
+        return item.second == p;
+    }), v.end());
+}
+
 
 void OpenGLDriver::setRasterStateSlow(RasterState rs) noexcept {
     mRasterState = rs;
@@ -539,7 +552,10 @@ void OpenGLDriver::createRenderPrimitiveR(Handle<HwRenderPrimitive> rph, int) {
 void OpenGLDriver::createProgramR(Handle<HwProgram> ph, Program&& program) {
     DEBUG_MARKER()
 
-    construct<OpenGLProgram>(ph, this, program);
+    OpenGLProgram* p = construct<OpenGLProgram>(ph, this, std::move(program));
+    // the compile and link status are only checked when the program is first needed, so that
+    // the driver can compile in the background in the meantime.
+    mPendingPrograms.emplace_back(++mProgramSerial, p);
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -1322,6 +1338,12 @@ void OpenGLDriver::destroyProgram(Handle<HwProgram> ph) {
     DEBUG_MARKER()
     if (ph) {
         OpenGLProgram* p = handle_cast<OpenGLProgram*>(ph);
+        if (!p->isInitialized()) {
+            auto& v = mPendingPrograms;
+            v.erase(std::remove_if(v.begin(), v.end(), [p](auto const& item) {
+                return item.second == p;
+            }), v.end());
+        }
         destruct(ph, p);
     }
 }
@@ -1678,6 +1700,10 @@ bool OpenGLDriver::isFrameTimeSupported() {
     return mFrameTimeSupported;
 }
 
+PipelineCacheStats OpenGLDriver::getPipelineCacheStats() {
+    return {};
+}
+
 math::float2 OpenGLDriver::getClipSpaceParams() {
     return mContext.ext.EXT_clip_control ?
             math::float2{ -0.5f, 0.5f } : math::float2{ -1.0f, 0.0f };
@@ -1780,6 +1806,30 @@ void OpenGLDriver::loadUniformBuffer(Handle<HwUniformBuffer> ubh, BufferDescript
     scheduleDestroy(std::move(p));
 }
 
+void OpenGLDriver::compilePrograms(ProgramsCompiledCallback callback, void* user) {
+    DEBUG_MARKER()
+
+    // Wait for all the programs created so far, programs created later are not our concern.
+    const uint32_t serial = mProgramSerial;
+    runEveryNowAndThen([this, serial, callback, user]() -> bool {
+        bool done = true;
+        auto pending = mPendingPrograms;
+        for (auto const& item : pending) {
+            if (item.first <= serial) {
+                if (item.second->isReady(mContext)) {
+                    initializeProgram(item.second);
+                } else {
+                    done = false;
+                }
+            }
+        }
+        if (done && callback) {
+            scheduleCallback(callback, user);
+        }
+        return done;
+    });
+}
+
 void OpenGLDriver::updateBuffer(GLenum target,
         GLBuffer* buffer, BufferDescriptor const& p, uint32_t alignment) noexcept {
     assert_invariant(buffer->capacity >= p.size);
@@ -2791,6 +2841,11 @@ void OpenGLDriver::bindSamplers(size_t index, Handle<HwSamplerGroup> sbh) {
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+void OpenGLDriver::setAsyncProgramCompilation(bool enabled) {
+    DEBUG_MARKER()
+    mAsyncProgramCompilation = enabled;
+}
+
 
 GLuint OpenGLDriver::getSamplerSlow(SamplerParams params) const noexcept {
     assert_invariant(mSamplerMap.find(params.u) == mSamplerMap.end());
@@ -3183,12 +3238,24 @@ void OpenGLDriver::updateTextureLodRange(GLTexture* texture, int8_t targetLevel)
     }
 }
 
+void OpenGLDriver::warmUpPipeline(PipelineState state, Handle<HwRenderPrimitive> rph) {
+}
+
 void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph) {
     DEBUG_MARKER()
     auto& gl = mContext;
 
     OpenGLProgram* p = handle_cast<OpenGLProgram*>(state.program);
 
+    // With asynchronous compilation, skip the draw rather than stalling on a program the
+    // driver is still compiling in the background.
+    if (UTILS_UNLIKELY(!p->isInitialized())) {
+        if (mAsyncProgramCompilation && !p->isReady(mContext)) {
+            return;
+        }
+        initializeProgram(p);
+    }
+
     // If the material debugger is enabled, avoid fatal (or cascading) errors and that can occur
     // during the draw call when the program is invalid. The shader compile error has already been
     // dumped to the console at this point, so it's fine to simply return early.
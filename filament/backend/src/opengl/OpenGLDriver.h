@@ -19,6 +19,7 @@
 
 #include "private/backend/Driver.h"
 #include "DriverBase.h"
+#include "OpenGLBlobCache.h"
 #include "OpenGLContext.h"
 
 #include <utils/compiler.h>
@@ -219,6 +220,7 @@ public:
 
 private:
     OpenGLContext mContext;
+    OpenGLBlobCache mBlobCache;
 
     OpenGLContext& getContext() noexcept { return mContext; }
 
@@ -359,6 +361,7 @@ private:
            void bindTexture(GLuint unit, GLTexture const* t) noexcept;
            void bindSampler(GLuint unit, backend::SamplerParams params) noexcept;
     inline void useProgram(OpenGLProgram* p) noexcept;
+    void initializeProgram(OpenGLProgram* p) noexcept;
 
     enum class ResolveAction { LOAD, STORE };
     void resolvePass(ResolveAction action, GLRenderTarget const* rt,
@@ -428,6 +431,11 @@ private:
     void executeEveryNowAndThenOps() noexcept;
     std::vector<std::function<bool()>> mEveryNowAndThenOps;
 
+    // programs whose compile and link status haven't been checked yet, with their creation serial
+    std::vector<std::pair<uint32_t, OpenGLProgram*>> mPendingPrograms;
+    uint32_t mProgramSerial = 0;
+    bool mAsyncProgramCompilation = false;
+
     // timer query implementation
     TimerQueryInterface* mTimerQueryImpl = nullptr;
     bool mFrameTimeSupported = false;
@@ -24,6 +24,7 @@
 #include <utils/debug.h>
 
 #include <private/backend/BackendUtils.h>
+#include <private/backend/OpenGLPlatform.h>
 
 #include <ctype.h>
 
@@ -33,14 +34,24 @@ using namespace filament::math;
 using namespace utils;
 using namespace backend;
 
-OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) noexcept
+OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, Program&& programBuilder) noexcept
         :  HwProgram(programBuilder.getName()), mIsValid(false) {
 
     using Shader = Program::Shader;
 
+    // try the binary cache first, there is nothing to compile if the program is in it
+    GLuint cachedProgram = gl->mBlobCache.retrieve(gl->mPlatform, programBuilder);
+    if (cachedProgram) {
+        this->gl.program = cachedProgram;
+        mIsCached = true;
+        mPendingBuilder = std::make_unique<Program>(std::move(programBuilder));
+        return;
+    }
+
     const auto& shadersSource = programBuilder.getShadersSource();
 
-    // build all shaders
+    // build all shaders, we don't check the results here because that would wait for the
+    // compiler, see initialize().
     #pragma nounroll
     for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
         GLenum glShaderType;
@@ -55,7 +66,6 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
         }
 
         if (!shadersSource[i].empty()) {
-            GLint status;
             auto shader = shadersSource[i];
             GLint const length = (GLint)shader.size();
 
@@ -75,13 +85,6 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
             glShaderSource(shaderId, 1, &source, &length);
             glCompileShader(shaderId);
 
-            glGetShaderiv(shaderId, GL_COMPILE_STATUS, &status);
-            if (UTILS_UNLIKELY(status != GL_TRUE)) {
-                logCompilationError(slog.e, type,
-                        programBuilder.getName().c_str_safe(), shaderId, source);
-                glDeleteShader(shaderId);
-                return;
-            }
             this->gl.shaders[i] = shaderId;
             mValidShaderSet |= 1U << i;
         }
@@ -90,25 +93,78 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
     // we need at least a vertex and fragment program
     const uint8_t validShaderSet = mValidShaderSet;
     const uint8_t mask = VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT;
-    if (UTILS_LIKELY((mValidShaderSet & mask) == mask)) {
-        GLint status;
+    if (UTILS_LIKELY((validShaderSet & mask) == mask)) {
         GLuint program = glCreateProgram();
         for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
             if (validShaderSet & (1U << i)) {
                 glAttachShader(program, this->gl.shaders[i]);
             }
         }
+        if (gl->mBlobCache.isCacheable(gl->mPlatform, programBuilder)) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
         glLinkProgram(program);
+        this->gl.program = program;
+    }
+
+    mPendingBuilder = std::make_unique<Program>(std::move(programBuilder));
+}
+
+bool OpenGLProgram::isReady(OpenGLContext& context) const noexcept {
+    if (!mPendingBuilder || !context.ext.KHR_parallel_shader_compile || !gl.program) {
+        return true;
+    }
+    // this doesn't block, unlike GL_LINK_STATUS
+    GLint status = GL_FALSE;
+    glGetProgramiv(gl.program, GL_COMPLETION_STATUS_KHR, &status);
+    return status == GL_TRUE;
+}
+
+void OpenGLProgram::initialize(OpenGLDriver* gl) noexcept {
+    assert_invariant(mPendingBuilder);
+    std::unique_ptr<Program> builder(std::move(mPendingBuilder));
+    Program const& programBuilder = *builder;
+
+    using Shader = Program::Shader;
+
+    const auto& shadersSource = programBuilder.getShadersSource();
+
+    #pragma nounroll
+    for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
+        if (mValidShaderSet & (1U << i)) {
+            GLint status;
+            const GLuint shaderId = this->gl.shaders[i];
+            glGetShaderiv(shaderId, GL_COMPILE_STATUS, &status);
+            if (UTILS_UNLIKELY(status != GL_TRUE)) {
+                logCompilationError(slog.e, (Shader)i, programBuilder.getName().c_str_safe(),
+                        shaderId, (const char*)shadersSource[i].data());
+                if (this->gl.program) {
+                    glDetachShader(this->gl.program, shaderId);
+                }
+                glDeleteShader(shaderId);
+                mValidShaderSet &= ~(1U << i);
+            }
+        }
+    }
 
+    const uint8_t mask = VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT;
+    GLuint program = this->gl.program;
+    if (mIsCached) {
+        // programs from the cache are known to be linked already
+    } else if (UTILS_LIKELY(program && (mValidShaderSet & mask) == mask)) {
+        GLint status;
         glGetProgramiv(program, GL_LINK_STATUS, &status);
         if (UTILS_UNLIKELY(status != GL_TRUE)) {
             logProgramLinkError(slog.e, programBuilder.getName().c_str_safe(), program);
-            glDeleteProgram(program);
-            return;
+            program = 0;
+        } else {
+            gl->mBlobCache.insert(gl->mPlatform, programBuilder, program);
         }
+    } else {
+        program = 0;
+    }
 
-        this->gl.program = program;
-
+    if (UTILS_LIKELY(program)) {
         // Associate each UniformBlock in the program to a known binding.
         auto const& uniformBlockInfo = programBuilder.getUniformBlockInfo();
         #pragma nounroll
@@ -163,11 +219,21 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
             mUsedBindingsCount = numUsedBindings;
         }
         mIsValid = true;
+    } else if (this->gl.program) {
+        // the shaders are deleted with this object
+        const GLuint invalidProgram = this->gl.program;
+        for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
+            if (mValidShaderSet & (1U << i)) {
+                glDetachShader(invalidProgram, this->gl.shaders[i]);
+            }
+        }
+        glDeleteProgram(invalidProgram);
+        this->gl.program = 0;
     }
 
     // Failing to compile a program can't be fatal, because this will happen a lot in
     // the material tools. We need to have a better way to handle these errors and
-    // return to the editor. Also note the early "return" statements in this function.
+    // return to the editor.
     if (UTILS_UNLIKELY(!isValid())) {
         PANIC_LOG("Failed to compile GLSL program.");
     }
@@ -175,21 +241,20 @@ OpenGLProgram::OpenGLProgram(OpenGLDriver* gl, const Program& programBuilder) no
 
 OpenGLProgram::~OpenGLProgram() noexcept {
     const size_t validShaderSet = mValidShaderSet;
-    const bool isValid = mIsValid;
     GLuint program = gl.program;
     if (validShaderSet) {
         #pragma nounroll
         for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
             if (validShaderSet & (1U << i)) {
                 const GLuint shader = gl.shaders[i];
-                if (isValid) {
+                if (program) {
                     glDetachShader(program, shader);
                 }
                 glDeleteShader(shader);
             }
         }
     }
-    if (isValid) {
+    if (program) {
         glDeleteProgram(program);
     }
 }
@@ -26,6 +26,7 @@
 #include <utils/compiler.h>
 #include <utils/Log.h>
 
+#include <memory>
 #include <vector>
 
 #include <stddef.h>
@@ -38,9 +39,19 @@ class OpenGLProgram : public backend::HwProgram {
 public:
 
     OpenGLProgram() noexcept = default;
-    OpenGLProgram(OpenGLDriver* gl, const backend::Program& builder) noexcept;
+    OpenGLProgram(OpenGLDriver* gl, backend::Program&& builder) noexcept;
     ~OpenGLProgram() noexcept;
 
+    // The shaders are compiled and linked when the program is created, but the results are only
+    // checked by initialize(), because querying them waits for the compiler to finish.
+    bool isInitialized() const noexcept { return !mPendingBuilder; }
+    void initialize(OpenGLDriver* gl) noexcept;
+
+    // Whether initialize() can be called without waiting for the compiler. This can only be known
+    // with KHR_parallel_shader_compile, without it this always returns true.
+    bool isReady(OpenGLContext& context) const noexcept;
+
+    // only meaningful once the program is initialized
     bool isValid() const noexcept { return mIsValid; }
 
     void use(OpenGLDriver* const gl) noexcept {
@@ -64,7 +75,7 @@ public:
     struct {
         GLuint shaders[backend::Program::SHADER_TYPE_COUNT];
         GLuint program;
-    } gl; // 12 bytes
+    } gl = {}; // 12 bytes
 
     static void logCompilationError(utils::io::ostream& out,
             backend::Program::Shader shaderType, const char* name,
@@ -93,6 +104,7 @@ private:
     uint8_t mUsedBindingsCount = 0;
     uint8_t mValidShaderSet = 0;
     bool mIsValid = false;
+    bool mIsCached = false;     // linked from a binary in the blob cache, there are no shaders
 
     // information about each USED sampler buffer (no gaps)
     std::array<BlockInfo, backend::Program::BINDING_COUNT> mBlockInfos;   // 8 bytes
@@ -100,6 +112,10 @@ private:
     // runs of indices into SamplerGroup -- run start index and size given by BlockInfo
     std::array<uint8_t, TEXTURE_UNIT_COUNT> mIndicesRuns;    // 16 bytes
 
+    // the uniform blocks and samplers are only bound by initialize(), until then we hold on to
+    // the description of the program (which also provides the sources for error reporting).
+    std::unique_ptr<backend::Program> mPendingBuilder;       // 8 bytes
+
     void updateSamplers(OpenGLDriver* gld) noexcept;
 };
 
@@ -48,9 +48,13 @@ constexpr static const int VK_REQUIRED_VERSION_MINOR = 0;
 // We choose a capacity of 3 because this matches the needs of triple-buffering.
 constexpr static const int VK_MAX_COMMAND_BUFFERS = 3;
 
-// Maximum number of command buffer flush events that can occur before an unused pipeline is removed
-// from the cache. If this number is low, VkPipeline construction will occur frequently, which can
-// be extremely slow. If this number is high, the memory footprint will be large.
-constexpr static const int VK_MAX_PIPELINE_AGE = 5;
+// Maximum number of pipelines kept in the cache, the least recently used ones are destroyed first.
+// If this number is low, VkPipeline construction will occur frequently, which can be extremely
+// slow. If this number is high, the memory footprint will be large.
+constexpr static const uint32_t VK_MAX_PIPELINE_COUNT = 512;
+
+// Maximum number of descriptor set bundles kept in the cache when they are not in use. Keeping
+// them around avoids rewriting descriptor sets every frame.
+constexpr static const uint32_t VK_MAX_DESCRIPTOR_BUNDLE_COUNT = 1024;
 
 #endif
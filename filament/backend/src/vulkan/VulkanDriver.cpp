@@ -85,6 +85,28 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugUtilsCallback(VkDebugUtilsMessageSeverityFla
 namespace filament {
 namespace backend {
 
+// Identifies the device in the platform's blob cache. The driver validates the header of the
+// cache data as well, but this avoids handing it data from another GPU in the first place.
+struct PipelineCacheKey {
+    char tag[8];
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+static PipelineCacheKey getPipelineCacheKey(VulkanContext const& context) noexcept {
+    VkPhysicalDeviceProperties const& props = context.physicalDeviceProperties;
+    PipelineCacheKey key = {
+        .tag = { 'F', 'V', 'K', 'P', 'C', 'A', 'C', 'H' },
+        .vendorID = props.vendorID,
+        .deviceID = props.deviceID,
+        .driverVersion = props.driverVersion
+    };
+    memcpy(key.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+    return key;
+}
+
 Driver* VulkanDriverFactory::create(VulkanPlatform* const platform,
         const char* const* ppEnabledExtensions, uint32_t enabledExtensionCount) noexcept {
     return VulkanDriver::create(platform, ppEnabledExtensions, enabledExtensionCount);
@@ -210,6 +232,19 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
     mPipelineCache.setDevice(mContext.device);
     mPipelineCache.setDummyTexture(mContext.emptyTexture->getPrimaryImageView());
 
+    // Seed the pipeline cache with the pipelines from the previous run, if the application gave
+    // us a place to keep them.
+    std::vector<uint8_t> pipelineCacheData;
+    if (mContextManager.hasBlobFunc()) {
+        const PipelineCacheKey key = getPipelineCacheKey(mContext);
+        pipelineCacheData.resize(mContextManager.retrieveBlob(&key, sizeof(key), nullptr, 0));
+        if (!pipelineCacheData.empty()) {
+            mContextManager.retrieveBlob(&key, sizeof(key),
+                    pipelineCacheData.data(), pipelineCacheData.size());
+        }
+    }
+    mPipelineCache.createPipelineCache(pipelineCacheData.data(), pipelineCacheData.size());
+
     // Choose a depth format that meets our requirements. Take care not to include stencil formats
     // just yet, since that would require a corollary change to the "aspect" flags for the VkImage.
     mContext.finalDepthFormat = findSupportedFormat(mContext,
@@ -269,6 +304,17 @@ void VulkanDriver::terminate() {
     mDisposer.reset();
 
     mStagePool.reset();
+#ifndef NDEBUG
+    const VulkanPipelineCache::Stats stats = mPipelineCache.getStats();
+    utils::slog.i << "Vulkan pipelines: " << stats.pipelineCount
+            << " cached, " << stats.pipelineHits << " hits, " << stats.pipelineMisses
+            << " misses, " << stats.pipelineEvictions << " evictions" << utils::io::endl;
+    utils::slog.i << "Vulkan descriptor sets: " << stats.descriptorBundleCount
+            << " cached, " << stats.descriptorHits << " hits, " << stats.descriptorMisses
+            << " misses, " << stats.descriptorEvictions << " evictions, pool size "
+            << stats.descriptorPoolSize << utils::io::endl;
+#endif
+    savePipelineCache();
     mPipelineCache.destroyCache();
     mFramebufferCache.reset();
     mSamplerCache.reset();
@@ -288,6 +334,29 @@ void VulkanDriver::terminate() {
     mContext.instance = nullptr;
 }
 
+// Persists the VkPipelineCache if pipelines were created since it was last saved. This doesn't only
+// happen at shutdown, since mobile applications are often killed without terminating the engine.
+void VulkanDriver::savePipelineCache() {
+    mFramesSincePipelineCacheSave = 0;
+    const uint32_t pipelineCount = mPipelineCache.getPipelineCreationCount();
+    if (!mContextManager.hasBlobFunc() || pipelineCount == mSavedPipelineCount) {
+        return;
+    }
+    mSavedPipelineCount = pipelineCount;
+    std::vector<uint8_t> pipelineCacheData = mPipelineCache.getPipelineCacheData();
+    if (!pipelineCacheData.empty()) {
+        const PipelineCacheKey key = getPipelineCacheKey(mContext);
+        mContextManager.insertBlob(&key, sizeof(key),
+                pipelineCacheData.data(), pipelineCacheData.size());
+    }
+}
+
+void VulkanDriver::updatePipelineCacheStats() {
+    const PipelineCacheStats stats = mPipelineCache.getPipelineCacheStats();
+    std::lock_guard<std::mutex> lock(mPipelineCacheStatsLock);
+    mPipelineCacheStats = stats;
+}
+
 void VulkanDriver::tick(int) {
     mContext.commands->updateFences();
 }
@@ -324,6 +393,13 @@ void VulkanDriver::endFrame(uint32_t frameId) {
     if (mContext.commands->flush()) {
         collectGarbage();
     }
+    updatePipelineCacheStats();
+
+    // Saving the pipeline cache can be slow, so it's done at most every few seconds.
+    static constexpr uint32_t PIPELINE_CACHE_SAVE_INTERVAL = 300; // frames
+    if (++mFramesSincePipelineCacheSave >= PIPELINE_CACHE_SAVE_INTERVAL) {
+        savePipelineCache();
+    }
 }
 
 void VulkanDriver::flush(int) {
@@ -332,6 +408,10 @@ void VulkanDriver::flush(int) {
 
 void VulkanDriver::finish(int dummy) {
     mContext.commands->flush();
+    updatePipelineCacheStats();
+    // Engine::flushAndWait() ends up here, which gives applications a way to persist the
+    // pipelines created so far, e.g. after warming them up behind a loading screen.
+    savePipelineCache();
 }
 
 void VulkanDriver::createSamplerGroupR(Handle<HwSamplerGroup> sbh, size_t count) {
@@ -453,7 +533,11 @@ void VulkanDriver::importTextureR(Handle<HwTexture> th, intptr_t id,
 void VulkanDriver::destroyTexture(Handle<HwTexture> th) {
     if (th) {
         auto texture = handle_cast<VulkanTexture>(mHandleMap, th);
-        mPipelineCache.unbindImageView(texture->getPrimaryImageView());
+        // Descriptor bundles outlive their last use, and Vulkan may reuse the handle of any view
+        // the texture created, not only the current primary one.
+        texture->forEachImageView([this](VkImageView imageView) {
+            mPipelineCache.unbindImageView(imageView);
+        });
         mDisposer.removeReference(texture);
     }
 }
@@ -772,6 +856,12 @@ bool VulkanDriver::isFrameTimeSupported() {
     return true;
 }
 
+PipelineCacheStats VulkanDriver::getPipelineCacheStats() {
+    // This is called from the main thread, so it returns the counters as of the last frame.
+    std::lock_guard<std::mutex> lock(mPipelineCacheStatsLock);
+    return mPipelineCacheStats;
+}
+
 math::float2 VulkanDriver::getClipSpaceParams() {
     // z-coordinate of clip-space is in [0,w]
     return math::float2{ -0.5f, 0.5f };
@@ -921,6 +1011,13 @@ void VulkanDriver::loadUniformBuffer(Handle<HwUniformBuffer> ubh, BufferDescript
     }
 }
 
+void VulkanDriver::compilePrograms(backend::ProgramsCompiledCallback callback, void* user) {
+    // shader modules are created synchronously by createProgram, there is nothing to wait for
+    if (callback) {
+        scheduleCallback(callback, user);
+    }
+}
+
 void VulkanDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
         SamplerGroup&& samplerGroup) {
     auto* sb = handle_cast<VulkanSamplerGroup>(mHandleMap, sbh);
@@ -1261,6 +1358,9 @@ void VulkanDriver::bindSamplers(size_t index, Handle<HwSamplerGroup> sbh) {
     mSamplerBindings[index] = hwsb;
 }
 
+void VulkanDriver::setAsyncProgramCompilation(bool enabled) {
+}
+
 void VulkanDriver::insertEventMarker(char const* string, size_t len) {
     constexpr float MARKER_COLOR[] = { 0.0f, 1.0f, 0.0f, 1.0f };
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
@@ -1553,30 +1653,8 @@ void VulkanDriver::blit(TargetBufferFlags buffers, Handle<HwRenderTarget> dst, V
     }
 }
 
-void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> rph) {
-    VulkanCommandBuffer const* commands = &mContext.commands->get();
-    VkCommandBuffer cmdbuffer = commands->cmdbuffer;
-    const VulkanRenderPrimitive& prim = *handle_cast<VulkanRenderPrimitive>(mHandleMap, rph);
-
-    Handle<HwProgram> programHandle = pipelineState.program;
-    RasterState rasterState = pipelineState.rasterState;
-    PolygonOffset depthOffset = pipelineState.polygonOffset;
-    const Viewport& viewportScissor = pipelineState.scissor;
-
-    auto* program = handle_cast<VulkanProgram>(mHandleMap, programHandle);
-    mDisposer.acquire(program);
-    mDisposer.acquire(prim.indexBuffer);
-    mDisposer.acquire(prim.vertexBuffer);
-
-    // If this is a debug build, validate the current shader.
-#if !defined(NDEBUG)
-    if (program->bundle.vertex == VK_NULL_HANDLE || program->bundle.fragment == VK_NULL_HANDLE) {
-        utils::slog.e << "Binding missing shader: " << program->name.c_str() << utils::io::endl;
-    }
-#endif
-
-    // Update the VK raster state.
-
+void VulkanDriver::updateRasterState(const RasterState& rasterState,
+        const PolygonOffset& depthOffset) noexcept {
     const VulkanRenderTarget* rt = mCurrentRenderTarget;
 
     mContext.rasterState.depthStencil = {
@@ -1613,13 +1691,13 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
     vkraster.depthBiasSlopeFactor = depthOffset.slope;
 
     mContext.rasterState.colorTargetCount = rt->getColorTargetCount(mContext.currentRenderPass);
+}
 
-    // Declare fixed-size arrays that get passed to the pipeCache and to vkCmdBindVertexBuffers.
-    VulkanPipelineCache::VertexArray varray = {};
-    VkBuffer buffers[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
-    VkDeviceSize offsets[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
-
-    // For each attribute, append to each of the above lists.
+bool VulkanDriver::getVertexArray(const VulkanRenderPrimitive& prim,
+        VulkanPipelineCache::VertexArray& varray,
+        VkBuffer buffers[backend::MAX_VERTEX_ATTRIBUTE_COUNT],
+        VkDeviceSize offsets[backend::MAX_VERTEX_ATTRIBUTE_COUNT]) noexcept {
+    // For each attribute, append to each of the given lists.
     const uint32_t bufferCount = prim.vertexBuffer->attributes.size();
     for (uint32_t attribIndex = 0; attribIndex < bufferCount; attribIndex++) {
         Attribute attrib = prim.vertexBuffer->attributes[attribIndex];
@@ -1641,10 +1719,8 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
 
         const VulkanBuffer* buffer = prim.vertexBuffer->buffers[attrib.buffer];
 
-        // If the vertex buffer is missing a constituent buffer object, skip the draw call.
-        // There is no need to emit an error message because this is not explicitly forbidden.
         if (buffer == nullptr) {
-            return;
+            return false;
         }
 
         buffers[attribIndex] = buffer->getGpuBuffer();
@@ -1659,6 +1735,68 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
             .stride = attrib.stride,
         };
     }
+    return true;
+}
+
+void VulkanDriver::warmUpPipeline(PipelineState pipelineState, Handle<HwRenderPrimitive> rph) {
+    const VulkanRenderPrimitive& prim = *handle_cast<VulkanRenderPrimitive>(mHandleMap, rph);
+    auto* program = handle_cast<VulkanProgram>(mHandleMap, pipelineState.program);
+    if (!mCurrentRenderTarget || program->bundle.vertex == VK_NULL_HANDLE ||
+            program->bundle.fragment == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // The raster state of the next draw call is set from scratch, so it can be clobbered here.
+    updateRasterState(pipelineState.rasterState, pipelineState.polygonOffset);
+
+    VulkanPipelineCache::VertexArray varray = {};
+    VkBuffer buffers[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
+    VkDeviceSize offsets[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
+    if (!getVertexArray(prim, varray, buffers, offsets)) {
+        return;
+    }
+
+    mPipelineCache.warmUpPipeline(program->bundle, mContext.rasterState, prim.primitiveTopology,
+            varray);
+}
+
+void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> rph) {
+    VulkanCommandBuffer const* commands = &mContext.commands->get();
+    VkCommandBuffer cmdbuffer = commands->cmdbuffer;
+    const VulkanRenderPrimitive& prim = *handle_cast<VulkanRenderPrimitive>(mHandleMap, rph);
+
+    Handle<HwProgram> programHandle = pipelineState.program;
+    RasterState rasterState = pipelineState.rasterState;
+    PolygonOffset depthOffset = pipelineState.polygonOffset;
+    const Viewport& viewportScissor = pipelineState.scissor;
+
+    auto* program = handle_cast<VulkanProgram>(mHandleMap, programHandle);
+    mDisposer.acquire(program);
+    mDisposer.acquire(prim.indexBuffer);
+    mDisposer.acquire(prim.vertexBuffer);
+
+    // If this is a debug build, validate the current shader.
+#if !defined(NDEBUG)
+    if (program->bundle.vertex == VK_NULL_HANDLE || program->bundle.fragment == VK_NULL_HANDLE) {
+        utils::slog.e << "Binding missing shader: " << program->name.c_str() << utils::io::endl;
+    }
+#endif
+
+    // Update the VK raster state.
+    const VulkanRenderTarget* rt = mCurrentRenderTarget;
+    updateRasterState(rasterState, depthOffset);
+
+    // Declare fixed-size arrays that get passed to the pipeCache and to vkCmdBindVertexBuffers.
+    VulkanPipelineCache::VertexArray varray = {};
+    VkBuffer buffers[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
+    VkDeviceSize offsets[backend::MAX_VERTEX_ATTRIBUTE_COUNT] = {};
+
+    // If the vertex buffer is missing a constituent buffer object, skip the draw call.
+    // There is no need to emit an error message because this is not explicitly forbidden.
+    if (!getVertexArray(prim, varray, buffers, offsets)) {
+        return;
+    }
+    const uint32_t bufferCount = prim.vertexBuffer->attributes.size();
 
     // Push state changes to the VulkanPipelineCache instance. This is fast and does not make VK calls.
     mPipelineCache.bindProgramBundle(program->bundle);
@@ -39,6 +39,7 @@ namespace filament {
 namespace backend {
 
 class VulkanPlatform;
+struct VulkanRenderPrimitive;
 struct VulkanRenderTarget;
 struct VulkanSamplerGroup;
 
@@ -146,6 +147,16 @@ private:
 
     void refreshSwapChain();
     void collectGarbage();
+    void savePipelineCache();
+    void updatePipelineCacheStats();
+
+    // Helpers shared by draw() and warmUpPipeline().
+    void updateRasterState(const RasterState& rasterState,
+            const PolygonOffset& depthOffset) noexcept;
+    bool getVertexArray(const VulkanRenderPrimitive& prim,
+            VulkanPipelineCache::VertexArray& varray,
+            VkBuffer buffers[backend::MAX_VERTEX_ATTRIBUTE_COUNT],
+            VkDeviceSize offsets[backend::MAX_VERTEX_ATTRIBUTE_COUNT]) noexcept;
 
     VulkanContext mContext = {};
     VulkanPipelineCache mPipelineCache;
@@ -158,6 +169,15 @@ private:
     VulkanSamplerGroup* mSamplerBindings[VulkanPipelineCache::SAMPLER_BINDING_COUNT] = {};
     VkDebugReportCallbackEXT mDebugCallback = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT mDebugMessenger = VK_NULL_HANDLE;
+
+    // Number of pipelines that existed when the pipeline cache was last persisted, and frames
+    // elapsed since then.
+    uint32_t mSavedPipelineCount = 0;
+    uint32_t mFramesSincePipelineCacheSave = 0;
+
+    // Copy of the pipeline cache counters that the main thread can read.
+    std::mutex mPipelineCacheStatsLock;
+    PipelineCacheStats mPipelineCacheStats;
 };
 
 } // namespace backend
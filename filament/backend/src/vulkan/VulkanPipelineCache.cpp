@@ -20,6 +20,9 @@
 #include <utils/Panic.h>
 #include <utils/trap.h>
 
+#include <algorithm>
+#include <functional>
+
 #include "VulkanConstants.h"
 
 // Vulkan functions often immediately dereference pointers, so it's fine to pass in a pointer
@@ -112,6 +115,7 @@ void VulkanPipelineCache::getOrCreateDescriptors(
             descriptorSets[i] = descriptorBundle->handles[i];
         }
         descriptorBundle->commandBuffers.set(mCmdBufferIndex);
+        descriptorBundle->age = 0;
         return;
     }
 
@@ -123,10 +127,13 @@ void VulkanPipelineCache::getOrCreateDescriptors(
             descriptorSets[i] = descriptorBundle->handles[i];
         }
         descriptorBundle->commandBuffers.set(mCmdBufferIndex);
+        descriptorBundle->age = 0;
         mDirtyDescriptor.unset(mCmdBufferIndex);
+        mStats.descriptorHits++;
         *bind = true;
         return;
     }
+    mStats.descriptorMisses++;
 
     // If there are no available descriptor sets that can be re-used, then create brand new ones
     // (one for each type). Otherwise, grab a descriptor set from each of the arenas.
@@ -291,9 +298,55 @@ bool VulkanPipelineCache::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
         currentPipeline->age = 0;
         *pipeline = currentPipeline->handle;
         mDirtyPipeline.unset(mCmdBufferIndex);
+        mStats.pipelineHits++;
         return true;
     }
+    mStats.pipelineMisses++;
+
+    // If we reach this point, we need to create and stash a brand new pipeline object.
+    *pipeline = createPipeline(mPipelineKey);
+
+    // Stash a stable pointer to the stored cache entry to allow fast subsequent calls to
+    // getOrCreatePipeline when nothing has been dirtied.
+    const PipelineVal cacheEntry = { *pipeline, 0u };
+    currentPipeline = &mPipelines.emplace(std::make_pair(mPipelineKey, cacheEntry)).first.value();
+    mDirtyPipeline.unset(mCmdBufferIndex);
+
+    return true;
+}
+
+void VulkanPipelineCache::warmUpPipeline(const ProgramBundle& bundle,
+        const RasterState& rasterState, VkPrimitiveTopology topology,
+        const VertexArray& varray) noexcept {
+    if (!mPipelineLayout) {
+        createLayoutsAndDescriptors();
+    }
+
+    // Start from the current key for the render pass and subpass, the rest is overwritten.
+    PipelineKey key = mPipelineKey;
+    key.shaders[0] = bundle.vertex;
+    key.shaders[1] = bundle.fragment;
+    key.rasterState = rasterState;
+    key.topology = topology;
+    static_assert(sizeof(key.vertexAttributes) == sizeof(varray.attributes));
+    static_assert(sizeof(key.vertexBuffers) == sizeof(varray.buffers));
+    memcpy(key.vertexAttributes, varray.attributes, sizeof(varray.attributes));
+    memcpy(key.vertexBuffers, varray.buffers, sizeof(varray.buffers));
+
+    // Pipelines are tied to a render pass, there is nothing to warm up outside of one.
+    if (!key.renderPass || mPipelines.find(key) != mPipelines.end()) {
+        return;
+    }
+    mStats.pipelineMisses++;
+    const PipelineVal cacheEntry = { createPipeline(key), 0u };
+    mPipelines.emplace(std::make_pair(key, cacheEntry));
+
+    // The insertion can move the other entries, so the pointers to the current pipelines must
+    // be refreshed.
+    markDirtyPipeline();
+}
 
+VkPipeline VulkanPipelineCache::createPipeline(const PipelineKey& key) const noexcept {
     VkPipelineShaderStageCreateInfo shaderStages[SHADER_MODULE_COUNT];
     shaderStages[0] = VkPipelineShaderStageCreateInfo{};
     shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -312,19 +365,18 @@ bool VulkanPipelineCache::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
     colorBlendState.attachmentCount = 1;
     colorBlendState.pAttachments = colorBlendAttachments;
 
-    // If we reach this point, we need to create and stash a brand new pipeline object.
-    shaderStages[0].module = mPipelineKey.shaders[0];
-    shaderStages[1].module = mPipelineKey.shaders[1];
+    shaderStages[0].module = key.shaders[0];
+    shaderStages[1].module = key.shaders[1];
 
     // We don't store array sizes to save space, but it's quick to count all non-zero
     // entries because these arrays have a small fixed-size capacity.
     uint32_t numVertexAttribs = 0;
     uint32_t numVertexBuffers = 0;
     for (uint32_t i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++) {
-        if (mPipelineKey.vertexAttributes[i].format > 0) {
+        if (key.vertexAttributes[i].format > 0) {
             numVertexAttribs++;
         }
-        if (mPipelineKey.vertexBuffers[i].stride > 0) {
+        if (key.vertexBuffers[i].stride > 0) {
             numVertexBuffers++;
         }
     }
@@ -332,13 +384,13 @@ bool VulkanPipelineCache::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
     VkPipelineVertexInputStateCreateInfo vertexInputState = {};
     vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputState.vertexBindingDescriptionCount = numVertexBuffers;
-    vertexInputState.pVertexBindingDescriptions = mPipelineKey.vertexBuffers;
+    vertexInputState.pVertexBindingDescriptions = key.vertexBuffers;
     vertexInputState.vertexAttributeDescriptionCount = numVertexAttribs;
-    vertexInputState.pVertexAttributeDescriptions = mPipelineKey.vertexAttributes;
+    vertexInputState.pVertexAttributeDescriptions = key.vertexAttributes;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
     inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssemblyState.topology = mPipelineKey.topology;
+    inputAssemblyState.topology = key.topology;
 
     VkPipelineViewportStateCreateInfo viewportState = {};
     viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -359,23 +411,23 @@ bool VulkanPipelineCache::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
     VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineCreateInfo.layout = mPipelineLayout;
-    pipelineCreateInfo.renderPass = mPipelineKey.renderPass;
-    pipelineCreateInfo.subpass = mPipelineKey.subpassIndex;
+    pipelineCreateInfo.renderPass = key.renderPass;
+    pipelineCreateInfo.subpass = key.subpassIndex;
     pipelineCreateInfo.stageCount = hasFragmentShader ? SHADER_MODULE_COUNT : 1;
     pipelineCreateInfo.pStages = shaderStages;
     pipelineCreateInfo.pVertexInputState = &vertexInputState;
     pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-    pipelineCreateInfo.pRasterizationState = &mPipelineKey.rasterState.rasterization;
+    pipelineCreateInfo.pRasterizationState = &key.rasterState.rasterization;
     pipelineCreateInfo.pColorBlendState = &colorBlendState;
-    pipelineCreateInfo.pMultisampleState = &mPipelineKey.rasterState.multisampling;
+    pipelineCreateInfo.pMultisampleState = &key.rasterState.multisampling;
     pipelineCreateInfo.pViewportState = &viewportState;
-    pipelineCreateInfo.pDepthStencilState = &mPipelineKey.rasterState.depthStencil;
+    pipelineCreateInfo.pDepthStencilState = &key.rasterState.depthStencil;
     pipelineCreateInfo.pDynamicState = &dynamicState;
 
     // Filament assumes consistent blend state across all color attachments.
-    colorBlendState.attachmentCount = mPipelineKey.rasterState.colorTargetCount;
+    colorBlendState.attachmentCount = key.rasterState.colorTargetCount;
     for (auto& target : colorBlendAttachments) {
-        target = mPipelineKey.rasterState.blending;
+        target = key.rasterState.blending;
     }
 
     // There are no color attachments if there is no bound fragment shader.  (e.g. shadow map gen)
@@ -388,20 +440,14 @@ bool VulkanPipelineCache::getOrCreatePipeline(VkPipeline* pipeline) noexcept {
     utils::slog.d << "vkCreateGraphicsPipelines with shaders = ("
             << shaderStages[0].module << ", " << shaderStages[1].module << ")" << utils::io::endl;
     #endif
-    VkResult err = vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo,
-            VKALLOC, pipeline);
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult err = vkCreateGraphicsPipelines(mDevice, mVkPipelineCache, 1, &pipelineCreateInfo,
+            VKALLOC, &pipeline);
     if (err) {
         utils::slog.e << "vkCreateGraphicsPipelines error " << err << utils::io::endl;
         utils::debug_trap();
     }
-
-    // Stash a stable pointer to the stored cache entry to allow fast subsequent calls to
-    // getOrCreatePipeline when nothing has been dirtied.
-    const PipelineVal cacheEntry = { *pipeline, 0u };
-    currentPipeline = &mPipelines.emplace(std::make_pair(mPipelineKey, cacheEntry)).first.value();
-    mDirtyPipeline.unset(mCmdBufferIndex);
-
-    return true;
+    return pipeline;
 }
 
 void VulkanPipelineCache::bindProgramBundle(const ProgramBundle& bundle) noexcept {
@@ -494,6 +540,14 @@ void VulkanPipelineCache::unbindUniformBuffer(VkBuffer uniformBuffer) noexcept {
             markDirtyDescriptor();
         }
     }
+    invalidateDescriptorBundles([uniformBuffer](const DescriptorKey& key) {
+        for (VkBuffer buffer : key.uniformBuffers) {
+            if (buffer == uniformBuffer) {
+                return true;
+            }
+        }
+        return false;
+    });
 }
 
 void VulkanPipelineCache::unbindImageView(VkImageView imageView) noexcept {
@@ -509,6 +563,19 @@ void VulkanPipelineCache::unbindImageView(VkImageView imageView) noexcept {
             markDirtyDescriptor();
         }
     }
+    invalidateDescriptorBundles([imageView](const DescriptorKey& key) {
+        for (const auto& sampler : key.samplers) {
+            if (sampler.imageView == imageView) {
+                return true;
+            }
+        }
+        for (const auto& target : key.inputAttachments) {
+            if (target.imageView == imageView) {
+                return true;
+            }
+        }
+        return false;
+    });
 }
 
 void VulkanPipelineCache::bindUniformBuffer(uint32_t bindingIndex, VkBuffer uniformBuffer,
@@ -568,6 +635,47 @@ void VulkanPipelineCache::destroyCache() noexcept {
         vkDestroySampler(mDevice, mDummySamplerInfo.sampler, VKALLOC);
         mDummySamplerInfo.sampler = VK_NULL_HANDLE;
     }
+    if (mVkPipelineCache) {
+        vkDestroyPipelineCache(mDevice, mVkPipelineCache, VKALLOC);
+        mVkPipelineCache = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanPipelineCache::createPipelineCache(const void* initialData,
+        size_t initialDataSize) noexcept {
+    assert_invariant(mVkPipelineCache == VK_NULL_HANDLE);
+    VkPipelineCacheCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = initialDataSize,
+        .pInitialData = initialData
+    };
+    VkResult err = vkCreatePipelineCache(mDevice, &createInfo, VKALLOC, &mVkPipelineCache);
+    if (err != VK_SUCCESS && initialDataSize) {
+        // the data could be rejected by the driver, start from an empty cache in that case
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        err = vkCreatePipelineCache(mDevice, &createInfo, VKALLOC, &mVkPipelineCache);
+    }
+    if (err != VK_SUCCESS) {
+        utils::slog.w << "vkCreatePipelineCache error " << err << utils::io::endl;
+        mVkPipelineCache = VK_NULL_HANDLE;
+    }
+}
+
+std::vector<uint8_t> VulkanPipelineCache::getPipelineCacheData() const noexcept {
+    std::vector<uint8_t> data;
+    if (mVkPipelineCache) {
+        size_t size = 0;
+        vkGetPipelineCacheData(mDevice, mVkPipelineCache, &size, nullptr);
+        data.resize(size);
+        if (size && vkGetPipelineCacheData(mDevice, mVkPipelineCache, &size,
+                data.data()) == VK_SUCCESS) {
+            data.resize(size);
+        } else {
+            data.clear();
+        }
+    }
+    return data;
 }
 
 void VulkanPipelineCache::onCommandBuffer(const VulkanCommandBuffer& cmdbuffer) {
@@ -580,48 +688,41 @@ void VulkanPipelineCache::onCommandBuffer(const VulkanCommandBuffer& cmdbuffer)
 
     // NOTE: Due to robin_map restrictions, we cannot use auto or range-based loops.
 
-    // Check if any bundles in the cache are no longer in use by any command buffer. Descriptors
-    // from unused bundles are moved back to their respective arenas.
-    using ConstDescIterator = decltype(mDescriptorBundles)::const_iterator;
-    for (ConstDescIterator iter = mDescriptorBundles.begin(); iter != mDescriptorBundles.end();) {
-        const DescriptorBundle& cacheEntry = iter.value();
-        if (cacheEntry.commandBuffers.getValue() == 0) {
-            mDescriptorSetArena[0].push_back(cacheEntry.handles[0]);
-            mDescriptorSetArena[1].push_back(cacheEntry.handles[1]);
-            mDescriptorSetArena[2].push_back(cacheEntry.handles[2]);
-            iter = mDescriptorBundles.erase(iter);
-        } else {
-            ++iter;
-        }
-    }
+    // Evict the least recently used bundles that are no longer in use by any command buffer.
+    // Descriptors from evicted bundles are moved back to their respective arenas.
+    evictDescriptorBundles();
 
-    // Increment the "age" of all cached pipelines. If the age of any pipeline is 0, then it is
-    // being used by the command buffer that was just flushed.
+    // Increment the "age" of all cached pipelines and bundles. If the age of any pipeline is 0,
+    // then it is being used by the command buffer that was just flushed.
     using PipeIterator = decltype(mPipelines)::iterator;
     for (PipeIterator iter = mPipelines.begin(); iter != mPipelines.end(); ++iter) {
         ++iter.value().age;
     }
-
-    // Evict any pipelines that have not been used in a while.
-    // Any pipeline older than VK_MAX_COMMAND_BUFFERS can be safely destroyed.
-    static_assert(VK_MAX_PIPELINE_AGE >= VK_MAX_COMMAND_BUFFERS);
-    using ConstPipeIterator = decltype(mPipelines)::const_iterator;
-    for (ConstPipeIterator iter = mPipelines.begin(); iter != mPipelines.end();) {
-        if (iter.value().age > VK_MAX_PIPELINE_AGE) {
-            vkDestroyPipeline(mDevice, iter->second.handle, VKALLOC);
-            iter = mPipelines.erase(iter);
-        } else {
-            ++iter;
-        }
+    using DescIterator = decltype(mDescriptorBundles)::iterator;
+    for (DescIterator iter = mDescriptorBundles.begin(); iter != mDescriptorBundles.end(); ++iter) {
+        ++iter.value().age;
     }
 
+    // Evict the least recently used pipelines if there are too many of them.
+    evictPipelines();
+
     // We know that the new command buffer is not being processed by the GPU, so we can clear
     // its "in use" bit from all descriptors in the cache.
-    using DescIterator = decltype(mDescriptorBundles)::iterator;
     for (DescIterator iter = mDescriptorBundles.begin(); iter != mDescriptorBundles.end(); ++iter) {
         iter.value().commandBuffers.unset(mCmdBufferIndex);
     }
 
+    // Invalidated bundles go back to the arenas once no command buffer uses them anymore.
+    for (auto iter = mRetiredDescriptorBundles.begin(); iter != mRetiredDescriptorBundles.end();) {
+        iter->commandBuffers.unset(mCmdBufferIndex);
+        if (iter->commandBuffers.getValue() == 0) {
+            recycleDescriptorBundle(*iter);
+            iter = mRetiredDescriptorBundles.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
     // Descriptor sets that arose from an old pool (i.e. before the most recent growth event)
     // also need to have their "in use" bit cleared for this command buffer.
     bool canPurgeExtinctPools = true;
@@ -643,6 +744,120 @@ void VulkanPipelineCache::onCommandBuffer(const VulkanCommandBuffer& cmdbuffer)
     }
 }
 
+void VulkanPipelineCache::evictPipelines() noexcept {
+    if (mPipelines.size() <= VK_MAX_PIPELINE_COUNT) {
+        return;
+    }
+
+    // Pipelines that were used within the last VK_MAX_COMMAND_BUFFERS flushes may still be
+    // referenced by a command buffer, they are never evicted. This means the capacity can be
+    // exceeded temporarily.
+    std::vector<uint32_t> ages;
+    ages.reserve(mPipelines.size());
+    for (const auto& entry : mPipelines) {
+        if (entry.second.age > VK_MAX_COMMAND_BUFFERS) {
+            ages.push_back(entry.second.age);
+        }
+    }
+    const size_t excess = std::min(mPipelines.size() - VK_MAX_PIPELINE_COUNT, ages.size());
+    if (excess == 0) {
+        return;
+    }
+
+    // Find the age of the most recently used pipeline that must go, everything at least as old
+    // is evicted.
+    std::nth_element(ages.begin(), ages.begin() + (excess - 1), ages.end(), std::greater<>());
+    const uint32_t threshold = ages[excess - 1];
+
+    using ConstPipeIterator = decltype(mPipelines)::const_iterator;
+    for (ConstPipeIterator iter = mPipelines.begin(); iter != mPipelines.end();) {
+        if (iter.value().age >= threshold) {
+            vkDestroyPipeline(mDevice, iter->second.handle, VKALLOC);
+            iter = mPipelines.erase(iter);
+            mStats.pipelineEvictions++;
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void VulkanPipelineCache::evictDescriptorBundles() noexcept {
+    if (mDescriptorBundles.size() <= VK_MAX_DESCRIPTOR_BUNDLE_COUNT) {
+        return;
+    }
+
+    // Only the bundles that no command buffer uses can be evicted.
+    std::vector<uint32_t> ages;
+    ages.reserve(mDescriptorBundles.size());
+    for (const auto& entry : mDescriptorBundles) {
+        if (entry.second.commandBuffers.getValue() == 0) {
+            ages.push_back(entry.second.age);
+        }
+    }
+    const size_t excess = std::min(mDescriptorBundles.size() - VK_MAX_DESCRIPTOR_BUNDLE_COUNT,
+            ages.size());
+    if (excess == 0) {
+        return;
+    }
+
+    std::nth_element(ages.begin(), ages.begin() + (excess - 1), ages.end(), std::greater<>());
+    const uint32_t threshold = ages[excess - 1];
+
+    using ConstDescIterator = decltype(mDescriptorBundles)::const_iterator;
+    for (ConstDescIterator iter = mDescriptorBundles.begin(); iter != mDescriptorBundles.end();) {
+        const DescriptorBundle& cacheEntry = iter.value();
+        if (cacheEntry.commandBuffers.getValue() == 0 && cacheEntry.age >= threshold) {
+            recycleDescriptorBundle(cacheEntry);
+            iter = mDescriptorBundles.erase(iter);
+            mStats.descriptorEvictions++;
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void VulkanPipelineCache::recycleDescriptorBundle(const DescriptorBundle& bundle) noexcept {
+    for (uint32_t i = 0; i < DESCRIPTOR_TYPE_COUNT; ++i) {
+        mDescriptorSetArena[i].push_back(bundle.handles[i]);
+    }
+}
+
+template<typename Predicate>
+void VulkanPipelineCache::invalidateDescriptorBundles(Predicate predicate) noexcept {
+    using ConstDescIterator = decltype(mDescriptorBundles)::const_iterator;
+    for (ConstDescIterator iter = mDescriptorBundles.begin(); iter != mDescriptorBundles.end();) {
+        if (predicate(iter.key())) {
+            const DescriptorBundle& cacheEntry = iter.value();
+            if (cacheEntry.commandBuffers.getValue() == 0) {
+                recycleDescriptorBundle(cacheEntry);
+            } else {
+                mRetiredDescriptorBundles.push_back(cacheEntry);
+            }
+            iter = mDescriptorBundles.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    // Erasing moves the other entries, so the pointers to the current bundles must be refreshed.
+    for (int i = 0; i < VK_MAX_COMMAND_BUFFERS; i++) {
+        mCmdBufferState[i].currentDescriptorBundle = nullptr;
+    }
+    markDirtyDescriptor();
+}
+
+VulkanPipelineCache::Stats VulkanPipelineCache::getStats() const noexcept {
+    Stats stats = mStats;
+    stats.pipelineCount = uint32_t(mPipelines.size());
+    stats.descriptorBundleCount = uint32_t(mDescriptorBundles.size());
+    stats.descriptorPoolSize = mDescriptorPoolSize;
+    stats.pipelineCacheDataSize = 0;
+    if (mVkPipelineCache) {
+        vkGetPipelineCacheData(mDevice, mVkPipelineCache, &stats.pipelineCacheDataSize, nullptr);
+    }
+    return stats;
+}
+
 void VulkanPipelineCache::createLayoutsAndDescriptors() noexcept {
     VkDescriptorSetLayoutBinding binding = {};
     binding.descriptorCount = 1; // NOTE: We never use arrays-of-blocks.
@@ -736,8 +951,8 @@ void VulkanPipelineCache::destroyLayoutsAndDescriptors() noexcept {
     for (auto& arena : mDescriptorSetArena) {
         arena.clear();
     }
-
     mDescriptorBundles.clear();
+    mRetiredDescriptorBundles.clear();
     vkDestroyPipelineLayout(mDevice, mPipelineLayout, VKALLOC);
     mPipelineLayout = VK_NULL_HANDLE;
     for (int i = 0; i < 3; i++) {
@@ -781,6 +996,9 @@ void VulkanPipelineCache::growDescriptorPool() noexcept {
         mExtinctDescriptorBundles.push_back(iter.value());
     }
     mDescriptorBundles.clear();
+    mExtinctDescriptorBundles.insert(mExtinctDescriptorBundles.end(),
+            mRetiredDescriptorBundles.begin(), mRetiredDescriptorBundles.end());
+    mRetiredDescriptorBundles.clear();
 }
 
 bool VulkanPipelineCache::PipelineEqual::operator()(const VulkanPipelineCache::PipelineKey& k1,
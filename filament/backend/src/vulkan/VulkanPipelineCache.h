@@ -38,6 +38,10 @@ namespace backend {
 
 // VulkanPipelineCache manages a cache of descriptor sets and pipelines.
 //
+// Both caches are bounded, see VK_MAX_PIPELINE_COUNT and VK_MAX_DESCRIPTOR_BUNDLE_COUNT. When a
+// cache is over capacity, its least recently used entries are destroyed, except for those that
+// may still be referenced by a command buffer in flight.
+//
 // Please note the following limitations:
 //
 // - Push constants are not supported. (if adding support, see VkPipelineLayoutCreateInfo)
@@ -86,6 +90,21 @@ public:
     };
     static_assert(std::is_pod<RasterState>::value, "RasterState must be a POD for fast hashing.");
 
+    // Counters for the current state and the lifetime activity of the caches. Hits and misses are
+    // only counted when the bindings have changed since the previous draw call.
+    struct Stats {
+        uint32_t pipelineCount;
+        uint32_t pipelineHits;
+        uint32_t pipelineMisses;
+        uint32_t pipelineEvictions;
+        uint32_t descriptorBundleCount;
+        uint32_t descriptorHits;
+        uint32_t descriptorMisses;
+        uint32_t descriptorEvictions;
+        uint32_t descriptorPoolSize;    // capacity of the descriptor pool, in bundles
+        size_t pipelineCacheDataSize;   // size of the VkPipelineCache data, in bytes
+    };
+
     // Upon construction, the pipeCache initializes some internal state but does not make any Vulkan
     // calls. On destruction it will free any cached Vulkan objects that haven't already been freed.
     VulkanPipelineCache();
@@ -103,6 +122,23 @@ public:
     // Creates a new pipeline if necessary and binds it using vkCmdBindPipeline.
     void bindPipeline(VulkanCommands& commands) noexcept;
 
+    // Creates the pipeline for the given state and the currently bound render pass, if it doesn't
+    // exist yet. This doesn't bind anything, it is meant to move the cost of pipeline creation
+    // to loading time.
+    void warmUpPipeline(const ProgramBundle& bundle, const RasterState& rasterState,
+            VkPrimitiveTopology topology, const VertexArray& varray) noexcept;
+
+    Stats getStats() const noexcept;
+
+    // Number of pipelines created since the cache was constructed, which is cheap to query.
+    uint32_t getPipelineCreationCount() const noexcept { return mStats.pipelineMisses; }
+
+    // The pipeline counters of getStats(), without querying the size of the VkPipelineCache.
+    PipelineCacheStats getPipelineCacheStats() const noexcept {
+        return { uint32_t(mPipelines.size()), mStats.pipelineHits, mStats.pipelineMisses,
+                mStats.pipelineEvictions, uint32_t(mDescriptorBundles.size()) };
+    }
+
     // Each of the following methods are fast and do not make Vulkan calls.
     void bindProgramBundle(const ProgramBundle& bundle) noexcept;
     void bindRasterState(const RasterState& rasterState) noexcept;
@@ -115,7 +151,8 @@ public:
     void bindVertexArray(const VertexArray& varray) noexcept;
 
     // Checks if the given uniform is bound to any slot, and if so binds "null" to that slot.
-    // Also invalidates all cached descriptors that refer to the given buffer.
+    // Also invalidates all cached descriptors that refer to the given buffer, since Vulkan can
+    // reuse its handle for a new buffer.
     // This is only necessary when the client knows that the UBO is about to be destroyed.
     void unbindUniformBuffer(VkBuffer uniformBuffer) noexcept;
 
@@ -129,6 +166,13 @@ public:
     // Destroys all managed Vulkan objects. This should be called before changing the VkDevice.
     void destroyCache() noexcept;
 
+    // Creates the VkPipelineCache used for all pipelines, optionally seeded with the data returned
+    // by getPipelineCacheData() in a previous run. Invalid or stale data is ignored by the driver.
+    void createPipelineCache(const void* initialData, size_t initialDataSize) noexcept;
+
+    // Returns the contents of the VkPipelineCache, so that it can be persisted across runs.
+    std::vector<uint8_t> getPipelineCacheData() const noexcept;
+
     // vkCmdBindPipeline and vkCmdBindDescriptorSets establish bindings to a specific command
     // buffer; they are not global to the device. Therefore we need to be notified when a
     // new command buffer becomes active.
@@ -188,6 +232,9 @@ private:
     struct DescriptorBundle {
         VkDescriptorSet handles[DESCRIPTOR_TYPE_COUNT];
         utils::bitset32 commandBuffers;
+
+        // Number of command buffer flush events since the bundle was last used, for LRU eviction.
+        uint32_t age;
     };
 
     struct PipelineVal {
@@ -216,6 +263,19 @@ private:
     // Returns true if any pipeline bindings have changed. (i.e., vkCmdBindPipeline is required)
     bool getOrCreatePipeline(VkPipeline* pipeline) noexcept;
 
+    VkPipeline createPipeline(const PipelineKey& key) const noexcept;
+
+    // Destroys the least recently used entries until the caches are back within their capacity.
+    void evictPipelines() noexcept;
+    void evictDescriptorBundles() noexcept;
+
+    // Returns the descriptor sets of a bundle that is no longer needed to the arenas.
+    void recycleDescriptorBundle(const DescriptorBundle& bundle) noexcept;
+
+    // Removes the cached descriptor bundles for which the predicate returns true.
+    template<typename Predicate>
+    void invalidateDescriptorBundles(Predicate predicate) noexcept;
+
     void createLayoutsAndDescriptors() noexcept;
     void destroyLayoutsAndDescriptors() noexcept;
     void markDirtyPipeline() noexcept { mDirtyPipeline.setValue(ALL_COMMAND_BUFFERS); }
@@ -247,6 +307,7 @@ private:
     std::vector<VkDescriptorSet> mDescriptorSetArena[DESCRIPTOR_TYPE_COUNT];
 
     VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+    VkPipelineCache mVkPipelineCache = VK_NULL_HANDLE;
     PipelineMap mPipelines;
     DescriptorMap mDescriptorBundles;
     uint32_t mCmdBufferIndex = 0;
@@ -260,6 +321,12 @@ private:
     std::vector<VkDescriptorPool> mExtinctDescriptorPools;
     std::vector<DescriptorBundle> mExtinctDescriptorBundles;
 
+    // Bundles that were invalidated while still in use by a command buffer. Their descriptor sets
+    // are returned to the arenas once the command buffers are done with them.
+    std::vector<DescriptorBundle> mRetiredDescriptorBundles;
+
+    Stats mStats = {};
+
     VkImageView mDummyImageView = VK_NULL_HANDLE;
     VkDescriptorBufferInfo mDummyBufferInfo = {};
     VkWriteDescriptorSet mDummyBufferWriteInfo = {};
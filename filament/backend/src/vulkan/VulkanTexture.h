@@ -43,6 +43,16 @@ struct VulkanTexture : public HwTexture {
     // Sets the min/max range of miplevels in the primary image view.
     void setPrimaryRange(uint32_t minMiplevel, uint32_t maxMiplevel);
 
+    // Calls the given function with each cached image view, i.e. every view that was created for
+    // this texture, including primary views of earlier min/max ranges and attachment views. They
+    // all stay alive until the texture is destroyed.
+    template<typename F>
+    void forEachImageView(F f) const {
+        for (const auto& entry : mCachedImageViews) {
+            f(entry.second);
+        }
+    }
+
     // Gets or creates a cached VkImageView for a range of miplevels and array layers.
     // If force2D is true, this always returns an image view that has type = VK_IMAGE_VIEW_TYPE_2D,
     // regardless of the type of the primary image view.
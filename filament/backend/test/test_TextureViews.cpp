@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackendTest.h"
+
+#include "ShaderGenerator.h"
+#include "TrianglePrimitive.h"
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shaders
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string vertex (R"(#version 450 core
+
+layout(location = 0) in vec4 mesh_position;
+
+void main() {
+    gl_Position = vec4(mesh_position.xy, 0.0, 1.0);
+}
+)");
+
+std::string fragment (R"(#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 0) uniform sampler2D tex;
+
+void main() {
+    fragColor = texture(tex, vec2(0.5));
+}
+
+)");
+
+}
+
+namespace test {
+
+using namespace filament;
+using namespace filament::backend;
+
+/**
+ * This test case samples a texture through several min/max level ranges, which gives it a
+ * different image view for each range, then destroys it. Backends that cache descriptor sets must
+ * drop every set that refers to any of these views, since their handles can be reused.
+ */
+TEST_F(BackendTest, DestroyTextureWithSeveralViews) {
+    constexpr uint8_t kLevelCount = 4;
+    constexpr uint32_t kRanges[][2] = { { 0, 3 }, { 1, 3 }, { 2, 2 }, { 3, 3 } };
+    constexpr uint32_t kRangeCount = sizeof(kRanges) / sizeof(kRanges[0]);
+
+    auto& api = getDriverApi();
+    const uint32_t initialCount = api.getPipelineCacheStats().descriptorSetCount;
+
+    Handle<HwSwapChain> swapChain;
+    Handle<HwProgram> program;
+    Handle<HwRenderTarget> defaultRenderTarget;
+    Handle<HwTexture> texture;
+    Handle<HwSamplerGroup> samplerGroup;
+    {
+        // Create a platform-specific SwapChain and make it current.
+        swapChain = createSwapChain();
+        api.makeCurrent(swapChain, swapChain);
+
+        // Create a program that samples a single texture.
+        ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+        Program prog = shaderGen.getProgram();
+        Program::Sampler psamplers[] = { utils::CString("tex"), 0, false };
+        prog.setSamplerGroup(0, psamplers, sizeof(psamplers) / sizeof(psamplers[0]));
+        program = api.createProgram(std::move(prog));
+
+        defaultRenderTarget = api.createDefaultRenderTarget(0);
+
+        TrianglePrimitive triangle(api);
+
+        texture = api.createTexture(SamplerType::SAMPLER_2D, kLevelCount, TextureFormat::RGBA8,
+                1, 1u << kLevelCount, 1u << kLevelCount, 1, TextureUsage::DEFAULT);
+
+        SamplerGroup samplers(1);
+        SamplerParams sparams = {};
+        sparams.filterMag = SamplerMagFilter::NEAREST;
+        sparams.filterMin = SamplerMinFilter::NEAREST_MIPMAP_NEAREST;
+        samplers.setSampler(0, texture, sparams);
+        samplerGroup = api.createSamplerGroup(samplers.getSize());
+        api.updateSamplerGroup(samplerGroup, std::move(samplers.toCommandStream()));
+
+        RenderPassParams params = {};
+        fullViewport(params);
+        params.flags.clear = TargetBufferFlags::COLOR;
+        params.flags.discardStart = TargetBufferFlags::ALL;
+        params.flags.discardEnd = TargetBufferFlags::NONE;
+
+        PipelineState state;
+        state.program = program;
+        state.rasterState.colorWrite = true;
+        state.rasterState.depthWrite = false;
+        state.rasterState.depthFunc = RasterState::DepthFunc::A;
+        state.rasterState.culling = CullingMode::NONE;
+
+        api.makeCurrent(swapChain, swapChain);
+        api.beginFrame(0, 0);
+        api.bindSamplers(0, samplerGroup);
+
+        // Draw once with each range of levels.
+        for (auto const& range : kRanges) {
+            api.setMinMaxLevels(texture, range[0], range[1]);
+            api.beginRenderPass(defaultRenderTarget, params);
+            api.draw(state, triangle.getRenderPrimitive());
+            api.endRenderPass();
+        }
+
+        api.flush();
+        api.commit(swapChain);
+        api.endFrame(0);
+        api.finish();
+    }
+    executeCommands();
+
+    // Each range has its own view, hence its own descriptor set. Other backends report none.
+    if (sBackend == Backend::VULKAN) {
+        EXPECT_GE(api.getPipelineCacheStats().descriptorSetCount, initialCount + kRangeCount);
+    }
+
+    api.destroyTexture(texture);
+    api.finish();
+    executeCommands();
+
+    // None of the cached sets may still refer to one of the texture's views.
+    EXPECT_EQ(api.getPipelineCacheStats().descriptorSetCount, initialCount);
+
+    api.destroySamplerGroup(samplerGroup);
+    api.destroyProgram(program);
+    api.destroySwapChain(swapChain);
+    api.destroyRenderTarget(defaultRenderTarget);
+    executeCommands();
+}
+
+} // namespace test
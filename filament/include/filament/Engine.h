@@ -38,13 +38,16 @@ class IndexBuffer;
 class IndirectLight;
 class Material;
 class MaterialInstance;
+class MorphTargetBuffer;
 class Renderer;
 class RenderTarget;
 class Scene;
+class SkinningBuffer;
 class Skybox;
 class Stream;
 class SwapChain;
 class Texture;
+class TextureStreamer;
 class VertexBuffer;
 class View;
 
@@ -149,6 +152,7 @@ class UTILS_PUBLIC Engine {
 public:
     using Platform = backend::Platform;
     using Backend = backend::Backend;
+    using PipelineCacheStats = backend::PipelineCacheStats;
 
     /**
      * Creates an instance of Engine
@@ -324,6 +328,11 @@ public:
      */
     TransformManager& getTransformManager() noexcept;
 
+    /**
+     * @return TextureStreamer reference
+     */
+    TextureStreamer& getTextureStreamer() noexcept;
+
     /**
      * Creates a SwapChain from the given Operating System's native window handle.
      *
@@ -411,6 +420,8 @@ public:
     bool destroy(const Fence* p);               //!< Destroys a Fence object.
     bool destroy(const IndexBuffer* p);         //!< Destroys an IndexBuffer object.
     bool destroy(const IndirectLight* p);       //!< Destroys an IndirectLight object.
+    bool destroy(const SkinningBuffer* p);      //!< Destroys a SkinningBuffer object.
+    bool destroy(const MorphTargetBuffer* p);   //!< Destroys a MorphTargetBuffer object.
 
     /**
      * Destroys a Material object
@@ -442,6 +453,9 @@ public:
      * in cases where a guarantee about the <code>SwapChain</code> destruction is needed in a
      * timely fashion, such as when responding to Android's
      * <code>android.view.SurfaceHolder.Callback.surfaceDestroyed</code></p>
+     *
+     * <p>Backends that keep compiled pipelines in the Platform's blob cache also store the ones
+     * created so far, which they otherwise only do periodically and at shutdown.</p>
      */
     void flushAndWait();
 
@@ -459,6 +473,23 @@ public:
      */
     Backend getBackend() const noexcept;
 
+    /**
+     * Enables or disables asynchronous shader compilation. When enabled, objects whose shaders
+     * are still being compiled are not drawn, instead of stalling the frame until the compiler
+     * is done. This is typically combined with Material::compile().
+     *
+     * This requires driver support (e.g. KHR_parallel_shader_compile with OpenGL), without it
+     * this setting has no effect. Disabled by default.
+     */
+    void setAsynchronousShaderCompilation(bool enabled) noexcept;
+
+    /**
+     * Returns the counters of the backend's graphics pipeline cache, as of the last frame, e.g.
+     * to check that Renderer::warmUp() created the pipelines a scene needs. They are all zero on
+     * backends that don't cache pipelines.
+     */
+    PipelineCacheStats getPipelineCacheStats() noexcept;
+
     /**
      * Allocate a small amount of memory directly in the command stream. The allocated memory is
      * guaranteed to be preserved until the current command buffer is executed
@@ -133,6 +133,56 @@ public:
      */
     MaterialInstance* createInstance(const char* name = nullptr) const noexcept;
 
+    using CompilationCallback = void(*)(Material* material, void* user);
+
+    /**
+     * Asynchronously compiles the variants of this material that can be needed when the given
+     * features are in use, so that they are ready before they're first drawn. Without this,
+     * each variant is compiled the first time it is needed, which can cause hitches.
+     *
+     * Depth variants are always included. The work is submitted with the next Engine::flush()
+     * or Renderer::endFrame(), and the shaders compile on the driver's own threads when it has
+     * them.
+     *
+     * @param variants  Features whose variants should be compiled, see UserVariantFilterBit.
+     * @param callback  Optional callback, invoked on the application thread during a later
+     *                  Engine::flush(), Engine::flushAndWait() or Renderer::endFrame(), once
+     *                  all the programs are ready to be used. The material must not be destroyed
+     *                  before then.
+     * @param user      User data passed to the callback.
+     */
+    void compile(UserVariantFilterMask variants = UserVariantFilterMask(UserVariantFilterBit::ALL),
+            CompilationCallback callback = nullptr, void* user = nullptr) noexcept;
+
+    /**
+     * Enables or disables the recording of the variants this material is rendered with.
+     * Recording is meant for profiling sessions: the recorded variants of all materials can be
+     * exported with exportVariantUsage() and given to matc's --variant-usage option, which then
+     * only generates these variants. Disabled by default.
+     */
+    void setVariantRecording(bool enabled) noexcept;
+
+    /**
+     * Returns the variants recorded so far.
+     *
+     * @param variants  Array receiving up to \p count variant keys, can be null.
+     * @param count     Size of the \p variants array.
+     * @return The total number of recorded variants.
+     */
+    size_t getRecordedVariants(uint8_t* variants, size_t count) const noexcept;
+
+    //! Forgets the variants recorded so far.
+    void clearRecordedVariants() noexcept;
+
+    /**
+     * Writes the variants recorded for the given materials to a text file, one line per
+     * material that has recorded variants. Files from several sessions can be concatenated.
+     *
+     * @return true on success.
+     */
+    static bool exportVariantUsage(const char* path,
+            Material const* const* materials, size_t count) noexcept;
+
     //! Returns the name of this material as a null-terminated string.
     const char* getName() const noexcept;
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//! \file
+
+#ifndef TNT_FILAMENT_MORPHTARGETBUFFER_H
+#define TNT_FILAMENT_MORPHTARGETBUFFER_H
+
+#include <filament/FilamentAPI.h>
+
+#include <math/mathfwd.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class FMorphTargetBuffer;
+
+class Engine;
+
+/**
+ * Storage for any number of morph targets of a primitive.
+ *
+ * Morph targets set up as vertex attributes are limited to 4 per primitive. A MorphTargetBuffer
+ * instead holds the positions and tangents of all the targets of a primitive in a texture, which
+ * the vertex shader blends using the weights given to RenderableManager::setMorphWeights(). The
+ * blended targets are not rebound when the weights change, regardless of how many are active.
+ *
+ * A MorphTargetBuffer is attached to a primitive with
+ * RenderableManager::Builder::morphing(size_t, MorphTargetBuffer*), or later with
+ * RenderableManager::setMorphTargetBufferAt() if the renderable was created with morphing enabled.
+ * Materials must use 7 samplers or fewer to render primitives that use a MorphTargetBuffer.
+ *
+ * The MorphTargetBuffer must outlive all renderables that reference it.
+ *
+ * @see RenderableManager
+ */
+class UTILS_PUBLIC MorphTargetBuffer : public FilamentAPI {
+    struct BuilderDetails;
+
+public:
+    class Builder : public BuilderBase<BuilderDetails> {
+        friend struct BuilderDetails;
+    public:
+        Builder() noexcept;
+        Builder(Builder const& rhs) noexcept;
+        Builder(Builder&& rhs) noexcept;
+        ~Builder() noexcept;
+        Builder& operator=(Builder const& rhs) noexcept;
+        Builder& operator=(Builder&& rhs) noexcept;
+
+        /**
+         * Size of the morph targets in vertices, this must match the vertex count of the
+         * primitives that use this MorphTargetBuffer.
+         *
+         * @param vertexCount Number of vertices of each morph target.
+         * @return A reference to this Builder for chaining calls.
+         */
+        Builder& vertexCount(size_t vertexCount) noexcept;
+
+        /**
+         * Number of morph targets in this buffer.
+         *
+         * @param count Number of morph targets, up to 256.
+         * @return A reference to this Builder for chaining calls.
+         */
+        Builder& count(size_t count) noexcept;
+
+        /**
+         * Creates the MorphTargetBuffer object and returns a pointer to it.
+         *
+         * @param engine Reference to the filament::Engine to associate this MorphTargetBuffer
+         *               with.
+         *
+         * @return pointer to the newly created object or nullptr if exceptions are disabled and
+         *         an error occurred.
+         *
+         * @exception utils::PostConditionPanic if a runtime error occurred, such as running out of
+         *            memory or other resources.
+         * @exception utils::PreConditionPanic if a parameter to a builder function was invalid.
+         */
+        MorphTargetBuffer* build(Engine& engine);
+    private:
+        friend class FMorphTargetBuffer;
+    };
+
+    /**
+     * Updates the position deltas of a morph target. Vertices past count are left unmorphed.
+     *
+     * @param engine Reference to the filament::Engine associated with this MorphTargetBuffer.
+     * @param targetIndex index of the morph target to update
+     * @param positions pointer to at least count position deltas
+     * @param count number of elements in positions, at most getVertexCount()
+     */
+    void setPositionsAt(Engine& engine, size_t targetIndex,
+            math::float3 const* positions, size_t count);
+
+    /**
+     * Updates the position deltas of a morph target. Vertices past count are left unmorphed.
+     * The w component of the positions is ignored.
+     *
+     * @param engine Reference to the filament::Engine associated with this MorphTargetBuffer.
+     * @param targetIndex index of the morph target to update
+     * @param positions pointer to at least count position deltas
+     * @param count number of elements in positions, at most getVertexCount()
+     */
+    void setPositionsAt(Engine& engine, size_t targetIndex,
+            math::float4 const* positions, size_t count);
+
+    /**
+     * Updates the tangents of a morph target, encoded as quaternions in the same way as the
+     * \c TANGENTS vertex attribute. Targets without tangents don't affect the normals.
+     *
+     * @param engine Reference to the filament::Engine associated with this MorphTargetBuffer.
+     * @param targetIndex index of the morph target to update
+     * @param tangents pointer to at least count normalized quaternions
+     * @param count number of elements in tangents, at most getVertexCount()
+     */
+    void setTangentsAt(Engine& engine, size_t targetIndex,
+            math::short4 const* tangents, size_t count);
+
+    /**
+     * Returns the vertex count of this MorphTargetBuffer.
+     * @return The number of vertices the MorphTargetBuffer holds.
+     */
+    size_t getVertexCount() const noexcept;
+
+    /**
+     * Returns the target count of this MorphTargetBuffer.
+     * @return The number of targets the MorphTargetBuffer holds.
+     */
+    size_t getCount() const noexcept;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_MORPHTARGETBUFFER_H
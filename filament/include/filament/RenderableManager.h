@@ -40,7 +40,9 @@ class Engine;
 class IndexBuffer;
 class Material;
 class MaterialInstance;
+class MorphTargetBuffer;
 class Renderer;
+class SkinningBuffer;
 class VertexBuffer;
 
 class FEngine;
@@ -240,22 +242,39 @@ public:
         Builder& screenSpaceContactShadows(bool enable) noexcept;
 
         /**
-         * Enables GPU vertex skinning for up to 255 bones, 0 by default.
+         * Enables GPU vertex skinning for up to 65536 bones, 0 by default.
          *
          * Each vertex can be affected by up to 4 bones simultaneously. The attached
          * VertexBuffer must provide data in the \c BONE_INDICES slot (uvec4) and the
          * \c BONE_WEIGHTS slot (float4).
          *
+         * Skeletons with more than 256 bones are stored in a texture rather than in a uniform
+         * buffer, which requires the material to use at most 8 samplers.
+         *
          * See also RenderableManager::setBones(), which can be called on a per-frame basis
          * to advance the animation.
          *
-         * @param boneCount 0 to disable, otherwise the number of bone transforms (up to 255)
+         * @param boneCount 0 to disable, otherwise the number of bone transforms (up to 65536)
          * @param transforms the initial set of transforms (one for each bone)
          */
         Builder& skinning(size_t boneCount, math::mat4f const* transforms) noexcept;
         Builder& skinning(size_t boneCount, Bone const* bones) noexcept; //!< \overload
         Builder& skinning(size_t boneCount) noexcept; //!< \overload
 
+        /**
+         * Enables GPU vertex skinning using bones from a SkinningBuffer, which can be shared
+         * with other renderables. Unlike the other overloads, this does not allocate storage
+         * for a private set of bones.
+         *
+         * @param skinningBuffer the SkinningBuffer holding the bone transforms, which must
+         *                       outlive this renderable
+         * @param count number of bones used by this renderable, must not exceed the size of
+         *              the SkinningBuffer
+         *
+         * @see SkinningBuffer, RenderableManager::setSkinningBuffer()
+         */
+        Builder& skinning(SkinningBuffer* skinningBuffer, size_t count) noexcept;
+
         /**
          * Controls if the renderable has vertex morphing targets, false by default.
          *
@@ -267,6 +286,24 @@ public:
          */
         Builder& morphing(bool enable) noexcept;
 
+        /**
+         * Blends any number of morph targets stored in a MorphTargetBuffer on the given
+         * primitive, and enables morphing on the renderable. Vertex attribute morph targets are
+         * ignored on renderables that use a MorphTargetBuffer.
+         *
+         * Renderables with morphing enabled can have at most 256 primitives.
+         *
+         * See also RenderableManager::setMorphWeights(Instance, float const*, size_t, size_t),
+         * which can be called on a per-frame basis to advance the animation.
+         *
+         * @param index 0-based index of the primitive, must be less than 256
+         * @param morphTargetBuffer the morph targets of the primitive, which must outlive this
+         *                          renderable and match the vertex count of its VertexBuffer
+         *
+         * @see MorphTargetBuffer, RenderableManager::setMorphTargetBufferAt()
+         */
+        Builder& morphing(size_t index, MorphTargetBuffer* morphTargetBuffer) noexcept;
+
         /**
          * Sets an ordering index for blended primitives that all live at the same Z value.
          *
@@ -309,6 +346,7 @@ public:
             MaterialInstance const* materialInstance = nullptr;
             PrimitiveType type = PrimitiveType::TRIANGLES;
             uint16_t blendOrder = 0;
+            MorphTargetBuffer* morphTargetBuffer = nullptr;
         };
     };
 
@@ -390,6 +428,22 @@ public:
     void setBones(Instance instance, Bone const* transforms, size_t boneCount = 1, size_t offset = 0) noexcept;
     void setBones(Instance instance, math::mat4f const* transforms, size_t boneCount = 1, size_t offset = 0) noexcept; //!< \overload
 
+    /**
+     * Associates a SkinningBuffer with a renderable that was created with skinning enabled,
+     * replacing its own set of bones (if any). From then on, setBones() has no effect on this
+     * renderable and the bones must be updated through the SkinningBuffer.
+     *
+     * @param instance the renderable of interest
+     * @param skinningBuffer the SkinningBuffer holding the bone transforms, which must outlive
+     *                       this renderable
+     * @param count number of bones used by this renderable, must not exceed the size of the
+     *              SkinningBuffer
+     *
+     * @see Builder::skinning(), SkinningBuffer
+     */
+    void setSkinningBuffer(Instance instance, SkinningBuffer* skinningBuffer,
+            size_t count) noexcept;
+
     /**
      * Updates the vertex morphing weights on a renderable, all zeroes by default.
      *
@@ -400,6 +454,35 @@ public:
      */
     void setMorphWeights(Instance instance, math::float4 const& weights) noexcept;
 
+    /**
+     * Updates the weights of the morph targets stored in MorphTargetBuffers, in the range
+     * [offset, offset + count), all zeroes by default. Weight i applies to the morph target i
+     * of each primitive's MorphTargetBuffer.
+     *
+     * @param instance the renderable of interest
+     * @param weights pointer to at least count weights
+     * @param count number of weights
+     * @param offset index of the first morph target to update, offset + count must not exceed 256
+     *
+     * @see Builder::morphing(size_t, MorphTargetBuffer*)
+     */
+    void setMorphWeights(Instance instance, float const* weights, size_t count,
+            size_t offset = 0) noexcept;
+
+    /**
+     * Associates a MorphTargetBuffer with a primitive of a renderable that was created with
+     * morphing enabled.
+     *
+     * @param instance the renderable of interest
+     * @param primitiveIndex 0-based index of the primitive, must be less than 256
+     * @param morphTargetBuffer the morph targets of the primitive, which must outlive this
+     *                          renderable
+     *
+     * @see Builder::morphing(size_t, MorphTargetBuffer*), MorphTargetBuffer
+     */
+    void setMorphTargetBufferAt(Instance instance, size_t primitiveIndex,
+            MorphTargetBuffer* morphTargetBuffer) noexcept;
+
     /**
      * Gets the bounding box used for frustum culling.
      *
@@ -308,6 +308,33 @@ public:
      */
     void render(View const* view);
 
+    /**
+     * Renders a View like render() does, except that the draw calls of its renderables are
+     * replaced by requests to create the graphics pipelines they need. This avoids hitches the
+     * first time a scene is shown on backends that create pipelines lazily, such as Vulkan.
+     *
+     * Everything else still runs, and costs about as much as in render(): culling, shadow maps,
+     * clears, post-processing and the final output to the View's render target or to the swap
+     * chain. The View's viewport is therefore left cleared and post-processed, and its previous
+     * contents are lost. Like render(), it applies the Renderer's ClearOptions when it's the
+     * first View of the frame. On backends that don't create pipelines lazily, warmUp() only
+     * has this cost.
+     *
+     * This is typically called during a loading screen, for the View that will be shown next,
+     * before rendering the Views that are actually displayed over it in the same frame, or with
+     * a View that renders into an off-screen RenderTarget. Material::compile() can be used
+     * beforehand so that the programs are ready.
+     *
+     * @param view A pointer to the view to warm up.
+     *
+     * @attention
+     * warmUp() must be called *after* beginFrame() and *before* endFrame().
+     *
+     * @see
+     * render(), Engine::getPipelineCacheStats(), Material::compile()
+     */
+    void warmUp(View const* view);
+
     /**
      * Copy the currently rendered view to the indicated swap chain, using the
      * indicated source and destination rectangle.
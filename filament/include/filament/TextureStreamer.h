@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//! \file
+
+#ifndef TNT_FILAMENT_TEXTURESTREAMER_H
+#define TNT_FILAMENT_TEXTURESTREAMER_H
+
+#include <filament/FilamentAPI.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+
+namespace filament {
+
+class Texture;
+
+/**
+ * TextureStreamer keeps in GPU memory only the mipmap levels of textures that are needed to
+ * render the current frames, within a memory budget.
+ *
+ * Every frame, the size on screen of each visible renderable gives the finest level needed by
+ * the textures its material instances sample. Levels that become needed are requested from the
+ * application through a callback, and the texture starts using them once they're all provided.
+ * Levels that aren't needed anymore stop being sampled right away and their memory is reclaimed
+ * when the texture is next reallocated.
+ *
+ * When the resident levels of all textures exceed the memory budget, the finest levels of the
+ * textures that weren't visible in the last frame are evicted first, then those of the visible
+ * textures with the lowest priority. The smallest levels of a texture, 64 texels or less, form
+ * its tail and are always resident.
+ *
+ * The TextureStreamer is obtained with Engine::getTextureStreamer(). It works from
+ * Renderer::beginFrame() and View preparation, therefore all its methods must be called from
+ * the engine's thread.
+ *
+ * Only 2D and cubemap textures can be streamed, they must not be imported, swizzled,
+ * multisampled or used as attachments of a RenderTarget. Since a streamed texture is reallocated
+ * when its resident levels change, only the MaterialInstances that sample it follow these
+ * changes: it must not be used by an IndirectLight or a Skybox.
+ *
+ * Example:
+ *
+ * ```
+ * void onLevelNeeded(Texture* texture, size_t level, void* user) {
+ *     // load the level, now or later, and provide it with Texture::setImage()
+ * }
+ *
+ * Texture* texture = Texture::Builder()
+ *         .width(4096).height(4096).levels(13)
+ *         .build(*engine);
+ * TextureStreamer& streamer = engine->getTextureStreamer();
+ * streamer.setMemoryBudget(256 * 1024 * 1024);
+ * streamer.addTexture(texture, onLevelNeeded, loader);
+ * materialInstance->setParameter("baseColor", texture, sampler);
+ * ```
+ */
+class UTILS_PUBLIC TextureStreamer : public FilamentAPI {
+public:
+    /**
+     * Called when a level of a streamed texture must be provided, with the level's data given
+     * to Texture::setImage() in a single call, e.g. once it's loaded from disk. Data of levels
+     * that aren't needed anymore when they're provided is ignored.
+     *
+     * @param texture   the streamed texture
+     * @param level     the level needed
+     * @param user      the user pointer given to addTexture()
+     */
+    using LevelCallback = void(*)(Texture* texture, size_t level, void* user);
+
+    /**
+     * Starts streaming the levels of a texture. The texture is reallocated with only its tail,
+     * whose levels are requested from this call. Levels provided before this call are discarded,
+     * so textures are best added right after they're built.
+     *
+     * @param texture   2D or cubemap texture to stream, with all its levels
+     * @param callback  called when levels are needed
+     * @param user      user pointer given to the callback
+     */
+    void addTexture(Texture* texture, LevelCallback callback, void* user = nullptr);
+
+    /**
+     * Stops streaming a texture, which keeps its resident levels. Destroying a streamed texture
+     * removes it automatically.
+     */
+    void removeTexture(Texture* texture) noexcept;
+
+    /**
+     * Sets the priority of a streamed texture, 1 by default. Visible textures with lower
+     * priorities lose their finest levels first when the memory budget is exceeded.
+     */
+    void setPriority(Texture* texture, float priority) noexcept;
+
+    /**
+     * Returns the finest level of a texture that's in use, which is 0 unless the texture has been
+     * streamed.
+     */
+    size_t getResidentLevel(Texture const* texture) const noexcept;
+
+    /**
+     * Sets the GPU memory the streamed textures may use, unlimited by default. Tails of the
+     * textures are always resident, even when they exceed the budget.
+     *
+     * @param budget    budget in bytes
+     */
+    void setMemoryBudget(size_t budget) noexcept;
+
+    //! Returns the memory budget in bytes.
+    size_t getMemoryBudget() const noexcept;
+
+    /**
+     * Returns the GPU memory used by streamed textures in bytes, including levels that are being
+     * loaded.
+     */
+    size_t getResidentMemory() const noexcept;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_TEXTURESTREAMER_H
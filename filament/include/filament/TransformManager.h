@@ -247,6 +247,15 @@ public:
      * @see openLocalTransformTransaction(), setTransform()
      */
     void commitLocalTransformTransaction() noexcept;
+
+    /**
+     * Returns whether a local transform transaction is currently open. This lets code that
+     * updates many transforms at once, e.g. an animation system, open and commit its own
+     * transaction only when its caller didn't.
+     *
+     * @see openLocalTransformTransaction(), commitLocalTransformTransaction()
+     */
+    bool isLocalTransformTransactionOpen() const noexcept;
 };
 
 } // namespace filament
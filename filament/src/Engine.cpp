@@ -38,6 +38,8 @@
 #include "details/View.h"
 
 #include <private/filament/SibGenerator.h>
+#include <private/filament/UibGenerator.h>
+#include "private/backend/SamplerGroup.h"
 
 #include <filament/MaterialEnums.h>
 
@@ -172,6 +174,7 @@ FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext) :
         mTransformManager(),
         mLightManager(*this),
         mCameraManager(*this),
+        mTextureStreamer(*this),
         mCommandBufferQueue(CONFIG_MIN_COMMAND_BUFFERS_SIZE, CONFIG_COMMAND_BUFFERS_SIZE),
         mPerRenderPassAllocator("per-renderpass allocator", CONFIG_PER_RENDER_PASS_ARENA_SIZE),
         mEngineEpoch(std::chrono::steady_clock::now()),
@@ -235,6 +238,30 @@ void FEngine::init() {
     Texture::FaceOffsets offsets = {};
     mDefaultIblTexture->setImage(*this, 0, std::move(buffer), offsets);
 
+    // Skinned renderables whose bones live in a texture still need a bones uniform buffer, and
+    // every other renderable still needs a bones texture and morph target data, because the
+    // skinning variant declares all of them. These are bound when the real ones are not used.
+    mDummyBonesUbh = driverApi.createUniformBuffer(
+            CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone), BufferUsage::STATIC);
+    mDummyBonesTexture = driverApi.createTexture(SamplerType::SAMPLER_2D, 1,
+            TextureFormat::RGBA32F, 1, 1, 1, 1, TextureUsage::DEFAULT);
+    SamplerGroup bonesSamplers(PerRenderableBonesSib::SAMPLER_COUNT);
+    bonesSamplers.setSampler(PerRenderableBonesSib::TRANSFORMS, mDummyBonesTexture, {});
+    mDummyBonesSbh = driverApi.createSamplerGroup(bonesSamplers.getSize());
+    driverApi.updateSamplerGroup(mDummyBonesSbh, std::move(bonesSamplers.toCommandStream()));
+
+    mDummyMorphingUbh = driverApi.createUniformBuffer(
+            sizeof(PerRenderableMorphingUib), BufferUsage::STATIC);
+    static const PerRenderableMorphingUib noMorphing{};
+    driverApi.loadUniformBuffer(mDummyMorphingUbh, { &noMorphing, sizeof(noMorphing) });
+    mDummyMorphingTexture = driverApi.createTexture(SamplerType::SAMPLER_2D_ARRAY, 1,
+            TextureFormat::RGBA32F, 1, 1, 2, 1, TextureUsage::DEFAULT);
+    SamplerGroup morphingSamplers(PerRenderableMorphingSib::SAMPLER_COUNT);
+    morphingSamplers.setSampler(PerRenderableMorphingSib::TARGETS, mDummyMorphingTexture, {});
+    mDummyMorphingSbh = driverApi.createSamplerGroup(morphingSamplers.getSize());
+    driverApi.updateSamplerGroup(mDummyMorphingSbh,
+            std::move(morphingSamplers.toCommandStream()));
+
     // 3 bands = 9 float3
     const float sh[9 * 3] = { 0.0f };
     mDefaultIbl = upcast(IndirectLight::Builder()
@@ -291,6 +318,7 @@ void FEngine::shutdown() {
     mRenderableManager.terminate();         // free-up all renderables
     mLightManager.terminate();              // free-up all lights
     mCameraManager.terminate();             // free-up all cameras
+    mTextureStreamer.terminate();           // free-up textures being streamed in
 
     driver.destroyRenderPrimitive(mFullScreenTriangleRph);
     destroy(mFullScreenTriangleIb);
@@ -299,6 +327,13 @@ void FEngine::shutdown() {
     destroy(mDefaultIblTexture);
     destroy(mDefaultIbl);
 
+    driver.destroySamplerGroup(mDummyBonesSbh);
+    driver.destroyTexture(mDummyBonesTexture);
+    driver.destroyUniformBuffer(mDummyBonesUbh);
+    driver.destroySamplerGroup(mDummyMorphingSbh);
+    driver.destroyTexture(mDummyMorphingTexture);
+    driver.destroyUniformBuffer(mDummyMorphingUbh);
+
     destroy(mDefaultColorGrading);
 
     destroy(mDefaultMaterial);
@@ -320,6 +355,8 @@ void FEngine::shutdown() {
     destroy(mSkyboxMaterial);
 
     cleanupResourceList(mBufferObjects);
+    cleanupResourceList(mSkinningBuffers);
+    cleanupResourceList(mMorphTargetBuffers);
     cleanupResourceList(mIndexBuffers);
     cleanupResourceList(mVertexBuffers);
     cleanupResourceList(mTextures);
@@ -369,6 +406,10 @@ void FEngine::prepare() {
     // UBOs that are visible only. It's not such a big issue because the actual upload() is
     // skipped is the UBO hasn't changed. Still we could have a lot of these.
     FEngine::DriverApi& driver = getDriverApi();
+
+    // this may rebind textures in material instances, so it must happen before they're committed
+    mTextureStreamer.update();
+
     for (auto& materialInstanceList : mMaterialInstances) {
         for (const auto& item : materialInstanceList.second) {
             item->commit(driver);
@@ -381,6 +422,18 @@ void FEngine::prepare() {
     }
 }
 
+void FEngine::replaceTexture(backend::Handle<backend::HwTexture> from,
+        backend::Handle<backend::HwTexture> to) noexcept {
+    for (auto& materialInstanceList : mMaterialInstances) {
+        for (const auto& item : materialInstanceList.second) {
+            item->replaceTexture(from, to);
+        }
+    }
+    for (const auto& material : mMaterials) {
+        material->getDefaultInstance()->replaceTexture(from, to);
+    }
+}
+
 void FEngine::gc() {
     // Note: this runs in a Job
 
@@ -552,6 +605,15 @@ FBufferObject* FEngine::createBufferObject(const BufferObject::Builder& builder)
     return create(mBufferObjects, builder);
 }
 
+FSkinningBuffer* FEngine::createSkinningBuffer(const SkinningBuffer::Builder& builder) noexcept {
+    return create(mSkinningBuffers, builder);
+}
+
+FMorphTargetBuffer* FEngine::createMorphTargetBuffer(
+        const MorphTargetBuffer::Builder& builder) noexcept {
+    return create(mMorphTargetBuffers, builder);
+}
+
 FVertexBuffer* FEngine::createVertexBuffer(const VertexBuffer::Builder& builder) noexcept {
     return create(mVertexBuffers, builder);
 }
@@ -734,6 +796,14 @@ bool FEngine::destroy(const FBufferObject* p) {
     return terminateAndDestroy(p, mBufferObjects);
 }
 
+bool FEngine::destroy(const FSkinningBuffer* p) {
+    return terminateAndDestroy(p, mSkinningBuffers);
+}
+
+bool FEngine::destroy(const FMorphTargetBuffer* p) {
+    return terminateAndDestroy(p, mMorphTargetBuffers);
+}
+
 bool FEngine::destroy(const FVertexBuffer* p) {
     return terminateAndDestroy(p, mVertexBuffers);
 }
@@ -899,6 +969,14 @@ Backend Engine::getBackend() const noexcept {
     return upcast(this)->getBackend();
 }
 
+void Engine::setAsynchronousShaderCompilation(bool enabled) noexcept {
+    upcast(this)->setAsynchronousShaderCompilation(enabled);
+}
+
+Engine::PipelineCacheStats Engine::getPipelineCacheStats() noexcept {
+    return upcast(this)->getDriverApi().getPipelineCacheStats();
+}
+
 Renderer* Engine::createRenderer() noexcept {
     return upcast(this)->createRenderer();
 }
@@ -939,6 +1017,14 @@ bool Engine::destroy(const BufferObject* p) {
     return upcast(this)->destroy(upcast(p));
 }
 
+bool Engine::destroy(const SkinningBuffer* p) {
+    return upcast(this)->destroy(upcast(p));
+}
+
+bool Engine::destroy(const MorphTargetBuffer* p) {
+    return upcast(this)->destroy(upcast(p));
+}
+
 bool Engine::destroy(const VertexBuffer* p) {
     return upcast(this)->destroy(upcast(p));
 }
@@ -1023,6 +1109,10 @@ TransformManager& Engine::getTransformManager() noexcept {
     return upcast(this)->getTransformManager();
 }
 
+TextureStreamer& Engine::getTextureStreamer() noexcept {
+    return upcast(this)->getTextureStreamer();
+}
+
 void* Engine::streamAlloc(size_t size, size_t alignment) noexcept {
     return upcast(this)->streamAlloc(size, alignment);
 }
@@ -201,9 +201,14 @@ void RenderPass::recordDriverCommands(FEngine::DriverApi& driver, const Command*
                 mPolygonOffsetOverride ? &dummyPolyOffset : &pipeline.polygonOffset;
 
         Handle<HwUniformBuffer> uboHandle = mUboHandle;
+        auto const* const UTILS_RESTRICT soaBonesSbh = mRenderableSoa->data<FScene::BONES_SBH>();
+        auto const* const UTILS_RESTRICT soaMorphingUbh =
+                mRenderableSoa->data<FScene::MORPHING_UBH>();
+        auto const* const UTILS_RESTRICT soaPrimitives = mRenderableSoa->data<FScene::PRIMITIVES>();
         FMaterialInstance const* UTILS_RESTRICT mi = nullptr;
         FMaterial const* UTILS_RESTRICT ma = nullptr;
         auto const& customCommands = mCustomCommands;
+        const bool warmUpOnly = mFlags & WARM_UP_ONLY;
 
         first--;
         while (++first != last) {
@@ -236,8 +241,28 @@ void RenderPass::recordDriverCommands(FEngine::DriverApi& driver, const Command*
             if (UTILS_UNLIKELY(info.perRenderableBones)) {
                 driver.bindUniformBuffer(BindingPoints::PER_RENDERABLE_BONES,
                         info.perRenderableBones);
+                // large skeletons also need their bones texture, there is no room for its
+                // handle in PrimitiveInfo so we look it up in the scene.
+                Handle<HwSamplerGroup> bonesSbh = soaBonesSbh[info.index];
+                if (UTILS_UNLIKELY(bonesSbh)) {
+                    driver.bindSamplers(BindingPoints::PER_RENDERABLE_BONES, bonesSbh);
+                }
+                // same for the weights of the renderable and the MorphTargetBuffer of the
+                // primitive, primitives without one get the engine's empty buffer.
+                Handle<HwUniformBuffer> morphingUbh = soaMorphingUbh[info.index];
+                if (UTILS_UNLIKELY(morphingUbh)) {
+                    Handle<HwSamplerGroup> morphingSbh =
+                            soaPrimitives[info.index][info.primitiveIndex].getMorphTargetBuffer();
+                    driver.bindUniformBuffer(BindingPoints::PER_RENDERABLE_MORPHING, morphingUbh);
+                    driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING, morphingSbh ?
+                            morphingSbh : mEngine.getDummyMorphingSamplerGroup());
+                }
+            }
+            if (UTILS_UNLIKELY(warmUpOnly)) {
+                driver.warmUpPipeline(pipeline, info.primitiveHandle);
+            } else {
+                driver.draw(pipeline, info.primitiveHandle);
             }
-            driver.draw(pipeline, info.primitiveHandle);
         }
         mCustomCommands.clear();
     }
@@ -455,8 +480,12 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
          */
         for (auto const& primitive : primitives) {
             FMaterialInstance const* const mi = primitive.getMaterialInstance();
+            // only used to find the MorphTargetBuffer, renderables with morphing enabled have
+            // at most 256 primitives (see RenderableManager::Builder::build)
+            const uint8_t primitiveIndex = uint8_t(&primitive - primitives.data());
             if (isColorPass) {
                 cmdColor.primitive.primitiveHandle = primitive.getHwHandle();
+                cmdColor.primitive.primitiveIndex = primitiveIndex;
                 cmdColor.primitive.materialVariant = materialVariant;
                 RenderPass::setupColorCommand(cmdColor, mi, inverseFrontFaces);
 
@@ -541,6 +570,7 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
 
                 // unconditionally write the command
                 cmdDepth.primitive.primitiveHandle = primitive.getHwHandle();
+                cmdDepth.primitive.primitiveIndex = primitiveIndex;
                 cmdDepth.primitive.mi = mi;
                 cmdDepth.primitive.rasterState.culling = mi->getCullingMode();
                 *curr = cmdDepth;
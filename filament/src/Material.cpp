@@ -34,9 +34,15 @@
 
 #include <MaterialParser.h>
 
+#include <utils/algorithm.h>
 #include <utils/CString.h>
+#include <utils/Hash.h>
+#include <utils/Log.h>
 #include <utils/Panic.h>
 
+#include <stdio.h>
+#include <string.h>
+
 using namespace utils;
 using namespace filaflat;
 
@@ -127,6 +133,11 @@ Material* Material::Builder::build(Engine& engine) {
     return upcast(engine).createMaterial(*this);
 }
 
+static uint64_t computeCacheId(const void* payload, size_t size) noexcept {
+    // 0 means "don't cache"
+    return hash::murmur3_64(payload, size) | 1u;
+}
+
 static void addSamplerGroup(Program& pb, uint8_t bindingPoint, SamplerInterfaceBlock const& sib,
         SamplerBindingMap const& map) {
     const size_t samplerCount = sib.getSize();
@@ -154,6 +165,10 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
     MaterialParser* parser = builder->mMaterialParser;
     mMaterialParser = parser;
 
+    if (engine.hasBlobCache()) {
+        mCacheId = computeCacheId(builder->mPayload, builder->mSize);
+    }
+
     UTILS_UNUSED_IN_RELEASE bool nameOk = parser->getName(&mName);
     assert_invariant(nameOk);
 
@@ -289,7 +304,7 @@ FMaterial::FMaterial(FEngine& engine, const Material::Builder& builder)
         auto& cachedPrograms = mCachedPrograms;
         for (uint8_t i = 0, n = cachedPrograms.size(); i < n; ++i) {
             if (Variant(i).isDepthPass()) {
-                cachedPrograms[i] = engine.getDefaultMaterial()->getProgram(i);
+                cachedPrograms[i] = engine.getDefaultMaterial()->getCachedProgram(i);
             }
         }
     }
@@ -342,6 +357,12 @@ bool FMaterial::isSampler(const char* name) const noexcept {
     return mSamplerInterfaceBlock.hasSampler(name);
 }
 
+bool FMaterial::hasBonesTexture() const noexcept {
+    uint8_t binding;
+    return mSamplerBindings.getSamplerBinding(BindingPoints::PER_RENDERABLE_BONES,
+            PerRenderableBonesSib::TRANSFORMS, &binding);
+}
+
 UniformInterfaceBlock::UniformInfo const* FMaterial::reflect(
         utils::StaticString const& name) const noexcept {
     auto const& list = mUniformInterfaceBlock.getUniformInfoList();
@@ -369,6 +390,11 @@ Handle<HwProgram> FMaterial::getSurfaceProgramSlow(uint8_t variantKey)
 
     assert_invariant(!Variant::isReserved(variantKey));
 
+    // the program is built from the closest variant that the material was built with, and
+    // cached under the requested key
+    const uint8_t cacheKey = variantKey;
+    variantKey = getFallbackVariant(variantKey);
+
     uint8_t vertexVariantKey = Variant::filterVariantVertex(variantKey);
     uint8_t fragmentVariantKey = Variant::filterVariantFragment(variantKey);
 
@@ -384,12 +410,73 @@ Handle<HwProgram> FMaterial::getSurfaceProgramSlow(uint8_t variantKey)
     if (Variant(variantKey).hasSkinningOrMorphing()) {
         pb.setUniformBlock(BindingPoints::PER_RENDERABLE_BONES,
                 UibGenerator::getPerRenderableBonesUib().getName());
+        // the bones texture is only available if the material leaves a sampler free for it
+        uint8_t binding;
+        if (mSamplerBindings.getSamplerBinding(BindingPoints::PER_RENDERABLE_BONES,
+                PerRenderableBonesSib::TRANSFORMS, &binding)) {
+            addSamplerGroup(pb, BindingPoints::PER_RENDERABLE_BONES,
+                    SibGenerator::getPerRenderableBonesSib(), mSamplerBindings);
+        }
+        // same for MorphTargetBuffers, which also come with their own weights
+        if (mSamplerBindings.getSamplerBinding(BindingPoints::PER_RENDERABLE_MORPHING,
+                PerRenderableMorphingSib::TARGETS, &binding)) {
+            pb.setUniformBlock(BindingPoints::PER_RENDERABLE_MORPHING,
+                    UibGenerator::getPerRenderableMorphingUib().getName());
+            addSamplerGroup(pb, BindingPoints::PER_RENDERABLE_MORPHING,
+                    SibGenerator::getPerRenderableMorphingSib(), mSamplerBindings);
+        }
     }
 
     addSamplerGroup(pb, BindingPoints::PER_VIEW, SibGenerator::getPerViewSib(variantKey), mSamplerBindings);
     addSamplerGroup(pb, BindingPoints::PER_MATERIAL_INSTANCE, mSamplerInterfaceBlock, mSamplerBindings);
 
-    return createAndCacheProgram(std::move(pb), variantKey);
+    return createAndCacheProgram(std::move(pb), cacheKey);
+}
+
+uint8_t FMaterial::getFallbackVariant(uint8_t variantKey) const noexcept {
+    const ShaderModel sm = mEngine.getDriver().getShaderModel();
+    auto hasVariant = [this, sm](uint8_t key) {
+        return mMaterialParser->hasShader(sm, Variant::filterVariantVertex(key), ShaderType::VERTEX) &&
+               mMaterialParser->hasShader(sm, Variant::filterVariantFragment(key), ShaderType::FRAGMENT);
+    };
+    if (UTILS_LIKELY(mEngine.getBackend() == Backend::NOOP || hasVariant(variantKey))) {
+        return variantKey;
+    }
+
+    // Packages built from a variant usage profile only contain the recorded variants, plus the
+    // base and depth variants. Fall back to the variant that keeps the most features, but never
+    // cross between depth and color variants.
+    const uint8_t features = variantKey & ~Variant::DEPTH;
+    uint8_t fallback = variantKey & Variant::DEPTH;
+    int bestCount = -1;
+    for (uint8_t subset = features; ; subset = (subset - 1u) & features) {
+        const uint8_t key = subset | (variantKey & Variant::DEPTH);
+        const int count = int(utils::popcount(subset));
+        if (count > bestCount && !Variant::isReserved(key) && hasVariant(key)) {
+            fallback = key;
+            bestCount = count;
+        }
+        if (!subset) {
+            break;
+        }
+    }
+
+    slog.w << "Material '" << mName.c_str() << "' was not built with variant 0x" << io::hex
+           << +variantKey << ", using 0x" << +fallback << " instead" << io::dec << io::endl;
+    return fallback;
+}
+
+size_t FMaterial::getRecordedVariants(uint8_t* variants, size_t count) const noexcept {
+    size_t total = 0;
+    for (size_t k = 0; k < VARIANT_COUNT; k++) {
+        if (mRecordedVariants[k]) {
+            if (variants && total < count) {
+                variants[total] = uint8_t(k);
+            }
+            total++;
+        }
+    }
+    return total;
 }
 
 Handle<HwProgram> FMaterial::getPostProcessProgramSlow(uint8_t variantKey)
@@ -405,6 +492,53 @@ Handle<HwProgram> FMaterial::getPostProcessProgramSlow(uint8_t variantKey)
     return createAndCacheProgram(std::move(pb), variantKey);
 }
 
+void FMaterial::compile(UserVariantFilterMask variants,
+        CompilationCallback callback, void* user) noexcept {
+    // the public bits match the variant keys, the depth variants are always included
+    static_assert(uint32_t(UserVariantFilterBit::DIRECTIONAL_LIGHTING) == Variant::DIRECTIONAL_LIGHTING);
+    static_assert(uint32_t(UserVariantFilterBit::DYNAMIC_LIGHTING) == Variant::DYNAMIC_LIGHTING);
+    static_assert(uint32_t(UserVariantFilterBit::SHADOW_RECEIVER) == Variant::SHADOW_RECEIVER);
+    static_assert(uint32_t(UserVariantFilterBit::SKINNING) == Variant::SKINNING_OR_MORPHING);
+    static_assert(uint32_t(UserVariantFilterBit::FOG) == Variant::FOG);
+    static_assert(uint32_t(UserVariantFilterBit::VSM) == Variant::VSM);
+
+    const uint32_t allowed = (variants & uint32_t(UserVariantFilterBit::ALL)) | Variant::DEPTH;
+    const ShaderModel sm = mEngine.getDriver().getShaderModel();
+    const bool isPostProcess = mMaterialDomain == MaterialDomain::POST_PROCESS;
+    const bool isNoop = mEngine.getBackend() == Backend::NOOP;
+
+    for (size_t k = 0; k < VARIANT_COUNT; k++) {
+        const uint8_t key = uint8_t(k);
+        if (mCachedPrograms[key] || (key & ~allowed)) {
+            continue;
+        }
+        if (!isPostProcess) {
+            if (Variant::isReserved(key) || Variant::filterVariant(key, mIsVariantLit) != key) {
+                continue;
+            }
+        }
+        // only the variants that the material was actually built with can be compiled
+        const uint8_t vertexKey = isPostProcess ? key : Variant::filterVariantVertex(key);
+        const uint8_t fragmentKey = isPostProcess ? key : Variant::filterVariantFragment(key);
+        if (!isNoop && (!mMaterialParser->hasShader(sm, vertexKey, ShaderType::VERTEX) ||
+                !mMaterialParser->hasShader(sm, fragmentKey, ShaderType::FRAGMENT))) {
+            continue;
+        }
+        getCachedProgram(key);
+    }
+
+    struct Args {
+        CompilationCallback callback;
+        Material* material;
+        void* user;
+    };
+    mEngine.getDriverApi().compilePrograms(callback ? +[](void* user) {
+        Args* const args = static_cast<Args*>(user);
+        args->callback(args->material, args->user);
+        delete args;
+    } : nullptr, callback ? new Args{ callback, this, user } : nullptr);
+}
+
 Program FMaterial::getProgramBuilderWithVariants(
         uint8_t variantKey,
         uint8_t vertexVariantKey,
@@ -442,6 +576,7 @@ Program FMaterial::getProgramBuilderWithVariants(
 
     Program pb;
     pb      .diagnostics(mName, variantKey)
+            .cacheId(mCacheId)
             .withVertexShader(vsBuilder.data(), vsBuilder.size())
             .withFragmentShader(fsBuilder.data(), fsBuilder.size());
     return pb;
@@ -514,6 +649,8 @@ void FMaterial::applyPendingEdits() noexcept {
     delete mMaterialParser;
     mMaterialParser = mPendingEdits;
     mPendingEdits = nullptr;
+    // the edited package doesn't match the cached programs anymore
+    mCacheId = 0;
 }
 
 /**
@@ -572,6 +709,49 @@ MaterialInstance* Material::createInstance(const char* name) const noexcept {
     return upcast(this)->createInstance(name);
 }
 
+void Material::compile(UserVariantFilterMask variants,
+        CompilationCallback callback, void* user) noexcept {
+    upcast(this)->compile(variants, callback, user);
+}
+
+void Material::setVariantRecording(bool enabled) noexcept {
+    upcast(this)->setVariantRecording(enabled);
+}
+
+size_t Material::getRecordedVariants(uint8_t* variants, size_t count) const noexcept {
+    return upcast(this)->getRecordedVariants(variants, count);
+}
+
+void Material::clearRecordedVariants() noexcept {
+    upcast(this)->clearRecordedVariants();
+}
+
+bool Material::exportVariantUsage(const char* path,
+        Material const* const* materials, size_t count) noexcept {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        slog.e << "Unable to write variant usage to " << path << io::endl;
+        return false;
+    }
+    fprintf(file, "# material: variants\n");
+    for (size_t i = 0; i < count; i++) {
+        FMaterial const* material = upcast(materials[i]);
+        uint8_t variants[VARIANT_COUNT];
+        const size_t variantCount = material->getRecordedVariants(variants, VARIANT_COUNT);
+        if (variantCount == 0) {
+            continue;
+        }
+        fprintf(file, "%s:", material->getName().c_str());
+        for (size_t k = 0; k < variantCount; k++) {
+            fprintf(file, " 0x%02x", variants[k]);
+        }
+        fprintf(file, "\n");
+    }
+    const bool success = !ferror(file);
+    fclose(file);
+    return success;
+}
+
 const char* Material::getName() const noexcept {
     return upcast(this)->getName().c_str();
 }
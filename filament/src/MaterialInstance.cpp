@@ -286,6 +286,16 @@ void FMaterialInstance::setParameter(const char* name,
     mSamplers.setSampler(index, { texture, params });
 }
 
+void FMaterialInstance::replaceTexture(backend::Handle<backend::HwTexture> from,
+        backend::Handle<backend::HwTexture> to) noexcept {
+    backend::SamplerGroup::Sampler const* const samplers = mSamplers.getSamplers();
+    for (size_t i = 0, c = mSamplers.getSize(); i < c; i++) {
+        if (samplers[i].t == from) {
+            mSamplers.setSampler(i, { to, samplers[i].s });
+        }
+    }
+}
+
 void FMaterialInstance::setParameterImpl(const char* name,
         Texture const* texture, TextureSampler const& sampler) noexcept {
     setParameter(name, upcast(texture)->getHwHandle(), sampler.getSamplerParams());
@@ -98,6 +98,9 @@ ChunkContainer const& MaterialParser::getChunkContainer() const noexcept {
 MaterialParser::ParseResult MaterialParser::parse() noexcept {
     ChunkContainer& cc = getChunkContainer();
     if (cc.parse()) {
+        if (mImpl.mDictionaryTag == ChunkType::DictionaryText) {
+            mImpl.mDictionaryTag = DictionaryReader::getTextDictionaryTag(cc);
+        }
         if (!cc.hasChunk(mImpl.mMaterialTag) || !cc.hasChunk(mImpl.mDictionaryTag)) {
             return ParseResult::ERROR_MISSING_BACKEND;
         }
@@ -275,6 +278,11 @@ bool MaterialParser::getShader(ShaderBuilder& shader,
             mImpl.mBlobDictionary, (uint8_t)shaderModel, variant, stage);
 }
 
+bool MaterialParser::hasShader(ShaderModel shaderModel,
+        uint8_t variant, ShaderType stage) const noexcept {
+    return mImpl.mMaterialChunk.hasShader((uint8_t)shaderModel, variant, stage);
+}
+
 // ------------------------------------------------------------------------------------------------
 
 
@@ -93,6 +93,9 @@ public:
     bool getShader(filaflat::ShaderBuilder& shader, backend::ShaderModel shaderModel,
             uint8_t variant, backend::ShaderType stage) noexcept;
 
+    bool hasShader(backend::ShaderModel shaderModel,
+            uint8_t variant, backend::ShaderType stage) const noexcept;
+
 private:
     struct MaterialParserDetails {
         MaterialParserDetails(backend::Backend backend, const void* data, size_t size);
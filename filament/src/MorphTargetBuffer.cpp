@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/MorphTargetBuffer.h"
+
+#include "details/Engine.h"
+
+#include "FilamentAPI-impl.h"
+
+#include <private/filament/EngineEnums.h>
+#include <private/filament/SibGenerator.h>
+
+#include "private/backend/SamplerGroup.h"
+
+#include <utils/Panic.h>
+
+#include <math/vec3.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+struct MorphTargetBuffer::BuilderDetails {
+    size_t mVertexCount = 0;
+    size_t mCount = 0;
+};
+
+using BuilderType = MorphTargetBuffer;
+BuilderType::Builder::Builder() noexcept = default;
+BuilderType::Builder::~Builder() noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder&& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs) noexcept = default;
+
+MorphTargetBuffer::Builder& MorphTargetBuffer::Builder::vertexCount(size_t vertexCount) noexcept {
+    mImpl->mVertexCount = vertexCount;
+    return *this;
+}
+
+MorphTargetBuffer::Builder& MorphTargetBuffer::Builder::count(size_t count) noexcept {
+    mImpl->mCount = count;
+    return *this;
+}
+
+MorphTargetBuffer* MorphTargetBuffer::Builder::build(Engine& engine) {
+    ASSERT_PRECONDITION(mImpl->mCount > 0 && mImpl->mCount <= CONFIG_MAX_MORPH_TARGET_COUNT,
+            "morph target count must be between 1 and %u", CONFIG_MAX_MORPH_TARGET_COUNT);
+    // positions and tangents each take half of the rows, which are limited to 2048
+    ASSERT_PRECONDITION(mImpl->mVertexCount > 0 &&
+            mImpl->mVertexCount <= CONFIG_MORPH_TARGET_TEXTURE_WIDTH * 1024,
+            "vertex count must be between 1 and %u", CONFIG_MORPH_TARGET_TEXTURE_WIDTH * 1024);
+    return upcast(engine).createMorphTargetBuffer(*this);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+FMorphTargetBuffer::FMorphTargetBuffer(FEngine& engine, const Builder& builder)
+        : mVertexCount(uint32_t(builder->mVertexCount)),
+          mCount(uint32_t(builder->mCount)) {
+    FEngine::DriverApi& driver = engine.getDriverApi();
+
+    const uint2 size = getTextureSize(mVertexCount);
+    mTexture = driver.createTexture(SamplerType::SAMPLER_2D_ARRAY, 1, TextureFormat::RGBA32F, 1,
+            size.x, size.y, mCount, TextureUsage::DEFAULT);
+
+    SamplerGroup samplers(PerRenderableMorphingSib::SAMPLER_COUNT);
+    samplers.setSampler(PerRenderableMorphingSib::TARGETS, mTexture, {});
+    mSamplerGroupHandle = driver.createSamplerGroup(samplers.getSize());
+    driver.updateSamplerGroup(mSamplerGroupHandle, std::move(samplers.toCommandStream()));
+
+    // Textures are not guaranteed to be initialized, all targets start with null deltas and no
+    // tangents.
+    const size_t layerSize = size.x * size.y * sizeof(float4);
+    void* zeroes = calloc(layerSize, mCount);
+    driver.update3DImage(mTexture, 0, 0, 0, 0, size.x, size.y, mCount,
+            PixelBufferDescriptor(zeroes, layerSize * mCount,
+                    PixelDataFormat::RGBA, PixelDataType::FLOAT,
+                    [](void* buffer, size_t, void*) { free(buffer); }));
+}
+
+void FMorphTargetBuffer::terminate(FEngine& engine) {
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    driver.destroySamplerGroup(mSamplerGroupHandle);
+    driver.destroyTexture(mTexture);
+}
+
+void FMorphTargetBuffer::setPositionsAt(FEngine& engine, size_t targetIndex,
+        float3 const* positions, size_t count) {
+    ASSERT_PRECONDITION(targetIndex < mCount, "targetIndex must be < %u", mCount);
+    ASSERT_PRECONDITION(count <= mVertexCount, "count must be <= %u", mVertexCount);
+
+    const uint2 size = getTextureSize(mVertexCount);
+    float4* out = (float4*)calloc(size.x * (size.y / 2), sizeof(float4));
+    for (size_t i = 0; i < count; i++) {
+        out[i] = float4{ positions[i], 0 };
+    }
+    update(engine, targetIndex, 0, out);
+}
+
+void FMorphTargetBuffer::setPositionsAt(FEngine& engine, size_t targetIndex,
+        float4 const* positions, size_t count) {
+    ASSERT_PRECONDITION(targetIndex < mCount, "targetIndex must be < %u", mCount);
+    ASSERT_PRECONDITION(count <= mVertexCount, "count must be <= %u", mVertexCount);
+
+    const uint2 size = getTextureSize(mVertexCount);
+    float4* out = (float4*)calloc(size.x * (size.y / 2), sizeof(float4));
+    for (size_t i = 0; i < count; i++) {
+        out[i] = float4{ positions[i].xyz, 0 };
+    }
+    update(engine, targetIndex, 0, out);
+}
+
+void FMorphTargetBuffer::setTangentsAt(FEngine& engine, size_t targetIndex,
+        short4 const* tangents, size_t count) {
+    ASSERT_PRECONDITION(targetIndex < mCount, "targetIndex must be < %u", mCount);
+    ASSERT_PRECONDITION(count <= mVertexCount, "count must be <= %u", mVertexCount);
+
+    const uint2 size = getTextureSize(mVertexCount);
+    float4* out = (float4*)calloc(size.x * (size.y / 2), sizeof(float4));
+    for (size_t i = 0; i < count; i++) {
+        // same conversion as SHORT4 normalized vertex attributes
+        out[i] = max(float4(tangents[i]) / 32767.0f, -1.0f);
+    }
+    update(engine, targetIndex, size.y / 2, out);
+}
+
+void FMorphTargetBuffer::update(FEngine& engine, size_t targetIndex, size_t firstRow,
+        float4* data) {
+    const uint2 size = getTextureSize(mVertexCount);
+    const uint32_t rowCount = size.y / 2;
+    engine.getDriverApi().update3DImage(mTexture, 0,
+            0, uint32_t(firstRow), uint32_t(targetIndex), size.x, rowCount, 1,
+            PixelBufferDescriptor(data, size.x * rowCount * sizeof(float4),
+                    PixelDataFormat::RGBA, PixelDataType::FLOAT,
+                    [](void* buffer, size_t, void*) { free(buffer); }));
+}
+
+uint2 FMorphTargetBuffer::getTextureSize(size_t vertexCount) noexcept {
+    const size_t rowCount = (vertexCount + CONFIG_MORPH_TARGET_TEXTURE_WIDTH - 1) /
+            CONFIG_MORPH_TARGET_TEXTURE_WIDTH;
+    return { CONFIG_MORPH_TARGET_TEXTURE_WIDTH, rowCount * 2 };
+}
+
+uint2 FMorphTargetBuffer::getPositionTexel(size_t vertexIndex) noexcept {
+    // this must match getMorphTargetTexel() in getters.vs
+    return { vertexIndex % CONFIG_MORPH_TARGET_TEXTURE_WIDTH,
+             vertexIndex / CONFIG_MORPH_TARGET_TEXTURE_WIDTH };
+}
+
+uint2 FMorphTargetBuffer::getTangentTexel(size_t vertexIndex, size_t vertexCount) noexcept {
+    // this must match getMorphTargetTexel() in getters.vs
+    return getPositionTexel(vertexIndex) + uint2{ 0, getTextureSize(vertexCount).y / 2 };
+}
+
+// ------------------------------------------------------------------------------------------------
+// Trampoline calling into private implementation
+// ------------------------------------------------------------------------------------------------
+
+void MorphTargetBuffer::setPositionsAt(Engine& engine, size_t targetIndex,
+        float3 const* positions, size_t count) {
+    upcast(this)->setPositionsAt(upcast(engine), targetIndex, positions, count);
+}
+
+void MorphTargetBuffer::setPositionsAt(Engine& engine, size_t targetIndex,
+        float4 const* positions, size_t count) {
+    upcast(this)->setPositionsAt(upcast(engine), targetIndex, positions, count);
+}
+
+void MorphTargetBuffer::setTangentsAt(Engine& engine, size_t targetIndex,
+        short4 const* tangents, size_t count) {
+    upcast(this)->setTangentsAt(upcast(engine), targetIndex, tangents, count);
+}
+
+size_t MorphTargetBuffer::getVertexCount() const noexcept {
+    return upcast(this)->getVertexCount();
+}
+
+size_t MorphTargetBuffer::getCount() const noexcept {
+    return upcast(this)->getCount();
+}
+
+} // namespace filament
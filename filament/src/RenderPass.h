@@ -217,7 +217,7 @@ public:
         backend::RasterState rasterState;                               // 4 bytes
         uint16_t index = 0;                                             // 2 bytes
         Variant materialVariant;                                        // 1 byte
-        uint8_t reserved = {};                                          // 1 byte
+        uint8_t primitiveIndex = 0;                                     // 1 byte
     };
 
     struct alignas(8) Command {     // 32 bytes
@@ -240,6 +240,7 @@ public:
     static constexpr RenderFlags HAS_INVERSE_FRONT_FACES = 0x08;
     static constexpr RenderFlags HAS_FOG                 = 0x10;
     static constexpr RenderFlags HAS_VSM                 = 0x20;
+    static constexpr RenderFlags WARM_UP_ONLY            = 0x40;  // create pipelines, don't draw
 
 
     RenderPass(FEngine& engine, utils::GrowingSlice<Command> commands) noexcept;
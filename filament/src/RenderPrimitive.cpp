@@ -20,6 +20,7 @@
 #include "details/VertexBuffer.h"
 #include "details/IndexBuffer.h"
 #include "details/Material.h"
+#include "details/MorphTargetBuffer.h"
 
 #include <utils/debug.h>
 
@@ -34,6 +35,10 @@ void FRenderPrimitive::init(backend::DriverApi& driver,
     mMaterialInstance = upcast(entry.materialInstance);
     mBlendOrder = entry.blendOrder;
 
+    if (entry.morphTargetBuffer) {
+        mMorphTargetBuffer = upcast(entry.morphTargetBuffer)->getHwHandle();
+    }
+
     if (entry.indices && entry.vertices) {
         FVertexBuffer* vertexBuffer = upcast(entry.vertices);
         FIndexBuffer* indexBuffer = upcast(entry.indices);
@@ -195,6 +195,12 @@ void FRenderer::render(FView const* view) {
     }
 }
 
+void FRenderer::warmUp(FView const* view) {
+    mWarmUpOnly = true;
+    render(view);
+    mWarmUpOnly = false;
+}
+
 void FRenderer::renderInternal(FView const* view) {
     // per-renderpass data
     ArenaScope rootArena(mPerRenderPassArena);
@@ -290,6 +296,7 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     if (view.hasFog())                     renderFlags |= RenderPass::HAS_FOG;
     if (view.isFrontFaceWindingInverted()) renderFlags |= RenderPass::HAS_INVERSE_FRONT_FACES;
     if (view.hasVsm())                     renderFlags |= RenderPass::HAS_VSM;
+    if (mWarmUpOnly)                       renderFlags |= RenderPass::WARM_UP_ONLY;
     pass.setRenderFlags(renderFlags);
 
     /*
@@ -1158,6 +1165,10 @@ void Renderer::render(View const* view) {
     upcast(this)->render(upcast(view));
 }
 
+void Renderer::warmUp(View const* view) {
+    upcast(this)->warmUp(upcast(view));
+}
+
 bool Renderer::beginFrame(SwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano) {
     return upcast(this)->beginFrame(upcast(swapChain), vsyncSteadyClockTimeNano,
             nullptr, nullptr);
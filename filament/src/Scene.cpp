@@ -123,6 +123,8 @@ void FScene::prepare(const mat4f& worldOriginTransform) {
                     reversedWindingOrder,     // REVERSED_WINDING_ORDER
                     rcm.getVisibility(ri),    // VISIBILITY_STATE
                     rcm.getBonesUbh(ri),      // BONES_UBH
+                    rcm.getBonesSbh(ri),      // BONES_SBH
+                    rcm.getMorphingUbh(ri),   // MORPHING_UBH
                     worldAABB.center,         // WORLD_AABB_CENTER
                     0,                        // VISIBLE_MASK
                     rcm.getMorphWeights(ri),  // MORPH_WEIGHTS
@@ -224,13 +226,17 @@ void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Hand
 
         FRenderableManager::Visibility visibility = sceneData.elementAt<VISIBILITY_STATE>(i);
         hasContactShadows = hasContactShadows || visibility.screenSpaceContactShadows;
+        // skinningEnabled is 2 when the bones are stored in a texture rather than in the UBO
+        const uint32_t skinning = visibility.skinning ?
+                (sceneData.elementAt<BONES_SBH>(i) ? 2u : 1u) : 0u;
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, skinningEnabled),
-                uint32_t(visibility.skinning));
+                offset + offsetof(PerRenderableUib, skinningEnabled), skinning);
 
+        // morphingEnabled is 2 when the morph targets are stored in MorphTargetBuffers
+        const uint32_t morphing = visibility.morphing ?
+                (sceneData.elementAt<MORPHING_UBH>(i) ? 2u : 1u) : 0u;
         UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, morphingEnabled),
-                uint32_t(visibility.morphing));
+                offset + offsetof(PerRenderableUib, morphingEnabled), morphing);
 
         UniformBuffer::setUniform(buffer,
                 offset + offsetof(PerRenderableUib, screenSpaceContactShadows),
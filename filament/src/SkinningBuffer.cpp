@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/SkinningBuffer.h"
+
+#include "components/RenderableManager.h"
+
+#include "details/Engine.h"
+
+#include "FilamentAPI-impl.h"
+
+#include <private/filament/EngineEnums.h>
+#include <private/filament/SibGenerator.h>
+
+#include "private/backend/SamplerGroup.h"
+
+#include <utils/Panic.h>
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+struct SkinningBuffer::BuilderDetails {
+    uint32_t mBoneCount = 0;
+    bool mInitialize = false;
+};
+
+using BuilderType = SkinningBuffer;
+BuilderType::Builder::Builder() noexcept = default;
+BuilderType::Builder::~Builder() noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder::Builder(BuilderType::Builder&& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder const& rhs) noexcept = default;
+BuilderType::Builder& BuilderType::Builder::operator=(BuilderType::Builder&& rhs) noexcept = default;
+
+SkinningBuffer::Builder& SkinningBuffer::Builder::boneCount(uint32_t boneCount) noexcept {
+    mImpl->mBoneCount = boneCount;
+    return *this;
+}
+
+SkinningBuffer::Builder& SkinningBuffer::Builder::initialize(bool initialize) noexcept {
+    mImpl->mInitialize = initialize;
+    return *this;
+}
+
+SkinningBuffer* SkinningBuffer::Builder::build(Engine& engine) {
+    ASSERT_PRECONDITION(mImpl->mBoneCount > 0 &&
+            mImpl->mBoneCount <= CONFIG_MAX_BONE_TEXTURE_BONE_COUNT,
+            "bone count must be between 1 and %u", CONFIG_MAX_BONE_TEXTURE_BONE_COUNT);
+    return upcast(engine).createSkinningBuffer(*this);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+FSkinningBuffer::FSkinningBuffer(FEngine& engine, const Builder& builder)
+        : mBones(getStorageSize(builder->mBoneCount)),
+          mBoneCount(builder->mBoneCount) {
+    FEngine::DriverApi& driver = engine.getDriverApi();
+
+    if (mBoneCount <= CONFIG_MAX_BONE_COUNT) {
+        // The driver-level buffer is always sized for CONFIG_MAX_BONE_COUNT bones, because the
+        // uniform block bound to PER_RENDERABLE_BONES must be fully populated (see the comment in
+        // FRenderableManager::create).
+        mHandle = driver.createUniformBuffer(CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone),
+                BufferUsage::DYNAMIC);
+    } else {
+        // Large skeletons don't fit in the UBO, their bones are stored in a texture instead. The
+        // shaders still expect a bones UBO to be bound, so we use the engine's empty one.
+        const uint2 size = getTextureSize(mBoneCount);
+        mHandle = engine.getDummyBonesUniformBuffer();
+        mTexture = driver.createTexture(SamplerType::SAMPLER_2D, 1, TextureFormat::RGBA32F, 1,
+                size.x, size.y, 1, TextureUsage::DEFAULT);
+        SamplerGroup samplers(PerRenderableBonesSib::SAMPLER_COUNT);
+        samplers.setSampler(PerRenderableBonesSib::TRANSFORMS, mTexture, {});
+        mSamplerGroupHandle = driver.createSamplerGroup(samplers.getSize());
+        driver.updateSamplerGroup(mSamplerGroupHandle, std::move(samplers.toCommandStream()));
+    }
+
+    if (builder->mInitialize) {
+        // initialize the bones to identity
+        PerRenderableUibBone* out = (PerRenderableUibBone*)mBones.invalidate();
+        std::uninitialized_fill_n(out, mBoneCount, PerRenderableUibBone{});
+        commit(driver, 0, mBoneCount);
+    }
+}
+
+void FSkinningBuffer::terminate(FEngine& engine) {
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    if (mTexture) {
+        driver.destroySamplerGroup(mSamplerGroupHandle);
+        driver.destroyTexture(mTexture);
+    } else {
+        driver.destroyUniformBuffer(mHandle);
+    }
+}
+
+void FSkinningBuffer::setBones(FEngine& engine,
+        RenderableManager::Bone const* transforms, size_t boneCount, size_t offset) {
+    ASSERT_PRECONDITION((offset + boneCount) <= mBoneCount,
+            "SkinningBuffer overflow (offset=%u, count=%u, size=%u)",
+            unsigned(offset), unsigned(boneCount), unsigned(mBoneCount));
+
+    PerRenderableUibBone* UTILS_RESTRICT out = (PerRenderableUibBone*)mBones.invalidateUniforms(
+            offset * sizeof(PerRenderableUibBone), boneCount * sizeof(PerRenderableUibBone));
+    for (size_t i = 0, c = boneCount; i < c; ++i) {
+        out[i].q = transforms[i].unitQuaternion;
+        out[i].t.xyz = transforms[i].translation;
+        out[i].s = out[i].ns = { 1, 1, 1, 0 };
+    }
+    commit(engine.getDriverApi(), offset, boneCount);
+}
+
+void FSkinningBuffer::setBones(FEngine& engine,
+        mat4f const* transforms, size_t boneCount, size_t offset) {
+    ASSERT_PRECONDITION((offset + boneCount) <= mBoneCount,
+            "SkinningBuffer overflow (offset=%u, count=%u, size=%u)",
+            unsigned(offset), unsigned(boneCount), unsigned(mBoneCount));
+
+    PerRenderableUibBone* UTILS_RESTRICT out = (PerRenderableUibBone*)mBones.invalidateUniforms(
+            offset * sizeof(PerRenderableUibBone), boneCount * sizeof(PerRenderableUibBone));
+    for (size_t i = 0, c = boneCount; i < c; ++i) {
+        FRenderableManager::makeBone(&out[i], transforms[i]);
+    }
+    commit(engine.getDriverApi(), offset, boneCount);
+}
+
+void FSkinningBuffer::commit(FEngine::DriverApi& driver, size_t offset, size_t boneCount) {
+    if (!mTexture) {
+        driver.loadUniformBuffer(mHandle, mBones.toBufferDescriptor(driver));
+        return;
+    }
+    if (boneCount == 0) {
+        return;
+    }
+
+    // Only the rows that contain modified bones are uploaded. The CPU-side copy has the same
+    // layout as the texture, including the padding of the last row.
+    const size_t firstRow = offset / CONFIG_BONE_TEXTURE_ROW_SIZE;
+    const size_t lastRow = (offset + boneCount - 1) / CONFIG_BONE_TEXTURE_ROW_SIZE;
+    const size_t rowCount = lastRow - firstRow + 1;
+    const size_t rowSize = CONFIG_BONE_TEXTURE_ROW_SIZE * sizeof(PerRenderableUibBone);
+    BufferDescriptor data = mBones.toBufferDescriptor(driver, firstRow * rowSize,
+            rowCount * rowSize);
+    driver.update2DImage(mTexture, 0, 0, uint32_t(firstRow),
+            uint32_t(CONFIG_BONE_TEXTURE_ROW_SIZE * 4), uint32_t(rowCount),
+            PixelBufferDescriptor(data.buffer, data.size,
+                    PixelDataFormat::RGBA, PixelDataType::FLOAT));
+}
+
+size_t FSkinningBuffer::getStorageSize(size_t boneCount) noexcept {
+    if (boneCount <= CONFIG_MAX_BONE_COUNT) {
+        return boneCount * sizeof(PerRenderableUibBone);
+    }
+    return getTextureSize(boneCount).y * CONFIG_BONE_TEXTURE_ROW_SIZE * sizeof(PerRenderableUibBone);
+}
+
+uint2 FSkinningBuffer::getTextureSize(size_t boneCount) noexcept {
+    const size_t rowCount = (boneCount + CONFIG_BONE_TEXTURE_ROW_SIZE - 1) /
+            CONFIG_BONE_TEXTURE_ROW_SIZE;
+    return { CONFIG_BONE_TEXTURE_ROW_SIZE * 4, rowCount };
+}
+
+uint2 FSkinningBuffer::getBoneTexel(size_t boneIndex, size_t component) noexcept {
+    // this must match getBone() in getters.vs
+    const size_t rowTexelCount = CONFIG_BONE_TEXTURE_ROW_SIZE * 4;
+    const size_t texel = boneIndex * 4 + component;
+    return { texel % rowTexelCount, texel / rowTexelCount };
+}
+
+// ------------------------------------------------------------------------------------------------
+// Trampoline calling into private implementation
+// ------------------------------------------------------------------------------------------------
+
+void SkinningBuffer::setBones(Engine& engine,
+        RenderableManager::Bone const* transforms, size_t count, size_t offset) {
+    upcast(this)->setBones(upcast(engine), transforms, count, offset);
+}
+
+void SkinningBuffer::setBones(Engine& engine,
+        mat4f const* transforms, size_t count, size_t offset) {
+    upcast(this)->setBones(upcast(engine), transforms, count, offset);
+}
+
+size_t SkinningBuffer::getBoneCount() const noexcept {
+    return upcast(this)->getBoneCount();
+}
+
+} // namespace filament
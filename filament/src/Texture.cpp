@@ -148,12 +148,14 @@ FTexture::FTexture(FEngine& engine, const Builder& builder) {
             mHandle = driver.createTexture(
                     mTarget, mLevelCount, mFormat, mSampleCount, mWidth, mHeight, mDepth, mUsage);
         } else {
+            mStreamable = false;
             mHandle = driver.createTextureSwizzled(
                     mTarget, mLevelCount, mFormat, mSampleCount, mWidth, mHeight, mDepth, mUsage,
                     builder->mSwizzle[0], builder->mSwizzle[1], builder->mSwizzle[2],
                     builder->mSwizzle[3]);
         }
     } else {
+        mStreamable = false;
         mHandle = driver.importTexture(builder->mImportedId,
                 mTarget, mLevelCount, mFormat, mSampleCount, mWidth, mHeight, mDepth, mUsage);
     }
@@ -161,10 +163,27 @@ FTexture::FTexture(FEngine& engine, const Builder& builder) {
 
 // frees driver resources, object becomes invalid
 void FTexture::terminate(FEngine& engine) {
+    if (mStreamed) {
+        engine.getTextureStreamer().removeTexture(this);
+    }
     FEngine::DriverApi& driver = engine.getDriverApi();
     driver.destroyTexture(mHandle);
 }
 
+bool FTexture::getUploadTarget(FEngine& engine, size_t level,
+        Handle<HwTexture>* handle, uint8_t* hwLevel) const noexcept {
+    if (UTILS_UNLIKELY(mStreamed)) {
+        return engine.getTextureStreamer().getUploadTarget(this, level, handle, hwLevel);
+    }
+    // levels below mBaseLevel were evicted before the texture stopped being streamed
+    if (UTILS_UNLIKELY(level < mBaseLevel)) {
+        return false;
+    }
+    *handle = mHandle;
+    *hwLevel = uint8_t(level - mBaseLevel);
+    return true;
+}
+
 size_t FTexture::getWidth(size_t level) const noexcept {
     return valueForLevel(level, mWidth);
 }
@@ -235,8 +254,12 @@ void FTexture::setImage(FEngine& engine,
         return;
     }
 
-    engine.getDriverApi().update2DImage(mHandle,
-            uint8_t(level), xoffset, yoffset, width, height, std::move(buffer));
+    Handle<HwTexture> handle;
+    uint8_t hwLevel;
+    if (getUploadTarget(engine, level, &handle, &hwLevel)) {
+        engine.getDriverApi().update2DImage(handle,
+                hwLevel, xoffset, yoffset, width, height, std::move(buffer));
+    }
 }
 
 void FTexture::setImage(FEngine& engine,
@@ -350,8 +373,12 @@ void FTexture::setImage(FEngine& engine, size_t level,
         return;
     }
 
-    engine.getDriverApi().updateCubeImage(mHandle, uint8_t(level),
-            std::move(buffer), faceOffsets);
+    Handle<HwTexture> handle;
+    uint8_t hwLevel;
+    if (getUploadTarget(engine, level, &handle, &hwLevel)) {
+        engine.getDriverApi().updateCubeImage(handle, hwLevel,
+                std::move(buffer), faceOffsets);
+    }
 }
 
 void FTexture::setExternalImage(FEngine& engine, void* image) noexcept {
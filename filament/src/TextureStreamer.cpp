@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/TextureStreamer.h"
+
+#include "details/Camera.h"
+#include "details/Engine.h"
+#include "details/MaterialInstance.h"
+#include "details/RenderPrimitive.h"
+#include "details/Texture.h"
+
+#include "private/backend/BackendUtils.h"
+
+#include <utils/Panic.h>
+#include <utils/Systrace.h>
+
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+using namespace utils;
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+// levels of this size or less form the tail of a texture, which is always resident
+static constexpr size_t TAIL_SIZE = 64;
+
+FTextureStreamer::FTextureStreamer(FEngine& engine) noexcept : mEngine(engine) {
+}
+
+void FTextureStreamer::terminate() {
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    for (auto& item : mEntries) {
+        Entry const& entry = item.second;
+        entry.texture->mStreamed = false;
+        if (entry.pending) {
+            driver.destroyTexture(entry.pending);
+        }
+    }
+    mEntries.clear();
+    mTextures.clear();
+    mRequests.clear();
+}
+
+size_t FTextureStreamer::getLevelSize(FTexture const* texture, size_t level) noexcept {
+    const TextureFormat format = texture->getFormat();
+    size_t width = texture->getWidth(level);
+    size_t height = texture->getHeight(level);
+    if (texture->isCompressed()) {
+        // getFormatSize() is the size of a block for compressed formats
+        const size_t bw = getBlockWidth(format);
+        const size_t bh = getBlockHeight(format);
+        width = (width + bw - 1) / bw;
+        height = (height + bh - 1) / bh;
+    }
+    const size_t size = width * height * getFormatSize(format);
+    return texture->isCubemap() ? size * 6 : size;
+}
+
+size_t FTextureStreamer::getSize(FTexture const* texture, size_t baseLevel) noexcept {
+    size_t size = 0;
+    for (size_t level = baseLevel, c = texture->getLevelCount(); level < c; level++) {
+        size += getLevelSize(texture, level);
+    }
+    return size;
+}
+
+void FTextureStreamer::addTexture(FTexture* texture, LevelCallback callback, void* user) {
+    ASSERT_PRECONDITION(callback, "A level callback is required.");
+    ASSERT_PRECONDITION(texture->getTarget() == Texture::Sampler::SAMPLER_2D ||
+            texture->isCubemap(), "Only 2D and cubemap textures can be streamed.");
+    ASSERT_PRECONDITION(texture->mStreamable && !texture->isMultisample(),
+            "Imported, swizzled and multisample textures can't be streamed.");
+
+    auto[pos, inserted] = mEntries.try_emplace(texture);
+    Entry& entry = pos.value();
+    entry.callback = callback;
+    entry.user = user;
+    if (!inserted) {
+        return;
+    }
+
+    // the tail starts at the first level small enough, and always includes the last level
+    uint8_t tail = 0;
+    const size_t levelCount = texture->getLevelCount();
+    while (tail + 1u < levelCount &&
+           std::max(texture->getWidth(tail), texture->getHeight(tail)) > TAIL_SIZE) {
+        tail++;
+    }
+
+    entry.texture = texture;
+    entry.tailLevel = tail;
+    entry.targetLevel = tail;
+    texture->mStreamed = true;
+    mTextures[texture->getHwHandle().getId()] = texture;
+
+    // the texture is reallocated even if its tail has all its levels, so that they get requested
+    startPendingTexture(entry, tail);
+    callLevelCallbacks();
+}
+
+void FTextureStreamer::removeTexture(FTexture* texture) noexcept {
+    auto pos = mEntries.find(texture);
+    if (pos == mEntries.end()) {
+        return;
+    }
+    Entry const& entry = pos->second;
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    if (entry.pending) {
+        driver.destroyTexture(entry.pending);
+    }
+    if (entry.minLevel) {
+        driver.setMinMaxLevels(texture->mHandle, 0,
+                texture->getLevelCount() - texture->mBaseLevel - 1);
+    }
+    texture->mStreamed = false;
+    mTextures.erase(texture->getHwHandle().getId());
+    mEntries.erase(pos);
+}
+
+void FTextureStreamer::setPriority(FTexture* texture, float priority) noexcept {
+    auto pos = mEntries.find(texture);
+    if (pos != mEntries.end()) {
+        pos.value().priority = priority;
+    }
+}
+
+size_t FTextureStreamer::getResidentLevel(FTexture const* texture) const noexcept {
+    return texture->mBaseLevel;
+}
+
+size_t FTextureStreamer::getResidentMemory() const noexcept {
+    size_t size = 0;
+    for (auto const& item : mEntries) {
+        Entry const& entry = item.second;
+        size += getSize(entry.texture, entry.texture->mBaseLevel);
+        if (entry.pending) {
+            size += getSize(entry.texture, entry.pendingLevel);
+        }
+    }
+    return size;
+}
+
+void FTextureStreamer::prepareVisibleRenderables(FScene::RenderableSoa const& renderableData,
+        Range<uint32_t> visible, CameraInfo const& camera, filament::Viewport const& viewport) noexcept {
+    SYSTRACE_CALL();
+
+    FRenderableManager& rcm = mEngine.getRenderableManager();
+    auto const* const UTILS_RESTRICT instances = renderableData.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* const UTILS_RESTRICT centers = renderableData.data<FScene::WORLD_AABB_CENTER>();
+    auto const* const UTILS_RESTRICT extents = renderableData.data<FScene::WORLD_AABB_EXTENT>();
+
+    // size in pixels of the projected diameter of a bounding sphere of radius 1 at distance 1
+    const float scale = camera.projection[1][1] * float(viewport.height);
+    const bool perspective = camera.projection[2][3] != 0.0f;
+    const float3 eye = camera.getPosition();
+
+    for (uint32_t i : visible) {
+        const float radius = length(extents[i]);
+        const float distance = perspective ?
+                std::max(length(centers[i] - eye) - radius, camera.zn) : 1.0f;
+        const float pixels = scale * radius / distance;
+
+        for (FRenderPrimitive const& primitive : rcm.getRenderPrimitives(instances[i], 0)) {
+            FMaterialInstance const* const mi = primitive.getMaterialInstance();
+            if (!mi) {
+                continue;
+            }
+            SamplerGroup const& samplers = mi->getSamplerGroup();
+            SamplerGroup::Sampler const* const list = samplers.getSamplers();
+            for (size_t j = 0, c = samplers.getSize(); j < c; j++) {
+                auto texture = mTextures.find(list[j].t.getId());
+                if (texture == mTextures.end()) {
+                    continue;
+                }
+                Entry& entry = mEntries.find(texture->second).value();
+
+                // the finest level we need has about one texel per pixel, assuming the texture is
+                // mapped once across the renderable.
+                const float size = float(std::max(
+                        texture->second->getWidth(), texture->second->getHeight()));
+                const float level = pixels < size ? std::floor(std::log2(size / pixels)) : 0.0f;
+                entry.neededLevel = uint8_t(std::min({ level, float(entry.tailLevel),
+                        float(entry.neededLevel) }));
+            }
+        }
+    }
+}
+
+void FTextureStreamer::update() {
+    SYSTRACE_CALL();
+
+    if (mEntries.empty()) {
+        return;
+    }
+
+    // textures seen in the last frame target the level they need, the others keep theirs
+    size_t total = 0;
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        Entry& entry = it.value();
+        if (entry.neededLevel != UNSEEN) {
+            entry.targetLevel = entry.neededLevel;
+        }
+        total += getSize(entry.texture, entry.targetLevel);
+    }
+
+    if (total > mBudget) {
+        // evict one level at a time from the texture that's least worth keeping: those that
+        // weren't seen, then those with the lowest priority, then the largest ones.
+        auto worthMore = [](Entry const* lhs, Entry const* rhs) {
+            const bool lhsSeen = lhs->neededLevel != UNSEEN;
+            const bool rhsSeen = rhs->neededLevel != UNSEEN;
+            if (lhsSeen != rhsSeen) {
+                return lhsSeen;
+            }
+            if (lhs->priority != rhs->priority) {
+                return lhs->priority > rhs->priority;
+            }
+            return getLevelSize(lhs->texture, lhs->targetLevel) <
+                   getLevelSize(rhs->texture, rhs->targetLevel);
+        };
+        std::priority_queue<Entry*, std::vector<Entry*>, decltype(worthMore)> candidates(worthMore);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it.value().targetLevel < it.value().tailLevel) {
+                candidates.push(&it.value());
+            }
+        }
+        while (total > mBudget && !candidates.empty()) {
+            Entry* const entry = candidates.top();
+            candidates.pop();
+            total -= getLevelSize(entry->texture, entry->targetLevel);
+            entry->targetLevel++;
+            if (entry->targetLevel < entry->tailLevel) {
+                candidates.push(entry);
+            }
+        }
+    }
+
+    const bool overBudget = total > mBudget || getResidentMemory() > mBudget;
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        applyTargetLevel(it.value(), overBudget);
+        it.value().neededLevel = UNSEEN;
+    }
+
+    callLevelCallbacks();
+
+    // textures whose levels have all been provided start being used now
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        Entry& entry = it.value();
+        if (entry.pending && !entry.missingLevels) {
+            swapPendingTexture(entry);
+        }
+    }
+}
+
+void FTextureStreamer::startPendingTexture(Entry& entry, uint8_t level) {
+    FTexture const* const texture = entry.texture;
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    const size_t levelCount = texture->getLevelCount();
+    entry.pending = driver.createTexture(texture->getTarget(),
+            uint8_t(levelCount - level), texture->getFormat(), 1,
+            uint32_t(texture->getWidth(level)), uint32_t(texture->getHeight(level)), 1,
+            texture->getUsage());
+    entry.pendingLevel = level;
+    entry.missingLevels = 0;
+
+    // Hardware textures can't gain or lose levels, so the texture is reallocated with the levels
+    // we want. Those we already have are copied on the GPU when the format can be blitted,
+    // only the others are requested. The contents of the texture we start from are unknown.
+    size_t firstCopied = levelCount;
+    if (entry.resident && !texture->isCompressed() && !texture->isCubemap() &&
+            driver.isRenderTargetFormatSupported(texture->getFormat())) {
+        firstCopied = std::max<size_t>(level, texture->mBaseLevel);
+    }
+    for (size_t l = level; l < firstCopied; l++) {
+        entry.missingLevels |= uint64_t(1) << l;
+        mRequests.push_back({ texture, uint8_t(l) });
+    }
+    for (size_t l = firstCopied; l < levelCount; l++) {
+        copyLevel(entry, l);
+    }
+}
+
+void FTextureStreamer::copyLevel(Entry const& entry, size_t level) {
+    FTexture const* const texture = entry.texture;
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    const uint32_t width = uint32_t(texture->getWidth(level));
+    const uint32_t height = uint32_t(texture->getHeight(level));
+    Handle<HwRenderTarget> src = driver.createRenderTarget(TargetBufferFlags::COLOR0,
+            width, height, 1,
+            TargetBufferInfo{ texture->mHandle, uint8_t(level - texture->mBaseLevel) }, {}, {});
+    Handle<HwRenderTarget> dst = driver.createRenderTarget(TargetBufferFlags::COLOR0,
+            width, height, 1,
+            TargetBufferInfo{ entry.pending, uint8_t(level - entry.pendingLevel) }, {}, {});
+    const backend::Viewport rect{ 0, 0, width, height };
+    driver.blit(TargetBufferFlags::COLOR0, dst, rect, src, rect, SamplerMagFilter::NEAREST);
+    driver.destroyRenderTarget(src);
+    driver.destroyRenderTarget(dst);
+}
+
+void FTextureStreamer::applyTargetLevel(Entry& entry, bool overBudget) {
+    FTexture const* const texture = entry.texture;
+    FEngine::DriverApi& driver = mEngine.getDriverApi();
+    const uint8_t target = entry.targetLevel;
+    const uint8_t baseLevel = texture->mBaseLevel;
+
+    // levels that aren't needed anymore stop being sampled right away
+    const uint8_t minLevel = target > baseLevel ? target - baseLevel : 0;
+    if (minLevel != entry.minLevel) {
+        driver.setMinMaxLevels(texture->mHandle, minLevel,
+                texture->getLevelCount() - baseLevel - 1);
+        entry.minLevel = minLevel;
+    }
+
+    if (entry.pending ? entry.pendingLevel == target : baseLevel == target) {
+        return;
+    }
+
+    // Avoid reloading textures whose needs change back and forth by a level, e.g. as the camera
+    // moves: keep loading more levels than needed as long as it's still an improvement, and
+    // don't reclaim a single level unless we need the memory.
+    if (!overBudget && entry.pending && entry.pendingLevel < target && target < baseLevel) {
+        return;
+    }
+
+    if (entry.pending) {
+        driver.destroyTexture(entry.pending);
+        entry.pending.clear();
+        entry.missingLevels = 0;
+    }
+
+    if (target != baseLevel && (overBudget || target != baseLevel + 1)) {
+        startPendingTexture(entry, target);
+    }
+}
+
+void FTextureStreamer::swapPendingTexture(Entry& entry) noexcept {
+    FTexture* const texture = entry.texture;
+    mTextures.erase(texture->mHandle.getId());
+    mEngine.replaceTexture(texture->mHandle, entry.pending);
+    mEngine.getDriverApi().destroyTexture(texture->mHandle);
+    texture->mHandle = entry.pending;
+    texture->mBaseLevel = entry.pendingLevel;
+    mTextures[texture->mHandle.getId()] = texture;
+    entry.pending.clear();
+    entry.minLevel = 0;
+    entry.resident = true;
+}
+
+void FTextureStreamer::callLevelCallbacks() {
+    // callbacks may add textures, which issue requests of their own
+    std::vector<Request> requests;
+    std::swap(requests, mRequests);
+    for (Request const& request : requests) {
+        // the level may have been provided or stopped being needed since it was requested
+        auto pos = mEntries.find(request.texture);
+        if (pos != mEntries.end() && (pos->second.missingLevels & (uint64_t(1) << request.level))) {
+            Entry const& entry = pos->second;
+            entry.callback(entry.texture, request.level, entry.user);
+        }
+    }
+}
+
+bool FTextureStreamer::getUploadTarget(FTexture const* texture, size_t level,
+        Handle<HwTexture>* handle, uint8_t* hwLevel) noexcept {
+    auto pos = mEntries.find(texture);
+    assert_invariant(pos != mEntries.end());
+    Entry& entry = pos.value();
+    const uint64_t bit = uint64_t(1) << level;
+    if (entry.missingLevels & bit) {
+        *handle = entry.pending;
+        *hwLevel = uint8_t(level - entry.pendingLevel);
+        entry.missingLevels &= ~bit;
+        return true;
+    }
+    if (level >= texture->mBaseLevel) {
+        *handle = texture->mHandle;
+        *hwLevel = uint8_t(level - texture->mBaseLevel);
+        return true;
+    }
+    return false;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Trampoline calling into private implementation
+// ------------------------------------------------------------------------------------------------
+
+void TextureStreamer::addTexture(Texture* texture, LevelCallback callback, void* user) {
+    upcast(this)->addTexture(upcast(texture), callback, user);
+}
+
+void TextureStreamer::removeTexture(Texture* texture) noexcept {
+    upcast(this)->removeTexture(upcast(texture));
+}
+
+void TextureStreamer::setPriority(Texture* texture, float priority) noexcept {
+    upcast(this)->setPriority(upcast(texture), priority);
+}
+
+size_t TextureStreamer::getResidentLevel(Texture const* texture) const noexcept {
+    return upcast(this)->getResidentLevel(upcast(texture));
+}
+
+void TextureStreamer::setMemoryBudget(size_t budget) noexcept {
+    upcast(this)->setMemoryBudget(budget);
+}
+
+size_t TextureStreamer::getMemoryBudget() const noexcept {
+    return upcast(this)->getMemoryBudget();
+}
+
+size_t TextureStreamer::getResidentMemory() const noexcept {
+    return upcast(this)->getResidentMemory();
+}
+
+} // namespace filament
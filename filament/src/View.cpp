@@ -518,6 +518,17 @@ void FView::prepare(FEngine& engine, backend::DriverApi& driver, ArenaScope& are
         }
     }
 
+    /*
+     * Record the mipmap levels needed by streamed textures, given the size of the visible
+     * renderables on screen.
+     */
+
+    FTextureStreamer& textureStreamer = engine.getTextureStreamer();
+    if (UTILS_UNLIKELY(textureStreamer.hasTextures())) {
+        textureStreamer.prepareVisibleRenderables(renderableData, mVisibleRenderables,
+                mViewingCameraInfo, viewport);
+    }
+
     /*
      * Prepare lighting -- this is where we update the lights UBOs, set-up the IBL,
      * set-up the froxelization parameters.
@@ -565,6 +576,16 @@ void FView::prepare(FEngine& engine, backend::DriverApi& driver, ArenaScope& are
 
     // set uniforms and samplers
     bindPerViewUniformsAndSamplers(driver);
+
+    // skinned renderables with bones in a texture bind their own, every other program that
+    // declares the bones texture samples this empty one.
+    driver.bindSamplers(BindingPoints::PER_RENDERABLE_BONES, engine.getDummyBonesSamplerGroup());
+
+    // likewise for the weights and targets of renderables that use MorphTargetBuffers
+    driver.bindUniformBuffer(BindingPoints::PER_RENDERABLE_MORPHING,
+            engine.getDummyMorphingUniformBuffer());
+    driver.bindSamplers(BindingPoints::PER_RENDERABLE_MORPHING,
+            engine.getDummyMorphingSamplerGroup());
 }
 
 void FView::computeVisibilityMasks(
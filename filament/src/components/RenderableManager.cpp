@@ -22,7 +22,9 @@
 #include "details/VertexBuffer.h"
 #include "details/IndexBuffer.h"
 #include "details/Material.h"
+#include "details/MorphTargetBuffer.h"
 #include "details/RenderPrimitive.h"
+#include "details/SkinningBuffer.h"
 
 #include <backend/DriverEnums.h>
 
@@ -49,6 +51,7 @@ struct RenderableManager::BuilderDetails {
     size_t mSkinningBoneCount = 0;
     Bone const* mUserBones = nullptr;
     mat4f const* mUserBoneMatrices = nullptr;
+    FSkinningBuffer* mSkinningBuffer = nullptr;
 
     explicit BuilderDetails(size_t count)
             : mEntries(count), mCulling(true), mCastShadows(false), mReceiveShadows(true),
@@ -159,11 +162,27 @@ RenderableManager::Builder& RenderableManager::Builder::skinning(
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::skinning(
+        SkinningBuffer* skinningBuffer, size_t count) noexcept {
+    mImpl->mSkinningBoneCount = count;
+    mImpl->mSkinningBuffer = upcast(skinningBuffer);
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::morphing(bool enable) noexcept {
     mImpl->mMorphingEnabled = enable;
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::morphing(size_t index,
+        MorphTargetBuffer* morphTargetBuffer) noexcept {
+    if (index < mImpl->mEntries.size()) {
+        mImpl->mEntries[index].morphTargetBuffer = morphTargetBuffer;
+        mImpl->mMorphingEnabled = true;
+    }
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::blendOrder(size_t index, uint16_t blendOrder) noexcept {
     if (index < mImpl->mEntries.size()) {
         mImpl->mEntries[index].blendOrder = blendOrder;
@@ -174,8 +193,25 @@ RenderableManager::Builder& RenderableManager::Builder::blendOrder(size_t index,
 RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& engine, Entity entity) {
     bool isEmpty = true;
 
-    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->mSkinningBoneCount <= CONFIG_MAX_BONE_COUNT,
-            "bone count > %u", CONFIG_MAX_BONE_COUNT)) {
+    if (!ASSERT_PRECONDITION_NON_FATAL(
+            mImpl->mSkinningBoneCount <= CONFIG_MAX_BONE_TEXTURE_BONE_COUNT,
+            "bone count > %u", CONFIG_MAX_BONE_TEXTURE_BONE_COUNT)) {
+        return Error;
+    }
+
+    if (!ASSERT_PRECONDITION_NON_FATAL(!mImpl->mSkinningBuffer ||
+            mImpl->mSkinningBoneCount <= mImpl->mSkinningBuffer->getBoneCount(),
+            "bone count > skinning buffer size (%u)",
+            mImpl->mSkinningBuffer ? unsigned(mImpl->mSkinningBuffer->getBoneCount()) : 0u)) {
+        return Error;
+    }
+
+    // render commands only have room for an 8-bit primitive index, which selects the primitive's
+    // MorphTargetBuffer when drawing.
+    if (!ASSERT_PRECONDITION_NON_FATAL(!mImpl->mMorphingEnabled ||
+            mImpl->mEntries.size() <= CONFIG_MAX_MORPH_TARGET_COUNT,
+            "[entity=%u] morphing renderables can't have more than %u primitives",
+            entity.getId(), unsigned(CONFIG_MAX_MORPH_TARGET_COUNT))) {
         return Error;
     }
 
@@ -224,6 +260,29 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
                    << required << "), declared=" << declared << io::endl;
         }
 
+        if (!ASSERT_PRECONDITION_NON_FATAL(!entry.morphTargetBuffer ||
+                (i < CONFIG_MAX_MORPH_TARGET_COUNT &&
+                 entry.morphTargetBuffer->getVertexCount() >= entry.vertices->getVertexCount()),
+                "[entity=%u, primitive @ %u] MorphTargetBuffer vertex count (%u) < "
+                "vertex count (%u), or primitive index >= %u",
+                entity.getId(), i, entry.morphTargetBuffer ?
+                        unsigned(entry.morphTargetBuffer->getVertexCount()) : 0u,
+                entry.vertices->getVertexCount(), CONFIG_MAX_MORPH_TARGET_COUNT)) {
+            return Error;
+        }
+
+        // skeletons larger than CONFIG_MAX_BONE_COUNT are stored in a texture, which needs a
+        // free sampler in the material, otherwise the renderable would be drawn unskinned.
+        const size_t boneCount = mImpl->mSkinningBuffer ?
+                mImpl->mSkinningBuffer->getBoneCount() : mImpl->mSkinningBoneCount;
+        if (!ASSERT_PRECONDITION_NON_FATAL(
+                boneCount <= CONFIG_MAX_BONE_COUNT || material->hasBonesTexture(),
+                "[entity=%u, primitive @ %u] more than %u bones require a material that leaves "
+                "a sampler free for the bones texture",
+                entity.getId(), i, unsigned(CONFIG_MAX_BONE_COUNT))) {
+            return Error;
+        }
+
         // we have at least one valid primitive
         isEmpty = false;
     }
@@ -276,6 +335,13 @@ void FRenderableManager::create(
         }
         setPrimitives(ci, { rp, size_type(builder->mEntries.size()) });
 
+        for (size_t i = 0, c = builder->mEntries.size(); i < c; ++i) {
+            if (UTILS_UNLIKELY(entries[i].morphTargetBuffer)) {
+                createMorphWeights(ci);
+                break;
+            }
+        }
+
         setAxisAlignedBoundingBox(ci, builder->mAABB);
         setLayerMask(ci, builder->mLayerMask);
         setPriority(ci, builder->mPriority);
@@ -288,7 +354,31 @@ void FRenderableManager::create(
         setMorphWeights(ci, {0, 0, 0, 0});
 
         const size_t count = builder->mSkinningBoneCount;
-        if (UTILS_UNLIKELY(count > 0 || builder->mMorphingEnabled)) {
+        if (UTILS_UNLIKELY(builder->mSkinningBuffer)) {
+            // The bones are owned by the SkinningBuffer, there is nothing to allocate.
+            std::unique_ptr<Bones>& bones = manager[ci].bones;
+            bones = std::unique_ptr<Bones>(new Bones{
+                    builder->mSkinningBuffer->getHwHandle(), UniformBuffer{}, count, true,
+                    builder->mSkinningBuffer->getSamplerGroupHandle() });
+            setSkinning(ci, count > 0);
+        } else if (UTILS_UNLIKELY(count > CONFIG_MAX_BONE_COUNT)) {
+            // Too many bones for the UBO, they are stored in a texture owned by a private
+            // SkinningBuffer instead.
+            FSkinningBuffer* skinningBuffer = upcast(SkinningBuffer::Builder()
+                    .boneCount(uint32_t(count))
+                    .initialize(!builder->mUserBones && !builder->mUserBoneMatrices)
+                    .build(mEngine));
+            std::unique_ptr<Bones>& bones = manager[ci].bones;
+            bones = std::unique_ptr<Bones>(new Bones{
+                    skinningBuffer->getHwHandle(), UniformBuffer{}, count, true,
+                    skinningBuffer->getSamplerGroupHandle(), skinningBuffer });
+            setSkinning(ci, true);
+            if (builder->mUserBones) {
+                setBones(ci, builder->mUserBones, count);
+            } else if (builder->mUserBoneMatrices) {
+                setBones(ci, builder->mUserBoneMatrices, count);
+            }
+        } else if (UTILS_UNLIKELY(count > 0 || builder->mMorphingEnabled)) {
             std::unique_ptr<Bones>& bones = manager[ci].bones;
             // Note that we are sizing the bones UBO according to CONFIG_MAX_BONE_COUNT rather than
             // mSkinningBoneCount. According to the OpenGL ES 3.2 specification in 7.6.3 Uniform
@@ -362,8 +452,16 @@ void FRenderableManager::destroyComponent(Instance ci) noexcept {
 
     // destroy the bones structures if any
     std::unique_ptr<Bones> const& bones = manager[ci].bones;
-    if (bones) {
+    if (bones && !bones->skinningBufferMode) {
         driver.destroyUniformBuffer(bones->handle);
+    } else if (bones && bones->ownedSkinningBuffer) {
+        engine.destroy(bones->ownedSkinningBuffer);
+    }
+
+    // destroy the morph target weights if any
+    std::unique_ptr<MorphWeights> const& morphing = manager[ci].morphing;
+    if (morphing) {
+        driver.destroyUniformBuffer(morphing->handle);
     }
 }
 
@@ -383,14 +481,20 @@ void FRenderableManager::prepare(
     const auto& manager = mManager;
 
     std::unique_ptr<Bones>  const * const UTILS_RESTRICT bones = manager.raw_array<BONES>();
+    std::unique_ptr<MorphWeights> const * const UTILS_RESTRICT morphing =
+            manager.raw_array<MORPHING>();
     for (uint32_t index : list) {
         size_t i = instances[index].asValue();
         assert_invariant(i);  // we should never get the null instance here
-        if (UTILS_UNLIKELY(bones[i])) {
+        if (UTILS_UNLIKELY(bones[i] && !bones[i]->skinningBufferMode)) {
             if (bones[i]->bones.isDirty()) {
                 driver.loadUniformBuffer(bones[i]->handle, bones[i]->bones.toBufferDescriptor(driver));
             }
         }
+        if (UTILS_UNLIKELY(morphing[i] && morphing[i]->weights.isDirty())) {
+            driver.loadUniformBuffer(morphing[i]->handle,
+                    morphing[i]->weights.toBufferDescriptor(driver));
+        }
     }
 }
 
@@ -407,6 +511,7 @@ void FRenderableManager::setMaterialInstanceAt(Instance instance, uint8_t level,
                        << "] missing required attributes ("
                        << required << "), declared=" << declared << io::endl;
             }
+            checkBonesTexture(instance);
         }
     }
 }
@@ -472,7 +577,10 @@ void FRenderableManager::setBones(Instance ci,
     if (ci) {
         std::unique_ptr<Bones> const& bones = mManager[ci].bones;
         assert_invariant(bones && offset + boneCount <= bones->count);
-        if (bones) {
+        if (UTILS_UNLIKELY(bones && bones->ownedSkinningBuffer)) {
+            boneCount = std::min(boneCount, bones->count - offset);
+            bones->ownedSkinningBuffer->setBones(mEngine, transforms, boneCount, offset);
+        } else if (bones && !bones->skinningBufferMode) {
             boneCount = std::min(boneCount, bones->count - offset);
             PerRenderableUibBone* UTILS_RESTRICT out = (PerRenderableUibBone*)bones->bones.invalidateUniforms(
                     offset * sizeof(PerRenderableUibBone),
@@ -491,7 +599,10 @@ void FRenderableManager::setBones(Instance ci,
     if (ci) {
         std::unique_ptr<Bones> const& bones = mManager[ci].bones;
         assert_invariant(bones && offset + boneCount <= bones->count);
-        if (bones) {
+        if (UTILS_UNLIKELY(bones && bones->ownedSkinningBuffer)) {
+            boneCount = std::min(boneCount, bones->count - offset);
+            bones->ownedSkinningBuffer->setBones(mEngine, transforms, boneCount, offset);
+        } else if (bones && !bones->skinningBufferMode) {
             boneCount = std::min(boneCount, bones->count - offset);
             PerRenderableUibBone* UTILS_RESTRICT out = (PerRenderableUibBone*)bones->bones.invalidateUniforms(
                     offset * sizeof(PerRenderableUibBone),
@@ -503,12 +614,115 @@ void FRenderableManager::setBones(Instance ci,
     }
 }
 
+void FRenderableManager::setSkinningBuffer(Instance ci, FSkinningBuffer* skinningBuffer,
+        size_t count) noexcept {
+    if (ci) {
+        std::unique_ptr<Bones>& bones = mManager[ci].bones;
+        if (!ASSERT_PRECONDITION_NON_FATAL(bones && skinningBuffer, "renderable has no skinning")) {
+            return;
+        }
+        if (!ASSERT_PRECONDITION_NON_FATAL(count <= skinningBuffer->getBoneCount(),
+                "bone count > skinning buffer size (%u)", unsigned(skinningBuffer->getBoneCount()))) {
+            return;
+        }
+        if (!bones->skinningBufferMode) {
+            mEngine.getDriverApi().destroyUniformBuffer(bones->handle);
+            bones->bones = UniformBuffer{};
+            bones->skinningBufferMode = true;
+        } else if (bones->ownedSkinningBuffer) {
+            mEngine.destroy(bones->ownedSkinningBuffer);
+            bones->ownedSkinningBuffer = nullptr;
+        }
+        bones->handle = skinningBuffer->getHwHandle();
+        bones->samplers = skinningBuffer->getSamplerGroupHandle();
+        bones->count = count;
+        setSkinning(ci, count > 0);
+        checkBonesTexture(ci);
+    }
+}
+
+// Primitives whose material has no sampler left for the bones texture of a large skeleton are
+// drawn unskinned. This can't be an error, since either the material or the skinning buffer can
+// be changed later on, so it's reported once per call.
+void FRenderableManager::checkBonesTexture(Instance ci) const noexcept {
+    std::unique_ptr<Bones> const& bones = mManager[ci].bones;
+    if (!bones || !bones->samplers) {
+        return;
+    }
+    for (FRenderPrimitive const& primitive : getRenderPrimitives(ci, 0)) {
+        FMaterialInstance const* mi = primitive.getMaterialInstance();
+        if (mi && !mi->getMaterial()->hasBonesTexture()) {
+            slog.w << "[instance=" << ci.asValue() << "] " << bones->count
+                   << " bones require materials that leave a sampler free for the bones "
+                   << "texture, the renderable will be drawn unskinned" << io::endl;
+            return;
+        }
+    }
+}
+
 void FRenderableManager::setMorphWeights(Instance ci, const float4& weights) noexcept {
     if (ci) {
         mManager[ci].morphWeights = weights;
     }
 }
 
+void FRenderableManager::setMorphWeights(Instance ci, float const* UTILS_RESTRICT weights,
+        size_t count, size_t offset) noexcept {
+    if (ci) {
+        std::unique_ptr<MorphWeights> const& morphing = mManager[ci].morphing;
+        if (!ASSERT_PRECONDITION_NON_FATAL(morphing, "renderable has no MorphTargetBuffer")) {
+            return;
+        }
+        if (!ASSERT_PRECONDITION_NON_FATAL(offset + count <= CONFIG_MAX_MORPH_TARGET_COUNT,
+                "offset (%u) + count (%u) > %u",
+                unsigned(offset), unsigned(count), CONFIG_MAX_MORPH_TARGET_COUNT)) {
+            return;
+        }
+        UniformBuffer& ub = morphing->weights;
+        float* UTILS_RESTRICT out = (float*)ub.invalidateUniforms(
+                offsetof(PerRenderableMorphingUib, weights) + offset * sizeof(float),
+                count * sizeof(float));
+        std::copy_n(weights, count, out);
+
+        // the shader only blends the targets up to the last weight that was ever set
+        const uint32_t last = uint32_t(offset + count);
+        if (ub.getUniform<uint32_t>(offsetof(PerRenderableMorphingUib, count)) < last) {
+            ub.setUniform(offsetof(PerRenderableMorphingUib, count), last);
+        }
+    }
+}
+
+void FRenderableManager::setMorphTargetBufferAt(Instance ci, uint8_t level,
+        size_t primitiveIndex, FMorphTargetBuffer* morphTargetBuffer) noexcept {
+    if (ci) {
+        if (!ASSERT_PRECONDITION_NON_FATAL(getVisibility(ci).morphing,
+                "renderable was not created with morphing enabled")) {
+            return;
+        }
+        Slice<FRenderPrimitive>& primitives = getRenderPrimitives(ci, level);
+        if (primitiveIndex < std::min(primitives.size(), CONFIG_MAX_MORPH_TARGET_COUNT)) {
+            primitives[primitiveIndex].setMorphTargetBuffer(
+                    morphTargetBuffer ? morphTargetBuffer->getHwHandle() :
+                            backend::Handle<backend::HwSamplerGroup>{});
+            std::unique_ptr<MorphWeights> const& morphing = mManager[ci].morphing;
+            if (morphTargetBuffer && !morphing) {
+                createMorphWeights(ci);
+            }
+        }
+    }
+}
+
+void FRenderableManager::createMorphWeights(Instance ci) noexcept {
+    std::unique_ptr<MorphWeights>& morphing = mManager[ci].morphing;
+    morphing = std::unique_ptr<MorphWeights>(new MorphWeights{
+            mEngine.getDriverApi().createUniformBuffer(sizeof(PerRenderableMorphingUib),
+                    backend::BufferUsage::DYNAMIC),
+            UniformBuffer{ sizeof(PerRenderableMorphingUib) }
+    });
+    // the weights start at zero and no target is blended until they're set
+    morphing->weights.invalidate();
+}
+
 void FRenderableManager::makeBone(PerRenderableUibBone* UTILS_RESTRICT out, mat4f const& t) noexcept {
     mat4f m(t);
 
@@ -637,8 +851,23 @@ void RenderableManager::setBones(Instance instance,
     upcast(this)->setBones(instance, transforms, boneCount, offset);
 }
 
+void RenderableManager::setSkinningBuffer(Instance instance, SkinningBuffer* skinningBuffer,
+        size_t count) noexcept {
+    upcast(this)->setSkinningBuffer(instance, upcast(skinningBuffer), count);
+}
+
 void RenderableManager::setMorphWeights(Instance instance, float4 const& weights) noexcept {
     upcast(this)->setMorphWeights(instance, weights);
 }
 
+void RenderableManager::setMorphWeights(Instance instance, float const* weights,
+        size_t count, size_t offset) noexcept {
+    upcast(this)->setMorphWeights(instance, weights, count, offset);
+}
+
+void RenderableManager::setMorphTargetBufferAt(Instance instance, size_t primitiveIndex,
+        MorphTargetBuffer* morphTargetBuffer) noexcept {
+    upcast(this)->setMorphTargetBufferAt(instance, 0, primitiveIndex, upcast(morphTargetBuffer));
+}
+
 } // namespace filament
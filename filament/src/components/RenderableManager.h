@@ -37,12 +37,16 @@
 
 // for gtest
 class FilamentTest_Bones_Test;
+class FilamentTest_BonesTexture_Test;
+class FilamentTest_MorphTargetBuffer_Test;
 
 namespace filament {
 
 class FMaterialInstance;
 class FRenderPrimitive;
 class FIndexBuffer;
+class FMorphTargetBuffer;
+class FSkinningBuffer;
 class FVertexBuffer;
 
 class FRenderableManager : public RenderableManager {
@@ -113,6 +117,12 @@ public:
     inline void setBones(Instance instance, Bone const* transforms, size_t boneCount, size_t offset = 0) noexcept;
     inline void setBones(Instance instance, math::mat4f const* transforms, size_t boneCount, size_t offset = 0) noexcept;
     inline void setMorphWeights(Instance instance, const math::float4& weights) noexcept;
+    void setMorphWeights(Instance instance, float const* weights, size_t count,
+            size_t offset = 0) noexcept;
+    void setMorphTargetBufferAt(Instance instance, uint8_t level, size_t primitiveIndex,
+            FMorphTargetBuffer* morphTargetBuffer) noexcept;
+    void setSkinningBuffer(Instance instance, FSkinningBuffer* skinningBuffer,
+            size_t count) noexcept;
 
 
     inline bool isShadowCaster(Instance instance) const noexcept;
@@ -128,7 +138,9 @@ public:
     inline filament::math::float4 getMorphWeights(Instance instance) const noexcept;
 
     inline backend::Handle<backend::HwUniformBuffer> getBonesUbh(Instance instance) const noexcept;
+    inline backend::Handle<backend::HwSamplerGroup> getBonesSbh(Instance instance) const noexcept;
     inline uint32_t getBoneCount(Instance instance) const noexcept;
+    inline backend::Handle<backend::HwUniformBuffer> getMorphingUbh(Instance instance) const noexcept;
 
 
     inline size_t getLevelCount(Instance instance) const noexcept { return 1; }
@@ -148,16 +160,37 @@ public:
 
 private:
     void destroyComponent(Instance ci) noexcept;
+    void checkBonesTexture(Instance ci) const noexcept;
     static void destroyComponentPrimitives(FEngine& engine,
             utils::Slice<FRenderPrimitive>& primitives) noexcept;
 
+    // The bones of a renderable either live in a UBO that it owns, or in a SkinningBuffer that
+    // it shares with other renderables. In the latter case, the handles belong to the
+    // SkinningBuffer and the CPU-side copy is unused. Renderables created with more than
+    // CONFIG_MAX_BONE_COUNT bones and no SkinningBuffer get a private one, which stores the bones
+    // in a texture.
     struct Bones {
         filament::backend::Handle<backend::HwUniformBuffer> handle;
         UniformBuffer bones;
         size_t count;
+        bool skinningBufferMode = false;
+        filament::backend::Handle<backend::HwSamplerGroup> samplers;
+        FSkinningBuffer* ownedSkinningBuffer = nullptr;
     };
 
+    // The weights of the morph targets stored in MorphTargetBuffers, only allocated for
+    // renderables that have at least one primitive with a MorphTargetBuffer.
+    struct MorphWeights {
+        filament::backend::Handle<backend::HwUniformBuffer> handle;
+        UniformBuffer weights;
+    };
+
+    void createMorphWeights(Instance instance) noexcept;
+
     friend class ::FilamentTest_Bones_Test;
+    friend class ::FilamentTest_BonesTexture_Test;
+    friend class ::FilamentTest_MorphTargetBuffer_Test;
+    friend class FSkinningBuffer;
 
     static void makeBone(PerRenderableUibBone* out, math::mat4f const& transforms) noexcept;
 
@@ -168,6 +201,7 @@ private:
         VISIBILITY,         // user data
         PRIMITIVES,         // user data
         BONES,              // filament data, UBO storing a pointer to the bones information
+        MORPHING,           // filament data, UBO storing the weights of the morph target buffers
     };
 
     using Base = utils::SingleInstanceComponentManager<
@@ -176,7 +210,8 @@ private:
             filament::math::float4,          // MORPH_WEIGHTS
             Visibility,                      // VISIBILITY
             utils::Slice<FRenderPrimitive>,  // PRIMITIVES
-            std::unique_ptr<Bones>           // BONES
+            std::unique_ptr<Bones>,          // BONES
+            std::unique_ptr<MorphWeights>    // MORPHING
     >;
 
     struct Sim : public Base {
@@ -197,6 +232,7 @@ private:
                 Field<VISIBILITY>   visibility;
                 Field<PRIMITIVES>   primitives;
                 Field<BONES>        bones;
+                Field<MORPHING>     morphing;
             };
         };
 
@@ -328,11 +364,21 @@ backend::Handle<backend::HwUniformBuffer> FRenderableManager::getBonesUbh(Instan
     return bones ? bones->handle : backend::Handle<backend::HwUniformBuffer>{};
 }
 
+backend::Handle<backend::HwSamplerGroup> FRenderableManager::getBonesSbh(Instance instance) const noexcept {
+    std::unique_ptr<Bones> const& bones = mManager[instance].bones;
+    return bones ? bones->samplers : backend::Handle<backend::HwSamplerGroup>{};
+}
+
 inline uint32_t FRenderableManager::getBoneCount(Instance instance) const noexcept {
     std::unique_ptr<Bones> const& bones = mManager[instance].bones;
     return bones ? bones->count : 0;
 }
 
+backend::Handle<backend::HwUniformBuffer> FRenderableManager::getMorphingUbh(Instance instance) const noexcept {
+    std::unique_ptr<MorphWeights> const& morphing = mManager[instance].morphing;
+    return morphing ? morphing->handle : backend::Handle<backend::HwUniformBuffer>{};
+}
+
 utils::Slice<FRenderPrimitive> const& FRenderableManager::getRenderPrimitives(
         Instance instance, uint8_t level) const noexcept {
     return mManager[instance].primitives;
@@ -448,6 +448,10 @@ void TransformManager::commitLocalTransformTransaction() noexcept {
     upcast(this)->commitLocalTransformTransaction();
 }
 
+bool TransformManager::isLocalTransformTransactionOpen() const noexcept {
+    return upcast(this)->isLocalTransformTransactionOpen();
+}
+
 TransformManager::children_iterator TransformManager::getChildrenBegin(
         TransformManager::Instance parent) const noexcept {
     return upcast(this)->getChildrenBegin(parent);
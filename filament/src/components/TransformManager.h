@@ -75,6 +75,10 @@ public:
 
     void commitLocalTransformTransaction() noexcept;
 
+    bool isLocalTransformTransactionOpen() const noexcept {
+        return mLocalTransformTransactionOpen;
+    }
+
     void gc(utils::EntityManager& em) noexcept;
 
     utils::Slice<const math::mat4f> getWorldTransforms() const noexcept {
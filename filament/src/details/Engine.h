@@ -32,6 +32,9 @@
 #include "details/Fence.h"
 #include "details/IndexBuffer.h"
 #include "details/RenderTarget.h"
+#include "details/MorphTargetBuffer.h"
+#include "details/SkinningBuffer.h"
+#include "details/TextureStreamer.h"
 #include "details/ResourceList.h"
 #include "details/ColorGrading.h"
 #include "details/Skybox.h"
@@ -166,6 +169,22 @@ public:
         return mFullScreenTriangleRph;
     }
 
+    backend::Handle<backend::HwUniformBuffer> getDummyBonesUniformBuffer() const noexcept {
+        return mDummyBonesUbh;
+    }
+
+    backend::Handle<backend::HwSamplerGroup> getDummyBonesSamplerGroup() const noexcept {
+        return mDummyBonesSbh;
+    }
+
+    backend::Handle<backend::HwUniformBuffer> getDummyMorphingUniformBuffer() const noexcept {
+        return mDummyMorphingUbh;
+    }
+
+    backend::Handle<backend::HwSamplerGroup> getDummyMorphingSamplerGroup() const noexcept {
+        return mDummyMorphingSbh;
+    }
+
     FVertexBuffer* getFullScreenVertexBuffer() const noexcept {
         return mFullScreenTriangleVb;
     }
@@ -198,6 +217,10 @@ public:
         return mTransformManager;
     }
 
+    FTextureStreamer& getTextureStreamer() noexcept {
+        return mTextureStreamer;
+    }
+
     utils::EntityManager& getEntityManager() noexcept {
         return mEntityManager;
     }
@@ -210,6 +233,10 @@ public:
         return mBackend;
     }
 
+    void setAsynchronousShaderCompilation(bool enabled) noexcept {
+        getDriverApi().setAsyncProgramCompilation(enabled);
+    }
+
     ResourceAllocator& getResourceAllocator() noexcept {
         assert_invariant(mResourceAllocator);
         return *mResourceAllocator;
@@ -226,6 +253,8 @@ public:
     T* create(ResourceList<T>& list, typename T::Builder const& builder) noexcept;
 
     FBufferObject* createBufferObject(const BufferObject::Builder& builder) noexcept;
+    FSkinningBuffer* createSkinningBuffer(const SkinningBuffer::Builder& builder) noexcept;
+    FMorphTargetBuffer* createMorphTargetBuffer(const MorphTargetBuffer::Builder& builder) noexcept;
     FVertexBuffer* createVertexBuffer(const VertexBuffer::Builder& builder) noexcept;
     FIndexBuffer* createIndexBuffer(const IndexBuffer::Builder& builder) noexcept;
     FIndirectLight* createIndirectLight(const IndirectLight::Builder& builder) noexcept;
@@ -254,6 +283,8 @@ public:
 
 
     bool destroy(const FBufferObject* p);
+    bool destroy(const FSkinningBuffer* p);
+    bool destroy(const FMorphTargetBuffer* p);
     bool destroy(const FVertexBuffer* p);
     bool destroy(const FFence* p);
     bool destroy(const FIndexBuffer* p);
@@ -285,9 +316,18 @@ public:
         return mPlatform->pumpEvents();
     }
 
+    // whether the application provided a persistent cache for compiled programs
+    bool hasBlobCache() const noexcept {
+        return mPlatform->hasBlobFunc();
+    }
+
     void prepare();
     void gc();
 
+    // makes all material instances sampling a texture sample another one instead
+    void replaceTexture(backend::Handle<backend::HwTexture> from,
+            backend::Handle<backend::HwTexture> to) noexcept;
+
     filaflat::ShaderBuilder& getVertexShaderBuilder() const noexcept {
         return mVertexShaderBuilder;
     }
@@ -334,6 +374,12 @@ private:
     backend::Handle<backend::HwRenderPrimitive> mFullScreenTriangleRph;
     FVertexBuffer* mFullScreenTriangleVb = nullptr;
     FIndexBuffer* mFullScreenTriangleIb = nullptr;
+    backend::Handle<backend::HwUniformBuffer> mDummyBonesUbh;
+    backend::Handle<backend::HwTexture> mDummyBonesTexture;
+    backend::Handle<backend::HwSamplerGroup> mDummyBonesSbh;
+    backend::Handle<backend::HwUniformBuffer> mDummyMorphingUbh;
+    backend::Handle<backend::HwTexture> mDummyMorphingTexture;
+    backend::Handle<backend::HwSamplerGroup> mDummyMorphingSbh;
 
     PostProcessManager mPostProcessManager;
 
@@ -342,9 +388,12 @@ private:
     FTransformManager mTransformManager;
     FLightManager mLightManager;
     FCameraManager mCameraManager;
+    FTextureStreamer mTextureStreamer;
     ResourceAllocator* mResourceAllocator = nullptr;
 
     ResourceList<FBufferObject> mBufferObjects{ "BufferObject" };
+    ResourceList<FSkinningBuffer> mSkinningBuffers{ "SkinningBuffer" };
+    ResourceList<FMorphTargetBuffer> mMorphTargetBuffers{ "MorphTargetBuffer" };
     ResourceList<FRenderer> mRenderers{ "Renderer" };
     ResourceList<FView> mViews{ "View" };
     ResourceList<FScene> mScenes{ "Scene" };
@@ -33,6 +33,7 @@
 #include <utils/compiler.h>
 
 #include <atomic>
+#include <bitset>
 
 namespace filament {
 
@@ -70,6 +71,9 @@ public:
 
     bool isSampler(const char* name) const noexcept;
 
+    // whether the material leaves a sampler free for the bones texture of large skeletons
+    bool hasBonesTexture() const noexcept;
+
     UniformInterfaceBlock::UniformInfo const* reflect(utils::StaticString const& name) const noexcept;
 
     FMaterialInstance const* getDefaultInstance() const noexcept { return &mDefaultInstance; }
@@ -83,19 +87,29 @@ public:
             const_cast<FMaterial*>(this)->applyPendingEdits();
         }
 #endif
-        backend::Handle<backend::HwProgram> const entry = mCachedPrograms[variantKey];
-        return UTILS_LIKELY(entry) ? entry : getProgramSlow(variantKey);
+        if (UTILS_UNLIKELY(mVariantRecording)) {
+            mRecordedVariants.set(variantKey);
+        }
+        return getCachedProgram(variantKey);
     }
     backend::Program getProgramBuilderWithVariants(uint8_t variantKey, uint8_t vertexVariantKey,
             uint8_t fragmentVariantKey) const noexcept;
     backend::Handle<backend::HwProgram> createAndCacheProgram(backend::Program&& p,
             uint8_t variantKey) const noexcept;
 
+    void compile(UserVariantFilterMask variants,
+            CompilationCallback callback, void* user) noexcept;
+
+    void setVariantRecording(bool enabled) noexcept { mVariantRecording = enabled; }
+    size_t getRecordedVariants(uint8_t* variants, size_t count) const noexcept;
+    void clearRecordedVariants() noexcept { mRecordedVariants.reset(); }
+
     bool isVariantLit() const noexcept { return mIsVariantLit; }
 
     const utils::CString& getName() const noexcept { return mName; }
     backend::RasterState getRasterState() const noexcept  { return mRasterState; }
     uint32_t getId() const noexcept { return mMaterialId; }
+    uint64_t getCacheId() const noexcept { return mCacheId; }
 
     Shading getShading() const noexcept { return mShading; }
     Interpolation getInterpolation() const noexcept { return mInterpolation; }
@@ -156,13 +170,22 @@ public:
     /** @}*/
 
 private:
+    backend::Handle<backend::HwProgram> getCachedProgram(uint8_t variantKey) const noexcept {
+        backend::Handle<backend::HwProgram> const entry = mCachedPrograms[variantKey];
+        return UTILS_LIKELY(entry) ? entry : getProgramSlow(variantKey);
+    }
     backend::Handle<backend::HwProgram> getProgramSlow(uint8_t variantKey) const noexcept;
+    uint8_t getFallbackVariant(uint8_t variantKey) const noexcept;
     backend::Handle<backend::HwProgram> getSurfaceProgramSlow(uint8_t variantKey) const noexcept;
     backend::Handle<backend::HwProgram> getPostProcessProgramSlow(uint8_t variantKey) const noexcept;
 
     // try to order by frequency of use
     mutable std::array<backend::Handle<backend::HwProgram>, VARIANT_COUNT> mCachedPrograms;
 
+    // variants requested through getProgram() while recording is enabled
+    mutable std::bitset<VARIANT_COUNT> mRecordedVariants;
+    bool mVariantRecording = false;
+
     backend::RasterState mRasterState;
     BlendingMode mRenderBlendingMode = BlendingMode::OPAQUE;
     TransparencyMode mTransparencyMode = TransparencyMode::DEFAULT;
@@ -203,6 +226,9 @@ private:
     utils::CString mName;
     FEngine& mEngine;
     const uint32_t mMaterialId;
+
+    // hash of the material package, identifies our programs in the platform's blob cache
+    uint64_t mCacheId = 0;
     mutable uint32_t mMaterialInstanceId = 0;
     MaterialParser* mMaterialParser = nullptr;
     std::atomic<MaterialParser*> mPendingEdits = {};
@@ -119,6 +119,10 @@ public:
     void setParameter(const char* name,
             backend::Handle<backend::HwTexture> texture, backend::SamplerParams params) noexcept;
 
+    // samples texture "to" wherever texture "from" was sampled
+    void replaceTexture(backend::Handle<backend::HwTexture> from,
+            backend::Handle<backend::HwTexture> to) noexcept;
+
     using MaterialInstance::setParameter;
 
 private:
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_MORPHTARGETBUFFER_H
+#define TNT_FILAMENT_DETAILS_MORPHTARGETBUFFER_H
+
+#include "upcast.h"
+
+#include "private/backend/DriverApiForward.h"
+#include <backend/Handle.h>
+
+#include <filament/MorphTargetBuffer.h>
+
+#include <utils/compiler.h>
+
+#include <math/vec2.h>
+#include <math/vec4.h>
+
+namespace filament {
+
+class FEngine;
+
+class FMorphTargetBuffer : public MorphTargetBuffer {
+public:
+    FMorphTargetBuffer(FEngine& engine, const Builder& builder);
+
+    // frees driver resources, object becomes invalid
+    void terminate(FEngine& engine);
+
+    void setPositionsAt(FEngine& engine, size_t targetIndex,
+            math::float3 const* positions, size_t count);
+
+    void setPositionsAt(FEngine& engine, size_t targetIndex,
+            math::float4 const* positions, size_t count);
+
+    void setTangentsAt(FEngine& engine, size_t targetIndex,
+            math::short4 const* tangents, size_t count);
+
+    size_t getVertexCount() const noexcept { return mVertexCount; }
+    size_t getCount() const noexcept { return mCount; }
+
+    backend::Handle<backend::HwSamplerGroup> getHwHandle() const noexcept {
+        return mSamplerGroupHandle;
+    }
+
+    // Layout of each layer of the texture: the positions of all the vertices, followed by their
+    // tangents starting on a new row. Each vertex takes one RGBA32F texel.
+    static math::uint2 getTextureSize(size_t vertexCount) noexcept;
+    static math::uint2 getPositionTexel(size_t vertexIndex) noexcept;
+    static math::uint2 getTangentTexel(size_t vertexIndex, size_t vertexCount) noexcept;
+
+private:
+    friend class MorphTargetBuffer;
+
+    // uploads the rows of one target that start at firstRow, data is consumed
+    void update(FEngine& engine, size_t targetIndex, size_t firstRow, math::float4* data);
+
+    backend::Handle<backend::HwTexture> mTexture;
+    backend::Handle<backend::HwSamplerGroup> mSamplerGroupHandle;
+    uint32_t mVertexCount;
+    uint32_t mCount;
+};
+
+FILAMENT_UPCAST(MorphTargetBuffer)
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_MORPHTARGETBUFFER_H
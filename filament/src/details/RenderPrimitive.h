@@ -53,15 +53,22 @@ public:
     backend::PrimitiveType getPrimitiveType() const noexcept { return mPrimitiveType; }
     AttributeBitset getEnabledAttributes() const noexcept { return mEnabledAttributes; }
     uint16_t getBlendOrder() const noexcept { return mBlendOrder; }
+    backend::Handle<backend::HwSamplerGroup> getMorphTargetBuffer() const noexcept {
+        return mMorphTargetBuffer;
+    }
 
     void setMaterialInstance(FMaterialInstance const* mi) noexcept { mMaterialInstance = mi; }
     void setBlendOrder(uint16_t order) noexcept {
         mBlendOrder = static_cast<uint16_t>(order & 0x7FFF);
     }
+    void setMorphTargetBuffer(backend::Handle<backend::HwSamplerGroup> sbh) noexcept {
+        mMorphTargetBuffer = sbh;
+    }
 
 private:
     FMaterialInstance const* mMaterialInstance = nullptr;
     backend::Handle<backend::HwRenderPrimitive> mHandle;
+    backend::Handle<backend::HwSamplerGroup> mMorphTargetBuffer;
     backend::PrimitiveType mPrimitiveType = backend::PrimitiveType::NONE;
     AttributeBitset mEnabledAttributes;
     uint16_t mBlendOrder = 0;
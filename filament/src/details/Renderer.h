@@ -81,6 +81,8 @@ public:
 
     void render(FView const* view);
 
+    void warmUp(FView const* view);
+
     void readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             backend::PixelBufferDescriptor&& buffer);
 
@@ -197,6 +199,7 @@ private:
     backend::TextureFormat mHdrQualityMedium{};
     backend::TextureFormat mHdrQualityHigh{};
     bool mIsRGB8Supported : 1;
+    bool mWarmUpOnly = false;
     Epoch mUserEpoch;
     math::float4 mShaderUserTime{};
     DisplayInfo mDisplayInfo;
@@ -104,6 +104,8 @@ public:
         REVERSED_WINDING_ORDER, //  1 | det(WORLD_TRANSFORM)<0
         VISIBILITY_STATE,       //  1 | visibility data of the component
         BONES_UBH,              //  4 | bones uniform buffer handle
+        BONES_SBH,              //  4 | bones sampler group handle, for large skeletons only
+        MORPHING_UBH,           //  4 | morph target weights handle, for MorphTargetBuffers only
         WORLD_AABB_CENTER,      // 12 | world-space bounding box center of the renderable
         VISIBLE_MASK,           //  1 | each bit represents a visibility in a pass
         MORPH_WEIGHTS,          //  4 | floats for morphing
@@ -123,6 +125,8 @@ public:
             bool,                                       // REVERSED_WINDING_ORDER
             FRenderableManager::Visibility,             // VISIBILITY_STATE
             backend::Handle<backend::HwUniformBuffer>,  // BONES_UBH
+            backend::Handle<backend::HwSamplerGroup>,   // BONES_SBH
+            backend::Handle<backend::HwUniformBuffer>,  // MORPHING_UBH
             math::float3,                               // WORLD_AABB_CENTER
             VisibleMaskType,                            // VISIBLE_MASK
             math::float4,                               // MORPH_WEIGHTS
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_SKINNINGBUFFER_H
+#define TNT_FILAMENT_DETAILS_SKINNINGBUFFER_H
+
+#include "upcast.h"
+
+#include "UniformBuffer.h"
+
+#include "private/backend/DriverApiForward.h"
+#include <backend/Handle.h>
+
+#include <filament/SkinningBuffer.h>
+
+#include <utils/compiler.h>
+
+#include <math/vec2.h>
+
+namespace filament {
+
+class FEngine;
+
+class FSkinningBuffer : public SkinningBuffer {
+public:
+    FSkinningBuffer(FEngine& engine, const Builder& builder);
+
+    // frees driver resources, object becomes invalid
+    void terminate(FEngine& engine);
+
+    void setBones(FEngine& engine, RenderableManager::Bone const* transforms,
+            size_t boneCount, size_t offset);
+
+    void setBones(FEngine& engine, math::mat4f const* transforms,
+            size_t boneCount, size_t offset);
+
+    size_t getBoneCount() const noexcept { return mBoneCount; }
+
+    // Skeletons larger than CONFIG_MAX_BONE_COUNT are stored in a texture, in which case the
+    // uniform buffer is the engine's dummy one.
+    backend::Handle<backend::HwUniformBuffer> getHwHandle() const noexcept { return mHandle; }
+
+    backend::Handle<backend::HwSamplerGroup> getSamplerGroupHandle() const noexcept {
+        return mSamplerGroupHandle;
+    }
+
+    // Layout of the bones texture: each row holds CONFIG_BONE_TEXTURE_ROW_SIZE bones, and each
+    // bone is made of 4 consecutive RGBA32F texels.
+    static math::uint2 getTextureSize(size_t boneCount) noexcept;
+    static math::uint2 getBoneTexel(size_t boneIndex, size_t component) noexcept;
+
+private:
+    friend class SkinningBuffer;
+
+    static size_t getStorageSize(size_t boneCount) noexcept;
+
+    void commit(backend::DriverApi& driver, size_t offset, size_t boneCount);
+
+    backend::Handle<backend::HwUniformBuffer> mHandle;
+    backend::Handle<backend::HwTexture> mTexture;
+    backend::Handle<backend::HwSamplerGroup> mSamplerGroupHandle;
+    UniformBuffer mBones;
+    uint32_t mBoneCount;
+};
+
+FILAMENT_UPCAST(SkinningBuffer)
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_SKINNINGBUFFER_H
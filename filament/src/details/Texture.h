@@ -116,6 +116,12 @@ public:
 
 private:
     friend class Texture;
+    friend class FTextureStreamer;
+
+    // where setImage() uploads the given level, false if that level isn't resident
+    bool getUploadTarget(FEngine& engine, size_t level,
+            backend::Handle<backend::HwTexture>* handle, uint8_t* hwLevel) const noexcept;
+
     FStream* mStream = nullptr;
     backend::Handle<backend::HwTexture> mHandle;
     uint32_t mWidth = 1;
@@ -126,6 +132,9 @@ private:
     uint8_t mLevelCount = 1;
     uint8_t mSampleCount = 1;
     Usage mUsage = Usage::DEFAULT;
+    uint8_t mBaseLevel = 0;     // level stored at level 0 of mHandle, see FTextureStreamer
+    bool mStreamable = true;    // false for imported and swizzled textures
+    bool mStreamed = false;
 };
 
 
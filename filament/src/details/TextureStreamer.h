@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
+#define TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
+
+#include "upcast.h"
+
+#include "details/Scene.h"
+
+#include <backend/Handle.h>
+
+#include <filament/TextureStreamer.h>
+#include <filament/Viewport.h>
+
+#include <utils/compiler.h>
+#include <utils/Range.h>
+
+#include <tsl/robin_map.h>
+
+#include <limits>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class FEngine;
+class FTexture;
+struct CameraInfo;
+
+class FTextureStreamer : public TextureStreamer {
+public:
+    explicit FTextureStreamer(FEngine& engine) noexcept;
+
+    // frees driver resources of the textures being loaded
+    void terminate();
+
+    void addTexture(FTexture* texture, LevelCallback callback, void* user);
+    void removeTexture(FTexture* texture) noexcept;
+    void setPriority(FTexture* texture, float priority) noexcept;
+    size_t getResidentLevel(FTexture const* texture) const noexcept;
+
+    void setMemoryBudget(size_t budget) noexcept { mBudget = budget; }
+    size_t getMemoryBudget() const noexcept { return mBudget; }
+    size_t getResidentMemory() const noexcept;
+
+    bool hasTextures() const noexcept { return !mEntries.empty(); }
+
+    // Called by the views for their visible renderables: records the finest level needed by the
+    // streamed textures they sample, given their size on screen.
+    void prepareVisibleRenderables(FScene::RenderableSoa const& renderableData,
+            utils::Range<uint32_t> visible, CameraInfo const& camera,
+            Viewport const& viewport) noexcept;
+
+    // Called once per frame, before material instances are committed: picks the levels to keep
+    // resident given the needs recorded in the previous frame and the budget, requests missing
+    // levels, and starts using the textures whose levels have all been provided.
+    void update();
+
+    // Where Texture::setImage() uploads a level of a streamed texture. Returns false if the level
+    // isn't needed.
+    bool getUploadTarget(FTexture const* texture, size_t level,
+            backend::Handle<backend::HwTexture>* handle, uint8_t* hwLevel) noexcept;
+
+private:
+    static constexpr uint8_t UNSEEN = std::numeric_limits<uint8_t>::max();
+
+    struct Entry {
+        FTexture* texture = nullptr;
+        LevelCallback callback = nullptr;
+        void* user = nullptr;
+        float priority = 1.0f;
+        uint8_t tailLevel = 0;          // levels from here are always resident
+        uint8_t targetLevel = 0;        // first level we want resident
+        uint8_t neededLevel = UNSEEN;   // finest level needed by the views since the last update
+        uint8_t minLevel = 0;           // first level sampled in the current hw texture
+        uint8_t pendingLevel = 0;       // first level of the hw texture being loaded
+        uint64_t missingLevels = 0;     // levels not yet provided to the hw texture being loaded
+        bool resident = false;          // the levels of the current hw texture have been provided
+        backend::Handle<backend::HwTexture> pending;
+    };
+
+    struct Request {
+        FTexture const* texture;
+        uint8_t level;
+    };
+
+    static size_t getLevelSize(FTexture const* texture, size_t level) noexcept;
+    static size_t getSize(FTexture const* texture, size_t baseLevel) noexcept;
+
+    void startPendingTexture(Entry& entry, uint8_t level);
+    void copyLevel(Entry const& entry, size_t level);
+    void applyTargetLevel(Entry& entry, bool overBudget);
+    void swapPendingTexture(Entry& entry) noexcept;
+    void callLevelCallbacks();
+
+    FEngine& mEngine;
+    tsl::robin_map<FTexture const*, Entry> mEntries;
+    tsl::robin_map<backend::HandleBase::HandleId, FTexture*> mTextures; // by current hw handle
+    std::vector<Request> mRequests;
+    size_t mBudget = std::numeric_limits<size_t>::max();
+};
+
+FILAMENT_UPCAST(TextureStreamer)
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
@@ -16,9 +16,11 @@
 
 #include <iostream>
 #include <random>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <math/vec2.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 #include <math/mat3.h>
@@ -31,6 +33,14 @@
 #include <filament/Frustum.h>
 #include <filament/Material.h>
 #include <filament/Engine.h>
+#include <filament/MorphTargetBuffer.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/Skybox.h>
+#include <filament/SkinningBuffer.h>
+#include <filament/Texture.h>
+#include <filament/TextureStreamer.h>
+#include <filament/View.h>
 
 #include <private/filament/UniformInterfaceBlock.h>
 #include <private/filament/UibGenerator.h>
@@ -41,6 +51,10 @@
 #include "details/Camera.h"
 #include "details/Froxelizer.h"
 #include "details/Engine.h"
+#include "details/MorphTargetBuffer.h"
+#include "details/RenderPrimitive.h"
+#include "details/SkinningBuffer.h"
+#include "details/Texture.h"
 #include "components/RenderableManager.h"
 #include "components/TransformManager.h"
 #include "UniformBuffer.h"
@@ -213,7 +227,9 @@ TEST(FilamentTest, TransformManager) {
     EXPECT_EQ(tcm.getWorldTransform(child), mat4f{ float4{ 2 }});
 
     // test local transaction
+    EXPECT_FALSE(tcm.isLocalTransformTransactionOpen());
     tcm.openLocalTransformTransaction();
+    EXPECT_TRUE(tcm.isLocalTransformTransactionOpen());
     tcm.setTransform(parent, mat4f{ float4{ 4 }});
 
     // check the transforms ARE NOT propagated
@@ -223,6 +239,7 @@ TEST(FilamentTest, TransformManager) {
     EXPECT_EQ(tcm.getWorldTransform(child), mat4f{ float4{ 2 }});
 
     tcm.commitLocalTransformTransaction();
+    EXPECT_FALSE(tcm.isLocalTransformTransactionOpen());
     // test propagation after closing the transaction
     EXPECT_EQ(tcm.getTransform(parent), mat4f{ float4{ 4 }});
     EXPECT_EQ(tcm.getWorldTransform(parent), mat4f{ float4{ 4 }});
@@ -860,6 +877,391 @@ TEST(FilamentTest, Bones) {
     }
 }
 
+TEST(FilamentTest, BonesTexture) {
+    // Bones that don't fit in the UBO are packed in a RGBA32F texture, this emulates the
+    // shader's fetches (see getBone() in getters.vs) and checks the transforms survive the trip.
+    const size_t boneCount = 700;
+    const uint2 size = FSkinningBuffer::getTextureSize(boneCount);
+    EXPECT_EQ(CONFIG_BONE_TEXTURE_ROW_SIZE * 4, size.x);
+    EXPECT_EQ(3, size.y);
+    EXPECT_EQ(uint2(1, 0), FSkinningBuffer::getBoneTexel(0, 1));
+    EXPECT_EQ(uint2(0, 1), FSkinningBuffer::getBoneTexel(CONFIG_BONE_TEXTURE_ROW_SIZE, 0));
+
+    std::default_random_engine generator(82828);
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+    auto rand_gen = std::bind(distribution, generator);
+
+    std::vector<mat4f> transforms(boneCount);
+    std::vector<PerRenderableUibBone> storage(size.y * CONFIG_BONE_TEXTURE_ROW_SIZE);
+    for (size_t i = 0; i < boneCount; i++) {
+        transforms[i] = mat4f::translation(float3{ rand_gen(), rand_gen(), rand_gen() }) *
+                mat4f::rotation(rand_gen(), normalize(float3{ rand_gen(), rand_gen(), 1 })) *
+                mat4f::scaling(float3{ 2, 0.5, -3 });
+        FRenderableManager::makeBone(&storage[i], transforms[i]);
+    }
+
+    float4 const* texels = (float4 const*)storage.data();
+    for (size_t i = 0; i < boneCount; i++) {
+        float4 bone[4];
+        for (size_t k = 0; k < 4; k++) {
+            uint2 xy = FSkinningBuffer::getBoneTexel(i, k);
+            ASSERT_LT(xy.x, size.x);
+            ASSERT_LT(xy.y, size.y);
+            bone[k] = texels[xy.y * size.x + xy.x];
+        }
+        // same as mulBoneVertex() in getters.vs
+        float3 p{ rand_gen(), rand_gen(), rand_gen() };
+        float3 v = p * bone[2].xyz;
+        v += 2.0f * cross(bone[0].xyz, cross(bone[0].xyz, v) + bone[0].w * v);
+        v += bone[1].xyz;
+        float3 e = (transforms[i] * p).xyz;
+        for (size_t j = 0; j < 3; j++) {
+            EXPECT_NEAR(e[j], v[j], 1e-3 * std::max(1.0f, std::abs(e[j])));
+        }
+    }
+}
+
+TEST(FilamentTest, SkinningBufferTexture) {
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    FRenderableManager& rcm = engine->getRenderableManager();
+
+    SkinningBuffer* sb = SkinningBuffer::Builder()
+            .boneCount(1000)
+            .initialize()
+            .build(*engine);
+    EXPECT_EQ(1000, sb->getBoneCount());
+    EXPECT_TRUE(bool(upcast(sb)->getSamplerGroupHandle()));
+    EXPECT_EQ(engine->getDummyBonesUniformBuffer(), upcast(sb)->getHwHandle());
+
+    Entity shared = engine->getEntityManager().create();
+    RenderableManager::Builder(1).culling(false).castShadows(false).receiveShadows(false)
+            .skinning(sb, 1000)
+            .build(*engine, shared);
+    auto ci0 = rcm.getInstance(shared);
+    EXPECT_EQ(upcast(sb)->getSamplerGroupHandle(), rcm.getBonesSbh(ci0));
+    EXPECT_EQ(1000, rcm.getBoneCount(ci0));
+
+    // Renderables with too many bones for the UBO get a private texture.
+    std::vector<mat4f> transforms(1000);
+    Entity owned = engine->getEntityManager().create();
+    RenderableManager::Builder(1).culling(false).castShadows(false).receiveShadows(false)
+            .skinning(600, transforms.data())
+            .build(*engine, owned);
+    auto ci1 = rcm.getInstance(owned);
+    EXPECT_TRUE(bool(rcm.getBonesSbh(ci1)));
+    EXPECT_TRUE(bool(rcm.getBonesUbh(ci1)));
+    EXPECT_NE(upcast(sb)->getSamplerGroupHandle(), rcm.getBonesSbh(ci1));
+    rcm.setBones(ci1, transforms.data(), 100, 500);
+
+    sb->setBones(*engine, transforms.data(), 1000);
+    sb->setBones(*engine, transforms.data(), 10, 300);
+
+    // Switching to a shared buffer releases the private one.
+    rcm.setSkinningBuffer(ci1, upcast(sb), 1000);
+    EXPECT_EQ(upcast(sb)->getSamplerGroupHandle(), rcm.getBonesSbh(ci1));
+
+    engine->destroy(shared);
+    engine->destroy(owned);
+    engine->destroy(upcast(sb));
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, SkinningBuffer) {
+    FEngine* engine = FEngine::create();
+    FRenderableManager& rcm = engine->getRenderableManager();
+
+    SkinningBuffer* sb = SkinningBuffer::Builder()
+            .boneCount(4)
+            .initialize()
+            .build(*engine);
+    EXPECT_EQ(4, sb->getBoneCount());
+
+    Entity shared[2] = { engine->getEntityManager().create(), engine->getEntityManager().create() };
+    for (Entity e : shared) {
+        RenderableManager::Builder(1).culling(false).castShadows(false).receiveShadows(false)
+                .skinning(sb, 4)
+                .build(*engine, e);
+    }
+
+    // Renderables built from the same skinning buffer reference the same bones.
+    auto ci0 = rcm.getInstance(shared[0]);
+    auto ci1 = rcm.getInstance(shared[1]);
+    EXPECT_EQ(upcast(sb)->getHwHandle(), rcm.getBonesUbh(ci0));
+    EXPECT_EQ(upcast(sb)->getHwHandle(), rcm.getBonesUbh(ci1));
+    EXPECT_EQ(4, rcm.getBoneCount(ci0));
+
+    // A renderable with its own bones can be switched to the shared buffer later on.
+    Entity owned = engine->getEntityManager().create();
+    RenderableManager::Builder(1).culling(false).castShadows(false).receiveShadows(false)
+            .skinning(2)
+            .build(*engine, owned);
+    auto ci2 = rcm.getInstance(owned);
+    EXPECT_NE(upcast(sb)->getHwHandle(), rcm.getBonesUbh(ci2));
+    rcm.setSkinningBuffer(ci2, upcast(sb), 3);
+    EXPECT_EQ(upcast(sb)->getHwHandle(), rcm.getBonesUbh(ci2));
+    EXPECT_EQ(3, rcm.getBoneCount(ci2));
+
+    mat4f transforms[4];
+    sb->setBones(*engine, transforms, 4);
+
+    engine->destroy(shared[0]);
+    engine->destroy(shared[1]);
+    engine->destroy(owned);
+    engine->destroy(upcast(sb));
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, MorphTargetTexels) {
+    // Same addressing as getMorphTargetTexel() in getters.vs: positions fill the first half of
+    // each layer and tangents the second half, every vertex taking one texel of each.
+    const size_t vertexCount = 5000;
+    const uint2 size = FMorphTargetBuffer::getTextureSize(vertexCount);
+    EXPECT_EQ(CONFIG_MORPH_TARGET_TEXTURE_WIDTH, size.x);
+    EXPECT_EQ(6, size.y);
+    EXPECT_EQ(uint2(CONFIG_MORPH_TARGET_TEXTURE_WIDTH, 2), FMorphTargetBuffer::getTextureSize(1));
+
+    for (size_t i : { size_t(0), size_t(1), size_t(2047), size_t(2048), vertexCount - 1 }) {
+        const uint2 p = FMorphTargetBuffer::getPositionTexel(i);
+        const uint2 t = FMorphTargetBuffer::getTangentTexel(i, vertexCount);
+        EXPECT_EQ(i, p.y * size.x + p.x);
+        EXPECT_EQ(p.x, t.x);
+        EXPECT_EQ(p.y + size.y / 2, t.y);
+        EXPECT_LT(t.y, size.y);
+    }
+}
+
+TEST(FilamentTest, MorphTargetBuffer) {
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    FRenderableManager& rcm = engine->getRenderableManager();
+
+    MorphTargetBuffer* mtb = MorphTargetBuffer::Builder()
+            .vertexCount(5000)
+            .count(50)
+            .build(*engine);
+    EXPECT_EQ(5000, mtb->getVertexCount());
+    EXPECT_EQ(50, mtb->getCount());
+    EXPECT_TRUE(bool(upcast(mtb)->getHwHandle()));
+
+    std::vector<float3> positions(5000, float3{ 1, 2, 3 });
+    std::vector<short4> tangents(5000, short4{ 0, 0, 0, 32767 });
+    for (size_t i = 0; i < 50; i++) {
+        mtb->setPositionsAt(*engine, i, positions.data(), positions.size());
+        mtb->setTangentsAt(*engine, i, tangents.data(), 100);
+    }
+
+    // Renderables without a MorphTargetBuffer don't pay for the weights.
+    Entity plain = engine->getEntityManager().create();
+    RenderableManager::Builder(2).culling(false).castShadows(false).receiveShadows(false)
+            .morphing(true)
+            .build(*engine, plain);
+    auto ci0 = rcm.getInstance(plain);
+    EXPECT_FALSE(bool(rcm.getMorphingUbh(ci0)));
+
+    Entity morphed = engine->getEntityManager().create();
+    RenderableManager::Builder(2).culling(false).castShadows(false).receiveShadows(false)
+            .morphing(1, mtb)
+            .build(*engine, morphed);
+    auto ci1 = rcm.getInstance(morphed);
+    EXPECT_TRUE(rcm.getVisibility(ci1).morphing);
+    EXPECT_TRUE(bool(rcm.getMorphingUbh(ci1)));
+    EXPECT_EQ(upcast(mtb)->getHwHandle(), rcm.getRenderPrimitives(ci1, 0)[1].getMorphTargetBuffer());
+    EXPECT_FALSE(bool(rcm.getRenderPrimitives(ci1, 0)[0].getMorphTargetBuffer()));
+
+    // Only the targets up to the last weight set are blended.
+    std::vector<float> weights(50, 0.5f);
+    UniformBuffer const& ub = rcm.mManager[ci1].morphing->weights;
+    EXPECT_EQ(0, ub.getUniform<uint32_t>(offsetof(PerRenderableMorphingUib, count)));
+    rcm.setMorphWeights(ci1, weights.data(), 10, 20);
+    EXPECT_EQ(30, ub.getUniform<uint32_t>(offsetof(PerRenderableMorphingUib, count)));
+    EXPECT_EQ(0.5f, ub.getUniform<float>(offsetof(PerRenderableMorphingUib, weights) + 25 * 4));
+    EXPECT_EQ(0.0f, ub.getUniform<float>(offsetof(PerRenderableMorphingUib, weights) + 5 * 4));
+    rcm.setMorphWeights(ci1, weights.data(), 5);
+    EXPECT_EQ(30, ub.getUniform<uint32_t>(offsetof(PerRenderableMorphingUib, count)));
+
+    // A MorphTargetBuffer can be attached later to renderables created with morphing enabled.
+    rcm.setMorphTargetBufferAt(ci0, 0, 0, upcast(mtb));
+    EXPECT_TRUE(bool(rcm.getMorphingUbh(ci0)));
+    EXPECT_EQ(upcast(mtb)->getHwHandle(), rcm.getRenderPrimitives(ci0, 0)[0].getMorphTargetBuffer());
+
+    engine->destroy(plain);
+    engine->destroy(morphed);
+    engine->destroy(upcast(mtb));
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, TextureStreamer) {
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    TextureStreamer& streamer = engine->getTextureStreamer();
+
+    Texture* texture = Texture::Builder()
+            .width(1024).height(512).levels(11)
+            .build(*engine);
+    const backend::Handle<backend::HwTexture> original = upcast(texture)->getHwHandle();
+
+    // levels are provided later, like they would be by an asynchronous loader
+    struct Requests {
+        Texture* texture = nullptr;
+        std::vector<size_t> levels;
+    } requests;
+    auto callback = [](Texture* texture, size_t level, void* user) {
+        Requests* const requests = static_cast<Requests*>(user);
+        requests->texture = texture;
+        requests->levels.push_back(level);
+    };
+    auto provide = [engine](Texture* texture, size_t level) {
+        const size_t size = texture->getWidth(level) * texture->getHeight(level) * 4;
+        texture->setImage(*engine, level, Texture::PixelBufferDescriptor(
+                malloc(size), size, Texture::Format::RGBA, Texture::Type::UBYTE,
+                [](void* buffer, size_t, void*) { free(buffer); }));
+    };
+
+    // only the tail is requested, it starts at the first level of 64 texels or less
+    streamer.addTexture(texture, callback, &requests);
+    EXPECT_EQ(texture, requests.texture);
+    EXPECT_EQ(std::vector<size_t>({ 4, 5, 6, 7, 8, 9, 10 }), requests.levels);
+    EXPECT_EQ(0, streamer.getResidentLevel(texture));
+
+    // the texture keeps its storage until the tail is provided
+    engine->prepare();
+    EXPECT_EQ(original, upcast(texture)->getHwHandle());
+    for (size_t level : requests.levels) {
+        provide(texture, level);
+    }
+    engine->prepare();
+    EXPECT_NE(original, upcast(texture)->getHwHandle());
+    EXPECT_EQ(4, streamer.getResidentLevel(texture));
+    provide(texture, 0); // not resident, ignored
+
+    size_t tailSize = 0;
+    for (size_t level = 4; level < 11; level++) {
+        tailSize += texture->getWidth(level) * texture->getHeight(level) * 4;
+    }
+    EXPECT_EQ(tailSize, streamer.getResidentMemory());
+
+    // tails are always resident, whatever the budget
+    EXPECT_EQ(std::numeric_limits<size_t>::max(), streamer.getMemoryBudget());
+    streamer.setMemoryBudget(1024);
+    EXPECT_EQ(1024, streamer.getMemoryBudget());
+    requests.levels.clear();
+    engine->prepare();
+    EXPECT_TRUE(requests.levels.empty());
+    EXPECT_EQ(4, streamer.getResidentLevel(texture));
+
+    // removed textures keep their levels
+    streamer.removeTexture(texture);
+    EXPECT_EQ(0, streamer.getResidentMemory());
+    EXPECT_EQ(4, streamer.getResidentLevel(texture));
+
+    // destroying a streamed texture stops streaming it
+    streamer.addTexture(texture, callback, &requests);
+    EXPECT_NE(0, streamer.getResidentMemory());
+    engine->destroy(upcast(texture));
+    EXPECT_EQ(0, streamer.getResidentMemory());
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, MaterialCompile) {
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    Material* material = const_cast<FMaterial*>(engine->getDefaultMaterial());
+
+    struct Result {
+        Material* material = nullptr;
+        int count = 0;
+    } result;
+    auto callback = [](Material* material, void* user) {
+        Result* const result = static_cast<Result*>(user);
+        result->material = material;
+        result->count++;
+    };
+
+    material->compile(UserVariantFilterMask(UserVariantFilterBit::DIRECTIONAL_LIGHTING |
+            UserVariantFilterBit::SHADOW_RECEIVER), callback, &result);
+    engine->flushAndWait();
+    EXPECT_EQ(material, result.material);
+    EXPECT_EQ(1, result.count);
+
+    // compiling again only waits for the programs that are already there
+    material->compile(UserVariantFilterMask(UserVariantFilterBit::ALL), callback, &result);
+    material->compile();
+    engine->flushAndWait();
+    EXPECT_EQ(2, result.count);
+
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, RendererWarmUp) {
+    // the noop backend counts the pipelines it is asked to warm up
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    SwapChain* swapChain = engine->createSwapChain(16, 16);
+    Renderer* renderer = engine->createRenderer();
+    Scene* scene = engine->createScene();
+    Skybox* skybox = Skybox::Builder().color({ 1.0f, 0.0f, 0.0f, 1.0f }).build(*engine);
+    scene->setSkybox(skybox);
+    Entity cameraEntity = EntityManager::get().create();
+    Camera* camera = engine->createCamera(cameraEntity);
+    View* view = engine->createView();
+    view->setViewport({ 0, 0, 16, 16 });
+    view->setScene(scene);
+    view->setCamera(camera);
+
+    EXPECT_EQ(0u, engine->getPipelineCacheStats().misses);
+
+    // the skybox is warmed up instead of being drawn
+    ASSERT_TRUE(renderer->beginFrame(swapChain));
+    renderer->warmUp(view);
+    renderer->endFrame();
+    engine->flushAndWait();
+    const uint32_t warmedUp = engine->getPipelineCacheStats().misses;
+    EXPECT_GT(warmedUp, 0u);
+
+    // rendering draws, it doesn't warm up anything
+    ASSERT_TRUE(renderer->beginFrame(swapChain));
+    renderer->render(view);
+    renderer->endFrame();
+    engine->flushAndWait();
+    EXPECT_EQ(warmedUp, engine->getPipelineCacheStats().misses);
+
+    engine->destroy(view);
+    engine->destroyCameraComponent(cameraEntity);
+    EntityManager::get().destroy(cameraEntity);
+    engine->destroy(skybox);
+    engine->destroy(scene);
+    engine->destroy(renderer);
+    engine->destroy(swapChain);
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, MaterialVariantRecording) {
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    FMaterial* material = const_cast<FMaterial*>(engine->getDefaultMaterial());
+
+    // the default material is unlit, so only unlit variants are used here
+    // nothing is recorded unless enabled
+    material->getProgram(Variant::FOG);
+    EXPECT_EQ(0u, material->getRecordedVariants(nullptr, 0));
+
+    material->setVariantRecording(true);
+    material->getProgram(Variant::SKINNING_OR_MORPHING | Variant::FOG);
+    material->getProgram(Variant::DEPTH_VARIANT);
+    material->getProgram(Variant::DEPTH_VARIANT);
+    material->setVariantRecording(false);
+    material->getProgram(Variant::SKINNING_OR_MORPHING);
+
+    uint8_t variants[VARIANT_COUNT] = {};
+    ASSERT_EQ(2u, material->getRecordedVariants(variants, VARIANT_COUNT));
+    EXPECT_EQ(Variant::DEPTH_VARIANT, variants[0]);
+    EXPECT_EQ(Variant::SKINNING_OR_MORPHING | Variant::FOG, variants[1]);
+
+    material->clearRecordedVariants();
+    EXPECT_EQ(0u, material->getRecordedVariants(variants, VARIANT_COUNT));
+
+    Engine::destroy((Engine **)&engine);
+}
+
 TEST(FilamentTest, GoogleLineDirective) {
     {
         char s[512] = "#line 10 \"foobar\"";
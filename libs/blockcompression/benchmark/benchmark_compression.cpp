@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <blockcompression/BlockCompression.h>
+
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+using namespace image;
+
+static constexpr uint32_t IMAGE_SIZE = 1024;
+
+static const char* const PRESET_NAMES[] = { "fastest", "fast", "balanced", "best" };
+
+// Builds a smooth gradient with some high frequency detail, so that the encoders have to work
+// somewhat harder than on a flat image, only once.
+static LinearImage const& getImage() {
+    static LinearImage image = []() {
+        LinearImage result(IMAGE_SIZE, IMAGE_SIZE, 4);
+        for (uint32_t y = 0; y < IMAGE_SIZE; y++) {
+            float* dst = result.getPixelRef(0, y);
+            for (uint32_t x = 0; x < IMAGE_SIZE; x++, dst += 4) {
+                const float u = float(x) / IMAGE_SIZE;
+                const float v = float(y) / IMAGE_SIZE;
+                const float detail = 0.5f + 0.5f * std::sin(float(x * y) * 0.001f);
+                dst[0] = u;
+                dst[1] = v;
+                dst[2] = detail;
+                dst[3] = 1.0f - 0.5f * u * v;
+            }
+        }
+        return result;
+    }();
+    return image;
+}
+
+static utils::JobSystem& getJobSystem() {
+    static utils::JobSystem* js = []() {
+        auto* js = new utils::JobSystem();
+        js->adopt();
+        return js;
+    }();
+    return *js;
+}
+
+// Compresses the test image with the given codec at the preset given as the benchmark argument,
+// and reports the throughput in megapixels per second.
+static void compress(benchmark::State& state, const char* options) {
+    CompressionConfig config{};
+    if (!parseOptionString(options, &config)) {
+        state.SkipWithError("Invalid compression options");
+        return;
+    }
+    const auto preset = CompressionPreset(state.range(0));
+    applyCompressionPreset(&config, preset);
+    state.SetLabel(PRESET_NAMES[state.range(0)]);
+
+    LinearImage const& image = getImage();
+    utils::JobSystem& js = getJobSystem();
+    for (auto _ : state) {
+        CompressedTexture texture = compressTexture(config, image, &js);
+        benchmark::DoNotOptimize(texture.data.get());
+    }
+
+    const double megapixels = double(image.getWidth()) * image.getHeight() * 1e-6;
+    state.counters["MP/s"] = benchmark::Counter(megapixels * double(state.iterations()),
+            benchmark::Counter::kIsRate);
+}
+
+static void BM_compressAstc(benchmark::State& state) {
+    compress(state, "astc_fast_ldr_4x4");
+}
+
+static void BM_compressEtc(benchmark::State& state) {
+    compress(state, "etc_rgba8_rgba_40");
+}
+
+static void BM_compressS3tc(benchmark::State& state) {
+    compress(state, "s3tc_rgba_dxt5");
+}
+
+// The BEST presets are very slow on large images, so a single iteration is enough.
+BENCHMARK(BM_compressAstc)->DenseRange(0, 3)->Unit(benchmark::kMillisecond)->Iterations(1);
+BENCHMARK(BM_compressEtc)->DenseRange(0, 3)->Unit(benchmark::kMillisecond)->Iterations(1);
+BENCHMARK(BM_compressS3tc)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
@@ -14,13 +14,19 @@
  * limitations under the License.
  */
 
-#include <imageio/BlockCompression.h>
+#include <blockcompression/BlockCompression.h>
 
 #include <image/ImageOps.h>
 
+#include <utils/JobSystem.h>
+
 #include <algorithm>
 #include <cmath>
-#include <thread>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <string.h>
 
 #include <astcenc.h>
 #include <Etc.h>
@@ -30,19 +36,49 @@
 
 namespace image {
 
-static LinearImage extendToFourChannels(LinearImage source);
+using namespace utils;
 
-CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
+static LinearImage extendToFourChannels(LinearImage source);
 
-    // If this is the first time, initialize the ARM encoder tables.
+// Calls task(first, count) over ranges of rows of blocks in [0, rowCount), in parallel. A temporary
+// job system is created when none is given.
+template<typename Task>
+static void forEachBlockRow(JobSystem* js, uint32_t rowCount, Task& task) {
+    std::unique_ptr<JobSystem> temporary;
+    if (!js) {
+        temporary = std::make_unique<JobSystem>();
+        temporary->adopt();
+        js = temporary.get();
+    }
+    auto job = jobs::parallel_for(*js, nullptr, 0, rowCount,
+            std::ref(task), jobs::CountSplitter<1, 8>());
+    js->runAndWait(job);
+    if (temporary) {
+        temporary->emancipate();
+    }
+}
 
-    static bool first = true;
-    if (first) {
+// The first time, initialize the ARM encoder tables.
+static void initAstcTables() {
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
         test_inappropriate_extended_precision();
         prepare_angular_tables();
         build_quantization_mode_table();
-        first = false;
-    }
+    });
+}
+
+// The ARM codec lazily builds tables for each block size, which isn't thread-safe. Both the encoder
+// and the decoder build them under this lock before going wide, rather than relying on the first
+// blocks to do it: blocks with a single partition never touch the partition tables.
+static void initAstcBlockTables(int xdim, int ydim, int zdim) {
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    prepare_block_size_tables(xdim, ydim, zdim);
+}
+
+CompressedTexture astcCompress(const LinearImage& original, AstcConfig config, JobSystem* js) {
+    initAstcTables();
 
     // Check the validity of the given block size.
 
@@ -289,8 +325,6 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
             break;
     }
 
-    const int threadcount = std::thread::hardware_concurrency();
-
     const int xsize = input_image->xsize;
     const int ysize = input_image->ysize;
     const int zsize = input_image->zsize;
@@ -301,8 +335,21 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
     uint32_t size = xblocks * yblocks * zblocks * 16;
     uint8_t* buffer = new uint8_t[size];
 
-    encode_astc_image(input_image, nullptr, xdim, ydim, zdim, &ewp, decode_mode,
-            swz_encode, swz_decode, buffer, 0, threadcount);
+    // Each range of rows of blocks is encoded as a separate image that references the rows of the
+    // input image, with a single encoder thread.
+    auto encodeRows = [&](uint32_t first, uint32_t count) {
+        const int y0 = int(first) * ydim;
+        uint16_t** rows = input_image->imagedata16[0] + y0;
+        astc_codec_image strip = *input_image;
+        strip.imagedata8 = nullptr;
+        strip.imagedata16 = &rows;
+        strip.ysize = std::min(int(count) * ydim, ysize - y0);
+        encode_astc_image(&strip, nullptr, xdim, ydim, zdim, &ewp, decode_mode,
+                swz_encode, swz_decode, buffer + first * xblocks * 16, 0, 1);
+    };
+
+    initAstcBlockTables(xdim, ydim, zdim);
+    forEachBlockRow(js, yblocks, encodeRows);
 
     destroy_image(input_image);
 
@@ -313,6 +360,55 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
     };
 }
 
+LinearImage astcDecompress(uint8_t const* data, uint32_t size, CompressedFormat format,
+        uint32_t width, uint32_t height, JobSystem* js) {
+    const uint32_t value = uint32_t(format);
+    const bool srgb = value >= uint32_t(CompressedFormat::SRGB8_ALPHA8_ASTC_4x4) &&
+            value <= uint32_t(CompressedFormat::SRGB8_ALPHA8_ASTC_12x12);
+    if (!srgb && (value < uint32_t(CompressedFormat::RGBA_ASTC_4x4) ||
+            value > uint32_t(CompressedFormat::RGBA_ASTC_12x12))) {
+        return {};
+    }
+
+    // The block sizes are in the same order in both ranges of formats.
+    static constexpr filament::math::ushort2 BLOCK_SIZES[] = {
+        {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8},
+        {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12},
+    };
+    const uint32_t first = uint32_t(srgb ? CompressedFormat::SRGB8_ALPHA8_ASTC_4x4 :
+            CompressedFormat::RGBA_ASTC_4x4);
+    const int xdim = BLOCK_SIZES[value - first].x;
+    const int ydim = BLOCK_SIZES[value - first].y;
+    const uint32_t xblocks = (width + xdim - 1) / xdim;
+    const uint32_t yblocks = (height + ydim - 1) / ydim;
+    if (width == 0 || height == 0 || size < xblocks * yblocks * 16) {
+        return {};
+    }
+
+    initAstcTables();
+
+    // The decoder produces half-floats, in the same color space as the compressed data.
+    const astc_decode_mode decode_mode = srgb ? DECODE_LDR_SRGB : DECODE_LDR;
+    astc_codec_image* output_image = allocate_image(16, width, height, 1, 0);
+    auto decodeRows = [&](uint32_t first, uint32_t count) {
+        decode_astc_image(data, xdim, ydim, decode_mode, first, count, output_image);
+    };
+    initAstcBlockTables(xdim, ydim, 1);
+    forEachBlockRow(js, yblocks, decodeRows);
+
+    LinearImage result(width, height, 4);
+    for (uint32_t y = 0; y < height; y++) {
+        uint16_t const* src = output_image->imagedata16[0][y];
+        float* dst = result.getPixelRef(0, y);
+        for (uint32_t x = 0; x < width * 4; x++) {
+            dst[x] = sf16_to_float(src[x]);
+        }
+    }
+
+    destroy_image(output_image);
+    return result;
+}
+
 AstcConfig astcParseOptionString(const std::string& configString) {
     const size_t _1 = configString.find('_');
     const size_t _2 = configString.find('_', _1 + 1);
@@ -375,6 +471,17 @@ static void extract4x4RGBA(uint8_t* dst, const LinearImage& source, uint32_t x0,
     }
 }
 
+// STB lazily builds its DXT tables on the first call, without a guard, so a single block is
+// compressed once before going wide.
+static void initDxtTables() {
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        uint8_t block[64] = {};
+        uint8_t dst[16];
+        stb_compress_dxt_block(dst, block, 0, STB_DXT_NORMAL);
+    });
+}
+
 // Our S3TC / DXT encoder uses the STB implementation by Fabian Giesen.
 //
 // Due to limitations in STB, this only supports the following formats:
@@ -382,22 +489,29 @@ static void extract4x4RGBA(uint8_t* dst, const LinearImage& source, uint32_t x0,
 //  - DXT5 with alpha (16 input pixels into 128 bits of output, 4:1)
 //
 // TODO: investigate using something more capable than STB (eg AMD Compressenator, bimg, libsquish)
-CompressedTexture s3tcCompress(const LinearImage& original, S3tcConfig config) {
-    const bool dxt5 = config.format == CompressedFormat::RGBA_S3TC_DXT5;
+CompressedTexture s3tcCompress(const LinearImage& original, S3tcConfig config, JobSystem* js) {
+    initDxtTables();
+
+    const bool dxt5 = config.format == CompressedFormat::RGBA_S3TC_DXT5 ||
+            config.format == CompressedFormat::SRGB_ALPHA_S3TC_DXT5;
+    const int mode = config.highQuality ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+    const uint32_t blockSize = dxt5 ? 16 : 8;
     LinearImage source = extendToFourChannels(original);
-    uint8_t block[64];
     uint32_t xblocks = (source.getWidth() + 3) / 4;
     uint32_t yblocks = (source.getHeight() + 3) / 4;
-    uint32_t size = xblocks * yblocks * (dxt5 ? 16 : 8);
+    uint32_t size = xblocks * yblocks * blockSize;
     uint8_t* buffer = new uint8_t[size];
-    uint8_t* dst = buffer;
-    for (int y = 0, h = source.getHeight(); y < h; y += 4) {
-        for (int x = 0, w = source.getWidth(); x < w; x += 4) {
-            extract4x4RGBA(block, source, x, y);
-            stb_compress_dxt_block(dst, block, dxt5, 8);
-            dst += dxt5 ? 16 : 8;
+    auto encodeRows = [&](uint32_t first, uint32_t count) {
+        uint8_t block[64];
+        uint8_t* dst = buffer + first * xblocks * blockSize;
+        for (uint32_t by = first; by < first + count; by++) {
+            for (uint32_t bx = 0; bx < xblocks; bx++, dst += blockSize) {
+                extract4x4RGBA(block, source, bx * 4, by * 4);
+                stb_compress_dxt_block(dst, block, dxt5, mode);
+            }
         }
-    }
+    };
+    forEachBlockRow(js, yblocks, encodeRows);
     return {
         .format = config.format,
         .size = size,
@@ -415,9 +529,8 @@ S3tcConfig s3tcParseOptionString(const std::string& options) {
     return {};
 }
 
-CompressedTexture etcCompress(const LinearImage& original, EtcConfig config) {
+CompressedTexture etcCompress(const LinearImage& original, EtcConfig config, JobSystem* js) {
     LinearImage source = extendToFourChannels(original);
-    const int threadcount = std::thread::hardware_concurrency();
     Etc::Image::Format etcformat;
     switch (config.format) {
         case CompressedFormat::R11_EAC: etcformat = Etc::Image::Format::R11; break;
@@ -441,31 +554,52 @@ CompressedTexture etcCompress(const LinearImage& original, EtcConfig config) {
         case EtcErrorMetric::NORMALXYZ: etcmetric = Etc::NORMALXYZ; break;
         default: return {};
     }
-    unsigned char *paucEncodingBits;
-    unsigned int uiEncodingBitsBytes;
-    unsigned int uiExtendedWidth;
-    unsigned int uiExtendedHeight;
-    int iEncodingTime_ms;
-
-    // The etc2comp API doesn't tell you that you need to free paucEncodingBits, but they have a
-    // commented-out "delete[] m_paucEncodingBits" in their Image destructor, which is essentially
-    // what our unique_ptr wrapper does (CompressedTexture::data).
-
-    Etc::Encode(source.getPixelRef(0, 0),
-        source.getWidth(), source.getHeight(),
-        etcformat,
-        etcmetric,
-        config.effort,
-        threadcount,
-        1024,
-        &paucEncodingBits, &uiEncodingBitsBytes,
-        &uiExtendedWidth, &uiExtendedHeight,
-        &iEncodingTime_ms);
+
+    // Each range of rows of blocks is encoded as a separate image, they are stored contiguously
+    // since blocks are laid out in row-major order. Only the width gets extended to a multiple of
+    // the block size, which makes every row of blocks the same size.
+
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    const uint32_t yblocks = (height + 3) / 4;
+    const bool wideBlocks = etcformat == Etc::Image::Format::RG11 ||
+            etcformat == Etc::Image::Format::SIGNED_RG11 ||
+            etcformat == Etc::Image::Format::RGBA8 || etcformat == Etc::Image::Format::SRGBA8;
+    const uint32_t rowSize = (width + 3) / 4 * (wideBlocks ? 16 : 8);
+    const uint32_t size = rowSize * yblocks;
+    uint8_t* buffer = new uint8_t[size];
+
+    auto encodeRows = [&](uint32_t first, uint32_t count) {
+        unsigned char *paucEncodingBits;
+        unsigned int uiEncodingBitsBytes;
+        unsigned int uiExtendedWidth;
+        unsigned int uiExtendedHeight;
+        int iEncodingTime_ms;
+
+        const uint32_t y0 = first * 4;
+        Etc::Encode(source.getPixelRef(0, y0),
+            width, std::min(count * 4, height - y0),
+            etcformat,
+            etcmetric,
+            config.effort,
+            1,
+            1024,
+            &paucEncodingBits, &uiEncodingBitsBytes,
+            &uiExtendedWidth, &uiExtendedHeight,
+            &iEncodingTime_ms);
+
+        // The etc2comp API doesn't tell you that you need to free paucEncodingBits, but they have
+        // a commented-out "delete[] m_paucEncodingBits" in their Image destructor.
+        memcpy(buffer + first * rowSize, paucEncodingBits,
+                std::min(uiEncodingBitsBytes, count * rowSize));
+        delete[] paucEncodingBits;
+    };
+    forEachBlockRow(js, yblocks, encodeRows);
 
     return {
         .format = config.format,
-        .size = uiEncodingBitsBytes,
-        .data = decltype(CompressedTexture::data)(paucEncodingBits)
+        .size = size,
+        .data = decltype(CompressedTexture::data)(buffer)
     };
 }
 
@@ -533,19 +667,82 @@ bool parseOptionString(const std::string& options, CompressionConfig* config) {
     return config->type != CompressionConfig::INVALID;
 }
 
-CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image) {
+void applyCompressionPreset(CompressionConfig* config, CompressionPreset preset) {
+    switch (preset) {
+        case CompressionPreset::FASTEST:
+            config->astc.quality = AstcPreset::VERYFAST;
+            config->etc.effort = 0;
+            config->s3tc.highQuality = false;
+            break;
+        case CompressionPreset::FAST:
+            config->astc.quality = AstcPreset::FAST;
+            config->etc.effort = 25;
+            config->s3tc.highQuality = false;
+            break;
+        case CompressionPreset::BALANCED:
+            config->astc.quality = AstcPreset::MEDIUM;
+            config->etc.effort = 50;
+            config->s3tc.highQuality = true;
+            break;
+        case CompressionPreset::BEST:
+            config->astc.quality = AstcPreset::THOROUGH;
+            config->etc.effort = 100;
+            config->s3tc.highQuality = true;
+            break;
+    }
+}
+
+CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image,
+        JobSystem* js) {
     if (config.type == CompressionConfig::ASTC) {
-        return astcCompress(image, config.astc);
+        return astcCompress(image, config.astc, js);
     }
     if (config.type == CompressionConfig::S3TC) {
-        return s3tcCompress(image, config.s3tc);
+        return s3tcCompress(image, config.s3tc, js);
     }
     if (config.type == CompressionConfig::ETC) {
-        return etcCompress(image, config.etc);
+        return etcCompress(image, config.etc, js);
     }
     return {};
 }
 
+filament::math::ushort2 getBlockDimensions(const CompressionConfig& config) {
+    switch (config.type) {
+        case CompressionConfig::ASTC: return config.astc.blocksize;
+        case CompressionConfig::S3TC: return { 4, 4 };
+        case CompressionConfig::ETC: return { 4, 4 };
+        case CompressionConfig::INVALID: break;
+    }
+    return { 0, 0 };
+}
+
+uint32_t getCompressedSize(const CompressionConfig& config, uint32_t width, uint32_t height) {
+    const filament::math::ushort2 dimensions = getBlockDimensions(config);
+    if (dimensions.x == 0 || dimensions.y == 0) {
+        return 0;
+    }
+    uint32_t blockSize = 16;
+    if (config.type == CompressionConfig::S3TC) {
+        blockSize = config.s3tc.format == CompressedFormat::RGBA_S3TC_DXT5 ||
+                config.s3tc.format == CompressedFormat::SRGB_ALPHA_S3TC_DXT5 ? 16 : 8;
+    } else if (config.type == CompressionConfig::ETC) {
+        switch (config.etc.format) {
+            case CompressedFormat::RG11_EAC:
+            case CompressedFormat::SIGNED_RG11_EAC:
+            case CompressedFormat::RGBA8_ETC2_EAC:
+            case CompressedFormat::SRGB8_ALPHA8_ETC2_EAC:
+                blockSize = 16;
+                break;
+            default:
+                blockSize = 8;
+                break;
+        }
+    }
+    const uint32_t xblocks = (width + dimensions.x - 1) / dimensions.x;
+    const uint32_t yblocks = (height + dimensions.y - 1) / dimensions.y;
+    return xblocks * yblocks * blockSize;
+}
+
 static LinearImage extendToFourChannels(LinearImage original) {
     LinearImage source = original;
     const uint32_t width = source.getWidth();
@@ -20,6 +20,7 @@
 #define TNT_FILAMENT_MATERIAL_ENUM_H
 
 #include <utils/bitset.h>
+#include <utils/BitmaskEnum.h>
 
 #include <stddef.h>
 #include <stdint.h>
@@ -27,7 +28,7 @@
 namespace filament {
 
 // update this when a new version of filament wouldn't work with older materials
-static constexpr size_t MATERIAL_VERSION = 11;
+static constexpr size_t MATERIAL_VERSION = 13;
 
 /**
  * Supported shading models
@@ -221,6 +222,25 @@ enum class Property : uint8_t {
     // when adding new Properties, make sure to update MATERIAL_PROPERTIES_COUNT
 };
 
+/**
+ * Features that select which variants of a material are compiled ahead of time,
+ * see Material::compile()
+ */
+enum class UserVariantFilterBit : uint32_t {
+    DIRECTIONAL_LIGHTING = 0x01,    //!< directional lighting
+    DYNAMIC_LIGHTING     = 0x02,    //!< point, spot and area lights
+    SHADOW_RECEIVER      = 0x04,    //!< receiving shadows
+    SKINNING             = 0x08,    //!< skinning and morphing
+    FOG                  = 0x20,    //!< fog
+    VSM                  = 0x40,    //!< variance shadow maps
+    ALL                  = 0x6F,    //!< all of the above
+};
+
+using UserVariantFilterMask = uint32_t;
+
 } // namespace filament
 
+template<> struct utils::EnableBitMaskOperators<filament::UserVariantFilterBit>
+        : public std::true_type {};
+
 #endif
@@ -39,8 +39,9 @@ namespace BindingPoints {
     constexpr uint8_t LIGHTS                  = 3;    // lights data array
     constexpr uint8_t SHADOW                  = 4;    // punctual shadow data
     constexpr uint8_t FROXEL_RECORDS          = 5;
-    constexpr uint8_t PER_MATERIAL_INSTANCE   = 6;    // uniforms/samplers updates per material
-    constexpr uint8_t COUNT                   = 7;
+    constexpr uint8_t PER_RENDERABLE_MORPHING = 6;    // morph target weights and data, per renderable
+    constexpr uint8_t PER_MATERIAL_INSTANCE   = 7;    // uniforms/samplers updates per material
+    constexpr uint8_t COUNT                   = 8;
     // These are limited by Program::UNIFORM_BINDING_COUNT (currently 8)
 }
 
@@ -67,6 +68,23 @@ constexpr size_t CONFIG_MAX_SHADOW_CASCADES = 4;
 // We store 64 bytes per bone.
 constexpr size_t CONFIG_MAX_BONE_COUNT = 256;
 
+// Skeletons with more than CONFIG_MAX_BONE_COUNT bones are stored in a RGBA32F texture instead,
+// which is sampled by the vertex shader. A bone takes 4 consecutive texels (the same 64 bytes as
+// in the UBO) and each row of the texture holds CONFIG_BONE_TEXTURE_ROW_SIZE bones.
+constexpr size_t CONFIG_BONE_TEXTURE_ROW_SIZE = 256;
+
+// Bone indices are typically 16 bits, this also keeps the texture under 256 rows.
+constexpr size_t CONFIG_MAX_BONE_TEXTURE_BONE_COUNT = 65536;
+
+// The weights of a renderable's morph targets are stored in a UBO, packed in vec4s. This is also
+// the number of layers of the morph target texture array, ES3.0 only guarantees 256.
+constexpr size_t CONFIG_MAX_MORPH_TARGET_COUNT = 256;
+
+// Each layer of the morph target texture array holds the data of one target, in RGBA32F texels.
+// The positions of all the vertices come first, then their tangents, each starting on a new row.
+// ES3.0 only guarantees 2048 texels per row.
+constexpr size_t CONFIG_MORPH_TARGET_TEXTURE_WIDTH = 2048;
+
 } // namespace filament
 
 #endif // TNT_FILAMENT_driver/EngineEnums.h
@@ -30,6 +30,8 @@ class SamplerInterfaceBlock;
 class SibGenerator {
 public:
     static SamplerInterfaceBlock const& getPerViewSib(uint8_t variantKey) noexcept;
+    static SamplerInterfaceBlock const& getPerRenderableBonesSib() noexcept;
+    static SamplerInterfaceBlock const& getPerRenderableMorphingSib() noexcept;
     static SamplerInterfaceBlock const* getSib(uint8_t bindingPoint, uint8_t variantKey) noexcept;
     // When adding a sampler block here, make sure to also update
     //      FMaterial::getSurfaceProgramSlow and FMaterial::getPostProcessProgramSlow if needed
@@ -48,5 +50,19 @@ struct PerViewSib {
     static constexpr size_t SAMPLER_COUNT  = 7;
 };
 
+struct PerRenderableBonesSib {
+    // indices of each samplers in this SamplerInterfaceBlock (see: getPerRenderableBonesSib())
+    static constexpr size_t TRANSFORMS     = 0;     // 1024xN, RGBA32F, see CONFIG_BONE_TEXTURE_ROW_SIZE
+
+    static constexpr size_t SAMPLER_COUNT  = 1;
+};
+
+struct PerRenderableMorphingSib {
+    // indices of each samplers in this SamplerInterfaceBlock (see: getPerRenderableMorphingSib())
+    static constexpr size_t TARGETS        = 0;     // 2048xN, RGBA32F, array, one layer per target
+
+    static constexpr size_t SAMPLER_COUNT  = 1;
+};
+
 }
 #endif // TNT_FILABRIDGE_SIBGENERATOR_H
@@ -33,6 +33,7 @@ public:
     static UniformInterfaceBlock const& getLightsUib() noexcept;
     static UniformInterfaceBlock const& getShadowUib() noexcept;
     static UniformInterfaceBlock const& getPerRenderableBonesUib() noexcept;
+    static UniformInterfaceBlock const& getPerRenderableMorphingUib() noexcept;
     static UniformInterfaceBlock const& getFroxelRecordUib() noexcept;
     // When adding an UBO here, make sure to also update
     //      FMaterial::getSurfaceProgramSlow and FMaterial::getPostProcessProgramSlow if needed
@@ -145,8 +146,8 @@ struct alignas(256) PerRenderableUib {
     filament::math::mat3f worldFromModelNormalMatrix; // this gets expanded to 48 bytes during the copy to the UBO
     alignas(16) filament::math::float4 morphWeights;
     // TODO: we can pack all the boolean bellow
-    int32_t skinningEnabled; // 0=disabled, 1=enabled, ignored unless variant & SKINNING_OR_MORPHING
-    int32_t morphingEnabled; // 0=disabled, 1=enabled, ignored unless variant & SKINNING_OR_MORPHING
+    int32_t skinningEnabled; // 0=disabled, 1=bones UBO, 2=bones texture, ignored unless variant & SKINNING_OR_MORPHING
+    int32_t morphingEnabled; // 0=disabled, 1=attributes, 2=morph target buffer, ignored unless variant & SKINNING_OR_MORPHING
     uint32_t screenSpaceContactShadows; // 0=disabled, 1=enabled, ignored unless variant & SKINNING_OR_MORPHING
     float padding0;
 };
@@ -183,6 +184,17 @@ struct FroxelRecordUib {
     filament::math::uint4 records[1024];
 };
 
+// UBO for the weights of morph targets stored in a MorphTargetBuffer.
+struct PerRenderableMorphingUib {
+    static const UniformInterfaceBlock& getUib() noexcept {
+        return UibGenerator::getPerRenderableMorphingUib();
+    }
+
+    filament::math::float4 weights[CONFIG_MAX_MORPH_TARGET_COUNT / 4]; // 4 weights per element
+    uint32_t count; // number of morph targets
+    uint32_t padding0[3];
+};
+
 // This is not the UBO proper, but just an element of a bone array.
 struct PerRenderableUibBone {
     filament::math::quatf q = { 1, 0, 0, 0 };
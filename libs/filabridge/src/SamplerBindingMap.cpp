@@ -32,11 +32,40 @@ void SamplerBindingMap::populate(const SamplerInterfaceBlock* perMaterialSib,
     uint8_t offset = 0;
     size_t maxSamplerIndex = backend::MAX_SAMPLER_COUNT - 1;
     bool overflow = false;
+
+    // The bones texture and the morph target texture are only needed by renderables that exceed
+    // what the UBOs and vertex attributes can hold. They are left out of the map, in that order,
+    // when they would not leave enough room for the material's own samplers, in which case such
+    // renderables cannot be rendered with this material.
+    auto isOptional = [](uint8_t blockIndex) {
+        return blockIndex == filament::BindingPoints::PER_RENDERABLE_BONES ||
+                blockIndex == filament::BindingPoints::PER_RENDERABLE_MORPHING;
+    };
+    size_t requiredSamplerCount = perMaterialSib ? perMaterialSib->getSize() : 0;
+    for (uint8_t blockIndex = 0; blockIndex < filament::BindingPoints::COUNT; blockIndex++) {
+        if (blockIndex != filament::BindingPoints::PER_MATERIAL_INSTANCE && !isOptional(blockIndex)) {
+            auto sib = filament::SibGenerator::getSib(blockIndex, variantKey);
+            requiredSamplerCount += sib ? sib->getSize() : 0;
+        }
+    }
+    const bool hasBonesSamplers = requiredSamplerCount +
+            PerRenderableBonesSib::SAMPLER_COUNT <= backend::MAX_SAMPLER_COUNT;
+    if (hasBonesSamplers) {
+        requiredSamplerCount += PerRenderableBonesSib::SAMPLER_COUNT;
+    }
+    const bool hasMorphingSamplers = requiredSamplerCount +
+            PerRenderableMorphingSib::SAMPLER_COUNT <= backend::MAX_SAMPLER_COUNT;
+
     for (uint8_t blockIndex = 0; blockIndex < filament::BindingPoints::COUNT; blockIndex++) {
         mSamplerBlockOffsets[blockIndex] = offset;
         filament::SamplerInterfaceBlock const* sib;
         if (blockIndex == filament::BindingPoints::PER_MATERIAL_INSTANCE) {
             sib = perMaterialSib;
+        } else if (blockIndex == filament::BindingPoints::PER_RENDERABLE_BONES && !hasBonesSamplers) {
+            sib = nullptr;
+        } else if (blockIndex == filament::BindingPoints::PER_RENDERABLE_MORPHING &&
+                !hasMorphingSamplers) {
+            sib = nullptr;
         } else {
             sib = filament::SibGenerator::getSib(blockIndex, variantKey);
         }
@@ -68,6 +97,8 @@ void SamplerBindingMap::populate(const SamplerInterfaceBlock* perMaterialSib,
             filament::SamplerInterfaceBlock const* sib;
             if (blockIndex == filament::BindingPoints::PER_MATERIAL_INSTANCE) {
                 sib = perMaterialSib;
+            } else if (isOptional(blockIndex)) {
+                sib = nullptr;
             } else {
                 sib = filament::SibGenerator::getSib(blockIndex, variantKey);
             }
@@ -66,12 +66,46 @@ SamplerInterfaceBlock const& SibGenerator::getPerViewSib(uint8_t variantKey) noe
     return v.hasVsm() ? sibVsm : sibPcf;
 }
 
+SamplerInterfaceBlock const& SibGenerator::getPerRenderableBonesSib() noexcept {
+    using Type = SamplerInterfaceBlock::Type;
+    using Format = SamplerInterfaceBlock::Format;
+    using Precision = SamplerInterfaceBlock::Precision;
+
+    static SamplerInterfaceBlock sib = SamplerInterfaceBlock::Builder()
+            .name("Bones")
+            .add("transforms", Type::SAMPLER_2D, Format::FLOAT, Precision::HIGH)
+            .build();
+
+    assert(sib.getSize() == PerRenderableBonesSib::SAMPLER_COUNT);
+
+    return sib;
+}
+
+SamplerInterfaceBlock const& SibGenerator::getPerRenderableMorphingSib() noexcept {
+    using Type = SamplerInterfaceBlock::Type;
+    using Format = SamplerInterfaceBlock::Format;
+    using Precision = SamplerInterfaceBlock::Precision;
+
+    static SamplerInterfaceBlock sib = SamplerInterfaceBlock::Builder()
+            .name("MorphTargetBuffer")
+            .add("targets", Type::SAMPLER_2D_ARRAY, Format::FLOAT, Precision::HIGH)
+            .build();
+
+    assert(sib.getSize() == PerRenderableMorphingSib::SAMPLER_COUNT);
+
+    return sib;
+}
+
 SamplerInterfaceBlock const* SibGenerator::getSib(uint8_t bindingPoint, uint8_t variantKey) noexcept {
     switch (bindingPoint) {
         case BindingPoints::PER_VIEW:
             return &getPerViewSib(variantKey);
         case BindingPoints::PER_RENDERABLE:
             return nullptr;
+        case BindingPoints::PER_RENDERABLE_BONES:
+            return &getPerRenderableBonesSib();
+        case BindingPoints::PER_RENDERABLE_MORPHING:
+            return &getPerRenderableMorphingSib();
         case BindingPoints::LIGHTS:
             return nullptr;
         default:
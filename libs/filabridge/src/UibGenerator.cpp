@@ -31,6 +31,9 @@ static_assert(sizeof(PerRenderableUib) % 256 == 0,
 static_assert(CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone) <= 16384,
         "Bones exceed max UBO size");
 
+static_assert(CONFIG_MAX_MORPH_TARGET_COUNT % 4 == 0,
+        "Morph target weights are packed in vec4s");
+
 static_assert(CONFIG_MAX_SHADOW_CASCADES == 4,
         "Changing CONFIG_MAX_SHADOW_CASCADES affects PerView size and breaks materials.");
 
@@ -154,6 +157,15 @@ UniformInterfaceBlock const& UibGenerator::getPerRenderableBonesUib() noexcept {
     return uib;
 }
 
+UniformInterfaceBlock const& UibGenerator::getPerRenderableMorphingUib() noexcept {
+    static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
+            .name("MorphingUniforms")
+            .add("weights", CONFIG_MAX_MORPH_TARGET_COUNT / 4, UniformInterfaceBlock::Type::FLOAT4, Precision::HIGH)
+            .add("count", 1, UniformInterfaceBlock::Type::UINT)
+            .build();
+    return uib;
+}
+
 UniformInterfaceBlock const& UibGenerator::getFroxelRecordUib() noexcept {
     static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
             .name("FroxelRecordUniforms")
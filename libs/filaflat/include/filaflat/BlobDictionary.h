@@ -17,6 +17,8 @@
 #ifndef TNT_FILAFLAT_BLOBDICTIONARY_H
 #define TNT_FILAFLAT_BLOBDICTIONARY_H
 
+#include <utils/compiler.h>
+
 #include <cstdint>
 #include <vector>
 
@@ -25,6 +27,11 @@
 namespace filaflat {
 
 // Flat list of blobs that can be referenced by index.
+//
+// Blobs can either be owned by the dictionary, or reference memory that outlives it (typically
+// the material package). Referenced blobs can be compressed, in which case they're decoded the
+// first time they're accessed, so that only the blobs that are actually used pay for decoding.
+// Because of this, accessing a blob is not thread-safe.
 class BlobDictionary {
 public:
     BlobDictionary() = default;
@@ -32,12 +39,31 @@ public:
 
     using Blob = std::vector<uint8_t>;
 
+    // decodes a compressed blob, returns false on failure
+    using DecodeFunc = bool(*)(const char* data, size_t size, Blob& out);
+
     inline void addBlob(const char* blob, size_t len) noexcept {
-        mBlobs.emplace_back(blob, blob + len);
+        mBlobs.push_back({ nullptr, 0, nullptr, Blob(blob, blob + len) });
     }
 
     inline void addBlob(Blob&& blob) noexcept {
-        mBlobs.push_back(std::move(blob));
+        mBlobs.push_back({ nullptr, 0, nullptr, std::move(blob) });
+    }
+
+    // adds a blob without copying it, the memory must outlive the dictionary
+    inline void addReference(const char* blob, size_t len) noexcept {
+        mBlobs.push_back({ blob, len, nullptr, {} });
+    }
+
+    // adds a compressed blob without copying it, the memory must outlive the dictionary
+    inline void addCompressed(const char* blob, size_t len, DecodeFunc decode) noexcept {
+        mBlobs.push_back({ blob, len, decode, {} });
+    }
+
+    // allocates memory owned by the dictionary, which referenced blobs can point into
+    inline char* allocateStorage(size_t size) {
+        mStorage.resize(size);
+        return (char*) mStorage.data();
     }
 
     inline bool isEmpty() const noexcept {
@@ -48,13 +74,28 @@ public:
         mBlobs.reserve(size);
     }
 
+    // returns nullptr if the blob couldn't be decoded
     inline const char* getBlob(size_t index, size_t* size) const noexcept {
-        *size = mBlobs[index].size();
-        return (const char*) mBlobs[index].data();
+        Entry const& entry = mBlobs[index];
+        if (UTILS_UNLIKELY(entry.decode)) {
+            if (!entry.decode(entry.data, entry.size, entry.storage)) {
+                *size = 0;
+                return nullptr;
+            }
+            entry.decode = nullptr;
+            entry.data = nullptr;
+        }
+        if (entry.data) {
+            *size = entry.size;
+            return entry.data;
+        }
+        *size = entry.storage.size();
+        return (const char*) entry.storage.data();
     }
 
     inline const char* getString(size_t index) const noexcept {
-        return (const char*) mBlobs[index].data();
+        size_t size;
+        return getBlob(index, &size);
     }
 
     inline size_t size() const noexcept {
@@ -62,7 +103,14 @@ public:
     }
 
 private:
-    std::vector<Blob> mBlobs;
+    struct Entry {
+        mutable const char* data;   // referenced blob, nullptr when owned
+        size_t size;
+        mutable DecodeFunc decode;  // set until a compressed blob is decoded
+        mutable Blob storage;       // owned or decoded blob
+    };
+    std::vector<Entry> mBlobs;
+    Blob mStorage;
 };
 
 } // namespace filaflat
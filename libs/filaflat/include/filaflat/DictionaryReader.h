@@ -24,6 +24,13 @@ namespace filaflat {
 class BlobDictionary;
 
 struct DictionaryReader {
+    // Returns DictionaryTextCompressed if the package holds a compressed text dictionary,
+    // DictionaryText otherwise.
+    static ChunkContainer::Type getTextDictionaryTag(ChunkContainer const& container) noexcept;
+
+    // Indexes the dictionary without copying or decoding it, the container's memory must
+    // outlive the dictionary. Compressed text dictionaries are inflated into memory owned by
+    // the dictionary.
     static bool unflatten(ChunkContainer const& container,
             ChunkContainer::Type dictionaryTag,
             BlobDictionary& dictionary);
@@ -43,6 +43,9 @@ public:
             BlobDictionary const& dictionary,
             uint8_t shaderModel, uint8_t variant, uint8_t stage);
 
+    // returns whether the given shader exists, without decoding it
+    bool hasShader(uint8_t shaderModel, uint8_t variant, uint8_t stage) const noexcept;
+
 private:
     ChunkContainer const& mContainer;
     filamat::ChunkType mMaterialTag = filamat::ChunkType::Unknown;
@@ -24,12 +24,83 @@
 #include <smolv.h>
 #endif
 
+#include <zlib.h>
+
 #include <assert.h>
 
 using namespace filamat;
 
 namespace filaflat {
 
+#if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
+static bool decodeSpirv(const char* compressed, size_t compressedSize,
+        BlobDictionary::Blob& spirv) {
+    size_t spirvSize = smolv::GetDecodedBufferSize(compressed, compressedSize);
+    if (spirvSize == 0) {
+        return false;
+    }
+    spirv.resize(spirvSize);
+    if (!smolv::Decode(compressed, compressedSize, spirv.data(), spirvSize)) {
+        spirv.clear();
+        return false;
+    }
+    return true;
+}
+#endif
+
+static bool readTextDictionary(Unflattener& unflattener, BlobDictionary& dictionary) {
+    uint32_t stringCount = 0;
+    if (!unflattener.read(&stringCount)) {
+        return false;
+    }
+
+    dictionary.reserve(stringCount);
+    for (uint32_t i = 0; i < stringCount; i++) {
+        const char* str;
+        if (!unflattener.read(&str)) {
+            return false;
+        }
+        // BlobDictionary hold binary chunks and does not care if the data holds text, it is
+        // therefore crucial to include the trailing null.
+        const size_t size = (const char*)unflattener.getCursor() - str;
+        dictionary.addReference(str, size);
+    }
+    return true;
+}
+
+// Inflates the zlib stream straight into the dictionary's storage, the size of the decompressed
+// dictionary is stored in the chunk so that no intermediate buffer is needed.
+static bool inflateTextDictionary(const char* compressed, size_t compressedSize,
+        uint32_t size, BlobDictionary& dictionary) {
+    char* const text = dictionary.allocateStorage(size);
+
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = (Bytef*) compressed;
+    stream.avail_in = uInt(compressedSize);
+    stream.next_out = (Bytef*) text;
+    stream.avail_out = uInt(size);
+    const int status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END || stream.total_out != size) {
+        return false;
+    }
+
+    Unflattener unflattener((const uint8_t*) text, (const uint8_t*) text + size);
+    return readTextDictionary(unflattener, dictionary);
+}
+
+ChunkContainer::Type DictionaryReader::getTextDictionaryTag(
+        ChunkContainer const& container) noexcept {
+    if (!container.hasChunk(ChunkType::DictionaryText) &&
+            container.hasChunk(ChunkType::DictionaryTextCompressed)) {
+        return ChunkType::DictionaryTextCompressed;
+    }
+    return ChunkType::DictionaryText;
+}
+
 bool DictionaryReader::unflatten(ChunkContainer const& container,
         ChunkContainer::Type dictionaryTag,
         BlobDictionary& dictionary) {
@@ -52,6 +123,7 @@ bool DictionaryReader::unflatten(ChunkContainer const& container,
             return false;
         }
 
+        // Only the index is built here, blobs are decoded the first time a shader uses them.
         dictionary.reserve(blobCount);
         for (uint32_t i = 0; i < blobCount; i++) {
             const char* compressed;
@@ -61,15 +133,7 @@ bool DictionaryReader::unflatten(ChunkContainer const& container,
             }
 
 #if defined (FILAMENT_DRIVER_SUPPORTS_VULKAN)
-            size_t spirvSize = smolv::GetDecodedBufferSize(compressed, compressedSize);
-            if (spirvSize == 0) {
-                return false;
-            }
-            BlobDictionary::Blob spirv(spirvSize);
-            if (!smolv::Decode(compressed, compressedSize, spirv.data(), spirvSize)) {
-                return false;
-            }
-            dictionary.addBlob(std::move(spirv));
+            dictionary.addCompressed(compressed, compressedSize, decodeSpirv);
 #else
             return false;
 #endif
@@ -77,22 +141,24 @@ bool DictionaryReader::unflatten(ChunkContainer const& container,
         }
         return true;
     } else if (dictionaryTag == ChunkType::DictionaryText) {
-        uint32_t stringCount = 0;
-        if (!unflattener.read(&stringCount)) {
+        return readTextDictionary(unflattener, dictionary);
+    } else if (dictionaryTag == ChunkType::DictionaryTextCompressed) {
+        uint32_t compressionScheme;
+        uint32_t size;
+        if (!unflattener.read(&compressionScheme) || !unflattener.read(&size)) {
+            return false;
+        }
+        // For now, 1 (zlib) is the only acceptable compression scheme.
+        if (compressionScheme != 1) {
             return false;
         }
 
-        dictionary.reserve(stringCount);
-        for (uint32_t i = 0; i < stringCount; i++) {
-            const char* str;
-            if (!unflattener.read(&str)) {
-                return false;
-            }
-            // BlobDictionary hold binary chunks and does not care if the data holds text, it is
-            // therefore crucial to include the trailing null.
-            dictionary.addBlob(str, strlen(str) + 1);
+        const char* compressed;
+        size_t compressedSize;
+        if (!unflattener.read(&compressed, &compressedSize)) {
+            return false;
         }
-        return true;
+        return inflateTextDictionary(compressed, compressedSize, size, dictionary);
     }
 
     return false;
@@ -126,8 +126,13 @@ bool MaterialChunk::getTextShader(Unflattener unflattener, BlobDictionary const&
         if (!unflattener.read(&lineIndex)) {
             return false;
         }
-        const char* string = dictionary.getString(lineIndex);
-        shaderBuilder.append(string, strlen(string));
+        if (lineIndex >= dictionary.size()) {
+            return false;
+        }
+        // dictionary strings include their null terminator
+        size_t size;
+        const char* string = dictionary.getBlob(lineIndex, &size);
+        shaderBuilder.append(string, size - 1);
         shaderBuilder.append("\n", 1);
     }
 
@@ -153,7 +158,14 @@ bool MaterialChunk::getSpirvShader(BlobDictionary const& dictionary,
 
     size_t index = pos->second;
     size_t shaderSize;
+    if (index >= dictionary.size()) {
+        return false;
+    }
+    // this decodes the blob if it is used for the first time
     const char* shaderContent = dictionary.getBlob(index, &shaderSize);
+    if (!shaderContent) {
+        return false;
+    }
 
     shaderBuilder.reset();
     shaderBuilder.announce(shaderSize);
@@ -161,6 +173,18 @@ bool MaterialChunk::getSpirvShader(BlobDictionary const& dictionary,
     return true;
 }
 
+bool MaterialChunk::hasShader(uint8_t shaderModel, uint8_t variant, uint8_t stage) const noexcept {
+    if (mBase == nullptr) {
+        return false;
+    }
+    auto pos = mOffsets.find(makeKey(shaderModel, variant, stage));
+    if (pos == mOffsets.end()) {
+        return false;
+    }
+    // text shaders use an offset of 0 for missing shaders
+    return mMaterialTag == filamat::ChunkType::MaterialSpirv || pos->second != 0;
+}
+
 bool MaterialChunk::getShader(ShaderBuilder& shaderBuilder,
         BlobDictionary const& dictionary, uint8_t shaderModel, uint8_t variant, uint8_t stage) {
     switch (mMaterialTag) {
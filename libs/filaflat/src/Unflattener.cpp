@@ -16,6 +16,8 @@
 
 #include <filaflat/Unflattener.h>
 
+#include <string.h>
+
 namespace filaflat {
 
 bool Unflattener::read(utils::CString* s) noexcept {
@@ -48,9 +50,8 @@ bool Unflattener::read(const char** blob, size_t* size) noexcept {
 
 bool Unflattener::read(const char** s) noexcept {
     const uint8_t* start = mCursor;
-    while (mCursor < mEnd && *mCursor != '\0') {
-        mCursor++;
-    }
+    const void* nul = mCursor < mEnd ? memchr(mCursor, '\0', size_t(mEnd - mCursor)) : nullptr;
+    mCursor = nul ? (const uint8_t*)nul : mEnd;
     bool overflowed = mCursor >= mEnd;
     if (!overflowed) {
         mCursor++;
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filamat/MaterialBuilder.h>
+#include <filamat/Package.h>
+
+#include <filaflat/BlobDictionary.h>
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
+
+#include <filament/MaterialChunkType.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace filamat;
+
+// Builds a lit material for all shader models with and without compression, only once.
+static Package const& getPackage(bool compression) {
+    static struct Packages {
+        Packages() {
+            utils::JobSystem jobSystem;
+            jobSystem.adopt();
+            MaterialBuilder::init();
+            for (bool compressed : { false, true }) {
+                MaterialBuilder builder;
+                builder.name("benchmark")
+                        .material("void material(inout MaterialInputs material) {\n"
+                                  "    prepareMaterial(material);\n"
+                                  "}\n")
+                        .shading(MaterialBuilder::Shading::LIT)
+                        .targetApi(MaterialBuilder::TargetApi::OPENGL)
+                        .platform(MaterialBuilder::Platform::ALL)
+                        .compression(compressed);
+                packages[compressed] = builder.build(jobSystem);
+            }
+            MaterialBuilder::shutdown();
+            jobSystem.emancipate();
+        }
+        Package packages[2];
+    } packages;
+    return packages.packages[compression];
+}
+
+// Measures the time it takes to read the text dictionary of a package and access all its lines,
+// and reports the size of the package and of its dictionary chunk.
+static void decodeDictionary(benchmark::State& state, bool compression) {
+    Package const& package = getPackage(compression);
+    filaflat::ChunkContainer container(package.getData(), package.getSize());
+    if (!package.isValid() || !container.parse()) {
+        state.SkipWithError("Unable to build the material");
+        return;
+    }
+
+    const ChunkType tag = filaflat::DictionaryReader::getTextDictionaryTag(container);
+    size_t lineCount = 0;
+    for (auto _ : state) {
+        filaflat::BlobDictionary dictionary;
+        if (!filaflat::DictionaryReader::unflatten(container, tag, dictionary)) {
+            state.SkipWithError("Unable to read the dictionary");
+            return;
+        }
+        lineCount = dictionary.size();
+        for (size_t i = 0; i < lineCount; i++) {
+            benchmark::DoNotOptimize(dictionary.getString(i));
+        }
+    }
+
+    const size_t chunkSize = container.getChunkEnd(tag) - container.getChunkStart(tag);
+    state.SetBytesProcessed(int64_t(state.iterations() * chunkSize));
+    state.counters["package"] = double(package.getSize());
+    state.counters["dictionary"] = double(chunkSize);
+    state.counters["lines"] = double(lineCount);
+}
+
+static void BM_decodeDictionary(benchmark::State& state) {
+    decodeDictionary(state, false);
+}
+
+static void BM_decodeCompressedDictionary(benchmark::State& state) {
+    decodeDictionary(state, true);
+}
+
+BENCHMARK(BM_decodeDictionary);
+BENCHMARK(BM_decodeCompressedDictionary);
@@ -32,6 +32,7 @@
 
 #include <filamat/IncludeCallback.h>
 #include <filamat/Package.h>
+#include <filamat/ShaderCache.h>
 
 #include <utils/BitmaskEnum.h>
 #include <utils/bitset.h>
@@ -104,6 +105,7 @@ protected:
     Optimization mOptimization = Optimization::PERFORMANCE;
     bool mPrintShaders = false;
     bool mGenerateDebugInfo = false;
+    bool mCompression = false;
     utils::bitset32 mShaderModels;
     struct CodeGenParams {
         int shaderModel;
@@ -119,6 +121,7 @@ protected:
         .targetLanguage = TargetLanguage::SPIRV
     };
     uint8_t mVariantFilter = 0;
+    std::vector<uint8_t> mUsedVariants;
 
     // Keeps track of how many times MaterialBuilder::init() has been called without a call to
     // MaterialBuilder::shutdown(). Internally, glslang does something similar. We keep track for
@@ -315,6 +318,13 @@ public:
      */
     MaterialBuilder& includeCallback(IncludeCallback callback) noexcept;
 
+    /**
+     * Set the cache used to reuse compiled shaders across builds. The default is no cache.
+     * The cache is not owned by the builder and must outlive the calls to build().
+     * The cache is bypassed when printShaders() is enabled, and is not used by filamat_lite.
+     */
+    MaterialBuilder& shaderCache(ShaderCache* cache) noexcept;
+
     /**
      * Set the vertex code content of this material.
      *
@@ -477,9 +487,24 @@ public:
     //! If true, will include debugging information in generated SPIRV.
     MaterialBuilder& generateDebugInfo(bool generateDebugInfo) noexcept;
 
+    /**
+     * If true, the text shader dictionary is compressed with zlib (default is false). This
+     * reduces the size of the package at the cost of decompressing the dictionary when the
+     * material is loaded. Compressed packages require a matching version of the engine.
+     */
+    MaterialBuilder& compression(bool compression) noexcept;
+
     //! Specifies a list of variants that should be filtered out during code generation.
     MaterialBuilder& variantFilter(uint8_t variantFilter) noexcept;
 
+    /**
+     * Only generates the shaders needed by the given variants, typically the ones recorded at
+     * runtime with Material::setVariantRecording(). The base and depth variants are always
+     * generated, the engine falls back to them for variants that are missing from the package.
+     * Only applies to materials in the SURFACE domain. By default all variants are generated.
+     */
+    MaterialBuilder& usedVariants(const uint8_t* variants, size_t count) noexcept;
+
     //! Adds a new preprocessor macro definition to the shader code. Can be called repeatedly.
     MaterialBuilder& shaderDefine(const char* name, const char* value) noexcept;
 
@@ -592,6 +617,8 @@ public:
 
     uint8_t getVariantFilter() const { return mVariantFilter; }
 
+    const utils::CString& getName() const noexcept { return mMaterialName; }
+
     /// @endcond
 
 private:
@@ -650,6 +677,7 @@ private:
     ShaderCode mMaterialVertexCode;
 
     IncludeCallback mIncludeCallback = nullptr;
+    ShaderCache* mShaderCache = nullptr;
 
     PropertyList mProperties;
     ParameterList mParameters;
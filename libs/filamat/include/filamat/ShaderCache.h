@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMAT_SHADERCACHE_H
+#define TNT_FILAMAT_SHADERCACHE_H
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace filamat {
+
+/**
+ * A store for compiled shaders, used by MaterialBuilder to skip the compilation, optimization and
+ * cross-compilation of shaders that were already built.
+ *
+ * Entries are content-addressed: the key is a hash of the generated source of a single shader,
+ * which includes the material code with all its includes resolved, and of every option that
+ * affects the compiled output, including the version of the compiler. An entry can therefore never
+ * become stale, and a cache can be shared by any number of materials.
+ *
+ * The cache is accessed concurrently from the JobSystem's threads, implementations must be
+ * thread-safe.
+ *
+ * For an example of implementing this interface, see tools/matc/src/matc/FileShaderCache.h.
+ */
+class UTILS_PUBLIC ShaderCache {
+public:
+    virtual ~ShaderCache();
+
+    // Fills data with the entry for the given key, returns false if there is none.
+    virtual bool load(uint64_t key, std::vector<uint8_t>* data) = 0;
+
+    // Stores the entry for the given key.
+    virtual void store(uint64_t key, const uint8_t* data, size_t size) = 0;
+};
+
+} // namespace filamat
+
+#endif // TNT_FILAMAT_SHADERCACHE_H
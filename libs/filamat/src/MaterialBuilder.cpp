@@ -19,6 +19,7 @@
 #include <atomic>
 #include <vector>
 
+#include <utils/Hash.h>
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
 #include <utils/Mutex.h>
@@ -151,6 +152,11 @@ MaterialBuilder& MaterialBuilder::includeCallback(IncludeCallback callback) noex
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::shaderCache(ShaderCache* cache) noexcept {
+    mShaderCache = cache;
+    return *this;
+}
+
 MaterialBuilder& MaterialBuilder::materialVertex(const char* code, size_t line) noexcept {
     mMaterialVertexCode.setUnresolved(CString(code));
     mMaterialVertexCode.setLineOffset(line);
@@ -386,11 +392,21 @@ MaterialBuilder& MaterialBuilder::generateDebugInfo(bool generateDebugInfo) noex
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::compression(bool compression) noexcept {
+    mCompression = compression;
+    return *this;
+}
+
 MaterialBuilder& MaterialBuilder::variantFilter(uint8_t variantFilter) noexcept {
     mVariantFilter = variantFilter;
     return *this;
 }
 
+MaterialBuilder& MaterialBuilder::usedVariants(const uint8_t* variants, size_t count) noexcept {
+    mUsedVariants.assign(variants, variants + count);
+    return *this;
+}
+
 MaterialBuilder& MaterialBuilder::shaderDefine(const char* name, const char* value) noexcept {
     mDefines.emplace_back(name, value);
     return *this;
@@ -598,6 +614,96 @@ static void showErrorMessage(const char* materialName, uint8_t variant,
             << shaderCode;
 }
 
+ShaderCache::~ShaderCache() = default;
+
+#ifndef FILAMAT_LITE
+
+// Identifies the versions of glslang, SPIRV-Tools, SPIRV-Cross and GLSLPostProcessor, which all
+// determine the cached outputs. It is computed by CMake, see libs/filamat/CMakeLists.txt.
+#ifndef FILAMAT_SHADER_TOOLS_VERSION
+#error "FILAMAT_SHADER_TOOLS_VERSION must be defined by the build system"
+#endif
+
+// Must be bumped whenever the layout of the cache entries changes.
+static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+static uint64_t computeShaderCacheKey(const std::string& shader,
+        std::initializer_list<uint32_t> options) noexcept {
+    std::vector<uint32_t> words = {
+            SHADER_CACHE_VERSION, uint32_t(FILAMAT_SHADER_TOOLS_VERSION),
+            uint32_t(filament::MATERIAL_VERSION), uint32_t(shader.size()) };
+    words.insert(words.end(), options.begin(), options.end());
+    const size_t offset = words.size();
+    words.resize(offset + (shader.size() + 3) / 4, 0);
+    memcpy(words.data() + offset, shader.data(), shader.size());
+    return utils::hash::murmur3_64(words.data(), words.size() * sizeof(uint32_t));
+}
+
+static void appendToCacheEntry(std::vector<uint8_t>& entry, const void* data, size_t size) {
+    const uint32_t size32 = uint32_t(size);
+    const uint8_t* header = (const uint8_t*) &size32;
+    entry.insert(entry.end(), header, header + sizeof(size32));
+    entry.insert(entry.end(), (const uint8_t*) data, (const uint8_t*) data + size);
+}
+
+static bool readFromCacheEntry(const uint8_t*& cursor, const uint8_t* end,
+        const uint8_t** data, size_t* size) {
+    uint32_t size32;
+    if (end - cursor < ptrdiff_t(sizeof(size32))) {
+        return false;
+    }
+    memcpy(&size32, cursor, sizeof(size32));
+    cursor += sizeof(size32);
+    if (end - cursor < ptrdiff_t(size32)) {
+        return false;
+    }
+    *data = cursor;
+    *size = size32;
+    cursor += size32;
+    return true;
+}
+
+// An entry holds the GLSL, SPIR-V and MSL outputs of GLSLPostProcessor, in that order. Outputs
+// that weren't requested are empty.
+static std::vector<uint8_t> packShaderCacheEntry(const std::string* glsl,
+        const std::vector<uint32_t>* spirv, const std::string* msl) {
+    std::vector<uint8_t> entry;
+    appendToCacheEntry(entry, glsl ? glsl->data() : nullptr, glsl ? glsl->size() : 0);
+    appendToCacheEntry(entry, spirv ? spirv->data() : nullptr, spirv ? spirv->size() * 4 : 0);
+    appendToCacheEntry(entry, msl ? msl->data() : nullptr, msl ? msl->size() : 0);
+    return entry;
+}
+
+// The outputs are left untouched if the entry is invalid.
+static bool unpackShaderCacheEntry(const std::vector<uint8_t>& entry, std::string* glsl,
+        std::vector<uint32_t>* spirv, std::string* msl) {
+    const uint8_t* cursor = entry.data();
+    const uint8_t* const end = cursor + entry.size();
+    const uint8_t* data[3];
+    size_t size[3];
+    for (size_t i = 0; i < 3; i++) {
+        if (!readFromCacheEntry(cursor, end, &data[i], &size[i])) {
+            return false;
+        }
+    }
+    if ((glsl && !size[0]) || (spirv && (!size[1] || size[1] % 4)) || (msl && !size[2])) {
+        return false;
+    }
+    if (glsl) {
+        glsl->assign((const char*) data[0], size[0]);
+    }
+    if (spirv) {
+        spirv->resize(size[1] / 4);
+        memcpy(spirv->data(), data[1], size[1]);
+    }
+    if (msl) {
+        msl->assign((const char*) data[2], size[2]);
+    }
+    return true;
+}
+
+#endif
+
 bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Variant>& variants,
         ChunkContainer& container, const MaterialInfo& info) const noexcept {
     // Create a postprocessor to optimize / compile to Spir-V if necessary.
@@ -717,7 +823,27 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                     config.glsl.subpassInputToColorLocation.emplace_back(0, 0);
                 }
 
-                bool ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+                // The output of the post-processor only depends on the generated shader and on
+                // the options below, so it can be reused from a previous build.
+                ShaderCache* const cache = mPrintShaders ? nullptr : mShaderCache;
+                uint64_t cacheKey = 0;
+                bool ok = false;
+                if (cache) {
+                    cacheKey = computeShaderCacheKey(shader, {
+                            uint32_t(params.shaderModel), uint32_t(targetApi),
+                            uint32_t(targetLanguage), uint32_t(v.stage),
+                            uint32_t(mOptimization), flags, mEnableFramebufferFetch });
+                    std::vector<uint8_t> entry;
+                    ok = cache->load(cacheKey, &entry) &&
+                            unpackShaderCacheEntry(entry, pGlsl, pSpirv, pMsl);
+                }
+                if (!ok) {
+                    ok = postProcessor.process(shader, config, pGlsl, pSpirv, pMsl);
+                    if (ok && cache) {
+                        std::vector<uint8_t> entry = packShaderCacheEntry(pGlsl, pSpirv, pMsl);
+                        cache->store(cacheKey, entry.data(), entry.size());
+                    }
+                }
 #else
                 bool ok = true;
 #endif
@@ -808,7 +934,8 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
 
     // Emit dictionary chunk (TextDictionaryReader and DictionaryTextChunk)
     const auto& dictionaryChunk = container.addChild<filamat::DictionaryTextChunk>(
-            std::move(textDictionary), ChunkType::DictionaryText);
+            std::move(textDictionary),
+            mCompression ? ChunkType::DictionaryTextCompressed : ChunkType::DictionaryText);
 
     // Emit GLSL chunk (MaterialTextChunk).
     if (!glslEntries.empty()) {
@@ -927,7 +1054,7 @@ Package MaterialBuilder::build(JobSystem& jobSystem) noexcept {
 
     // Generate all shaders and write the shader chunks.
     const auto variants = mMaterialDomain == MaterialDomain::SURFACE ?
-        determineSurfaceVariants(mVariantFilter, isLit(), mShadowMultiplier) :
+        determineSurfaceVariants(mVariantFilter, isLit(), mShadowMultiplier, mUsedVariants) :
         determinePostProcessVariants();
     bool success = generateShaders(jobSystem, variants, container, info);
 
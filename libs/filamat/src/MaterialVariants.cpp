@@ -18,12 +18,31 @@
 
 #include <private/filament/EngineEnums.h>
 
+#include <bitset>
+
 namespace filamat {
 
 std::vector<Variant> determineSurfaceVariants(uint8_t variantFilter, bool isLit,
-        bool shadowMultiplier) {
+        bool shadowMultiplier, const std::vector<uint8_t>& usedVariants) {
     std::vector<Variant> variants;
     uint8_t variantMask = ~variantFilter;
+
+    // The engine falls back to the base and depth variants when a variant is missing, so their
+    // shaders are always needed.
+    std::bitset<filament::VARIANT_COUNT> vertexNeeded;
+    std::bitset<filament::VARIANT_COUNT> fragmentNeeded;
+    for (uint8_t k : { uint8_t(0), filament::Variant::DEPTH_VARIANT }) {
+        vertexNeeded.set(filament::Variant::filterVariantVertex(k));
+        fragmentNeeded.set(filament::Variant::filterVariantFragment(k));
+    }
+    for (uint8_t k : usedVariants) {
+        if (k < filament::VARIANT_COUNT) {
+            vertexNeeded.set(filament::Variant::filterVariantVertex(k));
+            fragmentNeeded.set(filament::Variant::filterVariantFragment(k));
+        }
+    }
+    const bool keepAll = usedVariants.empty();
+
     for (uint8_t k = 0; k < filament::VARIANT_COUNT; k++) {
         if (filament::Variant::isReserved(k)) {
             continue;
@@ -33,11 +52,11 @@ std::vector<Variant> determineSurfaceVariants(uint8_t variantFilter, bool isLit,
         uint8_t v = filament::Variant::filterVariant(
                 k & variantMask, isLit || shadowMultiplier);
 
-        if (filament::Variant::filterVariantVertex(v) == k) {
+        if (filament::Variant::filterVariantVertex(v) == k && (keepAll || vertexNeeded[k])) {
             variants.emplace_back(k, filament::backend::ShaderType::VERTEX);
         }
 
-        if (filament::Variant::filterVariantFragment(v) == k) {
+        if (filament::Variant::filterVariantFragment(v) == k && (keepAll || fragmentNeeded[k])) {
             variants.emplace_back(k, filament::backend::ShaderType::FRAGMENT);
         }
     }
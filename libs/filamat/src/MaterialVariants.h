@@ -34,8 +34,10 @@ struct Variant {
     Stage stage;
 };
 
+// When usedVariants is not empty, only the shaders needed by these variants and by the base and
+// depth variants are kept.
 std::vector<Variant> determineSurfaceVariants(uint8_t variantFilter, bool isLit,
-        bool shadowMultiplier);
+        bool shadowMultiplier, const std::vector<uint8_t>& usedVariants = {});
 
 std::vector<Variant> determinePostProcessVariants();
 
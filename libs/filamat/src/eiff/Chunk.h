@@ -47,6 +47,11 @@ protected:
     Chunk(ChunkType type) : mType(type), mFlattenedSize(0) {
     }
 
+    // Only valid before the chunk is flattened.
+    void setType(ChunkType type) noexcept {
+        mType = type;
+    }
+
 private:
     ChunkType mType;
     size_t mFlattenedSize;
@@ -16,13 +16,35 @@
 
 #include "DictionaryTextChunk.h"
 
+#include <utils/Log.h>
+
+#include <zlib.h>
+
 namespace filamat {
 
 DictionaryTextChunk::DictionaryTextChunk(LineDictionary&& dictionary, ChunkType chunkType) :
         Chunk(chunkType), mDictionary(dictionary) {
+    if (chunkType == ChunkType::DictionaryTextCompressed && !compressLines()) {
+        utils::slog.w << "Error with dictionary compression, "
+                         "writing uncompressed dictionary" << utils::io::endl;
+        mCompressed.clear();
+        setType(ChunkType::DictionaryText);
+    }
 }
 
 void DictionaryTextChunk::flatten(Flattener& f) {
+    if (getType() != ChunkType::DictionaryTextCompressed) {
+        flattenLines(f);
+        return;
+    }
+
+    // For now, 1 (zlib) is the only compression scheme.
+    f.writeUint32(1);
+    f.writeUint32(mUncompressedSize);
+    f.writeBlob((const char*) mCompressed.data(), mCompressed.size());
+}
+
+void DictionaryTextChunk::flattenLines(Flattener& f) const {
     // NumStrings
     f.writeUint32(mDictionary.getLineCount());
 
@@ -32,4 +54,27 @@ void DictionaryTextChunk::flatten(Flattener& f) {
     }
 }
 
+bool DictionaryTextChunk::compressLines() {
+    size_t size = sizeof(uint32_t);
+    for (size_t i = 0 ; i < mDictionary.getLineCount() ; i++) {
+        size += mDictionary.getString(i).size() + 1;
+    }
+
+    std::vector<uint8_t> lines(size);
+    Flattener f(lines.data());
+    flattenLines(f);
+    assert(f.getBytesWritten() == size);
+
+    // Packages are built offline, so favor size over compression speed.
+    uLongf compressedSize = compressBound(size);
+    mCompressed.resize(compressedSize);
+    if (compress2(mCompressed.data(), &compressedSize, lines.data(), size,
+            Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    mCompressed.resize(compressedSize);
+    mUncompressedSize = uint32_t(size);
+    return true;
+}
+
 } // namespace filamat
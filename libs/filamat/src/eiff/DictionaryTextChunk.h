@@ -26,6 +26,9 @@
 
 namespace filamat {
 
+// Holds the lines referenced by MaterialTextChunk. When the chunk type is
+// DictionaryTextCompressed, the lines are written as a single zlib stream. If compression fails,
+// the chunk falls back to the DictionaryText type and uncompressed lines.
 class DictionaryTextChunk final : public Chunk {
 public:
     DictionaryTextChunk(LineDictionary&& dictionary, ChunkType chunkType);
@@ -35,8 +38,15 @@ public:
 
 private:
     void flatten(Flattener& f) override;
+    void flattenLines(Flattener& f) const;
+    bool compressLines();
 
     const LineDictionary mDictionary;
+
+    // Computed at construction, since the chunk is flattened twice (dry run and actual
+    // flattening) and its type must not change in between.
+    std::vector<uint8_t> mCompressed;
+    uint32_t mUncompressedSize = 0;
 };
 
 } // namespace filamat
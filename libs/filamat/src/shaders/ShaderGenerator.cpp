@@ -197,6 +197,27 @@ std::string ShaderGenerator::createVertexProgram(filament::backend::ShaderModel
     cg.generateDefine(vs, "HAS_SKINNING_OR_MORPHING", variant.hasSkinningOrMorphing());
     cg.generateDefine(vs, "HAS_VSM", variant.hasVsm());
     cg.generateDefine(vs, getShadingDefine(material.shading), true);
+
+    // The bones texture is missing from the binding map when the material uses too many samplers.
+    uint8_t bonesBinding = 0;
+    const bool hasBonesTexture = variant.hasSkinningOrMorphing() &&
+            material.samplerBindings.getSamplerBinding(BindingPoints::PER_RENDERABLE_BONES,
+                    PerRenderableBonesSib::TRANSFORMS, &bonesBinding);
+    cg.generateDefine(vs, "HAS_BONES_TEXTURE", hasBonesTexture);
+    if (hasBonesTexture) {
+        cg.generateDefine(vs, "BONE_TEXTURE_ROW_SIZE", uint32_t(CONFIG_BONE_TEXTURE_ROW_SIZE));
+    }
+
+    // Likewise for the morph target texture, which comes with the morph target weights UBO.
+    uint8_t morphingBinding = 0;
+    const bool hasMorphTargetBuffer = variant.hasSkinningOrMorphing() &&
+            material.samplerBindings.getSamplerBinding(BindingPoints::PER_RENDERABLE_MORPHING,
+                    PerRenderableMorphingSib::TARGETS, &morphingBinding);
+    cg.generateDefine(vs, "HAS_MORPH_TARGET_BUFFER", hasMorphTargetBuffer);
+    if (hasMorphTargetBuffer) {
+        cg.generateDefine(vs, "MORPH_TARGET_TEXTURE_WIDTH",
+                uint32_t(CONFIG_MORPH_TARGET_TEXTURE_WIDTH));
+    }
     generateMaterialDefines(vs, cg, mProperties, mDefines);
 
     AttributeBitset attributes = material.requiredAttributes;
@@ -237,10 +258,21 @@ std::string ShaderGenerator::createVertexProgram(filament::backend::ShaderModel
                 BindingPoints::PER_RENDERABLE_BONES,
                 UibGenerator::getPerRenderableBonesUib());
     }
+    if (hasMorphTargetBuffer) {
+        cg.generateUniforms(vs, ShaderType::VERTEX,
+                BindingPoints::PER_RENDERABLE_MORPHING,
+                UibGenerator::getPerRenderableMorphingUib());
+    }
     cg.generateUniforms(vs, ShaderType::VERTEX,
             BindingPoints::PER_MATERIAL_INSTANCE, material.uib);
     cg.generateSeparator(vs);
     // TODO: should we generate per-view SIB in the vertex shader?
+    if (hasBonesTexture) {
+        cg.generateSamplers(vs, bonesBinding, SibGenerator::getPerRenderableBonesSib());
+    }
+    if (hasMorphTargetBuffer) {
+        cg.generateSamplers(vs, morphingBinding, SibGenerator::getPerRenderableMorphingSib());
+    }
     cg.generateSamplers(vs,
             material.samplerBindings.getBlockOffset(BindingPoints::PER_MATERIAL_INSTANCE),
             material.sib);
@@ -23,9 +23,20 @@
 
 #include <filamat/Enums.h>
 
+#include <filaflat/BlobDictionary.h>
+#include <filaflat/ChunkContainer.h>
+#include <filaflat/DictionaryReader.h>
+#include <filaflat/MaterialChunk.h>
+
+#include <filament/MaterialChunkType.h>
+
+#include <private/filament/Variant.h>
+
 #include <utils/JobSystem.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
 
 using namespace utils;
 using namespace ASTUtils;
@@ -729,6 +740,138 @@ TEST_F(MaterialCompiler, Arrays) {
     EXPECT_TRUE(result.isValid());
 }
 
+TEST_F(MaterialCompiler, Compression) {
+    filamat::MaterialBuilder builder;
+    builder.targetApi(filamat::MaterialBuilder::TargetApi::OPENGL);
+    filamat::Package package = builder.build(*jobSystem);
+    ASSERT_TRUE(package.isValid());
+
+    builder.compression(true);
+    filamat::Package compressed = builder.build(*jobSystem);
+    ASSERT_TRUE(compressed.isValid());
+    EXPECT_LT(compressed.getSize(), package.getSize());
+
+    filaflat::ChunkContainer container(package.getData(), package.getSize());
+    filaflat::ChunkContainer compressedContainer(compressed.getData(), compressed.getSize());
+    ASSERT_TRUE(container.parse());
+    ASSERT_TRUE(compressedContainer.parse());
+
+    const auto tag = filaflat::DictionaryReader::getTextDictionaryTag(compressedContainer);
+    EXPECT_EQ(tag, filamat::ChunkType::DictionaryTextCompressed);
+    EXPECT_FALSE(compressedContainer.hasChunk(filamat::ChunkType::DictionaryText));
+
+    // The compressed dictionary must decode to the exact same lines.
+    filaflat::BlobDictionary dictionary;
+    filaflat::BlobDictionary compressedDictionary;
+    ASSERT_TRUE(filaflat::DictionaryReader::unflatten(container,
+            filamat::ChunkType::DictionaryText, dictionary));
+    ASSERT_TRUE(filaflat::DictionaryReader::unflatten(compressedContainer,
+            tag, compressedDictionary));
+    ASSERT_EQ(dictionary.size(), compressedDictionary.size());
+    for (size_t i = 0; i < dictionary.size(); i++) {
+        EXPECT_STREQ(dictionary.getString(i), compressedDictionary.getString(i));
+    }
+}
+
+TEST_F(MaterialCompiler, UsedVariants) {
+    using filament::Variant;
+
+    filamat::MaterialBuilder builder;
+    builder.targetApi(filamat::MaterialBuilder::TargetApi::OPENGL)
+            .platform(filamat::MaterialBuilder::Platform::DESKTOP);
+    filamat::Package package = builder.build(*jobSystem);
+    ASSERT_TRUE(package.isValid());
+
+    const uint8_t used[] = { Variant::DIRECTIONAL_LIGHTING | Variant::SHADOW_RECEIVER | Variant::FOG };
+    builder.usedVariants(used, 1);
+    filamat::Package pruned = builder.build(*jobSystem);
+    ASSERT_TRUE(pruned.isValid());
+    EXPECT_LT(pruned.getSize(), package.getSize());
+
+    filaflat::ChunkContainer container(pruned.getData(), pruned.getSize());
+    ASSERT_TRUE(container.parse());
+    filaflat::MaterialChunk chunk(container);
+    ASSERT_TRUE(chunk.readIndex(filamat::ChunkType::MaterialGlsl));
+
+    const uint8_t sm = uint8_t(ShaderModel::GL_CORE_41);
+    const uint8_t vertex = uint8_t(ShaderType::VERTEX);
+    const uint8_t fragment = uint8_t(ShaderType::FRAGMENT);
+
+    // the recorded variant, fog only affects the fragment shader
+    EXPECT_TRUE(chunk.hasShader(sm, Variant::filterVariantVertex(used[0]), vertex));
+    EXPECT_TRUE(chunk.hasShader(sm, used[0], fragment));
+
+    // the fallback variants
+    EXPECT_TRUE(chunk.hasShader(sm, 0, vertex));
+    EXPECT_TRUE(chunk.hasShader(sm, 0, fragment));
+    EXPECT_TRUE(chunk.hasShader(sm, Variant::DEPTH_VARIANT, vertex));
+    EXPECT_TRUE(chunk.hasShader(sm, Variant::DEPTH_VARIANT, fragment));
+
+    // everything else is gone
+    EXPECT_FALSE(chunk.hasShader(sm, Variant::DYNAMIC_LIGHTING, vertex));
+    EXPECT_FALSE(chunk.hasShader(sm, Variant::DIRECTIONAL_LIGHTING, fragment));
+    EXPECT_FALSE(chunk.hasShader(sm, Variant::SKINNING_OR_MORPHING, vertex));
+}
+
+class InMemoryShaderCache : public filamat::ShaderCache {
+public:
+    bool load(uint64_t key, std::vector<uint8_t>* data) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto pos = mEntries.find(key);
+        if (pos == mEntries.end()) {
+            return false;
+        }
+        *data = pos->second;
+        hits++;
+        return true;
+    }
+
+    void store(uint64_t key, const uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mEntries[key].assign(data, data + size);
+    }
+
+    size_t size() const { return mEntries.size(); }
+
+    size_t hits = 0;
+
+private:
+    std::mutex mLock;
+    std::map<uint64_t, std::vector<uint8_t>> mEntries;
+};
+
+TEST_F(MaterialCompiler, ShaderCache) {
+    InMemoryShaderCache cache;
+
+    filamat::MaterialBuilder builder;
+    builder.targetApi(filamat::MaterialBuilder::TargetApi::ALL);
+    filamat::Package package = builder.build(*jobSystem);
+    ASSERT_TRUE(package.isValid());
+
+    builder.shaderCache(&cache);
+    filamat::Package first = builder.build(*jobSystem);
+    ASSERT_TRUE(first.isValid());
+    EXPECT_GT(cache.size(), 0u);
+
+    // Every shader must come from the cache, and produce the exact same package.
+    const size_t firstHits = cache.hits;
+    filamat::Package second = builder.build(*jobSystem);
+    ASSERT_TRUE(second.isValid());
+    EXPECT_GE(cache.hits - firstHits, cache.size());
+
+    ASSERT_EQ(package.getSize(), first.getSize());
+    ASSERT_EQ(package.getSize(), second.getSize());
+    EXPECT_EQ(0, memcmp(package.getData(), first.getData(), package.getSize()));
+    EXPECT_EQ(0, memcmp(package.getData(), second.getData(), package.getSize()));
+
+    // Changing an option that affects the compiled shaders must not reuse them.
+    const size_t hits = cache.hits;
+    builder.optimization(filamat::MaterialBuilder::Optimization::NONE);
+    filamat::Package unoptimized = builder.build(*jobSystem);
+    ASSERT_TRUE(unoptimized.isValid());
+    EXPECT_EQ(cache.hits, hits);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
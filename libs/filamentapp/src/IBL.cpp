@@ -34,7 +34,9 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <string.h>
 
@@ -124,20 +126,24 @@ bool IBL::loadFromKtx(const std::string& prefix) {
         return false;
     }
 
-    auto createKtx = [] (Path path) {
+    // The bundles are views over the file contents, which are uploaded as they are and released
+    // once the upload is done.
+    auto readFile = [] (Path path) {
         using namespace std;
         ifstream file(path.getPath(), ios::binary);
-        vector<uint8_t> contents((istreambuf_iterator<char>(file)), {});
-        return new image::KtxBundle(contents.data(), contents.size());
+        return make_shared<vector<uint8_t>>(istreambuf_iterator<char>(file),
+                istreambuf_iterator<char>());
     };
 
-    KtxBundle* iblKtx = createKtx(iblPath);
-    KtxBundle* skyKtx = createKtx(skyPath);
+    auto iblContents = readFile(iblPath);
+    auto skyContents = readFile(skyPath);
+    KtxBundle iblKtx(iblContents->data(), iblContents->size(), KtxBundle::Storage::VIEW);
+    KtxBundle skyKtx(skyContents->data(), skyContents->size(), KtxBundle::Storage::VIEW);
 
-    mSkyboxTexture = ktx::createTexture(&mEngine, skyKtx, false);
-    mTexture = ktx::createTexture(&mEngine, iblKtx, false);
+    mSkyboxTexture = ktx::createTexture(&mEngine, skyKtx, false, skyContents);
+    mTexture = ktx::createTexture(&mEngine, iblKtx, false, iblContents);
 
-    if (!iblKtx->getSphericalHarmonics(mBands)) {
+    if (!iblKtx.getSphericalHarmonics(mBands)) {
         return false;
     }
 
@@ -42,6 +42,11 @@ public:
      * Applies rotation, translation, and scale to entities that have been targeted by the given
      * animation definition. Uses filament::TransformManager.
      *
+     * All channels are evaluated first, then the transforms they sample are updated within a local
+     * transform transaction. If the client already has a transaction open, e.g. to apply several
+     * animations in a row, the transforms are updated within it and the client must commit it.
+     * Otherwise the animator opens its own transaction and commits it before this returns.
+     *
      * @param animationIndex Zero-based index for the \c animation of interest.
      * @param time Elapsed time of interest in seconds.
      */
@@ -49,9 +54,13 @@ public:
 
     /**
      * Computes root-to-node transforms for all bone nodes, then passes
-     * the results into filament::RenderableManager::setBones.
+     * the results into filament::SkinningBuffer::setBones.
      * Uses filament::TransformManager and filament::RenderableManager.
      *
+     * Each skin is evaluated once, regardless of how many renderables it drives. Renderables that
+     * share a skin and a world transform are bound to a common filament::SkinningBuffer owned by
+     * the animator. Skins are evaluated in parallel on the engine's JobSystem.
+     *
      * NOTE: this operation is independent of \c animation.
      */
     void updateBoneMatrices();
@@ -152,6 +152,20 @@ public:
      */
     FilamentAsset* createAssetFromBinary(const uint8_t* bytes, uint32_t nbytes);
 
+    /**
+     * Memory-maps a glTF 2.0 file (JSON or GLB) and returns a bundle of Filament objects.
+     * Returns null on failure, or on platforms that do not have a file system.
+     *
+     * Unlike createAssetFromBinary, the file contents are not copied. The parser and the
+     * ResourceLoader work directly on the mapping, and the mapping is released only after the
+     * asset has been destroyed and all GPU uploads that reference it have completed. For large GLB
+     * files this avoids holding two copies of the geometry in RAM during loading.
+     *
+     * When loading a JSON-based file, consider also enabling ResourceConfiguration::memoryMapFiles
+     * so that external buffers and images are mapped as well.
+     */
+    FilamentAsset* createAssetFromFile(const char* path);
+
     /**
      * Consumes the contents of a glTF 2.0 file and produces a primary asset with one or more
      * instances. The primary asset has ownership over the instances.
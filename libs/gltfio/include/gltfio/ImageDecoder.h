@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_IMAGEDECODER_H
+#define GLTFIO_IMAGEDECODER_H
+
+#include <filament/Texture.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gltfio {
+
+/**
+ * \class ImageDecoder ImageDecoder.h gltfio/ImageDecoder.h
+ * \brief Interface to the codecs that ResourceLoader uses to decode glTF images.
+ *
+ * Decoders are registered with ResourceLoader::addImageDecoder() for a MIME type. PNG and JPEG
+ * images are decoded with stb_image unless another decoder is registered for their MIME type.
+ *
+ * Decoders produce either 8-bit texels with 1 to 4 channels, which the loader keeps as is when
+ * the Texture can use them, or compressed blocks that are uploaded without conversion. They may
+ * also provide the mipmap levels of an image, otherwise the loader generates them.
+ *
+ * getInfo() is called from the thread that starts the load, while decode() is called from the
+ * JobSystem, possibly for several images or several bands of rows of a single image at once.
+ * Both must therefore be thread-safe.
+ */
+class ImageDecoder {
+public:
+    struct Info {
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        //! Number of 8-bit channels of the decoded texels, from 1 to 4 (gray, gray-alpha, RGB and
+        //! RGBA). Ignored for compressed images.
+        uint8_t channels = 4;
+
+        //! Number of mipmap levels provided by the decoder. Mipmaps are generated when it is 1,
+        //! except for compressed images.
+        uint8_t levels = 1;
+
+        //! True if the image is made of compressed blocks, in which case format and compressedType
+        //! describe them.
+        bool compressed = false;
+        filament::Texture::InternalFormat format = filament::Texture::InternalFormat::RGBA8;
+        filament::Texture::CompressedType compressedType = {};
+
+        //! If non-zero, any band of this many rows can be decoded independently of the others,
+        //! which lets the loader decode large images in parallel. Ignored for compressed images.
+        uint32_t bandHeight = 0;
+    };
+
+    virtual ~ImageDecoder() = default;
+
+    /**
+     * Reads the header of an encoded image.
+     *
+     * @param data  encoded image
+     * @param size  size of the encoded image in bytes
+     * @param info  receives the description of the image
+     * @return false if the image can't be decoded by this decoder
+     */
+    virtual bool getInfo(const uint8_t* data, size_t size, Info* info) const = 0;
+
+    /**
+     * Returns the number of bytes that decode() produces for a whole level, which is
+     * width * height * channels of the level for uncompressed images. Decoders of compressed
+     * images must override it.
+     */
+    virtual size_t getLevelSize(const uint8_t* data, size_t size, const Info& info,
+            uint32_t level) const;
+
+    /**
+     * Decodes rows of a level of an image. Uncompressed rows are tightly packed.
+     *
+     * @param data      encoded image
+     * @param size      size of the encoded image in bytes
+     * @param info      the description returned by getInfo()
+     * @param level     level to decode
+     * @param firstRow  first row to decode, a multiple of Info::bandHeight
+     * @param rowCount  number of rows to decode, a multiple of Info::bandHeight unless the band
+     *                  ends the level. Always the whole level for compressed images, or when
+     *                  Info::bandHeight is 0.
+     * @param out       receives the decoded rows
+     * @return false if decoding failed
+     */
+    virtual bool decode(const uint8_t* data, size_t size, const Info& info, uint32_t level,
+            uint32_t firstRow, uint32_t rowCount, uint8_t* out) const = 0;
+};
+
+/**
+ * Creates the decoder of PNG and JPEG images that ResourceLoader uses by default, based on
+ * stb_image. Images can't be decoded in bands.
+ */
+ImageDecoder* createStbDecoder();
+
+/**
+ * Creates a decoder of KTX 1.1 files that hold a compressed 2D image, e.g. ETC2, BC or ASTC.
+ * The compressed blocks of all the levels are uploaded as they are, therefore the format must be
+ * supported by the engine. sRGB textures must be stored in sRGB formats.
+ *
+ * Example:
+ *
+ * ```
+ * ImageDecoder* ktxDecoder = createKtxDecoder();
+ * resourceLoader->addImageDecoder("image/ktx", ktxDecoder);
+ * resourceLoader->loadResources(asset);
+ * ...
+ * delete resourceLoader;
+ * delete ktxDecoder;
+ * ```
+ */
+ImageDecoder* createKtxDecoder();
+
+} // namespace gltfio
+
+#endif // GLTFIO_IMAGEDECODER_H
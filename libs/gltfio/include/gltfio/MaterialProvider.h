@@ -177,6 +177,34 @@ void processShaderString(std::string* shader, const UvMap& uvmap,
  */
 MaterialProvider* createMaterialGenerator(filament::Engine* engine, bool optimizeShaders = false);
 
+/**
+ * \struct MaterialCacheConfig MaterialProvider.h gltfio/MaterialProvider.h
+ * \brief Specifies an optional on-disk cache for materials built by the material generator.
+ */
+struct MaterialCacheConfig {
+    //! Directory that holds the compiled material packages. It is created if it does not exist.
+    const char* directory = nullptr;
+
+    //! Upper bound for the total size of the cache. The least recently used packages are evicted
+    //! when a new package would exceed this size.
+    size_t maxSizeInBytes = 64u * 1024u * 1024u;
+};
+
+/**
+ * Creates a material provider that builds materials on the fly and persists them on disk.
+ *
+ * Compiled material packages are keyed by a stable hash of the MaterialKey, the UvMap, the
+ * generated shader source, the engine's backend and the material format version, so cached
+ * packages are never reused across incompatible builds. On subsequent runs, materials found in
+ * the cache are loaded directly, skipping shader compilation entirely.
+ *
+ * Requires \c libfilamat to be linked in. Not available in \c libgltfio_core.
+ *
+ * @see createMaterialGenerator
+ */
+MaterialProvider* createMaterialGenerator(filament::Engine* engine, bool optimizeShaders,
+        const MaterialCacheConfig& cacheConfig);
+
 /**
  * Creates a material provider that loads a small set of pre-built materials.
  *
@@ -29,6 +29,7 @@ namespace gltfio {
 
 struct FFilamentAsset;
 class AssetPool;
+class ImageDecoder;
 
 /**
  * \struct ResourceConfiguration ResourceLoader.h gltfio/ResourceLoader.h
@@ -50,6 +51,53 @@ struct ResourceConfiguration {
     //! If true, computes the bounding boxes of all \c POSITION attibutes. Well formed glTF files
     //! do not need this, but it is useful for robustness.
     bool recomputeBoundingBoxes;
+
+    //! If true, external buffers and images are memory-mapped rather than read into heap memory,
+    //! and slices of the mapping are handed directly to the GPU uploads. Mappings are released
+    //! once the asset has been destroyed and all uploads that reference them have completed.
+    //! On platforms without a file system, buffers supplied via #addResourceData are shared with
+    //! the asset instead of being copied, unless #optimizeMeshes or #normalizeSkinningWeights
+    //! would modify them. They stay in the URI cache until #evictResourceData is called.
+    bool memoryMapFiles = false;
+
+    //! If true, asyncBeginLoad defers the upload of vertex and index buffers, which then happens
+    //! incrementally in asyncUpdateLoad. Each entity is published through
+    //! FilamentAsset::popRenderables as soon as its own geometry has been uploaded, rather than
+    //! after the entire asset. Textures initially show a neutral placeholder. Once decoded,
+    //! those that don't fit in the upload budget show their coarse mipmap levels first, then
+    //! finer ones at each update until the full image is uploaded. Compressed images without
+    //! mipmaps go straight from the placeholder to the full image.
+    bool progressiveLoading = false;
+
+    //! Maximum number of bytes that a single call to asyncUpdateLoad uploads for geometry and for
+    //! textures, when progressive loading is enabled. At least one mesh and one texture level are
+    //! always uploaded per call regardless of their size.
+    size_t progressiveUploadBudget = 4u * 1024u * 1024u;
+
+    //! If true, the triangles of each indexed primitive are reordered for better post-transform
+    //! vertex cache utilization and less overdraw, then vertices are reordered for better fetch
+    //! locality. This is done on the JobSystem before uploading, and modifies the source data in
+    //! place. Vertex reordering is skipped for primitives that share attributes with others.
+    bool optimizeMeshes = false;
+
+    //! If true, 32-bit index buffers are converted to 16-bit when possible. This only applies to
+    //! primitives that are processed by #optimizeMeshes.
+    bool compactIndices = false;
+};
+
+/**
+ * Statistics gathered by the most recent load when ResourceConfiguration::optimizeMeshes is
+ * enabled. The ACMR (average cache miss ratio) is the number of vertex shader invocations per
+ * triangle for a simulated 16-entry post-transform cache, averaged over all optimized triangles.
+ * It ranges from 0.5 (ideal) to 3.0 (worst).
+ */
+struct MeshOptimizationStats {
+    size_t optimizedPrimitiveCount = 0;     //!< indexed triangle lists that were reordered
+    size_t remappedPrimitiveCount = 0;      //!< primitives whose vertices were also reordered
+    size_t compactedIndexBufferCount = 0;   //!< index buffers converted from 32-bit to 16-bit
+    size_t triangleCount = 0;               //!< total number of optimized triangles
+    float acmrBefore = 0.0f;                //!< average cache miss ratio of the authored data
+    float acmrAfter = 0.0f;                 //!< average cache miss ratio after optimization
 };
 
 /**
@@ -93,6 +141,20 @@ public:
      */
     bool hasResourceData(const char* uri) const;
 
+    /**
+     * Registers the decoder of the images that have the given MIME type, e.g. "image/ktx". It
+     * replaces any decoder previously registered for this type, including the built-in decoder
+     * of "image/png" and "image/jpeg".
+     *
+     * The MIME type of an image is given by the glTF file, by its data URI, or by the extension
+     * of its file. Images whose MIME type has no decoder are decoded by the first registered
+     * decoder that recognizes them, or else by the built-in decoder.
+     *
+     * Decoders must be registered before calling #loadResources or #asyncBeginLoad. They are not
+     * owned by the loader and must outlive it. See also ImageDecoder.
+     */
+    void addImageDecoder(const char* mimeType, ImageDecoder* decoder);
+
     /**
      * Frees memory by evicting the URI cache that was populated via addResourceData.
      *
@@ -145,11 +207,19 @@ public:
      */
     void asyncCancelLoad();
 
+    /**
+     * Returns statistics about the mesh optimization that was performed by the most recent call
+     * to #loadResources or #asyncBeginLoad. All fields are zero if
+     * ResourceConfiguration::optimizeMeshes is disabled.
+     */
+    MeshOptimizationStats getMeshOptimizationStats() const;
+
 private:
     bool loadResources(FFilamentAsset* asset, bool async);
     void applySparseData(FFilamentAsset* asset) const;
     void normalizeSkinningWeights(FFilamentAsset* asset) const;
     void updateBoundingBoxes(FFilamentAsset* asset) const;
+    void optimizeMeshes(FFilamentAsset* asset);
     AssetPool* mPool;
     struct Impl;
     Impl* pImpl;
@@ -22,10 +22,13 @@
 #include "math.h"
 #include "upcast.h"
 
+#include <filament/Engine.h>
 #include <filament/MaterialEnums.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TransformManager.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 
 #include <math/mat4.h>
@@ -34,7 +37,9 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <map>
+#include <tsl/robin_map.h>
+
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -45,12 +50,12 @@ using namespace utils;
 
 namespace gltfio {
 
-using TimeValues = map<float, size_t>;
+using TimeValues = vector<float>;
 using SourceValues = vector<float>;
 using BoneVector = vector<filament::math::mat4f>;
 
 struct Sampler {
-    TimeValues times;
+    TimeValues times; // sorted in increasing order, as required by the spec
     SourceValues values;
     enum { LINEAR, STEP, CUBIC } interpolation;
 };
@@ -58,38 +63,75 @@ struct Sampler {
 struct Channel {
     const Sampler* sourceData;
     Entity targetEntity;
+    size_t targetIndex; // index into Animation::targets, unused for WEIGHTS
+    size_t cursor; // keyframe found by the most recent evaluation
     enum { TRANSLATION, ROTATION, SCALE, WEIGHTS } transformType;
 };
 
+// Local transform of a node, decomposed so that each channel can overwrite a single component.
+struct Transform {
+    float3 translation;
+    quatf rotation;
+    float3 scale;
+};
+
 struct Animation {
     float duration;
     std::string name;
     vector<Sampler> samplers;
     vector<Channel> channels;
+
+    // Unique list of entities whose transform is affected by at least one channel.
+    vector<Entity> targets;
+    tsl::robin_map<Entity, size_t> targetIndices;
 };
 
+// Skin targets that share the same world transform also share the same bone matrices, so they are
+// grouped together and bound to a single SkinningBuffer. Targets are grouped by the node that
+// gives them their world transform, i.e. their closest ancestor with a local transform that isn't
+// the identity, or the root of their hierarchy.
+struct SkeletonGroup {
+    Entity node;
+    SkinningBuffer* buffer;
+    BoneVector boneMatrices;
+};
+
+// Per-skin state that persists across calls to updateBoneMatrices. Groups are recycled from one
+// frame to the next, so the number of skinning buffers never exceeds the number of targets.
+struct SkinState {
+    const Skin* skin = nullptr;
+    vector<SkeletonGroup> groups;
+    size_t groupCount = 0;
+    BoneVector jointMatrices;
+    tsl::robin_map<Entity, SkinningBuffer*> bindings;
+    bool unsupported = false;   // too many joints, reported once
+};
+
+// Largest skeleton that a SkinningBuffer can hold.
+static constexpr size_t kMaxBoneCount = 65536;
+
 struct AnimatorImpl {
     vector<Animation> animations;
-    BoneVector boneMatrices;
+    vector<SkinState> skins;
     FFilamentAsset* asset = nullptr;
     FFilamentInstance* instance = nullptr;
     RenderableManager* renderableManager;
     TransformManager* transformManager;
     vector<float> weights;
+    vector<Transform> transforms;
+    vector<bool> sampled;
     MorphHelper* morpher;
     void addChannels(const NodeMap& nodeMap, const cgltf_animation& srcAnim, Animation& dst);
     void applyAnimation(const Channel& channel, float t, size_t prevIndex, size_t nextIndex);
+    void prepareSkin(const Skin& skin, SkinState& state);
+    void releaseSkin(SkinState& state);
 };
 
 static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
-    // Copy the time values into a red-black tree.
+    // Copy the time values into a flat array.
     const cgltf_accessor* timelineAccessor = src.input;
-    const uint8_t* timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
-    const float* timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
-            timelineAccessor->buffer_view->offset);
-    for (size_t i = 0, len = timelineAccessor->count; i < len; ++i) {
-        dst.times[timelineFloats[i]] = i;
-    }
+    dst.times.resize(timelineAccessor->count);
+    cgltf_accessor_unpack_floats(timelineAccessor, dst.times.data(), timelineAccessor->count);
 
     // Convert source data to float.
     const cgltf_accessor* valuesAccessor = src.output;
@@ -206,8 +248,7 @@ Animator::Animator(FFilamentAsset* asset, FFilamentInstance* instance) {
             Sampler& dstSampler = dstAnim.samplers[j];
             createSampler(srcSampler, dstSampler);
             if (dstSampler.times.size() > 1) {
-                float maxtime = (--dstSampler.times.end())->first;
-                dstAnim.duration = std::max(dstAnim.duration, maxtime);
+                dstAnim.duration = std::max(dstAnim.duration, dstSampler.times.back());
             }
         }
 
@@ -235,6 +276,9 @@ void Animator::addInstance(FFilamentInstance* instance) {
 }
 
 Animator::~Animator() {
+    for (SkinState& state : mImpl->skins) {
+        mImpl->releaseSkin(state);
+    }
     delete mImpl->morpher;
     delete mImpl;
 }
@@ -243,12 +287,50 @@ size_t Animator::getAnimationCount() const {
     return mImpl->animations.size();
 }
 
+// Returns the index of the first keyframe whose time is not less than the given time, or the
+// number of keyframes if there is no such keyframe. Playback typically advances by less than one
+// keyframe per frame, so the keyframe found by the previous call (or its successor) is checked
+// first before falling back to a binary search.
+static size_t findKeyframe(const TimeValues& times, float time, size_t* cursor) {
+    const size_t count = times.size();
+    for (size_t index = *cursor, end = std::min(*cursor + 2, count); index < end; ++index) {
+        if (times[index] >= time && (index == 0 || times[index - 1] < time)) {
+            return *cursor = index;
+        }
+    }
+    return *cursor = std::lower_bound(times.begin(), times.end(), time) - times.begin();
+}
+
 void Animator::applyAnimation(size_t animationIndex, float time) const {
-    const Animation& anim = mImpl->animations[animationIndex];
+    Animation& anim = mImpl->animations[animationIndex];
     TransformManager* transformManager = mImpl->transformManager;
-    RenderableManager* renderableManager = mImpl->renderableManager;
     time = fmod(time, anim.duration);
+
+    // Only the targets of channels that have enough keyframes to be sampled are written back.
+    vector<bool>& sampled = mImpl->sampled;
+    sampled.assign(anim.targets.size(), false);
     for (const auto& channel : anim.channels) {
+        if (channel.transformType != Channel::WEIGHTS && channel.sourceData->times.size() >= 2) {
+            sampled[channel.targetIndex] = true;
+        }
+    }
+
+    // Gather the current local transform of each sampled target. Channels typically animate only
+    // some of the TRS components of a given node, the others must retain their values.
+    vector<Transform>& transforms = mImpl->transforms;
+    transforms.resize(anim.targets.size());
+    for (size_t i = 0, n = anim.targets.size(); i < n; ++i) {
+        if (!sampled[i]) {
+            continue;
+        }
+        Transform& transform = transforms[i];
+        auto node = transformManager->getInstance(anim.targets[i]);
+        decomposeMatrix(transformManager->getTransform(node), &transform.translation,
+                &transform.rotation, &transform.scale);
+    }
+
+    // Evaluate all channels into the scratch transforms.
+    for (auto& channel : anim.channels) {
         const Sampler* sampler = channel.sourceData;
         if (sampler->times.size() < 2) {
             continue;
@@ -257,24 +339,23 @@ void Animator::applyAnimation(size_t animationIndex, float time) const {
         const TimeValues& times = sampler->times;
 
         // Find the first keyframe after the given time, or the keyframe that matches it exactly.
-        TimeValues::const_iterator iter = times.lower_bound(time);
+        const size_t index = findKeyframe(times, time, &channel.cursor);
 
         // Compute the interpolant (between 0 and 1) and determine the keyframe pair.
         float t = 0.0f;
         size_t nextIndex;
         size_t prevIndex;
-        if (iter == times.end()) {
+        if (index == times.size()) {
             nextIndex = times.size() - 1;
             prevIndex = nextIndex;
-        } else if (iter == times.begin()) {
+        } else if (index == 0) {
             nextIndex = 0;
             prevIndex = 0;
         } else {
-            TimeValues::const_iterator prev = iter; --prev;
-            nextIndex = iter->second;
-            prevIndex = prev->second;
-            const float nextTime = iter->first;
-            const float prevTime = prev->first;
+            nextIndex = index;
+            prevIndex = index - 1;
+            const float nextTime = times[nextIndex];
+            const float prevTime = times[prevIndex];
             float deltaTime = nextTime - prevTime;
             assert(deltaTime >= 0);
             if (deltaTime > 0) {
@@ -288,47 +369,104 @@ void Animator::applyAnimation(size_t animationIndex, float time) const {
 
         mImpl->applyAnimation(channel, t, prevIndex, nextIndex);
     }
+
+    // Apply the results in a single pass. The transaction defers the propagation of world
+    // transforms until all local transforms have been set. If the client already opened one, e.g.
+    // to apply several animations, it is left to the client to commit it.
+    const bool ownsTransaction = !transformManager->isLocalTransformTransactionOpen();
+    if (ownsTransaction) {
+        transformManager->openLocalTransformTransaction();
+    }
+    for (size_t i = 0, n = anim.targets.size(); i < n; ++i) {
+        if (!sampled[i]) {
+            continue;
+        }
+        const Transform& transform = transforms[i];
+        auto node = transformManager->getInstance(anim.targets[i]);
+        transformManager->setTransform(node,
+                composeMatrix(transform.translation, transform.rotation, transform.scale));
+    }
+    if (ownsTransaction) {
+        transformManager->commitLocalTransformTransaction();
+    }
+}
+
+// Computes the bone matrices of every group in the given skin. This only reads from the
+// TransformManager, so it can safely run on a worker thread while the main thread is waiting.
+static void computeBoneMatrices(SkinState* state, const TransformManager* transformManager) {
+    const Skin& skin = *state->skin;
+    const size_t njoints = skin.joints.size();
+
+    // The joint transforms do not depend on the target, so they are evaluated only once.
+    BoneVector& jointMatrices = state->jointMatrices;
+    jointMatrices.resize(njoints);
+    for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
+        auto jointInstance = transformManager->getInstance(skin.joints[boneIndex]);
+        jointMatrices[boneIndex] = transformManager->getWorldTransform(jointInstance) *
+                skin.inverseBindMatrices[boneIndex];
+    }
+
+    for (size_t i = 0; i < state->groupCount; ++i) {
+        SkeletonGroup& group = state->groups[i];
+        mat4f worldTransform;
+        if (auto instance = transformManager->getInstance(group.node)) {
+            worldTransform = transformManager->getWorldTransform(instance);
+        }
+        const mat4f inverseGlobalTransform = inverse(worldTransform);
+        group.boneMatrices.resize(njoints);
+        for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
+            group.boneMatrices[boneIndex] = inverseGlobalTransform * jointMatrices[boneIndex];
+        }
+    }
 }
 
 void Animator::updateBoneMatrices() {
-    auto renderableManager = mImpl->renderableManager;
-    auto transformManager = mImpl->transformManager;
+    Engine* engine = mImpl->asset->mEngine;
 
-    auto update = [=](const SkinVector& skins, BoneVector& boneVector) {
+    // Assign the targets of each skin to groups on the main thread, since this might need to
+    // create skinning buffers and modify renderables.
+    size_t skinCount = 0;
+    auto prepare = [this, &skinCount](const SkinVector& skins) {
         for (const auto& skin : skins) {
-            size_t njoints = skin.joints.size();
-            boneVector.resize(njoints);
-            for (const auto& entity : skin.targets) {
-                auto renderable = renderableManager->getInstance(entity);
-                if (!renderable) {
-                    continue;
-                }
-                mat4f inverseGlobalTransform;
-                auto xformable = transformManager->getInstance(entity);
-                if (xformable) {
-                    inverseGlobalTransform = inverse(transformManager->getWorldTransform(xformable));
-                }
-                for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
-                    const auto& joint = skin.joints[boneIndex];
-                    TransformManager::Instance jointInstance = transformManager->getInstance(joint);
-                    mat4f globalJointTransform = transformManager->getWorldTransform(jointInstance);
-                    boneVector[boneIndex] =
-                            inverseGlobalTransform *
-                            globalJointTransform *
-                            skin.inverseBindMatrices[boneIndex];
-                }
-                renderableManager->setBones(renderable, boneVector.data(), boneVector.size());
+            if (skinCount == mImpl->skins.size()) {
+                mImpl->skins.emplace_back();
             }
+            mImpl->prepareSkin(skin, mImpl->skins[skinCount++]);
         }
     };
 
     if (mImpl->instance) {
-        update(mImpl->instance->skins, mImpl->boneMatrices);
+        prepare(mImpl->instance->skins);
     } else if (!mImpl->asset->isInstanced()) {
-        update(mImpl->asset->mSkins, mImpl->boneMatrices);
+        prepare(mImpl->asset->mSkins);
     } else {
         for (FFilamentInstance* instance : mImpl->asset->mInstances) {
-            update(instance->skins, mImpl->boneMatrices);
+            prepare(instance->skins);
+        }
+    }
+
+    // Evaluate the skins in parallel, each job handles all the groups of a single skin.
+    const TransformManager* transformManager = mImpl->transformManager;
+    if (skinCount == 1) {
+        computeBoneMatrices(&mImpl->skins[0], transformManager);
+    } else if (skinCount > 1) {
+        JobSystem* js = &engine->getJobSystem();
+        JobSystem::Job* parent = js->createJob();
+        for (size_t i = 0; i < skinCount; ++i) {
+            SkinState* state = &mImpl->skins[i];
+            js->run(jobs::createJob(*js, parent, [state, transformManager] {
+                computeBoneMatrices(state, transformManager);
+            }));
+        }
+        js->runAndWait(parent);
+    }
+
+    // Finally, upload the results from the main thread, once per group.
+    for (size_t i = 0; i < skinCount; ++i) {
+        const SkinState& state = mImpl->skins[i];
+        for (size_t j = 0; j < state.groupCount; ++j) {
+            const SkeletonGroup& group = state.groups[j];
+            group.buffer->setBones(*engine, group.boneMatrices.data(), group.boneMatrices.size());
         }
     }
 }
@@ -368,25 +506,115 @@ void AnimatorImpl::addChannels(const NodeMap& nodeMap, const cgltf_animation& sr
         Channel dstChannel;
         dstChannel.sourceData = samplers + (srcChannel.sampler - srcSamplers);
         dstChannel.targetEntity = targetEntity;
+        dstChannel.targetIndex = 0;
+        dstChannel.cursor = 0;
         setTransformType(srcChannel, dstChannel);
+        if (dstChannel.transformType != Channel::WEIGHTS) {
+            auto target = dst.targetIndices.find(targetEntity);
+            if (target == dst.targetIndices.end()) {
+                target = dst.targetIndices.insert({targetEntity, dst.targets.size()}).first;
+                dst.targets.push_back(targetEntity);
+            }
+            dstChannel.targetIndex = target->second;
+        }
         dst.channels.push_back(dstChannel);
     }
 }
 
+// Returns the node whose world transform is the world transform of the given node, i.e. the node
+// itself unless its local transform is the identity.
+static Entity getTransformNode(const TransformManager* transformManager, Entity entity) {
+    const mat4f identity;
+    auto instance = transformManager->getInstance(entity);
+    while (instance) {
+        const mat4f& local = transformManager->getTransform(instance);
+        Entity parent = transformManager->getParent(instance);
+        if (!parent || local[0] != identity[0] || local[1] != identity[1] ||
+                local[2] != identity[2] || local[3] != identity[3]) {
+            break;
+        }
+        entity = parent;
+        instance = transformManager->getInstance(entity);
+    }
+    return entity;
+}
+
+void AnimatorImpl::prepareSkin(const Skin& skin, SkinState& state) {
+    if (state.skin != &skin) {
+        releaseSkin(state);
+        state.skin = &skin;
+    }
+    state.groupCount = 0;
+
+    const size_t njoints = skin.joints.size();
+    if (njoints == 0) {
+        return;
+    }
+    if (njoints > kMaxBoneCount) {
+        if (!state.unsupported) {
+            slog.w << "Skin has " << njoints << " joints, more than the " << kMaxBoneCount
+                    << " supported, it won't be animated." << io::endl;
+            state.unsupported = true;
+        }
+        return;
+    }
+
+    Engine* engine = asset->mEngine;
+    for (const auto& entity : skin.targets) {
+        auto renderable = renderableManager->getInstance(entity);
+        if (!renderable) {
+            continue;
+        }
+        const Entity node = getTransformNode(transformManager, entity);
+
+        // Targets are usually siblings under a common parent, so there are very few groups and a
+        // linear search is the fastest option.
+        size_t groupIndex = 0;
+        while (groupIndex < state.groupCount && state.groups[groupIndex].node != node) {
+            ++groupIndex;
+        }
+        if (groupIndex == state.groupCount) {
+            if (groupIndex == state.groups.size()) {
+                SkinningBuffer* buffer = SkinningBuffer::Builder()
+                        .boneCount(njoints)
+                        .initialize()
+                        .build(*engine);
+                state.groups.push_back({ node, buffer, {} });
+            }
+            state.groups[groupIndex].node = node;
+            ++state.groupCount;
+        }
+
+        SkinningBuffer* buffer = state.groups[groupIndex].buffer;
+        SkinningBuffer*& binding = state.bindings[entity];
+        if (binding != buffer) {
+            renderableManager->setSkinningBuffer(renderable, buffer, njoints);
+            binding = buffer;
+        }
+    }
+}
+
+void AnimatorImpl::releaseSkin(SkinState& state) {
+    for (SkeletonGroup& group : state.groups) {
+        asset->mEngine->destroy(group.buffer);
+    }
+    state.groups.clear();
+    state.bindings.clear();
+    state.groupCount = 0;
+    state.skin = nullptr;
+    state.unsupported = false;
+}
+
 void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIndex,
         size_t nextIndex) {
     const Sampler* sampler = channel.sourceData;
     const TimeValues& times = sampler->times;
-    TransformManager::Instance node = transformManager->getInstance(channel.targetEntity);
 
-    // Perform the interpolation. This is a simple but inefficient implementation; Filament
-    // stores transforms as mat4's but glTF animation is based on TRS (translation rotation
-    // scale).
-    mat4f xform = transformManager->getTransform(node);
-    float3 scale;
-    quatf rotation;
-    float3 translation;
-    decomposeMatrix(xform, &translation, &rotation, &scale);
+    // Perform the interpolation. Filament stores transforms as mat4's but glTF animation is based
+    // on TRS (translation rotation scale), so the result goes into the decomposed transform of
+    // the target, which the caller composes once all channels have been evaluated.
+    Transform* transform = channel.transformType == Channel::WEIGHTS ?
+            nullptr : &transforms[channel.targetIndex];
 
     switch (channel.transformType) {
 
@@ -397,9 +625,9 @@ void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIn
                 float3 tang0 = srcVec3[prevIndex * 3 + 2];
                 float3 tang1 = srcVec3[nextIndex * 3];
                 float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                scale = cubicSpline(vert0, tang0, vert1, tang1, t);
+                transform->scale = cubicSpline(vert0, tang0, vert1, tang1, t);
             } else {
-                scale = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
+                transform->scale = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
             }
             break;
         }
@@ -411,9 +639,9 @@ void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIn
                 float3 tang0 = srcVec3[prevIndex * 3 + 2];
                 float3 tang1 = srcVec3[nextIndex * 3];
                 float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                translation = cubicSpline(vert0, tang0, vert1, tang1, t);
+                transform->translation = cubicSpline(vert0, tang0, vert1, tang1, t);
             } else {
-                translation = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
+                transform->translation = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
             }
             break;
         }
@@ -425,9 +653,9 @@ void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIn
                 quatf tang0 = srcQuat[prevIndex * 3 + 2];
                 quatf tang1 = srcQuat[nextIndex * 3];
                 quatf vert1 = srcQuat[nextIndex * 3 + 1];
-                rotation = normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
+                transform->rotation = normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
             } else {
-                rotation = slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
+                transform->rotation = slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
             }
             break;
         }
@@ -465,9 +693,6 @@ void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIn
             return;
         }
     }
-
-    xform = composeMatrix(translation, rotation, scale);
-    transformManager->setTransform(node, xform);
 }
 
 } // namespace gltfio
@@ -20,6 +20,7 @@
 
 #include "FFilamentAsset.h"
 #include "GltfEnums.h"
+#include "MappedFile.h"
 
 #include <filament/Box.h>
 #include <filament/BufferObject.h>
@@ -58,6 +59,8 @@ using namespace filament;
 using namespace filament::math;
 using namespace utils;
 
+using BufferDescriptor = filament::backend::BufferDescriptor;
+
 namespace gltfio {
 
 void importSkins(const cgltf_data* gltf, const NodeMap& nodeMap, SkinVector& dstSkins);
@@ -99,6 +102,7 @@ struct FAssetLoader : public AssetLoader {
 
     FFilamentAsset* createAssetFromJson(const uint8_t* bytes, uint32_t nbytes);
     FFilamentAsset* createAssetFromBinary(const uint8_t* bytes, uint32_t nbytes);
+    FFilamentAsset* createAssetFromFile(const char* path);
     FFilamentAsset* createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances);
     FilamentInstance* createInstance(FFilamentAsset* primary);
@@ -196,6 +200,28 @@ FFilamentAsset* FAssetLoader::createAssetFromBinary(const uint8_t* bytes, uint32
     return mResult;
 }
 
+FFilamentAsset* FAssetLoader::createAssetFromFile(const char* path) {
+    BufferDescriptor mapping = mapFile(path);
+    if (!mapping.buffer) {
+        return nullptr;
+    }
+
+    // Let cgltf examine the magic identifier to determine whether this is JSON or GLB. For GLB
+    // files, the parsed buffer views point directly into the mapping.
+    cgltf_options options {};
+    cgltf_data* sourceAsset;
+    cgltf_result result = cgltf_parse(&options, mapping.buffer, mapping.size, &sourceAsset);
+    if (result != cgltf_result_success) {
+        slog.e << "Unable to parse " << path << io::endl;
+        return nullptr;
+    }
+    createAsset(sourceAsset, 0);
+    if (mResult) {
+        mResult->mSourceAsset->mappedFiles.push_back(std::move(mapping));
+    }
+    return mResult;
+}
+
 FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances) {
     ASSERT_PRECONDITION(numInstances > 0, "Instance count must be 1 or more.");
@@ -1214,6 +1240,10 @@ FilamentAsset* AssetLoader::createAssetFromBinary(uint8_t const* bytes, uint32_t
     return upcast(this)->createAssetFromBinary(bytes, nbytes);
 }
 
+FilamentAsset* AssetLoader::createAssetFromFile(const char* path) {
+    return upcast(this)->createAssetFromFile(path);
+}
+
 FilamentAsset* AssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances) {
     return upcast(this)->createInstancedAsset(bytes, numBytes, instances, numInstances);
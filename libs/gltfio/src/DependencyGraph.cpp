@@ -80,6 +80,29 @@ void DependencyGraph::addEdge(Texture* texture, MaterialInstance* material, cons
     mMaterialToTexture.at(material).params.at(parameter) = getStatus(texture);
 }
 
+void DependencyGraph::addEdge(Entity entity, VertexBuffer* vertices) {
+    assert(!mFinalized);
+    if (mVertexBufferToEntity[vertices].insert(entity).second) {
+        mEntityToMaterial[entity].numPendingVertexBuffers++;
+    }
+}
+
+void DependencyGraph::markAsReady(VertexBuffer* vertices) {
+    auto iter = mVertexBufferToEntity.find(vertices);
+    if (iter == mVertexBufferToEntity.end()) {
+        return;
+    }
+    for (auto entity : iter->second) {
+        auto& status = mEntityToMaterial.at(entity);
+        assert(status.numPendingVertexBuffers > 0);
+        if (--status.numPendingVertexBuffers == 0 &&
+                status.numReadyMaterials == status.materials.size()) {
+            mReadyRenderables.push(entity);
+        }
+    }
+    mVertexBufferToEntity.erase(iter);
+}
+
 void DependencyGraph::checkReadiness(Material* material) {
     auto& status = mMaterialToTexture.at(material);
 
@@ -118,7 +141,8 @@ void DependencyGraph::markAsReady(MaterialInstance* material) {
         if (status.numReadyMaterials == status.materials.size()) {
             continue;
         }
-        if (++status.numReadyMaterials == status.materials.size()) {
+        if (++status.numReadyMaterials == status.materials.size() &&
+                status.numPendingVertexBuffers == 0) {
             mReadyRenderables.push(entity);
         }
     }
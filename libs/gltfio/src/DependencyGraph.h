@@ -28,6 +28,7 @@
 namespace filament {
     class MaterialInstance;
     class Texture;
+    class VertexBuffer;
 }
 
 namespace gltfio {
@@ -56,6 +57,9 @@ namespace gltfio {
  *
  * Note that the left-most entity in the above graph has no textures, so it becomes ready as soon as
  * finalize is called.
+ *
+ * During progressive loading, entities can additionally depend on vertex buffers. Such entities do
+ * not become ready until their geometry has been uploaded, even if all of their textures are ready.
  */
 class DependencyGraph {
 public:
@@ -83,6 +87,11 @@ public:
     void addEdge(filament::Texture* texture, Material* material, const char* parameter);
     void markAsReady(filament::Texture* texture);
 
+    // These are used for progressive loading. The edge must be added before finalization, and the
+    // vertex buffer is marked as ready once all of its attributes have been uploaded.
+    void addEdge(Entity entity, filament::VertexBuffer* vertices);
+    void markAsReady(filament::VertexBuffer* vertices);
+
 private:
     struct TextureNode {
         filament::Texture* texture;
@@ -96,6 +105,7 @@ private:
     struct EntityNode {
         tsl::robin_set<Material*> materials;
         size_t numReadyMaterials = 0;
+        size_t numPendingVertexBuffers = 0;
     };
 
     void checkReadiness(Material* material);
@@ -107,6 +117,7 @@ private:
     tsl::robin_map<Material*, tsl::robin_set<Entity>> mMaterialToEntity;
     tsl::robin_map<Material*, MaterialNode> mMaterialToTexture;
     tsl::robin_map<filament::Texture*, tsl::robin_set<Material*>> mTextureToMaterial;
+    tsl::robin_map<filament::VertexBuffer*, tsl::robin_set<Entity>> mVertexBufferToEntity;
 
     // Each texture (and its readiness flag) can be referenced from multiple nodes, so we own
     // a collection of wrapper objects in the following map. This uses std::unique_ptr to allow
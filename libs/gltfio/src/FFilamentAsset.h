@@ -251,10 +251,29 @@ struct FFilamentAsset : public FilamentAsset {
     // Encapsulates reference-counted source data, which includes the cgltf hierachy
     // and potentially also includes buffer data that can be uploaded to the GPU.
     struct SourceAsset {
-        ~SourceAsset() { cgltf_free(hierarchy); }
+        ~SourceAsset() {
+            // Buffers that point into a file mapping must not be freed by cgltf, the mapping is
+            // released when the corresponding BufferDescriptor is destroyed.
+            for (cgltf_size i = 0; hierarchy && i < hierarchy->buffers_count; ++i) {
+                if (isMapped(hierarchy->buffers[i].data)) {
+                    hierarchy->buffers[i].data = nullptr;
+                }
+            }
+            cgltf_free(hierarchy);
+        }
+        bool isMapped(const void* data) const {
+            for (const auto& mapping : mappedFiles) {
+                const uint8_t* begin = (const uint8_t*) mapping.buffer;
+                if (data >= begin && data < begin + mapping.size) {
+                    return true;
+                }
+            }
+            return false;
+        }
         cgltf_data* hierarchy;
         DracoCache dracoCache;
         std::vector<uint8_t> glbData;
+        std::vector<filament::backend::BufferDescriptor> mappedFiles;
     };
 
     // We used shared ownership for the raw cgltf data in order to permit ResourceLoader to
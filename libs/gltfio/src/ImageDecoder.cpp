@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gltfio/ImageDecoder.h>
+#include <gltfio/Image.h>
+
+#include <image/KtxBundle.h>
+#include <image/KtxUtility.h>
+
+#include <utils/Log.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+using namespace filament;
+using namespace utils;
+
+using image::KtxBundle;
+
+namespace gltfio {
+
+size_t ImageDecoder::getLevelSize(const uint8_t*, size_t, const Info& info,
+        uint32_t level) const {
+    const size_t width = std::max(info.width >> level, 1u);
+    const size_t height = std::max(info.height >> level, 1u);
+    return width * height * info.channels;
+}
+
+namespace {
+
+class StbDecoder : public ImageDecoder {
+public:
+    bool getInfo(const uint8_t* data, size_t size, Info* info) const override {
+        int width, height, channels;
+        if (!stbi_info_from_memory(data, size, &width, &height, &channels)) {
+            return false;
+        }
+        info->width = width;
+        info->height = height;
+        info->channels = channels;
+        return true;
+    }
+
+    // stb decodes whole images to a buffer of its own, so the rows are always copied once.
+    bool decode(const uint8_t* data, size_t size, const Info& info, uint32_t level,
+            uint32_t firstRow, uint32_t rowCount, uint8_t* out) const override {
+        int width, height, channels;
+        stbi_uc* texels = stbi_load_from_memory(data, size, &width, &height, &channels,
+                info.channels);
+        if (!texels) {
+            slog.e << "Unable to decode image: " << stbi_failure_reason() << io::endl;
+            return false;
+        }
+        memcpy(out, texels, getLevelSize(data, size, info, 0));
+        stbi_image_free(texels);
+        return true;
+    }
+};
+
+// The 12-byte identifier that starts every KTX 1.1 file.
+static const uint8_t KTX_MAGIC[] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+// KTX headers are 12 bytes of identifier followed by 13 32-bit fields.
+static constexpr size_t KTX_HEADER_SIZE = sizeof(KTX_MAGIC) + 13 * sizeof(uint32_t);
+
+class KtxDecoder : public ImageDecoder {
+public:
+    // Every image whose MIME type has no decoder is probed with this decoder, so images that
+    // aren't KTX are rejected quietly, before the bundle is parsed.
+    bool getInfo(const uint8_t* data, size_t size, Info* info) const override {
+        if (size < KTX_HEADER_SIZE || memcmp(data, KTX_MAGIC, sizeof(KTX_MAGIC)) != 0) {
+            return false;
+        }
+        KtxBundle ktx(data, uint32_t(size), KtxBundle::Storage::VIEW);
+        if (!image::ktx::isCompressed(ktx.getInfo()) || ktx.isCubemap() ||
+                ktx.getArrayLength() > 1) {
+            slog.w << "Only compressed 2D KTX images are supported." << io::endl;
+            return false;
+        }
+        info->width = ktx.getInfo().pixelWidth;
+        info->height = ktx.getInfo().pixelHeight;
+        info->levels = ktx.getNumMipLevels();
+        info->compressed = true;
+        info->format = image::ktx::toTextureFormat(ktx.getInfo());
+        info->compressedType = image::ktx::toCompressedPixelDataType(ktx.getInfo());
+        return true;
+    }
+
+    size_t getLevelSize(const uint8_t* data, size_t size, const Info& info,
+            uint32_t level) const override {
+        KtxBundle ktx(data, uint32_t(size), KtxBundle::Storage::VIEW);
+        uint8_t* blob;
+        uint32_t blobSize;
+        return ktx.getBlob({ level, 0, 0 }, &blob, &blobSize) ? blobSize : 0;
+    }
+
+    // The bundle is a view over the file, so the blocks are copied only once, into the buffer
+    // that's uploaded.
+    bool decode(const uint8_t* data, size_t size, const Info& info, uint32_t level,
+            uint32_t firstRow, uint32_t rowCount, uint8_t* out) const override {
+        KtxBundle ktx(data, uint32_t(size), KtxBundle::Storage::VIEW);
+        uint8_t* blob;
+        uint32_t blobSize;
+        if (!ktx.getBlob({ level, 0, 0 }, &blob, &blobSize)) {
+            return false;
+        }
+        memcpy(out, blob, blobSize);
+        return true;
+    }
+};
+
+} // anonymous namespace
+
+ImageDecoder* createStbDecoder() {
+    return new StbDecoder();
+}
+
+ImageDecoder* createKtxDecoder() {
+    return new KtxDecoder();
+}
+
+} // namespace gltfio
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MappedFile.h"
+
+#include <utils/Log.h>
+
+#if defined(__EMSCRIPTEN__) || defined(ANDROID) || defined(IOS)
+#define USE_FILESYSTEM 0
+#else
+#define USE_FILESYSTEM 1
+#endif
+
+#if USE_FILESYSTEM
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
+
+using namespace utils;
+
+using BufferDescriptor = filament::backend::BufferDescriptor;
+
+namespace gltfio {
+
+#if USE_FILESYSTEM && defined(WIN32)
+
+static void unmapCallback(void* buffer, size_t, void*) {
+    UnmapViewOfFile(buffer);
+}
+
+BufferDescriptor mapFile(const char* path) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        slog.e << "Unable to open " << path << io::endl;
+        return {};
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return {};
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        slog.e << "Unable to map " << path << io::endl;
+        return {};
+    }
+    // The view keeps the underlying mapping object alive, so the handle can be closed right away.
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        slog.e << "Unable to map " << path << io::endl;
+        return {};
+    }
+    return BufferDescriptor(data, size_t(size.QuadPart), unmapCallback);
+}
+
+#elif USE_FILESYSTEM
+
+static void unmapCallback(void* buffer, size_t size, void*) {
+    munmap(buffer, size);
+}
+
+BufferDescriptor mapFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        slog.e << "Unable to open " << path << io::endl;
+        return {};
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return {};
+    }
+    const size_t size = size_t(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    // The mapping holds its own reference to the file, so the descriptor can be closed right away.
+    close(fd);
+    if (data == MAP_FAILED) {
+        slog.e << "Unable to map " << path << io::endl;
+        return {};
+    }
+#if defined(MADV_WILLNEED)
+    madvise(data, size, MADV_WILLNEED);
+#endif
+    return BufferDescriptor(data, size, unmapCallback);
+}
+
+#else
+
+BufferDescriptor mapFile(const char* path) {
+    slog.e << "Memory-mapped files are not supported on this platform." << io::endl;
+    return {};
+}
+
+#endif
+
+} // namespace gltfio
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_MAPPEDFILE_H
+#define GLTFIO_MAPPEDFILE_H
+
+#include <backend/BufferDescriptor.h>
+
+#include <stddef.h>
+
+namespace gltfio {
+
+// Maps the contents of the given file into memory and wraps the mapping in a BufferDescriptor
+// whose release callback unmaps it. Returns an empty descriptor on failure, or on platforms that
+// do not have a file system.
+//
+// Pages are mapped copy-on-write so that the loader can patch data in place (e.g. when normalizing
+// skinning weights) without touching the file on disk. Only pages that are actually written to
+// are ever duplicated in RAM.
+filament::backend::BufferDescriptor mapFile(const char* path);
+
+} // namespace gltfio
+
+#endif // GLTFIO_MAPPEDFILE_H
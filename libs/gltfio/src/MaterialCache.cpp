@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaterialCache.h"
+
+#include <utils/CacheFile.h>
+#include <utils/Log.h>
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#if defined(WIN32)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include <algorithm>
+
+using namespace utils;
+
+namespace gltfio {
+
+static constexpr uint32_t CACHE_MAGIC = 0x31434d47; // "GMC1"
+
+static bool getFileInfo(const Path& path, size_t* size, int64_t* lastUsed) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    *size = size_t(st.st_size);
+    *lastUsed = int64_t(st.st_mtime);
+    return true;
+}
+
+static void touchFile(const Path& path) {
+    // Passing null sets both the access and modification times to the current time.
+    utime(path.c_str(), nullptr);
+}
+
+MaterialCache::MaterialCache(const char* directory, size_t maxSizeInBytes) :
+        mDirectory(directory), mMaxSize(maxSizeInBytes) {
+    mEnabled = mDirectory.mkdirRecursive();
+    if (!mEnabled) {
+        slog.w << "Unable to create material cache in " << mDirectory.c_str() << io::endl;
+    }
+}
+
+Path MaterialCache::getPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.filamat", (unsigned long long) key);
+    return mDirectory + name;
+}
+
+bool MaterialCache::load(uint64_t key, std::vector<uint8_t>* package) {
+    if (!mEnabled) {
+        return false;
+    }
+    Path path = getPath(key);
+    if (!path.exists()) {
+        return false;
+    }
+    if (!CacheFile::read(path, CACHE_MAGIC, key, package)) {
+        slog.w << "Discarding invalid material cache entry " << path.c_str() << io::endl;
+        remove(path);
+        return false;
+    }
+
+    touchFile(path);
+    for (Entry& entry : mEntries) {
+        if (entry.path == path) {
+            entry.lastUsed = int64_t(time(nullptr));
+            break;
+        }
+    }
+    return true;
+}
+
+void MaterialCache::store(uint64_t key, const uint8_t* package, size_t size) {
+    if (!mEnabled || size == 0 || size + CacheFile::HEADER_SIZE > mMaxSize) {
+        return;
+    }
+
+    Path path = getPath(key);
+    remove(path);
+    evict(size + CacheFile::HEADER_SIZE);
+
+    if (!CacheFile::write(path, CACHE_MAGIC, key, package, size)) {
+        slog.w << "Unable to write material cache entry " << path.c_str() << io::endl;
+        return;
+    }
+    mEntries.push_back({ path, size + CacheFile::HEADER_SIZE, int64_t(time(nullptr)) });
+    mTotalSize += size + CacheFile::HEADER_SIZE;
+}
+
+void MaterialCache::scan() {
+    mScanned = true;
+    for (const Path& path : mDirectory.listContents()) {
+        if (path.getExtension() != "filamat") {
+            continue;
+        }
+        Entry entry { path };
+        if (getFileInfo(path, &entry.size, &entry.lastUsed)) {
+            mTotalSize += entry.size;
+            mEntries.push_back(entry);
+        }
+    }
+}
+
+void MaterialCache::remove(Path path) {
+    if (!mScanned) {
+        scan();
+    }
+    auto iter = std::find_if(mEntries.begin(), mEntries.end(), [&path](const Entry& entry) {
+        return entry.path == path;
+    });
+    if (iter != mEntries.end()) {
+        mTotalSize -= iter->size;
+        mEntries.erase(iter);
+    }
+    path.unlinkFile();
+}
+
+void MaterialCache::evict(size_t incomingSize) {
+    if (!mScanned) {
+        scan();
+    }
+    if (mTotalSize + incomingSize <= mMaxSize) {
+        return;
+    }
+
+    // Evict the least recently used entries until the new package fits. Files that another
+    // process already deleted are dropped from the list all the same.
+    std::sort(mEntries.begin(), mEntries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    auto iter = mEntries.begin();
+    for (; iter != mEntries.end() && mTotalSize + incomingSize > mMaxSize; ++iter) {
+        iter->path.unlinkFile();
+        mTotalSize -= iter->size;
+    }
+    mEntries.erase(mEntries.begin(), iter);
+}
+
+} // namespace gltfio
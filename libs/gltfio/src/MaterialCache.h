@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_MATERIALCACHE_H
+#define GLTFIO_MATERIALCACHE_H
+
+#include <utils/Path.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace gltfio {
+
+// Persistent store for compiled material packages, used by MaterialGenerator to avoid recompiling
+// the same shaders every time the process starts.
+//
+// Each package is stored in its own file, named after a 64-bit key that the caller derives from
+// everything that affects the compiled output. Files start with a small header that repeats the
+// key and holds a checksum of the payload, so that truncated or stale files are detected and
+// discarded rather than handed to the engine.
+//
+// The total size of the cache is bounded. When a store would exceed the budget, the least
+// recently used files are deleted first. Recency is tracked through file modification times,
+// which are refreshed on every hit, so the policy survives across runs. The directory is scanned
+// once, on the first store, after which the size of the cache is tracked incrementally. Files
+// added by other processes sharing the directory are therefore only accounted for at the next
+// run.
+class MaterialCache {
+public:
+    MaterialCache(const char* directory, size_t maxSizeInBytes);
+
+    // Reads the package for the given key, returns false if it is missing or invalid.
+    bool load(uint64_t key, std::vector<uint8_t>* package);
+
+    // Writes the package for the given key, evicting older entries if necessary.
+    void store(uint64_t key, const uint8_t* package, size_t size);
+
+private:
+    struct Entry {
+        utils::Path path;
+        size_t size;
+        int64_t lastUsed;
+    };
+
+    utils::Path getPath(uint64_t key) const;
+    void scan();
+    void evict(size_t incomingSize);
+    void remove(utils::Path path);
+
+    const utils::Path mDirectory;
+    const size_t mMaxSize;
+    bool mEnabled = false;
+    bool mScanned = false;
+    std::vector<Entry> mEntries;
+    size_t mTotalSize = 0;
+};
+
+} // namespace gltfio
+
+#endif // GLTFIO_MATERIALCACHE_H
@@ -16,12 +16,18 @@
 
 #include <gltfio/MaterialProvider.h>
 
+#include "MaterialCache.h"
+
 #include <filamat/MaterialBuilder.h>
 
+#include <filament/MaterialEnums.h>
+
 #include <utils/Hash.h>
+#include <utils/Systrace.h>
 
 #include <tsl/robin_map.h>
 
+#include <memory>
 #include <string>
 
 using namespace filamat;
@@ -33,7 +39,8 @@ namespace {
 
 class MaterialGenerator : public MaterialProvider {
 public:
-    explicit MaterialGenerator(filament::Engine* engine, bool optimizeShaders);
+    MaterialGenerator(filament::Engine* engine, bool optimizeShaders,
+            const MaterialCacheConfig* cacheConfig);
     ~MaterialGenerator() override;
 
     MaterialSource getSource() const noexcept override { return GENERATE_SHADERS; }
@@ -50,11 +57,17 @@ public:
     std::vector<filament::Material*> mMaterials;
     filament::Engine* const mEngine;
     const bool mOptimizeShaders;
+    std::unique_ptr<MaterialCache> mDiskCache;
 };
 
-MaterialGenerator::MaterialGenerator(Engine* engine, bool optimizeShaders) : mEngine(engine),
+MaterialGenerator::MaterialGenerator(Engine* engine, bool optimizeShaders,
+        const MaterialCacheConfig* cacheConfig) : mEngine(engine),
         mOptimizeShaders(optimizeShaders) {
     MaterialBuilder::init();
+    if (cacheConfig && cacheConfig->directory) {
+        mDiskCache = std::make_unique<MaterialCache>(cacheConfig->directory,
+                cacheConfig->maxSizeInBytes);
+    }
 }
 
 MaterialGenerator::~MaterialGenerator() {
@@ -286,10 +299,73 @@ std::string shaderFromKey(const MaterialKey& config) {
     return shader;
 }
 
-static Material* createMaterial(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
-        const char* name, bool optimizeShaders) {
-    std::string shader = shaderFromKey(config);
-    processShaderString(&shader, uvmap, config);
+// Bump this whenever the material generator changes in a way that is not reflected in the
+// generated shader source, e.g. when adding a material property or parameter.
+static constexpr uint32_t CACHE_VERSION = 1;
+
+static void appendString(std::vector<uint32_t>& words, const char* str, size_t size) {
+    words.push_back(uint32_t(size));
+    const size_t offset = words.size();
+    words.resize(offset + (size + 3) / 4, 0);
+    memcpy(words.data() + offset, str, size);
+}
+
+// Computes a key that identifies the compiled output of createPackage. Unlike the in-memory cache
+// key, this must be stable across runs and builds, so it includes everything that influences the
+// contents of the package. The fields of MaterialKey are hashed one by one because its bitfields
+// leave bits whose value is unspecified.
+static uint64_t computeCacheKey(const MaterialKey& config, const UvMap& uvmap, const char* label,
+        const std::string& shader, MaterialBuilder::TargetApi targetApi, bool optimizeShaders) {
+    std::vector<uint32_t> words = {
+        CACHE_VERSION,
+        uint32_t(filament::MATERIAL_VERSION),
+        uint32_t(targetApi),
+        optimizeShaders,
+        config.doubleSided,
+        config.unlit,
+        config.hasVertexColors,
+        config.hasBaseColorTexture,
+        config.hasNormalTexture,
+        config.hasOcclusionTexture,
+        config.hasEmissiveTexture,
+        config.useSpecularGlossiness,
+        uint32_t(config.alphaMode),
+        config.enableDiagnostics,
+        config.hasMetallicRoughnessTexture,
+        config.metallicRoughnessUV,
+        config.baseColorUV,
+        config.hasClearCoatTexture,
+        config.clearCoatUV,
+        config.hasClearCoatRoughnessTexture,
+        config.clearCoatRoughnessUV,
+        config.hasClearCoatNormalTexture,
+        config.clearCoatNormalUV,
+        config.hasClearCoat,
+        config.hasTransmission,
+        config.hasTextureTransforms,
+        config.emissiveUV,
+        config.aoUV,
+        config.normalUV,
+        config.hasTransmissionTexture,
+        config.transmissionUV,
+        config.hasSheenColorTexture,
+        config.sheenColorUV,
+        config.hasSheenRoughnessTexture,
+        config.sheenRoughnessUV,
+        config.hasSheen,
+    };
+    for (UvSet uvset : uvmap) {
+        words.push_back(uvset);
+    }
+    // The label is the name of the material, which is stored in the package.
+    appendString(words, label ? label : "", label ? strlen(label) : 0);
+    appendString(words, shader.data(), shader.size());
+
+    return hash::murmur3_64(words.data(), words.size() * sizeof(uint32_t));
+}
+
+static Package createPackage(Engine* engine, const MaterialKey& config, const UvMap& uvmap,
+        const char* name, bool optimizeShaders, const std::string& shader) {
     MaterialBuilder builder = MaterialBuilder()
             .name(name)
             .flipUV(false)
@@ -468,8 +544,7 @@ static Material* createMaterial(Engine* engine, const MaterialKey& config, const
         builder.shading(Shading::LIT);
     }
 
-    Package pkg = builder.build(engine->getJobSystem());
-    return Material::Builder().package(pkg.getData(), pkg.getSize()).build(*engine);
+    return builder.build(engine->getJobSystem());
 }
 
 MaterialInstance* MaterialGenerator::createMaterialInstance(MaterialKey* config, UvMap* uvmap,
@@ -483,7 +558,31 @@ MaterialInstance* MaterialGenerator::createMaterialInstance(MaterialKey* config,
         optimizeShaders = false;
 #endif
 
-        Material* mat = createMaterial(mEngine, *config, *uvmap, label, optimizeShaders);
+        std::string shader = shaderFromKey(*config);
+        processShaderString(&shader, *uvmap, *config);
+
+        Material* mat = nullptr;
+        if (mDiskCache) {
+            SYSTRACE_NAME("MaterialGenerator::loadCachedMaterial");
+            const uint64_t key = computeCacheKey(*config, *uvmap, label, shader,
+                    filamat::targetApiFromBackend(mEngine->getBackend()), optimizeShaders);
+            std::vector<uint8_t> package;
+            if (mDiskCache->load(key, &package)) {
+                mat = Material::Builder().package(package.data(), package.size()).build(*mEngine);
+            }
+            if (!mat) {
+                Package pkg = createPackage(mEngine, *config, *uvmap, label, optimizeShaders,
+                        shader);
+                if (pkg.isValid()) {
+                    mDiskCache->store(key, pkg.getData(), pkg.getSize());
+                }
+                mat = Material::Builder().package(pkg.getData(), pkg.getSize()).build(*mEngine);
+            }
+        } else {
+            Package pkg = createPackage(mEngine, *config, *uvmap, label, optimizeShaders, shader);
+            mat = Material::Builder().package(pkg.getData(), pkg.getSize()).build(*mEngine);
+        }
+
         mCache.emplace(std::make_pair(*config, mat));
         mMaterials.push_back(mat);
         return mat->createInstance(label);
@@ -496,7 +595,12 @@ MaterialInstance* MaterialGenerator::createMaterialInstance(MaterialKey* config,
 namespace gltfio {
 
 MaterialProvider* createMaterialGenerator(filament::Engine* engine, bool optimizeShaders) {
-    return new MaterialGenerator(engine, optimizeShaders);
+    return new MaterialGenerator(engine, optimizeShaders, nullptr);
+}
+
+MaterialProvider* createMaterialGenerator(filament::Engine* engine, bool optimizeShaders,
+        const MaterialCacheConfig& cacheConfig) {
+    return new MaterialGenerator(engine, optimizeShaders, &cacheConfig);
 }
 
 } // namespace gltfio
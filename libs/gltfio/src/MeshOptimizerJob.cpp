@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshOptimizerJob.h"
+
+#include <meshoptimizer.h>
+
+#include <tsl/robin_map.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace gltfio;
+
+// Size of the simulated post-transform cache used for reporting statistics. This matches the
+// defaults in meshoptimizer and is representative of most mobile and desktop GPUs.
+static constexpr unsigned int kCacheSize = 16;
+
+// Overdraw optimization is allowed to make the vertex cache efficiency this much worse.
+static constexpr float kOverdrawThreshold = 1.05f;
+
+static size_t getComponentSize(cgltf_component_type type) {
+    switch (type) {
+        case cgltf_component_type_r_8:
+        case cgltf_component_type_r_8u:
+            return 1;
+        case cgltf_component_type_r_16:
+        case cgltf_component_type_r_16u:
+            return 2;
+        case cgltf_component_type_r_32u:
+        case cgltf_component_type_r_32f:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint8_t* getAccessorData(const cgltf_accessor* accessor) {
+    return (uint8_t*) accessor->buffer_view->buffer->data + accessor->buffer_view->offset +
+            accessor->offset;
+}
+
+static bool isAccessorSupported(const cgltf_accessor* accessor, cgltf_size vertexCount) {
+    return accessor && !accessor->is_sparse && accessor->buffer_view &&
+            accessor->buffer_view->buffer->data && accessor->count == vertexCount;
+}
+
+// Moves each element of the accessor to the location given by the remap table. Vertices that are
+// not referenced by any triangle are mapped to ~0 and are left behind at the end of the array.
+static void remapAccessor(const cgltf_accessor* accessor, const std::vector<unsigned int>& remap) {
+    const size_t elementSize = cgltf_num_components(accessor->type) *
+            getComponentSize(accessor->component_type);
+    uint8_t* data = getAccessorData(accessor);
+    std::vector<uint8_t> original(accessor->count * elementSize);
+    for (cgltf_size i = 0; i < accessor->count; ++i) {
+        memcpy(original.data() + i * elementSize, data + i * accessor->stride, elementSize);
+    }
+    for (cgltf_size i = 0; i < accessor->count; ++i) {
+        if (remap[i] != ~0u) {
+            memcpy(data + remap[i] * accessor->stride, original.data() + i * elementSize,
+                    elementSize);
+        }
+    }
+}
+
+// The bytes of a buffer that are read by an accessor, or that are used by something else when
+// accessor is null. Accessors read elementSize bytes every stride bytes, anything else is
+// contiguous and has a null stride.
+struct ByteRange {
+    const cgltf_buffer* buffer;
+    cgltf_size begin;
+    cgltf_size end;
+    cgltf_size stride;
+    cgltf_size elementSize;
+    const cgltf_accessor* accessor;
+};
+
+static ByteRange getByteRange(const cgltf_buffer_view* view) {
+    return { view->buffer, view->offset, view->offset + view->size, 0, view->size, nullptr };
+}
+
+static ByteRange getByteRange(const cgltf_accessor* accessor) {
+    const size_t elementSize = cgltf_num_components(accessor->type) *
+            getComponentSize(accessor->component_type);
+    const cgltf_size begin = accessor->buffer_view->offset + accessor->offset;
+    const cgltf_size size = accessor->count ? (accessor->count - 1) * accessor->stride +
+            elementSize : 0;
+    return { accessor->buffer_view->buffer, begin, begin + size, accessor->stride, elementSize,
+            accessor };
+}
+
+// Returns true if two ranges of the same buffer share at least one byte. Interleaved attributes
+// have overlapping spans, but as long as their elements don't overlap within a stride, moving the
+// elements of one of them leaves the other intact.
+static bool overlaps(const ByteRange& a, const ByteRange& b) {
+    if (a.begin >= b.end || b.begin >= a.end) {
+        return false;
+    }
+    const cgltf_size stride = a.stride;
+    if (stride == 0 || b.stride != stride || a.elementSize > stride || b.elementSize > stride) {
+        return true;
+    }
+    // Two arcs of a circle intersect when one of them starts within the other.
+    auto contains = [stride](cgltf_size first, cgltf_size size, cgltf_size offset) {
+        return (offset + stride - first) % stride < size;
+    };
+    const cgltf_size firstA = a.begin % stride;
+    const cgltf_size firstB = b.begin % stride;
+    return contains(firstA, a.elementSize, firstB) || contains(firstB, b.elementSize, firstA);
+}
+
+tsl::robin_set<const cgltf_accessor*> MeshOptimizerJob::findExclusiveAccessors(
+        const cgltf_data& gltf) {
+    // Count the number of primitives that reference each accessor. The same goes for animation
+    // and skinning data, which are not expected to alias vertex attributes but are allowed to by
+    // the spec.
+    tsl::robin_map<const cgltf_accessor*, int> refs;
+    for (cgltf_size mindex = 0; mindex < gltf.meshes_count; ++mindex) {
+        const cgltf_mesh& mesh = gltf.meshes[mindex];
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            const cgltf_primitive& prim = mesh.primitives[pindex];
+            tsl::robin_set<const cgltf_accessor*> accessors;
+            accessors.insert(prim.indices);
+            for (cgltf_size aindex = 0; aindex < prim.attributes_count; ++aindex) {
+                accessors.insert(prim.attributes[aindex].data);
+            }
+            for (cgltf_size tindex = 0; tindex < prim.targets_count; ++tindex) {
+                const cgltf_morph_target& target = prim.targets[tindex];
+                for (cgltf_size aindex = 0; aindex < target.attributes_count; ++aindex) {
+                    accessors.insert(target.attributes[aindex].data);
+                }
+            }
+            for (const cgltf_accessor* accessor : accessors) {
+                refs[accessor]++;
+            }
+        }
+    }
+    for (cgltf_size sindex = 0; sindex < gltf.skins_count; ++sindex) {
+        refs[gltf.skins[sindex].inverse_bind_matrices]++;
+    }
+    for (cgltf_size aindex = 0; aindex < gltf.animations_count; ++aindex) {
+        const cgltf_animation& anim = gltf.animations[aindex];
+        for (cgltf_size sindex = 0; sindex < anim.samplers_count; ++sindex) {
+            refs[anim.samplers[sindex].input]++;
+            refs[anim.samplers[sindex].output]++;
+        }
+    }
+
+    // Distinct accessors may read the same bytes, so gather the byte ranges of everything that
+    // lives in a buffer: all accessors (including sparse data), images and Draco meshes.
+    std::vector<ByteRange> ranges;
+    for (cgltf_size aindex = 0; aindex < gltf.accessors_count; ++aindex) {
+        const cgltf_accessor* accessor = &gltf.accessors[aindex];
+        if (accessor->buffer_view) {
+            ranges.push_back(getByteRange(accessor));
+        }
+        if (accessor->is_sparse) {
+            ranges.push_back(getByteRange(accessor->sparse.indices_buffer_view));
+            ranges.push_back(getByteRange(accessor->sparse.values_buffer_view));
+        }
+    }
+    for (cgltf_size iindex = 0; iindex < gltf.images_count; ++iindex) {
+        if (gltf.images[iindex].buffer_view) {
+            ranges.push_back(getByteRange(gltf.images[iindex].buffer_view));
+        }
+    }
+    for (cgltf_size mindex = 0; mindex < gltf.meshes_count; ++mindex) {
+        const cgltf_mesh& mesh = gltf.meshes[mindex];
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            const cgltf_primitive& prim = mesh.primitives[pindex];
+            if (prim.has_draco_mesh_compression && prim.draco_mesh_compression.buffer_view) {
+                ranges.push_back(getByteRange(prim.draco_mesh_compression.buffer_view));
+            }
+        }
+    }
+
+    // Sweep the ranges of each buffer in order, comparing each of them with the preceding ranges
+    // that it might overlap.
+    std::sort(ranges.begin(), ranges.end(), [](const ByteRange& a, const ByteRange& b) {
+        return a.buffer != b.buffer ? a.buffer < b.buffer : a.begin < b.begin;
+    });
+    tsl::robin_set<const cgltf_accessor*> aliased;
+    std::vector<const ByteRange*> active;
+    for (const ByteRange& range : ranges) {
+        active.erase(std::remove_if(active.begin(), active.end(), [&range](const ByteRange* r) {
+            return r->buffer != range.buffer || r->end <= range.begin;
+        }), active.end());
+        for (const ByteRange* other : active) {
+            if (overlaps(*other, range)) {
+                aliased.insert(other->accessor);
+                aliased.insert(range.accessor);
+            }
+        }
+        active.push_back(&range);
+    }
+
+    tsl::robin_set<const cgltf_accessor*> exclusive;
+    for (const auto& pair : refs) {
+        if (pair.first && pair.second == 1 && aliased.find(pair.first) == aliased.end()) {
+            exclusive.insert(pair.first);
+        }
+    }
+    return exclusive;
+}
+
+bool MeshOptimizerJob::isSupported(const cgltf_primitive& prim) {
+    if (prim.type != cgltf_primitive_type_triangles || prim.has_draco_mesh_compression ||
+            prim.attributes_count == 0 || !prim.indices || prim.indices->count % 3 != 0) {
+        return false;
+    }
+    const cgltf_size vertexCount = prim.attributes[0].data->count;
+    if (vertexCount == 0 || prim.indices->is_sparse || !prim.indices->buffer_view ||
+            !prim.indices->buffer_view->buffer->data) {
+        return false;
+    }
+    for (cgltf_size i = 0; i < prim.attributes_count; ++i) {
+        if (!isAccessorSupported(prim.attributes[i].data, vertexCount)) {
+            return false;
+        }
+    }
+    for (cgltf_size t = 0; t < prim.targets_count; ++t) {
+        const cgltf_morph_target& target = prim.targets[t];
+        for (cgltf_size i = 0; i < target.attributes_count; ++i) {
+            if (!isAccessorSupported(target.attributes[i].data, vertexCount)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// This procedure is designed to run in an isolated job.
+void MeshOptimizerJob::run(Params* params) {
+    cgltf_primitive& prim = *params->in.prim;
+    params->out = {};
+
+    cgltf_accessor* indicesAccessor = prim.indices;
+    const cgltf_size indexCount = indicesAccessor->count;
+    const cgltf_size vertexCount = prim.attributes[0].data->count;
+
+    // Unpack the indices into 32-bit integers and validate them, since meshoptimizer asserts that
+    // they are in range.
+    std::vector<unsigned int> indices(indexCount);
+    for (cgltf_size i = 0; i < indexCount; ++i) {
+        indices[i] = (unsigned int) cgltf_accessor_read_index(indicesAccessor, i);
+        if (indices[i] >= vertexCount) {
+            return;
+        }
+    }
+
+    params->out.acmrBefore = meshopt_analyzeVertexCache(indices.data(), indexCount, vertexCount,
+            kCacheSize, 0, 0).acmr;
+
+    meshopt_optimizeVertexCache(indices.data(), indices.data(), indexCount, vertexCount);
+
+    // Overdraw optimization requires floating point positions, which is always the case unless
+    // the asset uses KHR_mesh_quantization.
+    for (cgltf_size i = 0; i < prim.attributes_count; ++i) {
+        const cgltf_accessor* positions = prim.attributes[i].data;
+        if (prim.attributes[i].type == cgltf_attribute_type_position &&
+                positions->type == cgltf_type_vec3 &&
+                positions->component_type == cgltf_component_type_r_32f &&
+                positions->stride <= 256 && positions->stride % sizeof(float) == 0) {
+            meshopt_optimizeOverdraw(indices.data(), indices.data(), indexCount,
+                    (const float*) getAccessorData(positions), vertexCount, positions->stride,
+                    kOverdrawThreshold);
+            break;
+        }
+    }
+
+    params->out.acmrAfter = meshopt_analyzeVertexCache(indices.data(), indexCount, vertexCount,
+            kCacheSize, 0, 0).acmr;
+
+    // Reorder the vertices so that they appear in the order in which they are first referenced.
+    // Every attribute (including morph targets) must be moved using the same remap table.
+    if (params->in.remapVertices) {
+        std::vector<unsigned int> remap(vertexCount);
+        meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indexCount, vertexCount);
+        meshopt_remapIndexBuffer(indices.data(), indices.data(), indexCount, remap.data());
+
+        // The same accessor may legally appear more than once (e.g. TEXCOORD_0 and TEXCOORD_1),
+        // but it must be moved only once.
+        std::vector<const cgltf_accessor*> remapped;
+        auto remapOnce = [&remapped, &remap](const cgltf_accessor* accessor) {
+            if (std::find(remapped.begin(), remapped.end(), accessor) == remapped.end()) {
+                remapAccessor(accessor, remap);
+                remapped.push_back(accessor);
+            }
+        };
+        for (cgltf_size i = 0; i < prim.attributes_count; ++i) {
+            remapOnce(prim.attributes[i].data);
+        }
+        for (cgltf_size t = 0; t < prim.targets_count; ++t) {
+            const cgltf_morph_target& target = prim.targets[t];
+            for (cgltf_size i = 0; i < target.attributes_count; ++i) {
+                remapOnce(target.attributes[i].data);
+            }
+        }
+    }
+
+    // 32-bit indices can be narrowed in place when the primitive has few enough vertices. The
+    // accessor is patched accordingly so that the rest of the loader sees a 16-bit index buffer.
+    if (params->in.compactIndices && vertexCount <= 65536 &&
+            indicesAccessor->component_type == cgltf_component_type_r_32u) {
+        indicesAccessor->component_type = cgltf_component_type_r_16u;
+        indicesAccessor->stride = sizeof(uint16_t);
+        params->out.compacted = true;
+    }
+
+    // Write the indices back using the (possibly updated) component type.
+    uint8_t* dst = getAccessorData(indicesAccessor);
+    for (cgltf_size i = 0; i < indexCount; ++i, dst += indicesAccessor->stride) {
+        switch (indicesAccessor->component_type) {
+            case cgltf_component_type_r_8u:
+                *dst = uint8_t(indices[i]);
+                break;
+            case cgltf_component_type_r_16u:
+                *(uint16_t*) dst = uint16_t(indices[i]);
+                break;
+            default:
+                *(uint32_t*) dst = uint32_t(indices[i]);
+                break;
+        }
+    }
+    params->out.optimized = true;
+}
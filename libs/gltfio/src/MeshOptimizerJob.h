@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_MESHOPTIMIZERJOB_H
+#define GLTFIO_MESHOPTIMIZERJOB_H
+
+#include <cgltf.h>
+
+#include <tsl/robin_set.h>
+
+namespace gltfio {
+
+/**
+ * Internal helper that reorders the triangles and vertices of a cgltf primitive for better GPU
+ * cache utilization. The source buffers are modified in place, before they are uploaded. This has
+ * been designed to be run as a JobSystem job, but clients are not required to do so.
+ */
+struct MeshOptimizerJob {
+
+    // The inputs to the procedure. The client is responsible for ensuring that the index accessor
+    // is exclusive, and if remapVertices is enabled, that the vertex attributes are exclusive too.
+    // See findExclusiveAccessors.
+    struct InputParams {
+        cgltf_primitive* prim;
+        bool remapVertices;
+        bool compactIndices;
+    };
+
+    // The outputs of the procedure. The ACMR (average cache miss ratio) is the number of vertex
+    // shader invocations per triangle for a simulated post-transform cache, lower is better.
+    struct OutputParams {
+        float acmrBefore;
+        float acmrAfter;
+        bool optimized;
+        bool compacted;
+    };
+
+    // Clients might want to track the jobs in an array, so the arguments are bundled into a struct.
+    struct Params {
+        InputParams in;
+        OutputParams out;
+    };
+
+    // Returns true if the given primitive is something that the procedure knows how to handle,
+    // i.e. an indexed triangle list without Draco compression or sparse accessors.
+    static bool isSupported(const cgltf_primitive& prim);
+
+    // Returns the accessors whose data may be rewritten in place: those referenced by a single
+    // primitive, skin or animation sampler, whose bytes do not overlap the bytes of any other
+    // accessor, image or compressed mesh of the asset.
+    static tsl::robin_set<const cgltf_accessor*> findExclusiveAccessors(const cgltf_data& gltf);
+
+    // Performs the optimization synchronously. The parameters structure is owned by the client.
+    static void run(Params* params);
+};
+
+} // namespace gltfio
+
+#endif // GLTFIO_MESHOPTIMIZERJOB_H
@@ -15,10 +15,12 @@
  */
 
 #include <gltfio/ResourceLoader.h>
-#include <gltfio/Image.h>
+#include <gltfio/ImageDecoder.h>
 
 #include "GltfEnums.h"
 #include "FFilamentAsset.h"
+#include "MappedFile.h"
+#include "MeshOptimizerJob.h"
 #include "TangentsJob.h"
 #include "upcast.h"
 
@@ -42,8 +44,15 @@
 #include <math/vec4.h>
 
 #include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <string.h>
 
 #if defined(__EMSCRIPTEN__) || defined(ANDROID) || defined(IOS)
 #define USE_FILESYSTEM 0
@@ -64,13 +73,27 @@ static const auto FREE_CALLBACK = [](void* mem, size_t, void*) { free(mem); };
 namespace {
     struct TextureCacheEntry {
         Texture* texture;
-        std::atomic<stbi_uc*> texels;
-        uint32_t bufferSize;
-        int width;
-        int height;
-        int numComponents;
+        std::atomic<uint8_t*> texels;   // all the levels, laid out as they are uploaded
+        size_t byteCount;
+
+        // The encoded image and its decoder. Image files are mapped by the entry itself.
+        const gltfio::ImageDecoder* decoder;
+        gltfio::ImageDecoder::Info info;
+        const uint8_t* sourceData;
+        size_t sourceSize;
+        gltfio::ResourceLoader::BufferDescriptor mapping;
+
+        // Number of channels of the uploaded texels, which may be more than decoded.
+        uint8_t channels;
         bool srgb;
         bool completed;
+
+        // Used only for progressive loading: the material slots that are waiting for this texture,
+        // and the stand-in that is bound until the full image has been uploaded, which holds the
+        // levels of the image from previewLevel.
+        std::vector<gltfio::TextureSlot> slots;
+        Texture* preview;
+        uint32_t previewLevel;
     };
 
     using BufferTextureCache = tsl::robin_map<const void*, std::unique_ptr<TextureCacheEntry>>;
@@ -86,13 +109,29 @@ struct ResourceLoader::Impl {
         mEngine = config.engine;
         mNormalizeSkinningWeights = config.normalizeSkinningWeights;
         mRecomputeBoundingBoxes = config.recomputeBoundingBoxes;
+        mMemoryMapFiles = config.memoryMapFiles;
+        mProgressiveLoading = config.progressiveLoading;
+        mProgressiveUploadBudget = config.progressiveUploadBudget;
+        mOptimizeMeshes = config.optimizeMeshes;
+        mCompactIndices = config.compactIndices;
     }
 
     Engine* mEngine;
     bool mNormalizeSkinningWeights;
     bool mRecomputeBoundingBoxes;
+    bool mMemoryMapFiles;
+    bool mProgressiveLoading;
+    size_t mProgressiveUploadBudget;
+    bool mOptimizeMeshes;
+    bool mCompactIndices;
+    MeshOptimizationStats mMeshOptimizationStats;
     std::string mGltfPath;
 
+    // Image decoders registered with addImageDecoder(), by MIME type in the order they were
+    // registered, and the built-in decoder of PNG and JPEG images.
+    std::vector<std::pair<std::string, const ImageDecoder*>> mImageDecoders;
+    std::unique_ptr<ImageDecoder> mStbDecoder{ createStbDecoder() };
+
     // User-provided resource data with URI string keys, populated with addResourceData().
     // This is used on platforms without traditional file systems, such as Android, iOS, and WebGL.
     UriDataCache mUriDataCache;
@@ -108,10 +147,41 @@ struct ResourceLoader::Impl {
     JobSystem::Job* mDecoderRootJob = nullptr;
     FFilamentAsset* mCurrentAsset = nullptr;
 
-    void computeTangents(FFilamentAsset* asset);
+    // State for progressive loading. Geometry is uploaded one vertex buffer at a time from
+    // asyncUpdateLoad. Each pending entry holds the slots for a vertex buffer and its index buffer,
+    // as well as the primitives that require generated tangents. The source asset is retained
+    // because clients are allowed to call releaseSourceData while the load is still underway.
+    struct PendingPrimitive {
+        VertexBuffer* vertexBuffer;
+        std::vector<BufferSlot> slots;
+        std::vector<std::pair<const cgltf_primitive*, VertexBuffer*>> primitives;
+        size_t byteCount = 0;
+    };
+    bool mProgressive = false;
+    std::vector<PendingPrimitive> mPendingPrimitives;
+    size_t mNumPrimitivesUploaded = 0;
+    FFilamentAsset::SourceHandle mProgressiveSource;
+    Texture* mPlaceholders[3] = {};
+
+    void computeTangents(FFilamentAsset* asset, const std::vector<BufferSlot>& slots,
+            const std::vector<std::pair<const cgltf_primitive*, VertexBuffer*>>& primitives);
+    void preparePrimitiveUploads(FFilamentAsset* asset);
+    void uploadPendingPrimitives();
+    void cancelPrimitiveUploads();
+    Texture* getPlaceholder(const TextureSlot& tb);
+    Texture* createTexture(const TextureCacheEntry* entry, uint32_t width, uint32_t height,
+            uint8_t levels);
+    void createPreview(TextureCacheEntry* entry, uint32_t level);
+    void releasePreview(TextureCacheEntry* entry);
+    TextureCacheEntry* getTextureCacheEntry(const TextureSlot& tb);
+    bool mapBuffers(FFilamentAsset* asset);
     bool createTextures(bool async);
     void cancelTextureDecoding();
     void addTextureCacheEntry(const TextureSlot& tb);
+    const ImageDecoder* findImageDecoder(const std::string& mimeType, const uint8_t* data,
+            size_t size, ImageDecoder::Info* info) const;
+    bool initTextureCacheEntry(TextureCacheEntry* entry, const std::string& mimeType,
+            const uint8_t* data, size_t size);
     void bindTextureToMaterial(const TextureSlot& tb);
     void decodeSingleTexture();
     void uploadPendingTextures();
@@ -128,8 +198,8 @@ struct UploadEvent {
     FFilamentAsset::SourceHandle handle;
 };
 
-UploadEvent* uploadUserdata(FFilamentAsset* asset) {
-    return new UploadEvent({ asset->mSourceAsset });
+UploadEvent* uploadUserdata(const FFilamentAsset::SourceHandle& source) {
+    return new UploadEvent({ source });
 }
 
 static void uploadCallback(void* buffer, size_t size, void* user) {
@@ -218,6 +288,276 @@ static void convertToFloats(float* dest, const cgltf_accessor* accessor) {
     transcode(dest, source, accessor->count);
 }
 
+// Uploads the data for a single vertex attribute or index buffer. Uploads that reference the source
+// data directly retain the given handle until the GPU has consumed the data.
+static void uploadBufferSlot(Engine& engine, FFilamentAsset* asset,
+        const FFilamentAsset::SourceHandle& source, const BufferSlot& slot) {
+    using BufferDescriptor = ResourceLoader::BufferDescriptor;
+    const cgltf_accessor* accessor = slot.accessor;
+    if (!accessor->buffer_view) {
+        return;
+    }
+    auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
+    const uint8_t* data = computeBindingOffset(accessor) + bufferData;
+    const uint32_t size = computeBindingSize(accessor);
+    if (slot.vertexBuffer) {
+        if (requiresConversion(accessor->type, accessor->component_type)) {
+            const size_t dim = cgltf_num_components(accessor->type);
+            const size_t floatsSize = accessor->count * sizeof(float) * dim;
+            float* floatsData = (float*) malloc(floatsSize);
+            convertToFloats(floatsData, accessor);
+            BufferObject* bo = BufferObject::Builder().size(floatsSize).build(engine);
+            asset->mBufferObjects.push_back(bo);
+            bo->setBuffer(engine, BufferDescriptor(floatsData, floatsSize, FREE_CALLBACK));
+            slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+            return;
+        }
+        BufferObject* bo = BufferObject::Builder().size(size).build(engine);
+        asset->mBufferObjects.push_back(bo);
+        bo->setBuffer(engine, BufferDescriptor(data, size,
+                uploadCallback, uploadUserdata(source)));
+        slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+        return;
+    }
+    assert(slot.indexBuffer);
+    if (accessor->component_type == cgltf_component_type_r_8u) {
+        const size_t size16 = size * 2;
+        uint16_t* data16 = (uint16_t*) malloc(size16);
+        convertBytesToShorts(data16, data, size);
+        IndexBuffer::BufferDescriptor bd(data16, size16, FREE_CALLBACK);
+        slot.indexBuffer->setBuffer(engine, std::move(bd));
+        return;
+    }
+    IndexBuffer::BufferDescriptor bd(data, size, uploadCallback, uploadUserdata(source));
+    slot.indexBuffer->setBuffer(engine, std::move(bd));
+}
+
+// Unpacks a sparse accessor and uploads the result, replacing the base array.
+static void uploadSparseSlot(Engine& engine, FFilamentAsset* asset, const BufferSlot& slot) {
+    using BufferDescriptor = ResourceLoader::BufferDescriptor;
+    const cgltf_accessor* accessor = slot.accessor;
+    cgltf_size numFloats = accessor->count * cgltf_num_components(accessor->type);
+    cgltf_size numBytes = sizeof(float) * numFloats;
+    float* generated = (float*) malloc(numBytes);
+    cgltf_accessor_unpack_floats(accessor, generated, numFloats);
+    BufferObject* bo = BufferObject::Builder().size(numBytes).build(engine);
+    asset->mBufferObjects.push_back(bo);
+    bo->setBuffer(engine, BufferDescriptor(generated, numBytes, FREE_CALLBACK));
+    slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+}
+
+// Produces a small copy of an 8-bit image by averaging square blocks of texels. The result is
+// malloc'd and its dimensions never exceed maxSize.
+static uint8_t* downsampleTexels(const uint8_t* texels, int width, int height, int channels,
+        int maxSize, int* outWidth, int* outHeight) {
+    int factor = 1;
+    while (std::max(width, height) / factor > maxSize) {
+        factor *= 2;
+    }
+    const int w = std::max(width / factor, 1);
+    const int h = std::max(height / factor, 1);
+    uint8_t* result = (uint8_t*) malloc(w * h * channels);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            uint32_t sum[4] = {};
+            uint32_t count = 0;
+            for (int j = y * factor, jend = std::min((y + 1) * factor, height); j < jend; ++j) {
+                const uint8_t* row = texels + (j * width + x * factor) * channels;
+                for (int i = x * factor, iend = std::min((x + 1) * factor, width); i < iend; ++i) {
+                    for (int c = 0; c < channels; ++c) {
+                        sum[c] += row[c];
+                    }
+                    row += channels;
+                    ++count;
+                }
+            }
+            uint8_t* dst = result + (y * w + x) * channels;
+            for (int c = 0; c < channels; ++c) {
+                dst[c] = uint8_t(sum[c] / count);
+            }
+        }
+    }
+    *outWidth = w;
+    *outHeight = h;
+    return result;
+}
+
+// Number of channels of the uploaded texels. RGB8 can't be mipmapped on every backend and there
+// are no sRGB formats with fewer than 4 channels, so these images are expanded to RGBA. Gray and
+// gray-alpha images are kept as is when the texture can be swizzled to sample them the same way.
+static uint8_t getUploadedChannels(Engine& engine, const ImageDecoder::Info& info, bool srgb) {
+    if (info.compressed) {
+        return 0;
+    }
+    if (srgb || info.channels == 3 || !Texture::isTextureSwizzleSupported(engine)) {
+        return 4;
+    }
+    return info.channels;
+}
+
+static Texture::InternalFormat getTextureFormat(uint8_t channels, bool srgb) {
+    switch (channels) {
+        case 1: return Texture::InternalFormat::R8;
+        case 2: return Texture::InternalFormat::RG8;
+        default: return srgb ? Texture::InternalFormat::SRGB8_A8 : Texture::InternalFormat::RGBA8;
+    }
+}
+
+static Texture::Format getPixelFormat(uint8_t channels) {
+    switch (channels) {
+        case 1: return Texture::Format::R;
+        case 2: return Texture::Format::RG;
+        default: return Texture::Format::RGBA;
+    }
+}
+
+static size_t getUploadedLevelSize(const TextureCacheEntry& entry, uint32_t level) {
+    const ImageDecoder::Info& info = entry.info;
+    if (info.compressed) {
+        return entry.decoder->getLevelSize(entry.sourceData, entry.sourceSize, info, level);
+    }
+    const size_t width = std::max(info.width >> level, 1u);
+    const size_t height = std::max(info.height >> level, 1u);
+    return width * height * entry.channels;
+}
+
+static Texture::PixelBufferDescriptor createPixelBuffer(const TextureCacheEntry& entry,
+        uint8_t* texels, size_t size, Texture::PixelBufferDescriptor::Callback callback) {
+    if (entry.info.compressed) {
+        return Texture::PixelBufferDescriptor(texels, size, entry.info.compressedType, size,
+                callback);
+    }
+    return Texture::PixelBufferDescriptor(texels, size, getPixelFormat(entry.channels),
+            Texture::Type::UBYTE, callback);
+}
+
+// Mipmaps of uncompressed images with a single level are generated by the GPU, for their previews
+// too. Other images only have the levels provided by their decoder.
+static bool hasGeneratedMipmaps(const TextureCacheEntry& entry) {
+    return !entry.info.compressed && entry.info.levels == 1;
+}
+
+// The coarsest preview of an image starts at its first level of 64 texels or less. Compressed
+// images can't be downsampled, they only have previews if their decoder provides mipmaps.
+static uint32_t getFirstPreviewLevel(const TextureCacheEntry& entry) {
+    constexpr uint32_t kPreviewSize = 64;
+    const ImageDecoder::Info& info = entry.info;
+    const uint32_t lastLevel = entry.texture->getLevels() - 1;
+    uint32_t level = 0;
+    while (level < lastLevel &&
+            std::max(info.width >> level, info.height >> level) > kPreviewSize) {
+        ++level;
+    }
+    return level;
+}
+
+// Number of bytes uploaded to show the image from the given level, either as a preview or, for
+// level 0, as the full image.
+static size_t getPreviewSize(const TextureCacheEntry& entry, uint32_t level) {
+    if (level == 0) {
+        return entry.byteCount;
+    }
+    if (hasGeneratedMipmaps(entry)) {
+        return getUploadedLevelSize(entry, level);
+    }
+    size_t size = 0;
+    for (uint32_t l = level; l < entry.info.levels; ++l) {
+        size += getUploadedLevelSize(entry, l);
+    }
+    return size;
+}
+
+// Expands 8-bit texels to RGBA like stb does: gray is replicated to RGB, and alpha is opaque
+// unless the image has it.
+static void expandTexels(const uint8_t* src, uint8_t* dst, size_t count, int channels) {
+    for (size_t i = 0; i < count; ++i, src += channels, dst += 4) {
+        switch (channels) {
+            case 1: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = 0xff; break;
+            case 2: dst[0] = dst[1] = dst[2] = src[0]; dst[3] = src[1]; break;
+            case 3: dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 0xff; break;
+        }
+    }
+}
+
+// Decodes an uncompressed level in bands of rows that are decoded and expanded in parallel. Bands
+// are at least this many texels, which amortizes the cost of jobs for decoders that can decode
+// small bands. Images that can't be decoded in bands are decoded at once, and only their
+// expansion is split.
+static constexpr uint32_t kMinBandTexels = 64 * 1024;
+
+static bool decodeLevel(JobSystem& js, const TextureCacheEntry& entry, uint32_t level,
+        uint8_t* out) {
+    const ImageDecoder* decoder = entry.decoder;
+    const ImageDecoder::Info& info = entry.info;
+    const uint32_t width = std::max(info.width >> level, 1u);
+    const uint32_t height = std::max(info.height >> level, 1u);
+    const bool expand = entry.channels != info.channels;
+    assert_invariant(!expand || entry.channels == 4);
+
+    // Texels that are expanded are decoded to a temporary buffer first.
+    uint8_t* decoded = expand ? (uint8_t*) malloc(size_t(width) * height * info.channels) : out;
+
+    uint32_t bandHeight = std::max(kMinBandTexels / width, 1u);
+    if (info.bandHeight) {
+        bandHeight = (bandHeight + info.bandHeight - 1) / info.bandHeight * info.bandHeight;
+    }
+    const uint32_t bandCount = (height + bandHeight - 1) / bandHeight;
+
+    std::atomic<bool> success = true;
+    if (!info.bandHeight) {
+        success = decoder->decode(entry.sourceData, entry.sourceSize, info, level, 0, height,
+                decoded);
+    }
+
+    auto processBands = [&](uint32_t first, uint32_t count) {
+        for (uint32_t band = first; band < first + count; ++band) {
+            const uint32_t firstRow = band * bandHeight;
+            const uint32_t rowCount = std::min(bandHeight, height - firstRow);
+            const size_t offset = size_t(firstRow) * width;
+            if (info.bandHeight && !decoder->decode(entry.sourceData, entry.sourceSize, info,
+                    level, firstRow, rowCount, decoded + offset * info.channels)) {
+                success = false;
+                continue;
+            }
+            if (expand) {
+                expandTexels(decoded + offset * info.channels, out + offset * 4,
+                        size_t(rowCount) * width, info.channels);
+            }
+        }
+    };
+
+    if (success && (info.bandHeight || expand)) {
+        JobSystem::Job* job = jobs::parallel_for(js, nullptr, 0, bandCount,
+                std::ref(processBands), jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
+    }
+
+    if (expand) {
+        free(decoded);
+    }
+    return success;
+}
+
+// Decodes all the levels of an image into a single malloc'd buffer, which is laid out as the
+// levels are uploaded. Returns null if decoding failed.
+static uint8_t* decodeTexels(JobSystem& js, const TextureCacheEntry& entry) {
+    const ImageDecoder::Info& info = entry.info;
+    uint8_t* texels = (uint8_t*) malloc(entry.byteCount);
+    uint8_t* levelTexels = texels;
+    for (uint32_t level = 0; level < info.levels; ++level) {
+        const bool success = info.compressed ?
+                entry.decoder->decode(entry.sourceData, entry.sourceSize, info, level, 0,
+                        std::max(info.height >> level, 1u), levelTexels) :
+                decodeLevel(js, entry, level, levelTexels);
+        if (!success) {
+            free(texels);
+            return nullptr;
+        }
+        levelTexels += getUploadedLevelSize(entry, level);
+    }
+    return texels;
+}
+
 static void decodeDracoMeshes(FFilamentAsset* asset) {
     DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
 
@@ -283,6 +623,21 @@ static void decodeDracoMeshes(FFilamentAsset* asset) {
     }
 }
 
+static void releaseSharedBuffer(void*, size_t, void* user) {
+    delete (std::shared_ptr<ResourceLoader::BufferDescriptor>*) user;
+}
+
+// Shares the ownership of a client buffer: returns a descriptor of the same memory, which is
+// released once both this descriptor and the given one, that's updated, have been destroyed.
+static ResourceLoader::BufferDescriptor shareBuffer(ResourceLoader::BufferDescriptor& buffer) {
+    using BufferDescriptor = ResourceLoader::BufferDescriptor;
+    auto owner = std::make_shared<BufferDescriptor>(std::move(buffer));
+    buffer = BufferDescriptor(owner->buffer, owner->size, releaseSharedBuffer,
+            new std::shared_ptr<BufferDescriptor>(owner));
+    return BufferDescriptor(owner->buffer, owner->size, releaseSharedBuffer,
+            new std::shared_ptr<BufferDescriptor>(owner));
+}
+
 // Parses a data URI and returns a blob that gets malloc'd in cgltf, which the caller must free.
 // (implementation snarfed from meshoptimizer)
 static const uint8_t* parseDataUri(const char* uri, std::string* mimeType, size_t* psize) {
@@ -311,6 +666,30 @@ static const uint8_t* parseDataUri(const char* uri, std::string* mimeType, size_
     return nullptr;
 }
 
+// Returns the MIME type of an image, given by the glTF file, by its data URI, or by the extension
+// of its file.
+static std::string getMimeType(const cgltf_image* image) {
+    if (image->mime_type) {
+        return image->mime_type;
+    }
+    const char* uri = image->uri;
+    if (!uri) {
+        return {};
+    }
+    if (strncmp(uri, "data:", 5) == 0) {
+        const char* end = strpbrk(uri + 5, ";,");
+        return end ? std::string(uri + 5, end) : std::string();
+    }
+    const char* dot = strrchr(uri, '.');
+    if (!dot || strchr(dot, '/')) {
+        return {};
+    }
+    std::string extension = dot + 1;
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return (char) tolower(c); });
+    return "image/" + std::string(extension == "jpg" ? "jpeg" : extension);
+}
+
 ResourceLoader::ResourceLoader(const ResourceConfiguration& config) : pImpl(new Impl(config)) { }
 
 ResourceLoader::~ResourceLoader() {
@@ -338,6 +717,17 @@ bool ResourceLoader::hasResourceData(const char* uri) const {
     return pImpl->mUriDataCache.find(uri) != pImpl->mUriDataCache.end();
 }
 
+void ResourceLoader::addImageDecoder(const char* mimeType, ImageDecoder* decoder) {
+    auto& decoders = pImpl->mImageDecoders;
+    auto iter = std::find_if(decoders.begin(), decoders.end(),
+            [mimeType](const auto& pair) { return pair.first == mimeType; });
+    if (iter != decoders.end()) {
+        iter->second = decoder;
+        return;
+    }
+    decoders.emplace_back(mimeType, decoder);
+}
+
 void ResourceLoader::evictResourceData() {
     // Note that this triggers BufferDescriptor callbacks.
     pImpl->mUriDataCache.clear();
@@ -374,6 +764,8 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     }
 
     bool missingResources = false;
+    const bool modifiesBuffers = pImpl->mOptimizeMeshes ||
+            (pImpl->mNormalizeSkinningWeights && gltf->skins_count > 0);
 
     for (cgltf_size i = 0; i < gltf->buffers_count; ++i) {
         if (gltf->buffers[i].data) {
@@ -400,6 +792,16 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
             if (iter == pImpl->mUriDataCache.end()) {
                 slog.e << "Unable to load external resource: " << uri << io::endl;
                 missingResources = true;
+                continue;
+            }
+            // In zero-copy mode, the asset shares the client's blob with the URI cache, so that
+            // other assets can still use it. The source asset is retained by every pending upload,
+            // so the blob outlives the GPU transfers that reference it. Blobs are copied instead
+            // when the loader modifies buffers in place, which must not alter the client's data.
+            if (pImpl->mMemoryMapFiles && !modifiesBuffers) {
+                gltf->buffers[i].data = iter->second.buffer;
+                asset->mSourceAsset->mappedFiles.push_back(shareBuffer(iter.value()));
+                continue;
             }
             // Make a copy to allow cgltf_free() to work as expected and prevent a double-free.
             // TODO: Future versions of CGLTF will make this easier, see the following ticket.
@@ -419,7 +821,11 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
 
     #else
 
-    // Read data from the file system and base64 URIs.
+    // Map external buffers into memory if requested, then let cgltf read any remaining data from
+    // the file system and base64 URIs.
+    if (pImpl->mMemoryMapFiles && !pImpl->mapBuffers(asset)) {
+        return false;
+    }
     cgltf_result result = cgltf_load_buffers(&options, (cgltf_data*) gltf, pImpl->mGltfPath.c_str());
     if (result != cgltf_result_success) {
         slog.e << "Unable to load resources." << io::endl;
@@ -457,59 +863,37 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
         }
     }
 
+    // Reorder triangles and vertices for the GPU. This must happen before tangents are generated
+    // and before anything is uploaded, since both consume the source buffers.
+    pImpl->mMeshOptimizationStats = {};
+    if (pImpl->mOptimizeMeshes) {
+        optimizeMeshes(asset);
+    }
+
     if (pImpl->mRecomputeBoundingBoxes) {
         updateBoundingBoxes(asset);
     }
 
     Engine& engine = *pImpl->mEngine;
 
-    // Upload VertexBuffer and IndexBuffer data to the GPU.
-    for (auto slot : asset->mBufferSlots) {
-        const cgltf_accessor* accessor = slot.accessor;
-        if (!accessor->buffer_view) {
-            continue;
-        }
-        auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
-        const uint8_t* data = computeBindingOffset(accessor) + bufferData;
-        const uint32_t size = computeBindingSize(accessor);
-        if (slot.vertexBuffer) {
-            if (requiresConversion(accessor->type, accessor->component_type)) {
-                const size_t dim = cgltf_num_components(accessor->type);
-                const size_t floatsSize = accessor->count * sizeof(float) * dim;
-                float* floatsData = (float*) malloc(floatsSize);
-                convertToFloats(floatsData, accessor);
-                BufferObject* bo = BufferObject::Builder().size(floatsSize).build(engine);
-                asset->mBufferObjects.push_back(bo);
-                bo->setBuffer(engine, BufferDescriptor(floatsData, floatsSize, FREE_CALLBACK));
-                slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
-                continue;
-            }
-            BufferObject* bo = BufferObject::Builder().size(size).build(engine);
-            asset->mBufferObjects.push_back(bo);
-            bo->setBuffer(engine, BufferDescriptor(data, size,
-                    uploadCallback, uploadUserdata(asset)));
-            slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
-            continue;
-        }
-        assert(slot.indexBuffer);
-        if (accessor->component_type == cgltf_component_type_r_8u) {
-            const size_t size16 = size * 2;
-            uint16_t* data16 = (uint16_t*) malloc(size16);
-            convertBytesToShorts(data16, data, size);
-            IndexBuffer::BufferDescriptor bd(data16, size16, FREE_CALLBACK);
-            slot.indexBuffer->setBuffer(engine, std::move(bd));
-            continue;
+    // Upload VertexBuffer and IndexBuffer data to the GPU. In progressive mode, this is deferred
+    // to asyncUpdateLoad and the dependency graph holds back each entity until its geometry is in.
+    pImpl->mProgressive = async && pImpl->mProgressiveLoading;
+    if (pImpl->mProgressive) {
+        pImpl->preparePrimitiveUploads(asset);
+    } else {
+        for (const auto& slot : asset->mBufferSlots) {
+            uploadBufferSlot(engine, asset, asset->mSourceAsset, slot);
         }
-        IndexBuffer::BufferDescriptor bd(data, size, uploadCallback, uploadUserdata(asset));
-        slot.indexBuffer->setBuffer(engine, std::move(bd));
-    }
 
-    // Apply sparse data modifications to base arrays, then upload the result.
-    applySparseData(asset);
+        // Apply sparse data modifications to base arrays, then upload the result.
+        applySparseData(asset);
 
-    // Compute surface orientation quaternions if necessary. This is similar to sparse data in that
-    // we need to generate the contents of a GPU buffer by processing one or more CPU buffer(s).
-    pImpl->computeTangents(asset);
+        // Compute surface orientation quaternions if necessary. This is similar to sparse data in
+        // that we need to generate the contents of a GPU buffer by processing one or more CPU
+        // buffer(s).
+        pImpl->computeTangents(asset, asset->mBufferSlots, asset->mPrimitives);
+    }
 
     // Non-textured renderables are now considered ready, so notify the dependency graph.
     asset->mDependencyGraph.finalize();
@@ -525,17 +909,23 @@ bool ResourceLoader::asyncBeginLoad(FilamentAsset* asset) {
 }
 
 void ResourceLoader::asyncCancelLoad() {
+    pImpl->cancelPrimitiveUploads();
     pImpl->cancelTextureDecoding();
     pImpl->mEngine->flushAndWait();
 }
 
 float ResourceLoader::asyncGetLoadProgress() const {
-    const float finished = pImpl->mNumDecoderTasksFinished;
-    const float total = pImpl->mNumDecoderTasks;
+    const float finished = pImpl->mNumDecoderTasksFinished + pImpl->mNumPrimitivesUploaded;
+    const float total = pImpl->mNumDecoderTasks + pImpl->mPendingPrimitives.size();
     return total == 0 ? 0 : finished / total;
 }
 
+MeshOptimizationStats ResourceLoader::getMeshOptimizationStats() const {
+    return pImpl->mMeshOptimizationStats;
+}
+
 void ResourceLoader::asyncUpdateLoad() {
+    pImpl->uploadPendingPrimitives();
     if (!UTILS_HAS_THREADING) {
         pImpl->decodeSingleTexture();
     }
@@ -544,61 +934,81 @@ void ResourceLoader::asyncUpdateLoad() {
 
 void ResourceLoader::Impl::decodeSingleTexture() {
     assert(!UTILS_HAS_THREADING);
-    int w, h, c;
+    JobSystem& js = mEngine->getJobSystem();
 
     // Check if any buffer-based textures haven't been decoded yet.
     for (auto& pair : mBufferTextureCache) {
-        const uint8_t* sourceData = (const uint8_t*) pair.first;
         TextureCacheEntry* entry = pair.second.get();
         if (entry->texels) {
             continue;
         }
-        entry->texels = stbi_load_from_memory(sourceData, entry->bufferSize, &w, &h, &c, 4);
+        entry->texels = decodeTexels(js, *entry);
         return;
     }
 
     // Check if any URI-based textures haven't been decoded yet.
     for (auto& pair : mUriTextureCache) {
-        auto uri = pair.first;
         TextureCacheEntry* entry = pair.second.get();
         if (entry->texels) {
             continue;
         }
-
-        // First, check the user-supplied resource cache for this URI.
-        auto iter = mUriDataCache.find(uri);
-        if (iter != mUriDataCache.end()) {
-            const uint8_t* sourceData = (const uint8_t*) iter->second.buffer;
-            entry->texels = stbi_load_from_memory(sourceData, iter->second.size, &w, &h, &c, 4);
-            return;
-        }
-
-        // Otherwise load it from the file system if this platform supports it.
-        #if !USE_FILESYSTEM
-            slog.e << "Unable to load texture: " << uri << io::endl;
-            entry->completed = true;
-            mNumDecoderTasksFinished++;
-            return;
-        #else
-            Path fullpath = Path(mGltfPath).getParent() + uri;
-            entry->texels = stbi_load(fullpath.c_str(), &w, &h, &c, 4);
-            return;
-        #endif
+        entry->texels = decodeTexels(js, *entry);
+        return;
     }
 }
 
 void ResourceLoader::Impl::uploadPendingTextures() {
-    auto upload = [this](TextureCacheEntry* entry, Engine& engine) {
+    size_t uploadedBytes = 0;
+    auto upload = [this, &uploadedBytes](TextureCacheEntry* entry, Engine& engine) {
         Texture* texture = entry->texture;
         uint8_t* texels = entry->texels;
         if (texture && texels && !entry->completed) {
-            Texture::PixelBufferDescriptor pbd(texels,
-                    texture->getWidth() * texture->getHeight() * 4,
-                    Texture::Format::RGBA, Texture::Type::UBYTE, FREE_CALLBACK);
-            texture->setImage(engine, 0, std::move(pbd));
-            texture->generateMipmaps(engine);
+            const ImageDecoder::Info& info = entry->info;
+
+            // In progressive mode, uploads are spread over several updates. A decoded texture
+            // starts with a preview of its coarse levels, which is refined by one level or more
+            // per update depending on the budget, until the full image fits. At least one step
+            // is taken per update.
+            if (mProgressive) {
+                uint32_t level = entry->preview ? entry->previewLevel - 1 :
+                        getFirstPreviewLevel(*entry);
+                if (uploadedBytes > 0 &&
+                        uploadedBytes + getPreviewSize(*entry, level) > mProgressiveUploadBudget) {
+                    return;
+                }
+                while (level > 0 && uploadedBytes + getPreviewSize(*entry, level - 1) <=
+                        mProgressiveUploadBudget) {
+                    --level;
+                }
+                uploadedBytes += getPreviewSize(*entry, level);
+                if (level > 0) {
+                    createPreview(entry, level);
+                    return;
+                }
+            }
+
+            // All the levels are uploaded in order from a single allocation, which is therefore
+            // freed along with the last one.
+            for (uint32_t level = 0, offset = 0; level < info.levels; ++level) {
+                const size_t levelSize = getUploadedLevelSize(*entry, level);
+                BufferDescriptor::Callback callback = nullptr;
+                if (level + 1 == info.levels) {
+                    callback = FREE_CALLBACK;
+                }
+                texture->setImage(engine, level,
+                        createPixelBuffer(*entry, texels + offset, levelSize, callback));
+                offset += levelSize;
+            }
+            if (!info.compressed && info.levels == 1) {
+                texture->generateMipmaps(engine);
+            }
             entry->completed = true;
             mNumDecoderTasksFinished++;
+            for (const TextureSlot& slot : entry->slots) {
+                mCurrentAsset->bindTexture(slot, texture);
+            }
+            entry->slots.clear();
+            releasePreview(entry);
             mCurrentAsset->mDependencyGraph.markAsReady(texture);
         }
     };
@@ -620,6 +1030,49 @@ void ResourceLoader::Impl::releasePendingTextures() {
     for (auto& pair : mUriTextureCache) release(pair.second.get(), *mEngine);
 }
 
+const ImageDecoder* ResourceLoader::Impl::findImageDecoder(const std::string& mimeType,
+        const uint8_t* data, size_t size, ImageDecoder::Info* info) const {
+    for (const auto& pair : mImageDecoders) {
+        if (pair.first == mimeType) {
+            *info = {};
+            if (pair.second->getInfo(data, size, info)) {
+                return pair.second;
+            }
+        }
+    }
+    for (const auto& pair : mImageDecoders) {
+        if (pair.first != mimeType) {
+            *info = {};
+            if (pair.second->getInfo(data, size, info)) {
+                return pair.second;
+            }
+        }
+    }
+    *info = {};
+    return mStbDecoder->getInfo(data, size, info) ? mStbDecoder.get() : nullptr;
+}
+
+bool ResourceLoader::Impl::initTextureCacheEntry(TextureCacheEntry* entry,
+        const std::string& mimeType, const uint8_t* data, size_t size) {
+    entry->decoder = findImageDecoder(mimeType, data, size, &entry->info);
+    if (!entry->decoder) {
+        return false;
+    }
+    const ImageDecoder::Info& info = entry->info;
+    if (info.compressed && !Texture::isTextureFormatSupported(*mEngine, info.format)) {
+        slog.e << "Compressed texture format is not supported." << io::endl;
+        return false;
+    }
+    entry->sourceData = data;
+    entry->sourceSize = size;
+    entry->channels = getUploadedChannels(*mEngine, info, entry->srgb);
+    entry->byteCount = 0;
+    for (uint32_t level = 0; level < info.levels; ++level) {
+        entry->byteCount += getUploadedLevelSize(*entry, level);
+    }
+    return true;
+}
+
 void ResourceLoader::Impl::addTextureCacheEntry(const TextureSlot& tb) {
     TextureCacheEntry* entry = nullptr;
 
@@ -629,6 +1082,7 @@ void ResourceLoader::Impl::addTextureCacheEntry(const TextureSlot& tb) {
     const uint32_t totalSize = uint32_t(bv ? bv->size : 0);
     void** data = bv ? &bv->buffer->data : nullptr;
     const size_t offset = bv ? bv->offset : 0;
+    const std::string mimeType = getMimeType(srcTexture->image);
 
     // Check if the texture binding uses BufferView data (i.e. it does not have a URI).
     if (data) {
@@ -639,13 +1093,10 @@ void ResourceLoader::Impl::addTextureCacheEntry(const TextureSlot& tb) {
         }
         entry = (mBufferTextureCache[sourceData] = std::make_unique<TextureCacheEntry>()).get();
         entry->srgb = tb.srgb;
-        if (!stbi_info_from_memory(sourceData, totalSize, &entry->width, &entry->height,
-                &entry->numComponents)) {
-            slog.e << "Unable to decode BufferView texture: " << stbi_failure_reason() << io::endl;
+        if (!initTextureCacheEntry(entry, mimeType, sourceData, totalSize)) {
+            slog.e << "Unable to decode BufferView texture." << io::endl;
             mBufferTextureCache.erase(sourceData);
-            return;
         }
-        entry->bufferSize = totalSize;
         return;
     }
 
@@ -658,41 +1109,43 @@ void ResourceLoader::Impl::addTextureCacheEntry(const TextureSlot& tb) {
     entry = (mUriTextureCache[uri] = std::make_unique<TextureCacheEntry>()).get();
     entry->srgb = tb.srgb;
 
-    // Check if this is a data URI. We don't care about the MIME type since stb can infer it.
-    std::string mimeType;
+    // Check if this is a data URI. Its MIME type has already been taken into account.
+    std::string dataUriMimeType;
     size_t dataUriSize;
-    const uint8_t* dataUriContent = parseDataUri(uri, &mimeType, &dataUriSize);
+    const uint8_t* dataUriContent = parseDataUri(uri, &dataUriMimeType, &dataUriSize);
     if (dataUriContent) {
         BufferDescriptor buffer(dataUriContent, dataUriSize, FREE_CALLBACK);
         mUriDataCache.emplace(uri, std::move(buffer));
     }
 
-    // Check the user-supplied resource cache for this URI, otherwise peek at the file.
+    // Check the user-supplied resource cache for this URI, otherwise map the file.
     auto iter = mUriDataCache.find(uri);
     if (iter != mUriDataCache.end()) {
         const uint8_t* sourceData = (const uint8_t*) iter->second.buffer;
-        if (!stbi_info_from_memory(sourceData, iter->second.size, &entry->width,
-                &entry->height, &entry->numComponents)) {
-            slog.e << "Unable to decode " << uri << " : " << stbi_failure_reason() << io::endl;
+        if (!initTextureCacheEntry(entry, mimeType, sourceData, iter->second.size)) {
+            slog.e << "Unable to decode " << uri << io::endl;
             mUriTextureCache.erase(uri);
         }
         return;
     }
     #if !USE_FILESYSTEM
         slog.e << "Unable to load texture: " << uri << io::endl;
+        mUriTextureCache.erase(uri);
     #else
+        // Decoders read images from memory, so the file is mapped, which lets the decoder jobs read
+        // straight from the page cache. The mapping is released along with the entry.
         Path fullpath = Path(mGltfPath).getParent() + uri;
-        if (!stbi_info(fullpath.c_str(), &entry->width, &entry->height, &entry->numComponents)) {
-            slog.e << "Unable to decode " << fullpath.c_str() << " : " << stbi_failure_reason()
-                    << io::endl;
+        entry->mapping = mapFile(fullpath.c_str());
+        const uint8_t* sourceData = (const uint8_t*) entry->mapping.buffer;
+        if (!sourceData || !initTextureCacheEntry(entry, mimeType, sourceData,
+                entry->mapping.size)) {
+            slog.e << "Unable to decode " << fullpath.c_str() << io::endl;
             mUriTextureCache.erase(uri);
         }
     #endif
 }
 
-void ResourceLoader::Impl::bindTextureToMaterial(const TextureSlot& tb) {
-    FFilamentAsset* asset = mCurrentAsset;
-
+TextureCacheEntry* ResourceLoader::Impl::getTextureCacheEntry(const TextureSlot& tb) {
     const cgltf_texture* srcTexture = tb.texture;
     const cgltf_buffer_view* bv = srcTexture->image->buffer_view;
     const char* uri = srcTexture->image->uri;
@@ -703,21 +1156,144 @@ void ResourceLoader::Impl::bindTextureToMaterial(const TextureSlot& tb) {
     if (data) {
         const uint8_t* sourceData = offset + (const uint8_t*) *data;
         if (auto iter = mBufferTextureCache.find(sourceData); iter != mBufferTextureCache.end()) {
-            auto& entry = iter->second;
-            if (entry.get() && entry->texture) {
-                asset->bindTexture(tb, entry->texture);
-            }
+            return iter->second.get();
         }
-        return;
+        return nullptr;
     }
 
     // Next check if this is a URI-based texture.
     if (auto iter = mUriTextureCache.find(uri); iter != mUriTextureCache.end()) {
-        auto& entry = iter->second;
-        if (entry.get() && entry->texture) {
-            asset->bindTexture(tb, entry->texture);
+        return iter->second.get();
+    }
+    return nullptr;
+}
+
+void ResourceLoader::Impl::bindTextureToMaterial(const TextureSlot& tb) {
+    TextureCacheEntry* entry = getTextureCacheEntry(tb);
+    if (!entry || !entry->texture) {
+        return;
+    }
+
+    // In progressive mode, the material is immediately satisfied by a placeholder and the slot is
+    // remembered so that the real texture can be bound once it has been uploaded.
+    if (mProgressive) {
+        entry->slots.push_back(tb);
+        mCurrentAsset->bindTexture(tb, getPlaceholder(tb));
+        return;
+    }
+    mCurrentAsset->bindTexture(tb, entry->texture);
+}
+
+// Returns a 1x1 texture whose value does not visibly alter the material: flat for normal maps,
+// black for emissive maps and white for everything else, since the latter are multiplied with
+// their corresponding factors.
+Texture* ResourceLoader::Impl::getPlaceholder(const TextureSlot& tb) {
+    enum { WHITE, NORMAL, BLACK };
+    int index = WHITE;
+    uint32_t value = 0xffffffff;
+    if (!strcmp(tb.materialParameter, "normalMap") ||
+            !strcmp(tb.materialParameter, "clearCoatNormalMap")) {
+        index = NORMAL;
+        value = 0xffff8080;
+    } else if (!strcmp(tb.materialParameter, "emissiveMap")) {
+        index = BLACK;
+        value = 0xff000000;
+    }
+    if (!mPlaceholders[index]) {
+        Texture* texture = Texture::Builder()
+                .width(1)
+                .height(1)
+                .levels(1)
+                .format(Texture::InternalFormat::RGBA8)
+                .build(*mEngine);
+        uint32_t* texel = (uint32_t*) malloc(sizeof(uint32_t));
+        *texel = value;
+        texture->setImage(*mEngine, 0, Texture::PixelBufferDescriptor(texel, sizeof(uint32_t),
+                Texture::Format::RGBA, Texture::Type::UBYTE, FREE_CALLBACK));
+        mCurrentAsset->takeOwnership(texture);
+        mPlaceholders[index] = texture;
+    }
+    return mPlaceholders[index];
+}
+
+// Creates a texture for the texels of an entry, or for a smaller preview of them.
+Texture* ResourceLoader::Impl::createTexture(const TextureCacheEntry* entry, uint32_t width,
+        uint32_t height, uint8_t levels) {
+    Texture::Builder builder;
+    builder.width(width).height(height).levels(levels);
+    if (entry->info.compressed) {
+        builder.format(entry->info.format);
+    } else {
+        builder.format(getTextureFormat(entry->channels, entry->srgb));
+    }
+
+    // Gray and gray-alpha images are sampled as if they had been expanded to RGBA.
+    using Swizzle = Texture::Swizzle;
+    if (entry->channels == 1) {
+        builder.swizzle(Swizzle::CHANNEL_0, Swizzle::CHANNEL_0, Swizzle::CHANNEL_0,
+                Swizzle::SUBSTITUTE_ONE);
+    } else if (entry->channels == 2) {
+        builder.swizzle(Swizzle::CHANNEL_0, Swizzle::CHANNEL_0, Swizzle::CHANNEL_0,
+                Swizzle::CHANNEL_1);
+    }
+
+    Texture* texture = builder.build(*mEngine);
+    mCurrentAsset->takeOwnership(texture);
+    return texture;
+}
+
+// Replaces the preview of an entry with one that holds the levels of the image from the given
+// level. Its texels are copied, since the decoded image is freed by the upload of the full image,
+// which may be cancelled.
+void ResourceLoader::Impl::createPreview(TextureCacheEntry* entry, uint32_t level) {
+    const ImageDecoder::Info& info = entry->info;
+    const uint8_t* texels = entry->texels;
+    Texture* preview;
+    if (hasGeneratedMipmaps(*entry)) {
+        int width, height;
+        uint8_t* levelTexels = downsampleTexels(texels, info.width, info.height, entry->channels,
+                std::max(std::max(info.width >> level, info.height >> level), 1u),
+                &width, &height);
+        preview = createTexture(entry, width, height, 0xff);
+        preview->setImage(*mEngine, 0, createPixelBuffer(*entry, levelTexels,
+                width * height * entry->channels, FREE_CALLBACK));
+        preview->generateMipmaps(*mEngine);
+    } else {
+        preview = createTexture(entry, std::max(info.width >> level, 1u),
+                std::max(info.height >> level, 1u), uint8_t(info.levels - level));
+        size_t offset = 0;
+        for (uint32_t l = 0; l < level; ++l) {
+            offset += getUploadedLevelSize(*entry, l);
         }
+        for (uint32_t l = level; l < info.levels; ++l) {
+            const size_t levelSize = getUploadedLevelSize(*entry, l);
+            uint8_t* levelTexels = (uint8_t*) malloc(levelSize);
+            memcpy(levelTexels, texels + offset, levelSize);
+            preview->setImage(*mEngine, l - level,
+                    createPixelBuffer(*entry, levelTexels, levelSize, FREE_CALLBACK));
+            offset += levelSize;
+        }
+    }
+
+    // The preview is not tracked by the dependency graph, since the material has already been
+    // satisfied by a placeholder.
+    for (const TextureSlot& slot : entry->slots) {
+        slot.materialInstance->setParameter(slot.materialParameter, preview, slot.sampler);
     }
+    releasePreview(entry);
+    entry->preview = preview;
+    entry->previewLevel = level;
+}
+
+// Destroys the preview of an entry once the material slots have been bound to another texture.
+void ResourceLoader::Impl::releasePreview(TextureCacheEntry* entry) {
+    if (!entry->preview) {
+        return;
+    }
+    std::vector<Texture*>& textures = mCurrentAsset->mTextures;
+    textures.erase(std::find(textures.begin(), textures.end(), entry->preview));
+    mEngine->destroy(entry->preview);
+    entry->preview = nullptr;
 }
 
 void ResourceLoader::Impl::cancelTextureDecoding() {
@@ -744,6 +1320,7 @@ bool ResourceLoader::Impl::createTextures(bool async) {
 
     mBufferTextureCache.clear();
     mUriTextureCache.clear();
+    std::fill_n(mPlaceholders, 3, nullptr);
 
     // First, determine texture dimensions and create texture cache entries.
     FFilamentAsset* asset = mCurrentAsset;
@@ -762,25 +1339,27 @@ bool ResourceLoader::Impl::createTextures(bool async) {
         mNumDecoderTasksFinished = 0;
     }
 
-    // Next create blank Filament textures.
-    auto createTexture = [=](TextureCacheEntry* entry) {
-        entry->texture = Texture::Builder()
-            .width(entry->width)
-            .height(entry->height)
-            .levels(0xff)
-            .format(entry->srgb ? Texture::InternalFormat::SRGB8_A8 : Texture::InternalFormat::RGBA8)
-            .build(*mEngine);
-        asset->takeOwnership(entry->texture);
+    // Next create blank Filament textures. Mipmaps are generated unless the decoder provides them.
+    auto create = [this](TextureCacheEntry* entry) {
+        const ImageDecoder::Info& info = entry->info;
+        const bool generateMipmaps = !info.compressed && info.levels == 1;
+        entry->texture = createTexture(entry, info.width, info.height,
+                generateMipmaps ? 0xff : info.levels);
     };
-    for (auto& pair : mBufferTextureCache) createTexture(pair.second.get());
-    for (auto& pair : mUriTextureCache) createTexture(pair.second.get());
+    for (auto& pair : mBufferTextureCache) create(pair.second.get());
+    for (auto& pair : mUriTextureCache) create(pair.second.get());
 
     // Bind the textures to material instances.
     for (auto slot : asset->mTextureSlots) {
         bindTextureToMaterial(slot);
     }
+    for (Texture* placeholder : mPlaceholders) {
+        if (placeholder) {
+            asset->mDependencyGraph.markAsReady(placeholder);
+        }
+    }
 
-    // Before creating jobs for PNG / JPEG decoding, we might need to return early. On single
+    // Before creating jobs for image decoding, we might need to return early. On single
     // threaded systems, it is usually fine to create jobs because the job system will simply
     // execute serially. However if the client requests async behavior, then we need to wait
     // until subsequent calls to asyncUpdateLoad().
@@ -794,49 +1373,14 @@ bool ResourceLoader::Impl::createTextures(bool async) {
     // the texture decoding process.
     FFilamentAsset::SourceHandle retainSourceAsset = asset->mSourceAsset;
 
-    // Kick off jobs that decode texels from buffer pointers.
-    for (auto& pair : mBufferTextureCache) {
-        const uint8_t* sourceData = (const uint8_t*) pair.first;
-        TextureCacheEntry* entry = pair.second.get();
-        JobSystem::Job* decode = jobs::createJob(*js, parent, [retainSourceAsset, entry, sourceData] {
-            int width, height, comp;
-            entry->texels = stbi_load_from_memory(sourceData, entry->bufferSize,
-                    &width, &height, &comp, 4);
-        });
-        js->run(decode);
-    }
-
-    // Kick off jobs that decode texels from URI strings.
-    for (auto& pair : mUriTextureCache) {
-        auto uri = pair.first;
-        TextureCacheEntry* entry = pair.second.get();
-
-        // First, check the user-supplied resource cache for this URI.
-        auto iter = mUriDataCache.find(uri);
-        if (iter != mUriDataCache.end()) {
-            const uint8_t* sourceData = (const uint8_t*) iter->second.buffer;
-            JobSystem::Job* decode = jobs::createJob(*js, parent, [retainSourceAsset, entry, sourceData, iter] {
-                int width, height, comp;
-                entry->texels = stbi_load_from_memory(sourceData, iter->second.size, &width,
-                        &height, &comp, 4);
-            });
-            js->run(decode);
-            continue;
-        }
-
-        // Otherwise load it from the file system if this platform supports it.
-        #if !USE_FILESYSTEM
-            slog.e << "Unable to load texture: " << uri << io::endl;
-            return false;
-        #else
-            Path fullpath = Path(mGltfPath).getParent() + uri;
-            JobSystem::Job* decode = jobs::createJob(*js, parent, [retainSourceAsset, entry, fullpath] {
-                int width, height, comp;
-                entry->texels = stbi_load(fullpath.c_str(), &width, &height, &comp, 4);
-            });
-            js->run(decode);
-        #endif
-    }
+    // Kick off a job for each image, which decodes its large levels in several bands.
+    auto decode = [js, parent, retainSourceAsset](TextureCacheEntry* entry) {
+        js->run(jobs::createJob(*js, parent, [retainSourceAsset, entry, js] {
+            entry->texels = decodeTexels(*js, *entry);
+        }));
+    };
+    for (auto& pair : mBufferTextureCache) decode(pair.second.get());
+    for (auto& pair : mUriTextureCache) decode(pair.second.get());
 
     if (async) {
         mDecoderRootJob = js->runAndRetain(parent);
@@ -853,7 +1397,41 @@ bool ResourceLoader::Impl::createTextures(bool async) {
     return true;
 }
 
-void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
+#if USE_FILESYSTEM
+bool ResourceLoader::Impl::mapBuffers(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+    cgltf_data* gltf = asset->mSourceAsset->hierarchy;
+    for (cgltf_size i = 0; i < gltf->buffers_count; ++i) {
+        cgltf_buffer& buffer = gltf->buffers[i];
+        if (buffer.data || !buffer.uri) {
+            continue;
+        }
+        // Data URIs and remote URIs are left to cgltf_load_buffers.
+        if (strncmp(buffer.uri, "data:", 5) == 0 || strstr(buffer.uri, "://")) {
+            continue;
+        }
+        std::string decoded = buffer.uri;
+        cgltf_decode_uri(&decoded[0]);
+        decoded.resize(strlen(decoded.c_str()));
+        Path fullpath = Path(mGltfPath).getParent() + decoded;
+        BufferDescriptor mapping = mapFile(fullpath.c_str());
+        if (!mapping.buffer) {
+            return false;
+        }
+        if (mapping.size < buffer.size) {
+            slog.e << "Bad size for " << buffer.uri << io::endl;
+            return false;
+        }
+        buffer.data = mapping.buffer;
+        asset->mSourceAsset->mappedFiles.push_back(std::move(mapping));
+    }
+    return true;
+}
+#endif
+
+void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset,
+        const std::vector<BufferSlot>& slots,
+        const std::vector<std::pair<const cgltf_primitive*, VertexBuffer*>>& primitives) {
     SYSTRACE_CALL();
 
     const cgltf_accessor* kGenerateTangents = &asset->mGenerateTangents;
@@ -862,7 +1440,7 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     // Collect all TANGENT vertex attribute slots that need to be populated.
     tsl::robin_map<VertexBuffer*, uint8_t> baseTangents;
     tsl::robin_map<VertexBuffer*, uint8_t> morphTangents[4];
-    for (auto slot : asset->mBufferSlots) {
+    for (const auto& slot : slots) {
         if (slot.accessor != kGenerateTangents && slot.accessor != kGenerateNormals) {
             continue;
         }
@@ -876,7 +1454,7 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     // Create a job description for each primitive.
     using Params = TangentsJob::Params;
     std::vector<Params> jobParams;
-    for (auto pair : asset->mPrimitives) {
+    for (const auto& pair : primitives) {
         VertexBuffer* vb = pair.second;
         auto iter = baseTangents.find(vb);
         if (iter != baseTangents.end()) {
@@ -911,6 +1489,115 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     }
 }
 
+void ResourceLoader::Impl::preparePrimitiveUploads(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+
+    // Finish any geometry that is still pending from a previous progressive load.
+    while (mNumPrimitivesUploaded < mPendingPrimitives.size()) {
+        uploadPendingPrimitives();
+    }
+    cancelPrimitiveUploads();
+
+    // Index buffer slots do not know about their vertex buffer, so build a reverse mapping.
+    tsl::robin_map<IndexBuffer*, VertexBuffer*> indexToVertex;
+    for (const auto& pair : asset->mMeshCache) {
+        for (const Primitive& prim : pair.second) {
+            if (prim.indices) {
+                indexToVertex[prim.indices] = prim.vertices;
+            }
+        }
+    }
+
+    // Group the slots by vertex buffer, in the order in which the loader created them. This
+    // matches the traversal order of the scene, which tends to put the root meshes first.
+    tsl::robin_map<VertexBuffer*, size_t> groups;
+    for (const auto& slot : asset->mBufferSlots) {
+        VertexBuffer* vb = slot.vertexBuffer ? slot.vertexBuffer : indexToVertex[slot.indexBuffer];
+        auto iter = groups.find(vb);
+        size_t index;
+        if (iter == groups.end()) {
+            index = mPendingPrimitives.size();
+            groups[vb] = index;
+            mPendingPrimitives.push_back({ vb });
+        } else {
+            index = iter->second;
+        }
+        PendingPrimitive& pending = mPendingPrimitives[index];
+        pending.slots.push_back(slot);
+        if (slot.accessor->buffer_view) {
+            pending.byteCount += computeBindingSize(slot.accessor);
+        }
+    }
+    for (const auto& pair : asset->mPrimitives) {
+        if (auto iter = groups.find(pair.second); iter != groups.end()) {
+            mPendingPrimitives[iter->second].primitives.push_back(pair);
+        }
+    }
+
+    // Make each renderable wait for all of its vertex buffers.
+    auto addEdges = [asset](const NodeMap& nodeMap) {
+        for (const auto& pair : nodeMap) {
+            const cgltf_mesh* mesh = pair.first->mesh;
+            auto iter = mesh ? asset->mMeshCache.find(mesh) : asset->mMeshCache.end();
+            if (iter == asset->mMeshCache.end()) {
+                continue;
+            }
+            for (const Primitive& prim : iter->second) {
+                if (prim.vertices) {
+                    asset->mDependencyGraph.addEdge(pair.second, prim.vertices);
+                }
+            }
+        }
+    };
+    if (asset->isInstanced()) {
+        for (FFilamentInstance* instance : asset->mInstances) {
+            addEdges(instance->nodeMap);
+        }
+    } else {
+        addEdges(asset->mNodeMap);
+    }
+
+    mProgressiveSource = asset->mSourceAsset;
+}
+
+void ResourceLoader::Impl::uploadPendingPrimitives() {
+    if (mNumPrimitivesUploaded == mPendingPrimitives.size()) {
+        return;
+    }
+    SYSTRACE_CALL();
+    FFilamentAsset* asset = mCurrentAsset;
+    size_t uploadedBytes = 0;
+    while (mNumPrimitivesUploaded < mPendingPrimitives.size()) {
+        PendingPrimitive& pending = mPendingPrimitives[mNumPrimitivesUploaded];
+        if (uploadedBytes > 0 && uploadedBytes + pending.byteCount > mProgressiveUploadBudget) {
+            break;
+        }
+        for (const auto& slot : pending.slots) {
+            uploadBufferSlot(*mEngine, asset, mProgressiveSource, slot);
+            if (slot.accessor->is_sparse) {
+                uploadSparseSlot(*mEngine, asset, slot);
+            }
+        }
+        computeTangents(asset, pending.slots, pending.primitives);
+        asset->mDependencyGraph.markAsReady(pending.vertexBuffer);
+        uploadedBytes += pending.byteCount;
+        mNumPrimitivesUploaded++;
+
+        // Free the slot lists right away but keep the entry, it is still counted for progress.
+        pending.slots = {};
+        pending.primitives = {};
+    }
+    if (mNumPrimitivesUploaded == mPendingPrimitives.size()) {
+        mProgressiveSource.reset();
+    }
+}
+
+void ResourceLoader::Impl::cancelPrimitiveUploads() {
+    mPendingPrimitives.clear();
+    mNumPrimitivesUploaded = 0;
+    mProgressiveSource.reset();
+}
+
 ResourceLoader::Impl::~Impl() {
     if (mDecoderRootJob) {
         mEngine->getJobSystem().waitAndRelease(mDecoderRootJob);
@@ -918,19 +1605,10 @@ ResourceLoader::Impl::~Impl() {
 }
 
 void ResourceLoader::applySparseData(FFilamentAsset* asset) const {
-    for (auto slot : asset->mBufferSlots) {
-        const cgltf_accessor* accessor = slot.accessor;
-        if (!accessor->is_sparse) {
-            continue;
+    for (const auto& slot : asset->mBufferSlots) {
+        if (slot.accessor->is_sparse) {
+            uploadSparseSlot(*pImpl->mEngine, asset, slot);
         }
-        cgltf_size numFloats = accessor->count * cgltf_num_components(accessor->type);
-        cgltf_size numBytes = sizeof(float) * numFloats;
-        float* generated = (float*) malloc(numBytes);
-        cgltf_accessor_unpack_floats(accessor, generated, numFloats);
-        BufferObject* bo = BufferObject::Builder().size(numBytes).build(*asset->mEngine);
-        asset->mBufferObjects.push_back(bo);
-        bo->setBuffer(*pImpl->mEngine, BufferDescriptor(generated, numBytes, FREE_CALLBACK));
-        slot.vertexBuffer->setBufferObjectAt(*pImpl->mEngine, slot.bufferIndex, bo);
     }
 }
 
@@ -966,6 +1644,149 @@ void ResourceLoader::normalizeSkinningWeights(FFilamentAsset* asset) const {
     }
 }
 
+void ResourceLoader::optimizeMeshes(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+    const cgltf_data* gltf = asset->mSourceAsset->hierarchy;
+
+    // Reordering data that is shared with another primitive, or that aliases the bytes of any
+    // other data, would corrupt it.
+    const tsl::robin_set<const cgltf_accessor*> exclusive =
+            MeshOptimizerJob::findExclusiveAccessors(*gltf);
+    auto isExclusive = [&exclusive](const cgltf_accessor* accessor) {
+        return exclusive.find(accessor) != exclusive.end();
+    };
+
+    // Collect the primitives that can be optimized. The index buffer is always rewritten, so it
+    // must be exclusive. The vertices are reordered only if all attributes are exclusive too.
+    std::vector<MeshOptimizerJob::Params> tasks;
+    for (cgltf_size mindex = 0; mindex < gltf->meshes_count; ++mindex) {
+        const cgltf_mesh& mesh = gltf->meshes[mindex];
+        for (cgltf_size pindex = 0; pindex < mesh.primitives_count; ++pindex) {
+            cgltf_primitive* prim = &mesh.primitives[pindex];
+            if (!MeshOptimizerJob::isSupported(*prim) || !isExclusive(prim->indices)) {
+                continue;
+            }
+            bool remapVertices = true;
+            for (cgltf_size aindex = 0; aindex < prim->attributes_count; ++aindex) {
+                remapVertices = remapVertices && isExclusive(prim->attributes[aindex].data);
+            }
+            for (cgltf_size tindex = 0; tindex < prim->targets_count; ++tindex) {
+                const cgltf_morph_target& target = prim->targets[tindex];
+                for (cgltf_size aindex = 0; aindex < target.attributes_count; ++aindex) {
+                    remapVertices = remapVertices && isExclusive(target.attributes[aindex].data);
+                }
+            }
+            tasks.push_back({{ prim, remapVertices, pImpl->mCompactIndices }});
+        }
+    }
+
+    // Kick off an optimization job for every primitive.
+    JobSystem* js = &pImpl->mEngine->getJobSystem();
+    JobSystem::Job* parent = js->createJob();
+    for (auto& task : tasks) {
+        MeshOptimizerJob::Params* params = &task;
+        js->run(jobs::createJob(*js, parent, [params] {
+            MeshOptimizerJob::run(params);
+        }));
+    }
+    js->runAndWait(parent);
+
+    // Gather statistics, weighting the cache miss ratio of each primitive by its triangle count.
+    MeshOptimizationStats& stats = pImpl->mMeshOptimizationStats;
+    tsl::robin_set<const cgltf_accessor*> compacted;
+    double acmrBefore = 0, acmrAfter = 0;
+    for (const auto& job : tasks) {
+        if (!job.out.optimized) {
+            continue;
+        }
+        const size_t triangleCount = job.in.prim->indices->count / 3;
+        stats.optimizedPrimitiveCount++;
+        stats.remappedPrimitiveCount += job.in.remapVertices ? 1 : 0;
+        stats.triangleCount += triangleCount;
+        acmrBefore += double(job.out.acmrBefore) * triangleCount;
+        acmrAfter += double(job.out.acmrAfter) * triangleCount;
+        if (job.out.compacted) {
+            compacted.insert(job.in.prim->indices);
+        }
+    }
+    if (stats.triangleCount > 0) {
+        stats.acmrBefore = float(acmrBefore / stats.triangleCount);
+        stats.acmrAfter = float(acmrAfter / stats.triangleCount);
+    }
+    stats.compactedIndexBufferCount = compacted.size();
+
+    if (GLTFIO_VERBOSE) {
+        slog.i << "Optimized " << stats.optimizedPrimitiveCount << " primitives, ACMR "
+                << stats.acmrBefore << " => " << stats.acmrAfter << io::endl;
+    }
+
+    if (compacted.empty()) {
+        return;
+    }
+
+    // The IndexBuffer objects for narrowed accessors were created by AssetLoader with 32-bit
+    // indices, so they need to be replaced, both in the asset and in its renderables.
+    Engine& engine = *pImpl->mEngine;
+    tsl::robin_map<IndexBuffer*, IndexBuffer*> replacements;
+    for (auto iter = asset->mMeshCache.begin(); iter != asset->mMeshCache.end(); ++iter) {
+        const cgltf_mesh* mesh = iter->first;
+        std::vector<Primitive>& prims = iter.value();
+        for (size_t index = 0; index < prims.size(); ++index) {
+            const cgltf_accessor* accessor = mesh->primitives[index].indices;
+            if (!prims[index].indices || compacted.find(accessor) == compacted.end()) {
+                continue;
+            }
+            IndexBuffer* indices = IndexBuffer::Builder()
+                .indexCount(accessor->count)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(engine);
+            replacements[prims[index].indices] = indices;
+            prims[index].indices = indices;
+        }
+    }
+    for (auto& slot : asset->mBufferSlots) {
+        if (auto iter = replacements.find(slot.indexBuffer); iter != replacements.end()) {
+            slot.indexBuffer = iter->second;
+        }
+    }
+    for (auto& indices : asset->mIndexBuffers) {
+        if (auto iter = replacements.find(indices); iter != replacements.end()) {
+            engine.destroy(indices);
+            indices = iter->second;
+        }
+    }
+
+    auto& rm = engine.getRenderableManager();
+    auto updateRenderables = [&](const NodeMap& nodeMap) {
+        for (const auto& pair : nodeMap) {
+            const cgltf_mesh* mesh = pair.first->mesh;
+            auto iter = mesh ? asset->mMeshCache.find(mesh) : asset->mMeshCache.end();
+            if (iter == asset->mMeshCache.end() || !rm.hasComponent(pair.second)) {
+                continue;
+            }
+            auto renderable = rm.getInstance(pair.second);
+            const std::vector<Primitive>& prims = iter->second;
+            for (size_t index = 0; index < prims.size(); ++index) {
+                const cgltf_accessor* accessor = mesh->primitives[index].indices;
+                RenderableManager::PrimitiveType primType;
+                if (!prims[index].indices || compacted.find(accessor) == compacted.end() ||
+                        !getPrimitiveType(mesh->primitives[index].type, &primType)) {
+                    continue;
+                }
+                rm.setGeometryAt(renderable, index, primType, prims[index].vertices,
+                        prims[index].indices, 0, accessor->count);
+            }
+        }
+    };
+    if (asset->isInstanced()) {
+        for (FFilamentInstance* instance : asset->mInstances) {
+            updateRenderables(instance->nodeMap);
+        }
+    } else {
+        updateRenderables(asset->mNodeMap);
+    }
+}
+
 void ResourceLoader::updateBoundingBoxes(FFilamentAsset* asset) const {
     SYSTRACE_CALL();
     auto& rm = pImpl->mEngine->getRenderableManager();
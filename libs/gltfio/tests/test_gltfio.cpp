@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../src/MeshOptimizerJob.h"
+
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+using namespace gltfio;
+
+// A hand-built asset with a single buffer and a mesh made of two quads. Each quad has its own
+// index accessor and its own position accessor; tests move the accessors around in the buffer.
+class MeshOptimizerTest : public testing::Test {
+protected:
+    static constexpr cgltf_size kVertexSize = 3 * sizeof(float);
+
+    void SetUp() override {
+        mBytes.resize(512);
+        mBuffer.size = mBytes.size();
+        mBuffer.data = mBytes.data();
+        mView.buffer = &mBuffer;
+        mView.size = mBytes.size();
+
+        const uint16_t indices[] = { 3, 1, 2, 2, 1, 0 };
+        for (int i = 0; i < 2; i++) {
+            cgltf_accessor& index = mAccessors[i * 2];
+            index.component_type = cgltf_component_type_r_16u;
+            index.type = cgltf_type_scalar;
+            index.offset = 400 + i * sizeof(indices);
+            index.count = 6;
+            index.stride = sizeof(uint16_t);
+            index.buffer_view = &mView;
+            memcpy(mBytes.data() + index.offset, indices, sizeof(indices));
+
+            cgltf_accessor& position = mAccessors[i * 2 + 1];
+            position.component_type = cgltf_component_type_r_32f;
+            position.type = cgltf_type_vec3;
+            position.offset = i * 4 * kVertexSize;
+            position.count = 4;
+            position.stride = kVertexSize;
+            position.buffer_view = &mView;
+
+            mAttributes[i].type = cgltf_attribute_type_position;
+            mAttributes[i].data = &position;
+            mPrimitives[i].type = cgltf_primitive_type_triangles;
+            mPrimitives[i].indices = &index;
+            mPrimitives[i].attributes = &mAttributes[i];
+            mPrimitives[i].attributes_count = 1;
+        }
+        mMesh.primitives = mPrimitives;
+        mMesh.primitives_count = 2;
+
+        mData.meshes = &mMesh;
+        mData.meshes_count = 1;
+        mData.accessors = mAccessors;
+        mData.accessors_count = 4;
+        mData.buffer_views = &mView;
+        mData.buffer_views_count = 1;
+        mData.buffers = &mBuffer;
+        mData.buffers_count = 1;
+    }
+
+    bool isExclusive(const cgltf_accessor* accessor) const {
+        auto exclusive = MeshOptimizerJob::findExclusiveAccessors(mData);
+        return exclusive.find(accessor) != exclusive.end();
+    }
+
+    const cgltf_accessor* indices(int prim) const { return mPrimitives[prim].indices; }
+    const cgltf_accessor* positions(int prim) const { return mPrimitives[prim].attributes[0].data; }
+
+    std::vector<uint8_t> mBytes;
+    cgltf_buffer mBuffer = {};
+    cgltf_buffer_view mView = {};
+    cgltf_accessor mAccessors[4] = {};
+    cgltf_attribute mAttributes[2] = {};
+    cgltf_primitive mPrimitives[2] = {};
+    cgltf_mesh mMesh = {};
+    cgltf_data mData = {};
+};
+
+TEST_F(MeshOptimizerTest, DisjointAccessors) { // NOLINT
+    for (int prim = 0; prim < 2; prim++) {
+        EXPECT_TRUE(MeshOptimizerJob::isSupported(mPrimitives[prim]));
+        EXPECT_TRUE(isExclusive(indices(prim)));
+        EXPECT_TRUE(isExclusive(positions(prim)));
+    }
+}
+
+TEST_F(MeshOptimizerTest, SharedAccessor) { // NOLINT
+    mAttributes[1].data = mAttributes[0].data;
+    EXPECT_FALSE(isExclusive(positions(0)));
+    EXPECT_TRUE(isExclusive(indices(0)));
+    EXPECT_TRUE(isExclusive(indices(1)));
+}
+
+TEST_F(MeshOptimizerTest, AliasingAccessors) { // NOLINT
+    // The second quad reads the last three vertices of the first one through another accessor.
+    mAccessors[3].offset = kVertexSize;
+    EXPECT_FALSE(isExclusive(positions(0)));
+    EXPECT_FALSE(isExclusive(positions(1)));
+    EXPECT_TRUE(isExclusive(indices(0)));
+    EXPECT_TRUE(isExclusive(indices(1)));
+
+    // Both accessors start at the same byte.
+    mAccessors[3].offset = 0;
+    EXPECT_FALSE(isExclusive(positions(0)));
+    EXPECT_FALSE(isExclusive(positions(1)));
+
+    // Interleaved accessors don't alias as long as their elements don't overlap.
+    mAccessors[1].stride = mAccessors[3].stride = 2 * kVertexSize;
+    mAccessors[3].offset = kVertexSize;
+    EXPECT_TRUE(isExclusive(positions(0)));
+    EXPECT_TRUE(isExclusive(positions(1)));
+
+    mAccessors[3].offset = 2 * kVertexSize + 4;
+    EXPECT_FALSE(isExclusive(positions(0)));
+    EXPECT_FALSE(isExclusive(positions(1)));
+
+    // Adjacent accessors don't.
+    mAccessors[1].stride = mAccessors[3].stride = kVertexSize;
+    mAccessors[3].offset = 4 * kVertexSize;
+    EXPECT_TRUE(isExclusive(positions(0)));
+    EXPECT_TRUE(isExclusive(positions(1)));
+}
+
+TEST_F(MeshOptimizerTest, AliasingImage) { // NOLINT
+    // An embedded image overlaps the indices of the second quad.
+    cgltf_buffer_view view = {};
+    view.buffer = &mBuffer;
+    view.offset = 420;
+    view.size = 16;
+    cgltf_image image = {};
+    image.buffer_view = &view;
+    mData.images = &image;
+    mData.images_count = 1;
+    EXPECT_TRUE(isExclusive(indices(0)));
+    EXPECT_FALSE(isExclusive(indices(1)));
+}
+
+TEST_F(MeshOptimizerTest, AliasedDataIsPreserved) { // NOLINT
+    mAccessors[3].offset = kVertexSize;
+    float* vertices = (float*) mBytes.data();
+    for (int i = 0; i < 15; i++) {
+        vertices[i] = float(i);
+    }
+    const std::vector<uint8_t> before = mBytes;
+
+    // Optimize the primitives the way ResourceLoader does: the indices are rewritten, but since
+    // the positions alias each other, the vertices must not be reordered.
+    for (int prim = 0; prim < 2; prim++) {
+        MeshOptimizerJob::Params params = {{ &mPrimitives[prim],
+                isExclusive(positions(prim)), false }};
+        MeshOptimizerJob::run(&params);
+        EXPECT_TRUE(params.out.optimized);
+    }
+    EXPECT_EQ(memcmp(before.data(), mBytes.data(), 5 * kVertexSize), 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
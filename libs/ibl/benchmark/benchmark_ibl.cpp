@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+#include <ibl/utilities.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/mat3.h>
+#include <math/scalar.h>
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+
+static constexpr size_t ENVIRONMENT_SIZE = 256;
+static constexpr size_t OUTPUT_SIZE = 64;
+static constexpr size_t SAMPLE_COUNT = 1024;
+
+static const float ROUGHNESSES[] = { 0.05f, 0.25f, 1.0f };
+static const char* const QUALITY_NAMES[] = { "low", "medium", "high" };
+
+static utils::JobSystem& getJobSystem() {
+    static utils::JobSystem* js = []() {
+        auto* js = new utils::JobSystem();
+        js->adopt();
+        return js;
+    }();
+    return *js;
+}
+
+struct Environment {
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+};
+
+// Builds a sky with a small and very bright sun, and a checkered ground, so that both the
+// smooth and the high frequency parts of the filters are exercised, only once.
+static Environment const& getEnvironment() {
+    static Environment environment = []() {
+        utils::JobSystem& js = getJobSystem();
+        Environment env;
+        Image image;
+        Cubemap cm = CubemapUtils::create(image, ENVIRONMENT_SIZE);
+        const float3 sun = normalize(float3{ 0.3f, 0.6f, -0.7f });
+        for (size_t f = 0; f < 6; f++) {
+            const Cubemap::Face face = Cubemap::Face(f);
+            for (size_t y = 0; y < ENVIRONMENT_SIZE; y++) {
+                for (size_t x = 0; x < ENVIRONMENT_SIZE; x++) {
+                    const float3 d = cm.getDirectionFor(face, x, y);
+                    float3 c;
+                    if (d.y >= 0) {
+                        c = mix(float3{ 0.8f, 0.9f, 1.0f }, float3{ 0.2f, 0.4f, 0.9f }, d.y);
+                        c += 100.0f * std::pow(std::max(dot(d, sun), 0.0f), 2048.0f);
+                    } else {
+                        const bool odd = (std::sin(16.0f * d.x) > 0) != (std::sin(16.0f * d.z) > 0);
+                        c = odd ? float3{ 0.3f, 0.25f, 0.2f } : float3{ 0.05f };
+                    }
+                    Cubemap::writeAt(cm.getImageForFace(face).getPixelRef(x, y), c);
+                }
+            }
+        }
+        cm.makeSeamless();
+        env.images.push_back(std::move(image));
+        env.levels.push_back(std::move(cm));
+
+        size_t dim = ENVIRONMENT_SIZE;
+        while (dim > 1) {
+            dim >>= 1u;
+            Image temp;
+            Cubemap dst = CubemapUtils::create(temp, dim);
+            CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, env.levels.back());
+            dst.makeSeamless();
+            env.images.push_back(std::move(temp));
+            env.levels.push_back(std::move(dst));
+        }
+        return env;
+    }();
+    return environment;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reference implementation: this is how the filters were computed before they were tiled and
+// vectorized, one texel and one sample at a time. The benchmarks below measure how far the
+// current implementation is from it.
+// ------------------------------------------------------------------------------------------------
+
+static float3 hemisphereImportanceSampleDggx(float2 u, float a) {
+    const float phi = 2.0f * (float) F_PI * u.x;
+    const float cosTheta2 = (1 - u.y) / (1 + (a + 1) * ((a - 1) * u.y));
+    const float cosTheta = std::sqrt(cosTheta2);
+    const float sinTheta = std::sqrt(1 - cosTheta2);
+    return { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+}
+
+static float3 hemisphereCosSample(float2 u) {
+    const float phi = 2.0f * (float) F_PI * u.x;
+    const float cosTheta2 = 1 - u.y;
+    const float cosTheta = std::sqrt(cosTheta2);
+    const float sinTheta = std::sqrt(1 - cosTheta2);
+    return { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+}
+
+static float DistributionGGX(float NoH, float linearRoughness) {
+    float a = linearRoughness;
+    float f = (a - 1) * ((a + 1) * (NoH * NoH)) + 1;
+    return (a * a) / ((float) F_PI * f * f);
+}
+
+struct ReferenceSample {
+    float3 L;
+    float weight;
+    float lerp;
+    uint8_t l0;
+    uint8_t l1;
+};
+
+static void referenceFilter(Cubemap& dst, std::vector<Cubemap> const& levels,
+        std::vector<ReferenceSample> const& cache, bool rotate) {
+    utils::JobSystem& js = getJobSystem();
+    auto processFaces = [&](size_t first, size_t count) {
+        for (size_t faceIndex = first; faceIndex < first + count; faceIndex++) {
+            const Cubemap::Face f = Cubemap::Face(faceIndex);
+            std::default_random_engine gen;
+            std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
+            const size_t dim = dst.getDimensions();
+            for (size_t y = 0; y < dim; y++) {
+                auto* data = static_cast<Cubemap::Texel*>(
+                        dst.getImageForFace(f).getPixelRef(0, y));
+                for (size_t x = 0; x < dim; ++x, ++data) {
+                    const float3 N(dst.getDirectionFor(f, x, y));
+                    const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                    mat3 R;
+                    R[0] = normalize(cross(up, N));
+                    R[1] = cross(N, R[0]);
+                    R[2] = N;
+                    if (rotate) {
+                        R *= mat3f::rotation(distribution(gen), float3{ 0, 0, 1 });
+                    }
+                    float3 Li = 0;
+                    for (ReferenceSample const& e : cache) {
+                        const float3 L(R * e.L);
+                        Li += Cubemap::trilinearFilterAt(levels[e.l0], levels[e.l1], e.lerp, L)
+                                * e.weight;
+                    }
+                    Cubemap::writeAt(data, Cubemap::Texel(Li));
+                }
+            }
+        }
+    };
+    auto job = utils::jobs::parallel_for(js, nullptr, 0, 6, std::ref(processFaces),
+            utils::jobs::CountSplitter<1, 8>());
+    js.runAndWait(job);
+}
+
+static float getMipLevel(std::vector<Cubemap> const& levels, float pdf) {
+    const size_t dim0 = levels[0].getDimensions();
+    const float omegaP = (4.0f * (float) F_PI) / float(6 * dim0 * dim0);
+    const float omegaS = 1 / (SAMPLE_COUNT * pdf);
+    const float l = float(log4(omegaS) - log4(omegaP) + log4(4.0f));
+    return clamp(l, 0.0f, float(levels.size() - 1));
+}
+
+static ReferenceSample makeSample(std::vector<Cubemap> const& levels, float3 L, float weight,
+        float mipLevel) {
+    const uint8_t l0 = uint8_t(mipLevel);
+    const uint8_t l1 = uint8_t(std::min(levels.size() - 1, size_t(l0 + 1)));
+    return { L, weight, mipLevel - float(l0), l0, l1 };
+}
+
+static void referenceRoughnessFilter(Cubemap& dst, std::vector<Cubemap> const& levels,
+        float linearRoughness) {
+    std::vector<ReferenceSample> cache;
+    float weight = 0;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        const float3 H = hemisphereImportanceSampleDggx(
+                hammersley(uint32_t(i), 1.0f / SAMPLE_COUNT), linearRoughness);
+        const float NoL = 2 * H.z * H.z - 1;
+        if (NoL > 0) {
+            const float pdf = DistributionGGX(H.z, linearRoughness) / 4;
+            const float3 L(2 * H.z * H.x, 2 * H.z * H.y, NoL);
+            cache.push_back(makeSample(levels, L, NoL, getMipLevel(levels, pdf)));
+            weight += NoL;
+        }
+    }
+    for (auto& entry : cache) {
+        entry.weight *= 1.0f / weight;
+    }
+    std::sort(cache.begin(), cache.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.weight < rhs.weight;
+    });
+    referenceFilter(dst, levels, cache, true);
+}
+
+static void referenceDiffuseIrradiance(Cubemap& dst, std::vector<Cubemap> const& levels) {
+    std::vector<ReferenceSample> cache;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        const float3 L = hemisphereCosSample(hammersley(uint32_t(i), 1.0f / SAMPLE_COUNT));
+        if (L.z > 0) {
+            const float pdf = L.z * (float) F_1_PI;
+            cache.push_back(makeSample(levels, L, 1.0f / SAMPLE_COUNT, getMipLevel(levels, pdf)));
+        }
+    }
+    referenceFilter(dst, levels, cache, false);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+struct Result {
+    Image image;
+    Cubemap cubemap{ OUTPUT_SIZE };
+};
+
+// Root mean square of the difference between two results, relative to the average value of the
+// reference.
+static double getError(Cubemap const& result, Cubemap const& reference) {
+    double error = 0;
+    double sum = 0;
+    for (size_t f = 0; f < 6; f++) {
+        const Cubemap::Face face = Cubemap::Face(f);
+        for (size_t y = 0; y < OUTPUT_SIZE; y++) {
+            for (size_t x = 0; x < OUTPUT_SIZE; x++) {
+                const float3 a = Cubemap::sampleAt(result.getImageForFace(face).getPixelRef(x, y));
+                const float3 b = Cubemap::sampleAt(reference.getImageForFace(face).getPixelRef(x, y));
+                const float3 d = a - b;
+                error += dot(d, d) / 3.0;
+                sum += (b.r + b.g + b.b) / 3.0;
+            }
+        }
+    }
+    const double count = 6.0 * OUTPUT_SIZE * OUTPUT_SIZE;
+    return std::sqrt(error / count) / (sum / count);
+}
+
+static Cubemap const& getReferenceRoughness(size_t index) {
+    static std::map<size_t, Result> results;
+    auto pos = results.find(index);
+    if (pos == results.end()) {
+        Result& result = results[index];
+        result.cubemap = CubemapUtils::create(result.image, OUTPUT_SIZE);
+        referenceRoughnessFilter(result.cubemap, getEnvironment().levels, ROUGHNESSES[index]);
+        return result.cubemap;
+    }
+    return pos->second.cubemap;
+}
+
+static Cubemap const& getReferenceIrradiance() {
+    static Result result = []() {
+        Result result;
+        result.cubemap = CubemapUtils::create(result.image, OUTPUT_SIZE);
+        referenceDiffuseIrradiance(result.cubemap, getEnvironment().levels);
+        return result;
+    }();
+    return result.cubemap;
+}
+
+static void setLabel(benchmark::State& state, float roughness, const char* quality) {
+    char label[64];
+    snprintf(label, sizeof(label), "roughness %.2f, %s", roughness, quality);
+    state.SetLabel(label);
+}
+
+static void BM_roughnessFilter(benchmark::State& state) {
+    const size_t index = size_t(state.range(0));
+    const auto quality = CubemapIBL::Quality(state.range(1));
+    setLabel(state, ROUGHNESSES[index], QUALITY_NAMES[state.range(1)]);
+
+    utils::JobSystem& js = getJobSystem();
+    Environment const& env = getEnvironment();
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, OUTPUT_SIZE);
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(js, dst, env.levels, ROUGHNESSES[index], SAMPLE_COUNT,
+                float3{ 1 }, true, nullptr, nullptr, quality);
+    }
+    state.counters["error"] = getError(dst, getReferenceRoughness(index));
+}
+
+static void BM_roughnessFilterReference(benchmark::State& state) {
+    const size_t index = size_t(state.range(0));
+    setLabel(state, ROUGHNESSES[index], "reference");
+
+    Environment const& env = getEnvironment();
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, OUTPUT_SIZE);
+    for (auto _ : state) {
+        referenceRoughnessFilter(dst, env.levels, ROUGHNESSES[index]);
+    }
+}
+
+static void BM_diffuseIrradiance(benchmark::State& state) {
+    const auto quality = CubemapIBL::Quality(state.range(0));
+    state.SetLabel(QUALITY_NAMES[state.range(0)]);
+
+    utils::JobSystem& js = getJobSystem();
+    Environment const& env = getEnvironment();
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, OUTPUT_SIZE);
+    for (auto _ : state) {
+        CubemapIBL::diffuseIrradiance(js, dst, env.levels, SAMPLE_COUNT, nullptr, nullptr,
+                quality);
+    }
+    state.counters["error"] = getError(dst, getReferenceIrradiance());
+}
+
+static void BM_diffuseIrradianceReference(benchmark::State& state) {
+    state.SetLabel("reference");
+    Environment const& env = getEnvironment();
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, OUTPUT_SIZE);
+    for (auto _ : state) {
+        referenceDiffuseIrradiance(dst, env.levels);
+    }
+}
+
+static void roughnessAndQuality(benchmark::internal::Benchmark* benchmark) {
+    for (int roughness = 0; roughness < 3; roughness++) {
+        for (int quality = 0; quality < 3; quality++) {
+            benchmark->Args({ roughness, quality });
+        }
+    }
+}
+
+BENCHMARK(BM_roughnessFilter)->Apply(roughnessAndQuality)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_roughnessFilterReference)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_diffuseIrradiance)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_diffuseIrradianceReference)->Unit(benchmark::kMillisecond);
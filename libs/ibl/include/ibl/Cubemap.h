@@ -99,7 +99,7 @@ public:
     inline Texel filterAt(const filament::math::float3& direction) const;
 
     //! samples an image at the given location in pixel using bilinear filtering
-    static Texel filterAt(const Image& image, float x, float y);
+    static inline Texel filterAt(const Image& image, float x, float y);
     static Texel filterAtCenter(const Image& image, size_t x, size_t y);
 
     //! samples two cubemaps in a given direction and lerps the result by a given lerp factor
@@ -186,6 +186,25 @@ inline Cubemap::Texel const& Cubemap::sampleAt(const filament::math::float3& dir
     return sampleAt(getImageForFace(addr.face).getPixelRef(x, y));
 }
 
+inline Cubemap::Texel Cubemap::filterAt(const Image& image, float x, float y) {
+    const size_t x0 = size_t(x);
+    const size_t y0 = size_t(y);
+    // we allow ourselves to read past the width/height of the Image because the data is valid
+    // and contain the "seamless" data.
+    size_t x1 = x0 + 1;
+    size_t y1 = y0 + 1;
+
+    const float u = float(x - x0);
+    const float v = float(y - y0);
+    const float one_minus_u = 1 - u;
+    const float one_minus_v = 1 - v;
+    const Texel& c0 = sampleAt(image.getPixelRef(x0, y0));
+    const Texel& c1 = sampleAt(image.getPixelRef(x1, y0));
+    const Texel& c2 = sampleAt(image.getPixelRef(x0, y1));
+    const Texel& c3 = sampleAt(image.getPixelRef(x1, y1));
+    return (one_minus_u*one_minus_v)*c0 + (u*one_minus_v)*c1 + (one_minus_u*v)*c2 + (u*v)*c3;
+}
+
 inline Cubemap::Texel Cubemap::filterAt(const filament::math::float3& direction) const {
     Cubemap::Address addr(getAddressFor(direction));
     addr.s = std::min(addr.s * mDimensions, mUpperBound);
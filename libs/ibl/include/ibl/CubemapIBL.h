@@ -41,6 +41,17 @@ class CubemapIBL {
 public:
     typedef void (*Progress)(size_t, float, void*);
 
+    /**
+     * Trades the number of samples for speed. Lower qualities take fewer samples, from more
+     * blurred levels of the source environment when prefiltering is enabled, which loses some
+     * sharpness rather than adding noise.
+     */
+    enum class Quality : uint8_t {
+        LOW,        //!< a 16th of the samples
+        MEDIUM,     //!< a quarter of the samples
+        HIGH        //!< all the samples
+    };
+
     /**
      * Computes a roughness LOD using prefiltered importance sampling GGX
      *
@@ -49,11 +60,22 @@ public:
      * @param linearRoughness   roughness
      * @param maxNumSamples     number of samples for importance sampling
      * @param updater           a callback for the caller to track progress
+     * @param quality           fraction of maxNumSamples actually used
+     */
+    static void roughnessFilter(
+            utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+            float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+            Progress updater = nullptr, void* userdata = nullptr,
+            Quality quality = Quality::HIGH);
+
+    /**
+     * Same as above, but only computes the given rows of the destination, so that a cubemap can
+     * be filtered in several steps. Rows are counted over all the faces, from 0 to 6 * dim.
      */
     static void roughnessFilter(
             utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
             float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
-            Progress updater = nullptr, void* userdata = nullptr);
+            size_t firstRow, size_t rowCount, Quality quality = Quality::HIGH);
 
     //! Computes the "DFG" term of the "split-sum" approximation and stores it in a 2D image
     static void DFG(utils::JobSystem& js, Image& dst, bool multiscatter, bool cloth);
@@ -67,11 +89,13 @@ public:
      * @param levels            a list of prefiltered lods of the source environment
      * @param maxNumSamples     number of samples for importance sampling
      * @param updater           a callback for the caller to track progress
+     * @param quality           fraction of maxNumSamples actually used
      *
      * @see CubemapSH
      */
     static void diffuseIrradiance(utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
-            size_t maxNumSamples = 1024, Progress updater = nullptr, void* userdata = nullptr);
+            size_t maxNumSamples = 1024, Progress updater = nullptr, void* userdata = nullptr,
+            Quality quality = Quality::HIGH);
 
     // for debugging. ignore.
     static void brdf(utils::JobSystem& js, Cubemap& dst, float linearRoughness);
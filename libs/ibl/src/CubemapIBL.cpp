@@ -25,10 +25,11 @@
 
 #include <utils/JobSystem.h>
 
-#include <math/mat3.h>
 #include <math/scalar.h>
 
-#include <random>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <vector>
 
 using namespace filament::math;
@@ -181,6 +182,193 @@ static float UTILS_UNUSED VisibilityAshikhmin(float NoV, float NoL, float /*a*/)
     return 1 / (4 * (NoL + NoV - NoL * NoV));
 }
 
+/*
+ * Filtering kernel
+ * ----------------
+ *
+ * Both the roughness and the irradiance filters evaluate a weighted sum of precomputed samples,
+ * rotated into the tangent frame of each texel.
+ *
+ * Texels are filtered in square tiles. All the texels of a tile look up a given sample one after
+ * the other, so these lookups land on the same area of the same level of the source, which stays
+ * in the cache. The sample directions and their cubemap addresses are computed for the whole
+ * tile at once, in SoA form, which lets these loops get vectorized.
+ */
+
+static constexpr size_t TILE_SIZE = 8;
+
+// be careful w/ the size of this structure, the smaller the better
+struct CacheEntry {
+    float3 L;
+    float weight;
+    float lerp;
+    uint8_t l0;
+    uint8_t l1;
+};
+
+static size_t getSampleCount(size_t maxNumSamples, CubemapIBL::Quality quality) {
+    switch (quality) {
+        case CubemapIBL::Quality::LOW:      return std::max(maxNumSamples / 16, size_t(1));
+        case CubemapIBL::Quality::MEDIUM:   return std::max(maxNumSamples / 4, size_t(1));
+        case CubemapIBL::Quality::HIGH:     return maxNumSamples;
+    }
+    return maxNumSamples;
+}
+
+// Rotation around the normal of a texel, used to turn the aliasing of the samples into noise.
+// It only depends on the texel, so the result doesn't depend on how the work is scheduled.
+static float randomAngle(size_t face, size_t x, size_t y, size_t dim) {
+    uint32_t h = uint32_t((face * dim + y) * dim + x);
+    h ^= h >> 16u;
+    h *= 0x7feb352du;
+    h ^= h >> 15u;
+    h *= 0x846ca68bu;
+    h ^= h >> 16u;
+    return float(h) * (2.0f * (float) F_PI / 4294967296.0f) - (float) F_PI;
+}
+
+static void filterTile(Cubemap& dst, const std::vector<Cubemap>& levels,
+        float const* upperBounds, CacheEntry const* cache, size_t numSamples,
+        Cubemap::Face f, size_t x0, size_t y0, size_t w, size_t h,
+        float3 mirror, bool rotate) {
+    constexpr size_t MAX_COUNT = TILE_SIZE * TILE_SIZE;
+    const size_t count = w * h;
+    const size_t dim = dst.getDimensions();
+
+    // tangent frame of each texel
+    float tx[MAX_COUNT], ty[MAX_COUNT], tz[MAX_COUNT];
+    float bx[MAX_COUNT], by[MAX_COUNT], bz[MAX_COUNT];
+    float nx[MAX_COUNT], ny[MAX_COUNT], nz[MAX_COUNT];
+    for (size_t i = 0; i < count; i++) {
+        const size_t x = x0 + i % w;
+        const size_t y = y0 + i / w;
+        const float2 p(Cubemap::center(x, y));
+        const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+        // center the cone around the normal (handle case of normal close to up)
+        const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+        float3 T = normalize(cross(up, N));
+        float3 B = cross(N, T);
+        if (rotate) {
+            const float angle = randomAngle(size_t(f), x, y, dim);
+            const float c = std::cos(angle);
+            const float s = std::sin(angle);
+            const float3 t = T;
+            T = c * t + s * B;
+            B = c * B - s * t;
+        }
+        tx[i] = T.x; ty[i] = T.y; tz[i] = T.z;
+        bx[i] = B.x; by[i] = B.y; bz[i] = B.z;
+        nx[i] = N.x; ny[i] = N.y; nz[i] = N.z;
+    }
+
+    float3 Li[MAX_COUNT];
+    std::fill_n(Li, count, float3{ 0 });
+
+    uint8_t faces[MAX_COUNT];
+    float s[MAX_COUNT];
+    float t[MAX_COUNT];
+    for (size_t sample = 0; sample < numSamples; sample++) {
+        const CacheEntry& e = cache[sample];
+
+        // This computes the same thing as Cubemap::getAddressFor() for all the texels, but it is
+        // written without if statements to avoid branches, which allows it to be vectorized.
+        for (size_t i = 0; i < count; i++) {
+            const float x = tx[i] * e.L.x + bx[i] * e.L.y + nx[i] * e.L.z;
+            const float y = ty[i] * e.L.x + by[i] * e.L.y + ny[i] * e.L.z;
+            const float z = tz[i] * e.L.x + bz[i] * e.L.y + nz[i] * e.L.z;
+            const float ax = std::abs(x);
+            const float ay = std::abs(y);
+            const float az = std::abs(z);
+            const bool isX = ax >= ay && ax >= az;
+            const bool isY = !isX && ay >= az;
+            const float ma = isX ? ax : (isY ? ay : az);
+            const float sc = isX ? (x >= 0 ? -z : z) : (isY ? x : (z >= 0 ? x : -x));
+            const float tc = isY ? (y >= 0 ? z : -z) : -y;
+            const uint8_t face = isX ? (x >= 0 ? 0 : 1) : (isY ? (y >= 0 ? 2 : 3) : (z >= 0 ? 4 : 5));
+            const float ima = 1.0f / ma;
+            faces[i] = face;
+            s[i] = (sc * ima + 1.0f) * 0.5f;
+            t[i] = (tc * ima + 1.0f) * 0.5f;
+        }
+
+        const Cubemap& c0 = levels[e.l0];
+        const Cubemap& c1 = levels[e.l1];
+        const float dim0 = float(c0.getDimensions());
+        const float dim1 = float(c1.getDimensions());
+        const float upperBound0 = upperBounds[e.l0];
+        const float upperBound1 = upperBounds[e.l1];
+        for (size_t i = 0; i < count; i++) {
+            const Cubemap::Face face = Cubemap::Face(faces[i]);
+            float3 c = Cubemap::filterAt(c0.getImageForFace(face),
+                    std::min(s[i] * dim0, upperBound0), std::min(t[i] * dim0, upperBound0));
+            if (e.lerp > 0) {
+                const float3 c2 = Cubemap::filterAt(c1.getImageForFace(face),
+                        std::min(s[i] * dim1, upperBound1), std::min(t[i] * dim1, upperBound1));
+                c += e.lerp * (c2 - c);
+            }
+            Li[i] += c * e.weight;
+        }
+    }
+
+    Image& image = dst.getImageForFace(f);
+    for (size_t i = 0; i < count; i++) {
+        Cubemap::writeAt(image.getPixelRef(x0 + i % w, y0 + i / w), Cubemap::Texel(Li[i]));
+    }
+}
+
+// Filters the rows [firstRow, lastRow) of the destination, counted over all its faces.
+static void filter(JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+        std::vector<CacheEntry> const& cache, float3 mirror, bool rotate,
+        size_t firstRow, size_t lastRow, CubemapIBL::Progress updater, void* userdata) {
+    struct Tile {
+        Cubemap::Face face;
+        uint16_t x0, y0, w, h;
+    };
+
+    const size_t dim = dst.getDimensions();
+    std::vector<Tile> tiles;
+    for (size_t f = firstRow / dim; f < 6 && f * dim < lastRow; f++) {
+        const size_t first = std::max(firstRow, f * dim) - f * dim;
+        const size_t last = std::min(lastRow, (f + 1) * dim) - f * dim;
+        for (size_t y0 = first; y0 < last; y0 += TILE_SIZE) {
+            for (size_t x0 = 0; x0 < dim; x0 += TILE_SIZE) {
+                tiles.push_back({ Cubemap::Face(f), uint16_t(x0), uint16_t(y0),
+                        uint16_t(std::min(TILE_SIZE, dim - x0)),
+                        uint16_t(std::min(TILE_SIZE, last - y0)) });
+            }
+        }
+    }
+
+    std::vector<float> upperBounds(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        upperBounds[i] = std::nextafter(float(levels[i].getDimensions()), 0.0f);
+    }
+
+    std::atomic_uint progress = { 0 };
+    auto processTiles = [&](size_t first, size_t count) {
+        for (size_t i = first; i < first + count; i++) {
+            if (UTILS_UNLIKELY(updater)) {
+                size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
+                updater(0, (float) p / (float) tiles.size(), userdata);
+            }
+            const Tile& tile = tiles[i];
+            filterTile(dst, levels, upperBounds.data(), cache.data(), cache.size(), tile.face,
+                    tile.x0, tile.y0, tile.w, tile.h, mirror, rotate);
+        }
+    };
+
+    // don't use the jobsystem unless we have enough work -- or the overhead of
+    // launching jobs will prevail.
+    if (dim * cache.size() <= 256 || tiles.size() < 2) {
+        processTiles(0, tiles.size());
+    } else {
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(tiles.size()),
+                std::ref(processTiles), jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
+    }
+}
+
 /*
  *
  * Importance sampling GGX - Trowbridge-Reitz
@@ -292,11 +480,14 @@ static float UTILS_UNUSED VisibilityAshikhmin(float NoV, float NoL, float /*a*/)
  *
  */
 
-void CubemapIBL::roughnessFilter(
+static void roughnessFilterRows(
         utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
         float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
-        Progress updater, void* userdata)
+        size_t firstRow, size_t rowCount, CubemapIBL::Progress updater, void* userdata,
+        CubemapIBL::Quality quality)
 {
+    const size_t lastRow = std::min(firstRow + rowCount, 6 * dst.getDimensions());
+    maxNumSamples = getSampleCount(maxNumSamples, quality);
     const float numSamples = maxNumSamples;
     const float inumSamples = 1.0f / numSamples;
     const size_t maxLevel = levels.size()-1;
@@ -321,6 +512,17 @@ void CubemapIBL::roughnessFilter(
                         Cubemap::writeAt(data, cm.sampleAt(N));
                     }
         };
+        if (firstRow != 0 || lastRow != 6 * dst.getDimensions()) {
+            CubemapUtils::EmptyState state;
+            const size_t dim = dst.getDimensions();
+            for (size_t row = firstRow; row < lastRow; row++) {
+                const Cubemap::Face f = Cubemap::Face(row / dim);
+                const size_t y = row % dim;
+                scanline(state, y, f,
+                        static_cast<Cubemap::Texel*>(dst.getImageForFace(f).getPixelRef(0, y)), dim);
+            }
+            return;
+        }
         // at least 256 pixel cubemap before we use multithreading -- the overhead of launching
         // jobs is too large compared to the work above.
         if (dst.getDimensions() <= 256) {
@@ -332,15 +534,6 @@ void CubemapIBL::roughnessFilter(
         return;
     }
 
-    // be careful w/ the size of this structure, the smaller the better
-    struct CacheEntry {
-        float3 L;
-        float brdf_NoL;
-        float lerp;
-        uint8_t l0;
-        uint8_t l1;
-    };
-
     std::vector<CacheEntry> cache;
     cache.reserve(maxNumSamples);
 
@@ -398,61 +591,33 @@ void CubemapIBL::roughnessFilter(
     }
 
     for (auto& entry : cache) {
-        entry.brdf_NoL *= 1.0f / weight;
+        entry.weight *= 1.0f / weight;
     }
 
     // we can sample the cubemap in any order, sort by the weight, it could improve fp precision
     std::sort(cache.begin(), cache.end(), [](CacheEntry const& lhs, CacheEntry const& rhs) {
-        return lhs.brdf_NoL < rhs.brdf_NoL;
+        return lhs.weight < rhs.weight;
     });
 
+    filter(js, dst, levels, cache, mirror, true, firstRow, lastRow, updater, userdata);
+}
 
-    struct State {
-        // maybe blue-noise instead would look even better
-        std::default_random_engine gen;
-        std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
-    };
-
-    auto scanline = [&](State& state, size_t y,
-            Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-        if (UTILS_UNLIKELY(updater)) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float) p / ((float) dim * 6.0f), userdata);
-        }
-        mat3 R;
-        const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
-
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
-
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
-
-            float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
-                const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
-            }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
-        }
-    };
+void CubemapIBL::roughnessFilter(
+        utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+        float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+        Progress updater, void* userdata, Quality quality)
+{
+    roughnessFilterRows(js, dst, levels, linearRoughness, maxNumSamples, mirror, prefilter,
+            0, 6 * dst.getDimensions(), updater, userdata, quality);
+}
 
-    // don't use the jobsystem unless we have enough work per scanline -- or the overhead of
-    // launching jobs will prevail.
-    if (dst.getDimensions() * maxNumSamples <= 256) {
-        CubemapUtils::processSingleThreaded<State>(dst, js, std::ref(scanline));
-    } else {
-        CubemapUtils::process<State>(dst, js, std::ref(scanline));
-    }
+void CubemapIBL::roughnessFilter(
+        utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+        float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+        size_t firstRow, size_t rowCount, Quality quality)
+{
+    roughnessFilterRows(js, dst, levels, linearRoughness, maxNumSamples, mirror, prefilter,
+            firstRow, rowCount, nullptr, nullptr, quality);
 }
 
 /*
@@ -543,8 +708,9 @@ void CubemapIBL::roughnessFilter(
  */
 
 void CubemapIBL::diffuseIrradiance(JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
-        size_t maxNumSamples, CubemapIBL::Progress updater, void* userdata)
+        size_t maxNumSamples, CubemapIBL::Progress updater, void* userdata, Quality quality)
 {
+    maxNumSamples = getSampleCount(maxNumSamples, quality);
     const float numSamples = maxNumSamples;
     const float inumSamples = 1.0f / numSamples;
     const size_t maxLevel = levels.size()-1;
@@ -553,15 +719,6 @@ void CubemapIBL::diffuseIrradiance(JobSystem& js, Cubemap& dst, const std::vecto
     const size_t dim0 = base.getDimensions();
     const float omegaP = (4.0f * (float) F_PI) / float(6 * dim0 * dim0);
 
-    std::atomic_uint progress = {0};
-
-    struct CacheEntry {
-        float3 L;
-        float lerp;
-        uint8_t l0;
-        uint8_t l1;
-    };
-
     std::vector<CacheEntry> cache;
     cache.reserve(maxNumSamples);
 
@@ -585,43 +742,12 @@ void CubemapIBL::diffuseIrradiance(JobSystem& js, Cubemap& dst, const std::vecto
             uint8_t l1 = uint8_t(std::min(maxLevel, size_t(l0 + 1)));
             float lerp = mipLevel - (float) l0;
 
-            cache.push_back({ L, lerp, l0, l1 });
+            cache.push_back({ L, inumSamples, lerp, l0, l1 });
         }
     }
 
-    CubemapUtils::process<CubemapUtils::EmptyState>(dst, js,
-            [&](CubemapUtils::EmptyState&, size_t y,
-                    Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-
-        if (updater) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float)p / ((float) dim * 6.0f), userdata);
-        }
-
-        mat3 R;
-        const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y));
-
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
-
-            float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
-                const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0;
-            }
-            Cubemap::writeAt(data, Cubemap::Texel(Li * inumSamples));
-        }
-    });
+    filter(js, dst, levels, cache, float3{ 1 }, false, 0, 6 * dst.getDimensions(),
+            updater, userdata);
 }
 
 // Not importance-sampled
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_IBL_PREFILTER_PROGRESSIVEIBL_H
+#define TNT_IBL_PREFILTER_PROGRESSIVEIBL_H
+
+#include <filament/Texture.h>
+
+#include <math/vec3.h>
+
+#include <memory>
+
+#include <stdint.h>
+
+namespace filament {
+class Engine;
+} // namespace filament
+
+/**
+ * ProgressiveIBL computes the reflections texture and the irradiance spherical harmonics of an
+ * IndirectLight on the CPU, like Texture::generatePrefilterMipmap() and cmgen do, without
+ * stalling the application for the whole computation.
+ *
+ * setEnvironment() quickly produces a coarse result that can be used right away: the spherical
+ * harmonics are computed from a small level of the environment, the smaller levels of the
+ * reflections are filtered with few samples, and the larger ones are magnified from them.
+ * refine() must then be called once per frame, it improves the result on the engine's JobSystem
+ * for about the given time, and uploads the levels of the reflections texture as they complete.
+ *
+ * Since the reflections texture is updated in place, an IndirectLight using it doesn't need to
+ * be rebuilt.
+ *
+ * Example:
+ *
+ * ```
+ * ProgressiveIBL ibl(*engine, reflections);
+ * ibl.setEnvironment(std::move(buffer), offsets);
+ * IndirectLight* light = IndirectLight::Builder()
+ *         .reflections(reflections)
+ *         .irradiance(3, ibl.getSphericalHarmonics())
+ *         .build(*engine);
+ *
+ * // every frame
+ * ibl.refine(2.0f);
+ * ```
+ */
+class ProgressiveIBL {
+public:
+    struct Config {
+        uint16_t sampleCount = 32;          //!< sample count of the final result
+        uint16_t coarseSampleCount = 8;     //!< sample count of the coarse result
+        uint8_t coarseLevel = 2;            //!< larger levels are magnified in the coarse result
+        bool mirror = true;                 //!< whether the environment must be mirrored
+    };
+
+    /**
+     * Creates a ProgressiveIBL.
+     * @param engine        filament engine to use
+     * @param reflections   Texture receiving the reflections.
+     *                      - Must be a cubemap with a power-of-two size and all its levels
+     *                      - Must not be compressed
+     *                      - Must accept RGB FLOAT data, e.g. R11F_G11F_B10F or RGB16F
+     * @param config        Configuration
+     */
+    ProgressiveIBL(filament::Engine& engine, filament::Texture* reflections, Config config);
+
+    //! Creates a ProgressiveIBL with the default configuration.
+    ProgressiveIBL(filament::Engine& engine, filament::Texture* reflections);
+
+    ~ProgressiveIBL() noexcept;
+
+    ProgressiveIBL(ProgressiveIBL const&) = delete;
+    ProgressiveIBL& operator=(ProgressiveIBL const&) = delete;
+
+    /**
+     * Starts processing a new environment, abandoning the previous one. The coarse result is
+     * computed and uploaded before this returns.
+     *
+     * @param buffer        The environment, with the same constraints as with
+     *                      Texture::generatePrefilterMipmap(). It must have the same size as
+     *                      the reflections texture. Its data is no longer needed when this
+     *                      returns.
+     * @param faceOffsets   Offsets in bytes into \p buffer for all six images. The offsets
+     *                      are specified in the following order: +x, -x, +y, -y, +z, -z
+     */
+    void setEnvironment(filament::Texture::PixelBufferDescriptor&& buffer,
+            filament::Texture::FaceOffsets const& faceOffsets);
+
+    /**
+     * Improves the result for about the given amount of time, always making some progress.
+     * Levels of the reflections texture are uploaded as they complete.
+     *
+     * @param budgetInMs    how long this may take
+     * @return true once the final result is uploaded, in which case refine() doesn't need to be
+     *         called anymore.
+     */
+    bool refine(float budgetInMs);
+
+    //! Returns true when the final result is uploaded.
+    bool isComplete() const noexcept;
+
+    /**
+     * Returns the 9 pre-scaled irradiance spherical harmonics coefficients of the environment,
+     * to be used with IndirectLight::Builder::irradiance(3, sh). They are final as soon as
+     * setEnvironment() returns.
+     */
+    filament::math::float3 const* getSphericalHarmonics() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
+
+#endif //TNT_IBL_PREFILTER_PROGRESSIVEIBL_H
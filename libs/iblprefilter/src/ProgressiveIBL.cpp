@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "filament-iblprefilter/ProgressiveIBL.h"
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+#include <utils/Panic.h>
+#include <utils/Systrace.h>
+#include <utils/algorithm.h>
+
+#include <math/half.h>
+#include <math/scalar.h>
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace ibl;
+using namespace utils;
+
+// Number of rows of the destination cubemap computed by a single refinement step. This is the
+// granularity at which refine() checks its time budget.
+static constexpr size_t ROWS_PER_STEP = 8;
+
+// The spherical harmonics are computed from the first level that is at most this size, they
+// barely change with the resolution of the environment.
+static constexpr size_t SH_MAX_DIMENSIONS = 32;
+
+struct ProgressiveIBL::Impl {
+    struct Task {
+        uint8_t level;
+        uint16_t sampleCount;
+    };
+
+    Impl(Engine& engine, Texture* reflections, Config const& config) noexcept
+            : engine(engine), reflections(reflections), config(config) {
+    }
+
+    float getLinearRoughness(size_t level) const noexcept {
+        if (levelCount == 1) {
+            return 0.0f;
+        }
+        const float lod = saturate(float(level) / float(levelCount - 1));
+        return lod * lod;
+    }
+
+    float3 getMirror() const noexcept {
+        return config.mirror ? float3{ -1, 1, 1 } : float3{ 1, 1, 1 };
+    }
+
+    void filter(Cubemap& dst, size_t level, size_t sampleCount,
+            size_t firstRow, size_t rowCount) {
+        CubemapIBL::roughnessFilter(engine.getJobSystem(), dst, environment,
+                getLinearRoughness(level), sampleCount, getMirror(), true,
+                firstRow, rowCount);
+    }
+
+    // Bilinearly magnifies src into dst, this is used for the levels the coarse result doesn't
+    // filter.
+    void magnify(Cubemap& dst, Cubemap const& src) {
+        JobSystem& js = engine.getJobSystem();
+        const size_t dim = dst.getDimensions();
+        auto magnifyRows = [&dst, &src, dim](size_t row, size_t count) {
+            for (size_t r = row; r < row + count; r++) {
+                const Cubemap::Face face = Cubemap::Face(r / dim);
+                const size_t y = r % dim;
+                Image& image = dst.getImageForFace(face);
+                Cubemap::Texel* out = static_cast<Cubemap::Texel*>(image.getPixelRef(0, y));
+                for (size_t x = 0; x < dim; x++, out++) {
+                    Cubemap::writeAt(out, src.filterAt(dst.getDirectionFor(face, x, y)));
+                }
+            }
+        };
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(6 * dim),
+                std::ref(magnifyRows), jobs::CountSplitter<ROWS_PER_STEP, 8>());
+        js.runAndWait(job);
+        dst.makeSeamless();
+    }
+
+    // Uploads the given level of the reflections, the texture then owns the image's data.
+    void upload(size_t level, Image&& image, Cubemap const& cm) {
+        Texture::FaceOffsets offsets;
+        const uintptr_t base = uintptr_t(image.getData());
+        for (size_t j = 0; j < 6; j++) {
+            Image const& faceImage = cm.getImageForFace((Cubemap::Face)j);
+            offsets[j] = uintptr_t(faceImage.getData()) - base;
+        }
+
+        const size_t size = image.getSize();
+        const uint32_t stride = uint32_t(image.getStride());
+        void* data = image.getData();
+        Texture::PixelBufferDescriptor pbd(data, size,
+                Texture::PixelBufferDescriptor::PixelDataFormat::RGB,
+                Texture::PixelBufferDescriptor::PixelDataType::FLOAT, 1, 0, 0, stride,
+                [](void*, size_t, void* user) {
+                    delete[] static_cast<uint8_t*>(user);
+                }, image.detach().release());
+        reflections->setImage(engine, level, std::move(pbd), offsets);
+    }
+
+    void setEnvironment(Texture::PixelBufferDescriptor const& buffer,
+            Texture::FaceOffsets const& faceOffsets);
+
+    bool step();
+
+    Engine& engine;
+    Texture* const reflections;
+    const Config config;
+    size_t levelCount = 0;
+
+    // the environment and its mipmaps, as needed by the roughness filter
+    std::vector<Image> images;
+    std::vector<Cubemap> environment;
+
+    std::unique_ptr<float3[]> sh;
+
+    // the refinement tasks, in order, and the state of the current one
+    std::vector<Task> tasks;
+    size_t currentTask = 0;
+    size_t currentRow = 0;
+    Image currentImage;
+    Cubemap currentLevel{ 0 };
+};
+
+void ProgressiveIBL::Impl::setEnvironment(Texture::PixelBufferDescriptor const& buffer,
+        Texture::FaceOffsets const& faceOffsets) {
+    using PixelDataFormat = Texture::PixelBufferDescriptor::PixelDataFormat;
+    using PixelDataType = Texture::PixelBufferDescriptor::PixelDataType;
+
+    const size_t size = reflections->getWidth();
+    const size_t stride = buffer.stride ? buffer.stride : size;
+
+    ASSERT_PRECONDITION(buffer.format == PixelDataFormat::RGB ||
+                        buffer.format == PixelDataFormat::RGBA,
+            "input data format must be RGB or RGBA");
+
+    ASSERT_PRECONDITION(buffer.type == PixelDataType::FLOAT ||
+                        buffer.type == PixelDataType::HALF ||
+                        buffer.type == PixelDataType::UINT_10F_11F_11F_REV,
+            "input data type must be FLOAT, HALF or UINT_10F_11F_11F_REV");
+
+    JobSystem& js = engine.getJobSystem();
+
+    /*
+     * Create the environment cubemap, exactly like Texture::generatePrefilterMipmap()
+     */
+
+    size_t bytesPerPixel = buffer.format == PixelDataFormat::RGB ? 3 : 4;
+    if (buffer.type == PixelDataType::FLOAT) {
+        bytesPerPixel *= 4;
+    } else if (buffer.type == PixelDataType::HALF) {
+        bytesPerPixel *= 2;
+    }
+
+    images.clear();
+    environment.clear();
+    images.reserve(levelCount);
+    environment.reserve(levelCount);
+
+    Image temp;
+    Cubemap base = CubemapUtils::create(temp, size);
+    for (size_t j = 0; j < 6; j++) {
+        Image const& image = base.getImageForFace((Cubemap::Face)j);
+        char const* face = static_cast<char const*>(buffer.buffer) + faceOffsets[j];
+        for (size_t y = 0; y < size; y++) {
+            Cubemap::Texel* out = (Cubemap::Texel*)image.getPixelRef(0, y);
+            if (buffer.type == PixelDataType::FLOAT) {
+                char const* src = face + y * stride * bytesPerPixel;
+                for (size_t x = 0; x < size; x++, out++, src += bytesPerPixel) {
+                    Cubemap::writeAt(out, *reinterpret_cast<float3 const*>(src));
+                }
+            } else if (buffer.type == PixelDataType::HALF) {
+                char const* src = face + y * stride * bytesPerPixel;
+                for (size_t x = 0; x < size; x++, out++, src += bytesPerPixel) {
+                    Cubemap::writeAt(out, Cubemap::Texel(*reinterpret_cast<half3 const*>(src)));
+                }
+            } else {
+                // this doesn't depend on buffer.format
+                uint32_t const* src = reinterpret_cast<uint32_t const*>(face) + y * stride;
+                for (size_t x = 0; x < size; x++, out++, src++) {
+                    using fp10 = math::fp<0, 5, 5>;
+                    using fp11 = math::fp<0, 5, 6>;
+                    fp11 r{ uint16_t( *src         & 0x7FFu) };
+                    fp11 g{ uint16_t((*src >> 11u) & 0x7FFu) };
+                    fp10 b{ uint16_t((*src >> 22u) & 0x3FFu) };
+                    Cubemap::Texel texel{ fp11::tof(r), fp11::tof(g), fp10::tof(b) };
+                    Cubemap::writeAt(out, texel);
+                }
+            }
+        }
+    }
+    base.makeSeamless();
+    images.push_back(std::move(temp));
+    environment.push_back(std::move(base));
+
+    for (size_t dim = size >> 1u; dim >= 1; dim >>= 1u) {
+        Cubemap dst = CubemapUtils::create(temp, dim);
+        CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, environment.back());
+        dst.makeSeamless();
+        images.push_back(std::move(temp));
+        environment.push_back(std::move(dst));
+    }
+
+    /*
+     * The irradiance, from a small level of the environment
+     */
+
+    auto shLevel = std::find_if(environment.begin(), environment.end(),
+            [](Cubemap const& cm) { return cm.getDimensions() <= SH_MAX_DIMENSIONS; });
+    sh = CubemapSH::computeSH(js, *shLevel, 3, true);
+    CubemapSH::preprocessSHForShader(sh);
+
+    /*
+     * The coarse reflections: the first level is a cheap copy, the smaller levels are filtered
+     * with few samples and the levels in between are magnified from the first filtered one.
+     */
+
+    const size_t coarseLevel = std::max(std::min(size_t(config.coarseLevel), levelCount - 1),
+            size_t(1));
+
+    std::vector<Image> coarseImages(levelCount);
+    std::vector<Cubemap> coarseLevels;
+    coarseLevels.reserve(levelCount);
+    for (size_t level = 0; level < levelCount; level++) {
+        coarseLevels.push_back(CubemapUtils::create(coarseImages[level], size >> level));
+    }
+
+    filter(coarseLevels[0], 0, 1, 0, 6 * size);
+    for (size_t level = coarseLevel; level < levelCount; level++) {
+        filter(coarseLevels[level], level, config.coarseSampleCount, 0, 6 * (size >> level));
+    }
+    for (size_t level = coarseLevel - 1; level > 0; level--) {
+        magnify(coarseLevels[level], coarseLevels[coarseLevel]);
+    }
+    for (size_t level = 0; level < levelCount; level++) {
+        upload(level, std::move(coarseImages[level]), coarseLevels[level]);
+    }
+
+    /*
+     * The refinement tasks: magnified levels first from the smallest, since they're the
+     * furthest from the final result, then the other levels if they need more samples.
+     */
+
+    tasks.clear();
+    for (size_t level = coarseLevel - 1; level > 0; level--) {
+        tasks.push_back({ uint8_t(level), config.sampleCount });
+    }
+    if (config.sampleCount != config.coarseSampleCount) {
+        for (size_t level = coarseLevel; level < levelCount; level++) {
+            tasks.push_back({ uint8_t(level), config.sampleCount });
+        }
+    }
+    currentTask = 0;
+    currentRow = 0;
+}
+
+bool ProgressiveIBL::Impl::step() {
+    if (currentTask == tasks.size()) {
+        return false;
+    }
+
+    Task const& task = tasks[currentTask];
+    const size_t dim = reflections->getWidth() >> task.level;
+    if (currentRow == 0) {
+        currentLevel = CubemapUtils::create(currentImage, dim);
+    }
+
+    const size_t rowCount = std::min(ROWS_PER_STEP, 6 * dim - currentRow);
+    filter(currentLevel, task.level, task.sampleCount, currentRow, rowCount);
+    currentRow += rowCount;
+
+    if (currentRow == 6 * dim) {
+        upload(task.level, std::move(currentImage), currentLevel);
+        currentImage = {};
+        currentTask++;
+        currentRow = 0;
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+ProgressiveIBL::ProgressiveIBL(Engine& engine, Texture* reflections, Config config) {
+    ASSERT_PRECONDITION(reflections != nullptr, "reflections is null!");
+
+    ASSERT_PRECONDITION(reflections->getTarget() == Texture::Sampler::SAMPLER_CUBEMAP,
+            "reflections must be a cubemap");
+
+    const size_t size = reflections->getWidth();
+    ASSERT_PRECONDITION(!(size & (size - 1)),
+            "reflections dimensions must be a power-of-two");
+
+    const size_t levelCount = ctz(size) + 1;
+    ASSERT_PRECONDITION(levelCount <= reflections->getLevels(),
+            "reflections has %u levels but %u are needed",
+            unsigned(reflections->getLevels()), unsigned(levelCount));
+
+    ASSERT_PRECONDITION(config.sampleCount > 0 && config.coarseSampleCount > 0,
+            "sample counts must be positive");
+
+    mImpl = std::make_unique<Impl>(engine, reflections, config);
+    mImpl->levelCount = levelCount;
+}
+
+ProgressiveIBL::ProgressiveIBL(Engine& engine, Texture* reflections)
+        : ProgressiveIBL(engine, reflections, Config{}) {
+}
+
+ProgressiveIBL::~ProgressiveIBL() noexcept = default;
+
+void ProgressiveIBL::setEnvironment(Texture::PixelBufferDescriptor&& buffer,
+        Texture::FaceOffsets const& faceOffsets) {
+    SYSTRACE_CALL();
+    mImpl->setEnvironment(buffer, faceOffsets);
+    // buffer was moved in, its callback is called when it goes out of scope here
+}
+
+bool ProgressiveIBL::refine(float budgetInMs) {
+    SYSTRACE_CALL();
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() +
+            std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<float, std::milli>(budgetInMs));
+    // always make some progress, even when the budget is too small for a single step
+    while (mImpl->step() && clock::now() < deadline) {
+    }
+    return isComplete();
+}
+
+bool ProgressiveIBL::isComplete() const noexcept {
+    return mImpl->currentTask == mImpl->tasks.size();
+}
+
+float3 const* ProgressiveIBL::getSphericalHarmonics() const noexcept {
+    return mImpl->sh.get();
+}
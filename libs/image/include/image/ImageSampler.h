@@ -19,6 +19,12 @@
 
 #include <image/LinearImage.h>
 
+#include <memory>
+
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -98,17 +104,62 @@ struct ImageSampler {
     Boundary south;
 };
 
+/**
+ * Selects the source of each miplevel in generateMipmaps.
+ */
+enum class MipmapMode {
+    FROM_SOURCE, // Resamples each level from the original image, for the best quality.
+    CASCADED     // Resamples each level from the previous one, which is much faster.
+};
+
 /**
  * Resizes or blurs the given linear image, producing a new linear image with the given dimensions.
+ *
+ * The image is resampled horizontally then vertically. If a job system is given, rows are
+ * processed in parallel on it, in which case the calling thread must be adopted by the job system.
  */
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        const ImageSampler& sampler);
+        const ImageSampler& sampler, utils::JobSystem* js = nullptr);
 
 /**
  * Resizes the given linear image using a simplified API that takes target dimensions and filter.
  */
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        Filter filter = Filter::DEFAULT);
+        Filter filter = Filter::DEFAULT, utils::JobSystem* js = nullptr);
+
+/**
+ * Resizes an image that is provided a band of rows at a time, from top to bottom, and produces the
+ * resized image a band of rows at a time. Only the source rows that the filter still needs are
+ * kept in memory, which allows images that are too large for memory to be processed.
+ *
+ * The concatenated bands are identical to what resampleImage returns for the whole image.
+ */
+class BandResampler {
+public:
+    BandResampler(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height,
+            Filter filter = Filter::DEFAULT);
+    ~BandResampler();
+
+    BandResampler(const BandResampler&) = delete;
+    BandResampler& operator=(const BandResampler&) = delete;
+
+    /**
+     * Consumes the next rows of the source image, which must all have the same number of
+     * channels, and returns the following rows of the resized image that can be computed so
+     * far. The returned image is invalid when there are none yet. The job system is used as in
+     * resampleImage.
+     */
+    LinearImage push(const LinearImage& band, utils::JobSystem* js = nullptr);
+
+    /**
+     * Returns the number of rows of the resized image returned so far.
+     */
+    uint32_t getCompletedRows() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> mImpl;
+};
 
 /**
  * Computes a single sample for the given texture coordinate and writes the resulting color
@@ -136,8 +187,12 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
  * Source image need not be power-of-two. In the result vector, the half-size image is returned at
  * index 0, the quarter-size image is at index 1, etc. Please note that the original-sized image is
  * not included.
+ *
+ * In CASCADED mode each level is a 2:1 reduction of the previous one with the requested filter.
+ * The job system is used as in resampleImage.
  */
-void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
+void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount,
+        MipmapMode mode = MipmapMode::FROM_SOURCE, utils::JobSystem* js = nullptr);
 
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
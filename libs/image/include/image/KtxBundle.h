@@ -64,6 +64,14 @@ struct KtxMetadata;
 class KtxBundle {
 public:
 
+    /**
+     * Whether a bundle created from serialized data owns a copy of its blobs.
+     */
+    enum class Storage : uint8_t {
+        COPY,   //!< The blobs are copied, the serialized data can be released after construction.
+        VIEW    //!< The blobs refer to the serialized data, which must outlive the bundle.
+    };
+
     ~KtxBundle();
 
     /**
@@ -78,6 +86,16 @@ public:
      */
     KtxBundle(uint8_t const* bytes, uint32_t nbytes);
 
+    /**
+     * Creates a new bundle by parsing the given data, with the given storage mode.
+     *
+     * In VIEW mode, only the header and the metadata are parsed, and the blobs point directly into
+     * the given data, e.g. a memory-mapped KTX file. The data must stay valid and unchanged for as
+     * long as the bundle or any of its blobs are in use, and the blobs are read-only: setBlob()
+     * and allocateBlob() return false.
+     */
+    KtxBundle(uint8_t const* bytes, uint32_t nbytes, Storage storage);
+
     /**
      * Serializes the bundle into the given target memory. Returns false if there's not enough
      * memory.
@@ -91,6 +109,20 @@ public:
      */
     uint32_t getSerializedLength() const;
 
+    /**
+     * Serializes only the header and the metadata, i.e. everything that precedes the first
+     * miplevel. Returns false if there's not enough memory.
+     *
+     * This allows very large files to be written one miplevel at a time, without populating the
+     * blobs: each miplevel follows as its size in bytes (a 32-bit integer) and its data.
+     */
+    bool serializeHeader(uint8_t* destination, uint32_t numBytes) const;
+
+    /**
+     * Computes the size (in bytes) of the serialized header and metadata.
+     */
+    uint32_t getSerializedHeaderLength() const;
+
     /**
      * Gets or sets information about the texture object, such as format and type.
      */
@@ -111,6 +143,11 @@ public:
      */
     bool getSphericalHarmonics(filament::math::float3* result);
 
+    /**
+     * Returns true if the blobs refer to the data this bundle was created from.
+     */
+    bool isView() const;
+
     /**
      * Gets the number of miplevels (this is never zero).
      */
@@ -128,7 +165,8 @@ public:
 
     /**
      * Retrieves a weak reference to a given data blob. Returns false if the given blob index is out
-     * of bounds, or if the blob at the given index is empty.
+     * of bounds, or if the blob at the given index is empty. The data of a view must not be
+     * modified.
      */
     bool getBlob(KtxBlobIndex index, uint8_t** data, uint32_t* size) const;
 
@@ -222,6 +260,10 @@ public:
     static constexpr uint32_t RGBA_S3TC_DXT1 = 0x83F1;
     static constexpr uint32_t RGBA_S3TC_DXT3 = 0x83F2;
     static constexpr uint32_t RGBA_S3TC_DXT5 = 0x83F3;
+    static constexpr uint32_t SRGB_S3TC_DXT1 = 0x8C4C;
+    static constexpr uint32_t SRGB_ALPHA_S3TC_DXT1 = 0x8C4D;
+    static constexpr uint32_t SRGB_ALPHA_S3TC_DXT3 = 0x8C4E;
+    static constexpr uint32_t SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
 
     static constexpr uint32_t RGBA_ASTC_4x4 = 0x93B0;
     static constexpr uint32_t RGBA_ASTC_5x4 = 0x93B1;
@@ -22,6 +22,8 @@
 
 #include <image/KtxBundle.h>
 
+#include <memory>
+
 namespace image {
 
 /**
@@ -50,22 +52,53 @@ namespace ktx {
     TextureFormat toTextureFormat(const KtxInfo& info);
 
     /**
-     * Creates a Texture object from a KTX file and populates all of its faces and miplevels.
+     * Creates a pixel buffer descriptor for all the faces of the given miplevel, which points
+     * directly at the bundle's data rather than at a copy of it.
+     *
+     * The given reference is held until the descriptor is released, i.e. until the data has been
+     * uploaded. With a bundle that is a view over mapped memory, it typically is the mapping.
+     *
+     * @param ktx The bundle, which needs to be alive only until this returns if it is a view
+     * @param level The miplevel
+     * @param owner Reference to the memory that holds the blob
+     */
+    inline PixelBufferDescriptor createPixelBufferDescriptor(const KtxBundle& ktx, uint32_t level,
+            std::shared_ptr<const void> owner) {
+        uint8_t* data = nullptr;
+        uint32_t size = 0;
+        ktx.getBlob({level, 0, 0}, &data, &size);
+
+        // All the faces of a level are contiguous.
+        const uint32_t faces = ktx.isCubemap() ? 6 : 1;
+        auto* reference = new std::shared_ptr<const void>(std::move(owner));
+        PixelBufferDescriptor::Callback release = [](void*, size_t, void* user) {
+            delete (std::shared_ptr<const void>*) user;
+        };
+
+        const auto& ktxinfo = ktx.getInfo();
+        if (isCompressed(ktxinfo)) {
+            return PixelBufferDescriptor(data, size * faces, toCompressedPixelDataType(ktxinfo),
+                    size, release, reference);
+        }
+        return PixelBufferDescriptor(data, size * faces, toPixelDataFormat(ktxinfo),
+                toPixelDataType(ktxinfo), release, reference);
+    }
+
+    /**
+     * Creates a Texture object from a KTX bundle and populates all of its faces and miplevels
+     * without copying them, see createPixelBufferDescriptor().
      *
      * @param engine Used to create the Filament Texture
-     * @param ktx In-memory representation of a KTX file
+     * @param ktx In-memory representation of a KTX file, which can be a view
      * @param srgb Forces the KTX-specified format into an SRGB format if possible
-     * @param callback Gets called after all texture data has been uploaded to the GPU
-     * @param userdata Passed into the callback
+     * @param owner Reference to the memory that holds the blobs, released once all the texture
+     *              data has been uploaded to the GPU
      */
     inline Texture* createTexture(Engine* engine, const KtxBundle& ktx, bool srgb,
-            Callback callback, void* userdata) {
+            std::shared_ptr<const void> owner) {
         using Sampler = Texture::Sampler;
         const auto& ktxinfo = ktx.getInfo();
         const uint32_t nmips = ktx.getNumMipLevels();
-        const auto cdatatype = toCompressedPixelDataType(ktxinfo);
-        const auto datatype = toPixelDataType(ktxinfo);
-        const auto dataformat = toPixelDataFormat(ktxinfo);
 
         auto texformat = toTextureFormat(ktxinfo);
         if (srgb) {
@@ -85,61 +118,41 @@ namespace ktx {
             .format(texformat)
             .build(*engine);
 
-        struct Userdata {
-            uint32_t remainingBuffers;
-            Callback callback;
-            void* userdata;
-        };
-
-        Userdata* cbuser = new Userdata({nmips, callback, userdata});
-
-        PixelBufferDescriptor::Callback cb = [](void*, size_t, void* cbuserptr) {
-            Userdata* cbuser = (Userdata*) cbuserptr;
-            if (--cbuser->remainingBuffers == 0) {
-                if (cbuser->callback) {
-                    cbuser->callback(cbuser->userdata);
-                }
-                delete cbuser;
-            }
-        };
-
-        uint8_t* data;
-        uint32_t size;
-
-        if (isCompressed(ktxinfo)) {
+        for (uint32_t level = 0; level < nmips; ++level) {
+            PixelBufferDescriptor pbd = createPixelBufferDescriptor(ktx, level, owner);
             if (ktx.isCubemap()) {
-                for (uint32_t level = 0; level < nmips; ++level) {
-                    ktx.getBlob({level, 0, 0}, &data, &size);
-                    PixelBufferDescriptor pbd(data, size * 6, cdatatype, size, cb, cbuser);
-                    texture->setImage(*engine, level, std::move(pbd), Texture::FaceOffsets(size));
-                }
-                return texture;
-            }
-            for (uint32_t level = 0; level < nmips; ++level) {
+                uint8_t* data;
+                uint32_t size;
                 ktx.getBlob({level, 0, 0}, &data, &size);
-                PixelBufferDescriptor pbd(data, size, cdatatype, size, cb, cbuser);
-                texture->setImage(*engine, level, std::move(pbd));
-            }
-            return texture;
-        }
-
-        if (ktx.isCubemap()) {
-            for (uint32_t level = 0; level < nmips; ++level) {
-                ktx.getBlob({level, 0, 0}, &data, &size);
-                PixelBufferDescriptor pbd(data, size * 6, dataformat, datatype, cb, cbuser);
                 texture->setImage(*engine, level, std::move(pbd), Texture::FaceOffsets(size));
+            } else {
+                texture->setImage(*engine, level, std::move(pbd));
             }
-            return texture;
-        }
-
-        for (uint32_t level = 0; level < nmips; ++level) {
-            ktx.getBlob({level, 0, 0}, &data, &size);
-            PixelBufferDescriptor pbd(data, size, dataformat, datatype, cb, cbuser);
-            texture->setImage(*engine, level, std::move(pbd));
         }
         return texture;
     }
 
+    /**
+     * Creates a Texture object from a KTX file and populates all of its faces and miplevels.
+     *
+     * @param engine Used to create the Filament Texture
+     * @param ktx In-memory representation of a KTX file
+     * @param srgb Forces the KTX-specified format into an SRGB format if possible
+     * @param callback Gets called after all texture data has been uploaded to the GPU
+     * @param userdata Passed into the callback
+     */
+    inline Texture* createTexture(Engine* engine, const KtxBundle& ktx, bool srgb,
+            Callback callback, void* userdata) {
+        // The callback is invoked when the last descriptor releases its reference.
+        std::shared_ptr<const void> owner(static_cast<const void*>(userdata),
+                [callback](const void* userdata) {
+                    if (callback) {
+                        callback(const_cast<void*>(userdata));
+                    }
+                });
+        return createTexture(engine, ktx, srgb, std::move(owner));
+    }
+
     /**
      * Creates a Texture object from a KTX bundle, populates all of its faces and miplevels,
      * and automatically destroys the bundle after all the texture data has been uploaded.
@@ -163,6 +176,10 @@ namespace ktx {
             case KtxBundle::RGBA_S3TC_DXT1: return T::DXT1_RGBA;
             case KtxBundle::RGBA_S3TC_DXT3: return T::DXT3_RGBA;
             case KtxBundle::RGBA_S3TC_DXT5: return T::DXT5_RGBA;
+            case KtxBundle::SRGB_S3TC_DXT1: return T::DXT1_SRGB;
+            case KtxBundle::SRGB_ALPHA_S3TC_DXT1: return T::DXT1_SRGBA;
+            case KtxBundle::SRGB_ALPHA_S3TC_DXT3: return T::DXT3_SRGBA;
+            case KtxBundle::SRGB_ALPHA_S3TC_DXT5: return T::DXT5_SRGBA;
             case KtxBundle::RGBA_ASTC_4x4: return T::RGBA_ASTC_4x4;
             case KtxBundle::RGBA_ASTC_5x4: return T::RGBA_ASTC_5x4;
             case KtxBundle::RGBA_ASTC_5x5: return T::RGBA_ASTC_5x5;
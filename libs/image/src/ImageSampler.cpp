@@ -21,14 +21,20 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <utils/compiler.h>
 #include <utils/Panic.h>
 #include <utils/CString.h>
+#include <utils/JobSystem.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <unordered_map>
 
 using namespace image;
+using namespace utils;
 
 namespace {
 
@@ -132,7 +138,7 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     // the [0,1] domain. If this were a huge number, the filtered results would look the same, but
     // the filter would perform very poorly because it would be iterating over a lot more samples
     // than necessary.
-    const float filterBounds = domainScale * std::abs(filter.boundingRadius);
+    const float filterBounds = std::abs(filter.boundingRadius) / domainScale;
 
     // Iterate through target samples. "xtarget" points to the center of each target pixel.
     float xtarget = dtarget / 2.0f;
@@ -143,9 +149,12 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
         uint32_t count = 0;
         float sum = 0;
 
-        // Iterate through source samples that lie within the bounded region.
-        const auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
-        const auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+        // Iterate through source samples that lie within the bounded region, which is mapped
+        // from the source range back to the whole row.
+        const float xlower = left + (xtarget - filterBounds) * (right - left);
+        const float xupper = left + (xtarget + filterBounds) * (right - left);
+        const auto isource_lower = int32_t(xlower * nsource);
+        const auto isource_upper = int32_t(std::ceil(xupper * nsource));
         for (int32_t isource = isource_lower; isource <= isource_upper; ++isource) {
             const float xsource = (((isource + 0.5f) / nsource) - left) / (right - left);
             const bool outside_image = isource < 0 || isource >= int32_t(nsource);
@@ -172,22 +181,64 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
+// Returns the index of the first instruction of each target sample in the given program, followed
+// by the size of the program. This relies on instructions being sorted by target.
+std::vector<uint32_t> getTargetOffsets(const MadProgram& program, uint32_t ntarget) {
+    std::vector<uint32_t> offsets(ntarget + 1, uint32_t(program.size()));
+    for (uint32_t i = uint32_t(program.size()); i-- > 0;) {
+        offsets[program[i].targetIndex] = i;
+    }
+    for (uint32_t i = ntarget; i-- > 0;) {
+        offsets[i] = std::min(offsets[i], offsets[i + 1]);
+    }
+    return offsets;
+}
+
+// Calls fn(first, count) over ranges of [0, count), in parallel when a job system is given.
+template<typename Fn>
+void forEachRange(JobSystem* js, uint32_t count, Fn& fn) {
+    if (!js || count < 2) {
+        fn(0, count);
         return;
     }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
+    auto job = jobs::parallel_for(*js, nullptr, 0, count, std::ref(fn),
+            jobs::CountSplitter<16, 8>());
+    js->runAndWait(job);
+}
+
+// Executes a horizontal MAD program over a row of texels with N channels. The channel count is a
+// template parameter so that the inner loop is unrolled and vectorized.
+template<uint32_t N, bool MIN>
+void executeRow(float* UTILS_RESTRICT dst, float const* UTILS_RESTRICT src,
+        const MadProgram& program, uint32_t nchan) {
+    const uint32_t n = N ? N : nchan;
+    for (const MadInstruction& mad : program) {
+        float* UTILS_RESTRICT d = dst + mad.targetIndex * n;
+        float const* UTILS_RESTRICT s = src + mad.sourceIndex * n;
+        for (uint32_t c = 0; c < n; ++c) {
+            d[c] = MIN ? std::min(d[c], s[c]) : d[c] + s[c] * mad.weight;
         }
     }
-    program->swap(result);
+}
+
+template<bool MIN>
+void executeRow(float* dst, float const* src, const MadProgram& program, uint32_t nchan) {
+    switch (nchan) {
+        case 1: executeRow<1, MIN>(dst, src, program, nchan); break;
+        case 2: executeRow<2, MIN>(dst, src, program, nchan); break;
+        case 3: executeRow<3, MIN>(dst, src, program, nchan); break;
+        case 4: executeRow<4, MIN>(dst, src, program, nchan); break;
+        default: executeRow<0, MIN>(dst, src, program, nchan); break;
+    }
+}
+
+// Accumulates a weighted row into another, which vectorizes across the texels of the row.
+template<bool MIN>
+void accumulateRow(float* UTILS_RESTRICT dst, float const* UTILS_RESTRICT src, float weight,
+        uint32_t size) {
+    for (uint32_t i = 0; i < size; ++i) {
+        dst[i] = MIN ? std::min(dst[i], src[i]) : dst[i] + src[i] * weight;
+    }
 }
 
 FilterFunction createFilterFunction(Filter ftype) {
@@ -226,58 +277,110 @@ void normalize(LinearImage& image) {
     }
 }
 
-LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
-    const uint32_t swidth = source.getWidth();
+Filter resolveFilter(Filter filter, uint32_t ntarget, uint32_t nsource) {
+    if (filter == Filter::DEFAULT) {
+        return ntarget > nsource ? Filter::MITCHELL : Filter::LANCZOS;
+    }
+    return filter;
+}
+
+// Applies a horizontal MAD program to every row of the image, rows are processed in parallel.
+LinearImage executeHorizontal(const LinearImage& source, const MadProgram& program,
+        uint32_t twidth, Filter filter, JobSystem* js) {
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
-    const bool mag = twidth > swidth;
-    if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
-    const FilterFunction hfn = createFilterFunction(filter);
-
-    // Generate a flat list of multiply-add (MAD) instructions.
-    program->clear();
-    generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
 
-    // Allocate the target image.
+    // Allocate the target image. The MIN filter is special because it starts with non-zero
+    // values and ignores filter weights.
     LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
+    const bool min = filter == Filter::MINIMUM;
+    if (min) {
+        std::fill_n(result.getPixelRef(), twidth * sheight * nchan,
+                std::numeric_limits<float>::max());
+    }
 
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
-        }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
+    auto resampleRows = [&](uint32_t first, uint32_t count) {
+        for (uint32_t row = first; row < first + count; ++row) {
+            float* dst = result.getPixelRef(0, row);
+            float const* src = source.getPixelRef(0, row);
+            if (min) {
+                executeRow<true>(dst, src, program, nchan);
+            } else {
+                executeRow<false>(dst, src, program, nchan);
             }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
         }
-        return result;
+    };
+    forEachRange(js, sheight, resampleRows);
+
+    // Perform post processing for the current pass.
+    if (filter == Filter::GAUSSIAN_NORMALS) {
+        normalize(result);
     }
+    return result;
+}
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
-        }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
+// Computes target rows [first, last) of a vertical MAD program by accumulating whole source rows,
+// target rows are processed in parallel. The source rows are contiguous, starting at "firstRow".
+LinearImage executeVertical(float const* rows, uint32_t firstRow, const MadProgram& program,
+        const std::vector<uint32_t>& offsets, uint32_t first, uint32_t last, uint32_t width,
+        uint32_t nchan, Filter filter, JobSystem* js) {
+    LinearImage result(width, last - first, nchan);
+    const bool min = filter == Filter::MINIMUM;
+    if (min) {
+        std::fill_n(result.getPixelRef(), width * (last - first) * nchan,
+                std::numeric_limits<float>::max());
     }
 
-    // Perform post processing for the current pass.
+    const uint32_t rowSize = width * nchan;
+    auto resampleRows = [&](uint32_t begin, uint32_t count) {
+        for (uint32_t row = begin; row < begin + count; ++row) {
+            float* dst = result.getPixelRef(0, row);
+            for (uint32_t i = offsets[first + row]; i < offsets[first + row + 1]; ++i) {
+                const MadInstruction& mad = program[i];
+                float const* src = rows + (uint32_t(mad.sourceIndex) - firstRow) * rowSize;
+                if (min) {
+                    accumulateRow<true>(dst, src, mad.weight, rowSize);
+                } else {
+                    accumulateRow<false>(dst, src, mad.weight, rowSize);
+                }
+            }
+        }
+    };
+    forEachRange(js, last - first, resampleRows);
+
     if (filter == Filter::GAUSSIAN_NORMALS) {
         normalize(result);
     }
     return result;
 }
 
+// Resizes the image horizontally, rows are processed in parallel.
+LinearImage resampleHorizontal(const LinearImage& source, MadProgram* program, uint32_t twidth,
+        Filter filter, float left, float right, float filterRadiusMultiplier, JobSystem* js) {
+    filter = resolveFilter(filter, twidth, source.getWidth());
+    const FilterFunction hfn = createFilterFunction(filter);
+
+    // Generate a flat list of multiply-add (MAD) instructions.
+    program->clear();
+    generateMadProgram(twidth, source.getWidth(), left, right, hfn, filterRadiusMultiplier,
+            program);
+    return executeHorizontal(source, *program, twidth, filter, js);
+}
+
+// Resizes the image vertically by accumulating whole rows, target rows are processed in parallel.
+LinearImage resampleVertical(const LinearImage& source, MadProgram* program, uint32_t theight,
+        Filter filter, float top, float bottom, float filterRadiusMultiplier, JobSystem* js) {
+    const uint32_t sheight = source.getHeight();
+    filter = resolveFilter(filter, theight, sheight);
+    const FilterFunction vfn = createFilterFunction(filter);
+
+    program->clear();
+    generateMadProgram(theight, sheight, top, bottom, vfn, filterRadiusMultiplier, program);
+    const std::vector<uint32_t> offsets = getTargetOffsets(*program, theight);
+    return executeVertical(source.getPixelRef(), 0, *program, offsets, 0, theight,
+            source.getWidth(), source.getChannels(), filter, js);
+}
+
 } // anonymous namespace
 
 namespace image {
@@ -287,7 +390,7 @@ SingleSample::~SingleSample() {
 }
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        const ImageSampler& sampler) {
+        const ImageSampler& sampler, JobSystem* js) {
     ASSERT_PRECONDITION(
         sampler.east.mode == Boundary::EXCLUDE &&
         sampler.north.mode == Boundary::EXCLUDE &&
@@ -302,17 +405,106 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     const float bottom = sampler.sourceRegion.bottom;
     MadProgram program;
     LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
+    result = resampleHorizontal(source, &program, width, hfilter, left, right, radius, js);
+    result = resampleVertical(result, &program, height, vfilter, top, bottom, radius, js);
     return result;
 }
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        Filter filter) {
+        Filter filter, JobSystem* js) {
     return resampleImage(source, width, height, ImageSampler {
         .horizontalFilter = filter,
         .verticalFilter = filter
-    });
+    }, js);
+}
+
+struct BandResampler::Impl {
+    uint32_t swidth;
+    uint32_t sheight;
+    uint32_t twidth;
+    uint32_t theight;
+    uint32_t nchan = 0;
+    Filter hfilter;
+    Filter vfilter;
+    MadProgram hprogram;
+    MadProgram vprogram;
+    std::vector<uint32_t> voffsets;
+
+    // Horizontally resampled source rows, starting at source row "firstRow".
+    std::vector<float> rows;
+    uint32_t firstRow = 0;
+    uint32_t receivedRows = 0;
+    uint32_t completedRows = 0;
+
+    // Whether all the source rows needed by the given target row have been received.
+    bool isComplete(uint32_t row) const noexcept {
+        const uint32_t end = voffsets[row + 1];
+        return voffsets[row] == end || uint32_t(vprogram[end - 1].sourceIndex) < receivedRows;
+    }
+};
+
+BandResampler::BandResampler(uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width,
+        uint32_t height, Filter filter) : mImpl(new Impl) {
+    Impl& impl = *mImpl;
+    impl.swidth = sourceWidth;
+    impl.sheight = sourceHeight;
+    impl.twidth = width;
+    impl.theight = height;
+    impl.hfilter = resolveFilter(filter, width, sourceWidth);
+    impl.vfilter = resolveFilter(filter, height, sourceHeight);
+    generateMadProgram(width, sourceWidth, 0, 1, createFilterFunction(impl.hfilter), 1,
+            &impl.hprogram);
+    generateMadProgram(height, sourceHeight, 0, 1, createFilterFunction(impl.vfilter), 1,
+            &impl.vprogram);
+    impl.voffsets = getTargetOffsets(impl.vprogram, height);
+}
+
+BandResampler::~BandResampler() = default;
+
+LinearImage BandResampler::push(const LinearImage& band, JobSystem* js) {
+    Impl& impl = *mImpl;
+    ASSERT_PRECONDITION(band.getWidth() == impl.swidth, "Band width must match the source.");
+    ASSERT_PRECONDITION(impl.receivedRows + band.getHeight() <= impl.sheight,
+            "More rows than the source height.");
+    ASSERT_PRECONDITION(!impl.nchan || band.getChannels() == impl.nchan,
+            "All bands must have the same number of channels.");
+    impl.nchan = band.getChannels();
+
+    // The horizontal pass only depends on the band, append its result to the pending rows.
+    const LinearImage resized = executeHorizontal(band, impl.hprogram, impl.twidth, impl.hfilter,
+            js);
+    const uint32_t rowSize = impl.twidth * impl.nchan;
+    impl.rows.insert(impl.rows.end(), resized.getPixelRef(),
+            resized.getPixelRef() + band.getHeight() * rowSize);
+    impl.receivedRows += band.getHeight();
+
+    const uint32_t first = impl.completedRows;
+    uint32_t last = first;
+    while (last < impl.theight && impl.isComplete(last)) {
+        ++last;
+    }
+    if (last == first) {
+        return {};
+    }
+    LinearImage result = executeVertical(impl.rows.data(), impl.firstRow, impl.vprogram,
+            impl.voffsets, first, last, impl.twidth, impl.nchan, impl.vfilter, js);
+    impl.completedRows = last;
+
+    // Drop the rows that no remaining target row needs. The source rows referenced by the
+    // program only move forward from one target row to the next.
+    uint32_t needed = impl.receivedRows;
+    if (last < impl.theight && impl.voffsets[last] < impl.voffsets[last + 1]) {
+        needed = std::min(needed, uint32_t(impl.vprogram[impl.voffsets[last]].sourceIndex));
+    }
+    if (needed > impl.firstRow) {
+        impl.rows.erase(impl.rows.begin(), impl.rows.begin() + (needed - impl.firstRow) * rowSize);
+        impl.firstRow = needed;
+    }
+    return result;
+}
+
+uint32_t BandResampler::getCompletedRows() const noexcept {
+    return mImpl->completedRows;
 }
 
 void computeSingleSample(const LinearImage& source, float x, float y, SingleSample* result,
@@ -323,8 +515,8 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
     const float right = x + radius / source.getWidth();
     const float bottom = y + radius / source.getHeight();
     MadProgram program;
-    LinearImage row = transpose(resampleImage1D(source, &program, 1, filter, left, right, radius));
-    row = resampleImage1D(row, &program, 1, filter, top, bottom, radius);
+    LinearImage row = resampleHorizontal(source, &program, 1, filter, left, right, radius, nullptr);
+    row = resampleVertical(row, &program, 1, filter, top, bottom, radius, nullptr);
     if (!result->data) {
         result->data = new float[source.getChannels()];
     }
@@ -336,15 +528,17 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 }
 
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
-// image, under the premise that this produces a higher quality result.
-void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
+// image by default, under the premise that this produces a higher quality result.
+void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips,
+        MipmapMode mode, JobSystem* js) {
     mips = std::min(mips, getMipmapCount(source));
     uint32_t width = source.getWidth();
     uint32_t height = source.getHeight();
     for (uint32_t n = 0; n < mips; ++n) {
         width = std::max(width >> 1u, 1u);
         height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
+        const bool cascaded = mode == MipmapMode::CASCADED && n > 0;
+        result[n] = resampleImage(cascaded ? result[n - 1] : source, width, height, filter, js);
     }
 }
 
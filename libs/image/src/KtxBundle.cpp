@@ -60,8 +60,14 @@ struct KtxBlobList {
     std::vector<uint8_t> blobs;
     std::vector<uint32_t> sizes;
 
+    // Locations of the blobs in the serialized data when the bundle is a view, empty otherwise.
+    std::vector<uint8_t const*> views;
+
     // Obtains a pointer to the given blob.
     uint8_t* get(uint32_t blobIndex) {
+        if (!views.empty()) {
+            return const_cast<uint8_t*>(views[blobIndex]);
+        }
         uint8_t* result = blobs.data();
         for (uint32_t i = 0; i < blobIndex; ++i) {
             result += sizes[i];
@@ -107,6 +113,10 @@ KtxBundle::KtxBundle(uint32_t numMipLevels, uint32_t arrayLength, bool isCubemap
 }
 
 KtxBundle::KtxBundle(uint8_t const* bytes, uint32_t nbytes) :
+        KtxBundle(bytes, nbytes, Storage::COPY) {
+}
+
+KtxBundle::KtxBundle(uint8_t const* bytes, uint32_t nbytes, Storage storage) :
         mBlobs(new KtxBlobList), mMetadata(new KtxMetadata) {
     ASSERT_PRECONDITION(sizeof(SerializationHeader) <= nbytes, "KTX buffer is too small");
 
@@ -149,18 +159,31 @@ KtxBundle::KtxBundle(uint8_t const* bytes, uint32_t nbytes) :
     const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
     const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
 
-    // Extract blobs from the serialized byte stream.
+    // Extract blobs from the serialized byte stream, or just locate them if this is a view.
+    const bool view = storage == Storage::VIEW;
     const uint32_t totalSize = nbytes - (pdata - bytes);
-    mBlobs->blobs.resize(totalSize);
+    if (view) {
+        mBlobs->views.resize(mBlobs->sizes.size());
+    } else {
+        mBlobs->blobs.resize(totalSize);
+    }
     for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
+        ASSERT_PRECONDITION(pdata + sizeof(uint32_t) <= bytes + nbytes, "KTX data is truncated");
         const uint32_t imageSize = *((uint32_t const*) pdata);
         const uint32_t faceSize = isNonArrayCube ? imageSize : (imageSize / facesPerMip);
         const uint32_t levelSize = faceSize * mNumCubeFaces * mArrayLength;
         pdata += sizeof(uint32_t);
-        memcpy(mBlobs->get(flatten(this, {mipmap, 0, 0})), pdata, levelSize);
+        ASSERT_PRECONDITION(levelSize <= size_t(bytes + nbytes - pdata), "KTX data is truncated");
+        if (!view) {
+            memcpy(mBlobs->get(flatten(this, {mipmap, 0, 0})), pdata, levelSize);
+        }
         for (uint32_t layer = 0; layer < mArrayLength; ++layer) {
             for (uint32_t face = 0; face < mNumCubeFaces; ++face) {
-                mBlobs->sizes[flatten(this, {mipmap, layer, face})] = faceSize;
+                const size_t flatIndex = flatten(this, {mipmap, layer, face});
+                mBlobs->sizes[flatIndex] = faceSize;
+                if (view) {
+                    mBlobs->views[flatIndex] = pdata;
+                }
                 pdata += faceSize;
                 pdata += cubePadding;
             }
@@ -169,12 +192,56 @@ KtxBundle::KtxBundle(uint8_t const* bytes, uint32_t nbytes) :
     }
 }
 
+bool KtxBundle::isView() const {
+    return !mBlobs->views.empty();
+}
+
 bool KtxBundle::serialize(uint8_t* destination, uint32_t numBytes) const {
     uint32_t requiredLength = getSerializedLength();
     if (numBytes < requiredLength) {
         return false;
     }
 
+    const uint32_t headerLength = getSerializedHeaderLength();
+    serializeHeader(destination, headerLength);
+    uint8_t* pdata = destination + headerLength;
+
+    // One aspect of the KTX spec is that the semantics differ for non-array cubemaps.
+    const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
+    const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
+
+    // Extract blobs from the serialized byte stream.
+    for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
+
+        // Every blob in a given miplevel has the same size, and each miplevel has at least one
+        // blob. Therefore we can safely determine each of the so-called "imageSize" fields in KTX
+        // by simply looking at the first blob in the LOD.
+        uint32_t faceSize;
+        uint8_t* blobData;
+        getBlob({mipmap, 0, 0}, &blobData, &faceSize);
+        uint32_t imageSize = isNonArrayCube ? faceSize : (faceSize * facesPerMip);
+        *((uint32_t*) pdata) = imageSize;
+        pdata += sizeof(imageSize);
+
+        // Next, copy out the actual blobs.
+        for (uint32_t layer = 0; layer < mArrayLength; ++layer) {
+            for (uint32_t face = 0; face < mNumCubeFaces; ++face) {
+                if (!getBlob({mipmap, layer, face}, &blobData, &faceSize)) {
+                    return false;
+                }
+                memcpy(pdata, blobData, faceSize);
+                pdata += faceSize;
+            }
+        }
+    }
+    return true;
+}
+
+bool KtxBundle::serializeHeader(uint8_t* destination, uint32_t numBytes) const {
+    if (numBytes < getSerializedHeaderLength()) {
+        return false;
+    }
+
     // Fill in the header with the magic identifier, format info, and dimensions.
     SerializationHeader header = {};
     memcpy(header.magic, MAGIC, sizeof(MAGIC));
@@ -214,45 +281,21 @@ bool KtxBundle::serialize(uint8_t* destination, uint32_t numBytes) const {
         pdata += iter.second.size();
         pdata += kvpadding;
     }
-
-    // One aspect of the KTX spec is that the semantics differ for non-array cubemaps.
-    const bool isNonArrayCube = mNumCubeFaces > 1 && mArrayLength == 1;
-    const uint32_t facesPerMip = mArrayLength * mNumCubeFaces;
-
-    // Extract blobs from the serialized byte stream.
-    for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
-
-        // Every blob in a given miplevel has the same size, and each miplevel has at least one
-        // blob. Therefore we can safely determine each of the so-called "imageSize" fields in KTX
-        // by simply looking at the first blob in the LOD.
-        uint32_t faceSize;
-        uint8_t* blobData;
-        getBlob({mipmap, 0, 0}, &blobData, &faceSize);
-        uint32_t imageSize = isNonArrayCube ? faceSize : (faceSize * facesPerMip);
-        *((uint32_t*) pdata) = imageSize;
-        pdata += sizeof(imageSize);
-
-        // Next, copy out the actual blobs.
-        for (uint32_t layer = 0; layer < mArrayLength; ++layer) {
-            for (uint32_t face = 0; face < mNumCubeFaces; ++face) {
-                if (!getBlob({mipmap, layer, face}, &blobData, &faceSize)) {
-                    return false;
-                }
-                memcpy(pdata, blobData, faceSize);
-                pdata += faceSize;
-            }
-        }
-    }
     return true;
 }
 
-uint32_t KtxBundle::getSerializedLength() const {
+uint32_t KtxBundle::getSerializedHeaderLength() const {
     uint32_t total = sizeof(SerializationHeader);
     for (const auto& iter : mMetadata->keyvals) {
         const uint32_t kvsize = iter.first.size() + 1 + iter.second.size();
         const uint32_t kvpadding = 3 - ((kvsize + 3) % 4);
         total += sizeof(uint32_t) + kvsize + kvpadding;
     }
+    return total;
+}
+
+uint32_t KtxBundle::getSerializedLength() const {
+    uint32_t total = getSerializedHeaderLength();
     for (uint32_t mipmap = 0; mipmap < mNumMipLevels; ++mipmap) {
         total += sizeof(uint32_t);
         size_t blobSize = 0;
@@ -324,6 +367,9 @@ bool KtxBundle::setBlob(KtxBlobIndex index, uint8_t const* data, uint32_t size)
             index.cubeFace >= mNumCubeFaces) {
         return false;
     }
+    if (isView()) {
+        return false;
+    }
     uint32_t flatIndex = flatten(this, index);
     uint32_t blobSize = mBlobs->sizes[flatIndex];
     if (blobSize != size) {
@@ -338,6 +384,9 @@ bool KtxBundle::allocateBlob(KtxBlobIndex index, uint32_t size) {
             index.cubeFace >= mNumCubeFaces) {
         return false;
     }
+    if (isView()) {
+        return false;
+    }
     uint32_t flatIndex = flatten(this, index);
     mBlobs->resize(flatIndex, size);
     return true;
@@ -20,12 +20,14 @@
 #include <image/ImageSampler.h>
 #include <image/LinearImage.h>
 
+#include <blockcompression/BlockCompression.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageDiffer.h>
 #include <imageio/ImageEncoder.h>
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -362,6 +364,119 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, ParallelResampling) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // Rows processed in parallel must give the exact same result as the serial path.
+    LinearImage src = resampleImage(createColorFromAscii("01234 56789 13579 02468"), 160, 90,
+            Filter::GAUSSIAN_SCALARS);
+    for (Filter filter : { Filter::LANCZOS, Filter::MITCHELL, Filter::MINIMUM }) {
+        LinearImage serial = resampleImage(src, 67, 301, filter);
+        LinearImage parallel = resampleImage(src, 67, 301, filter, &js);
+        const float* a = serial.getPixelRef();
+        const float* b = parallel.getPixelRef();
+        for (uint32_t i = 0, n = 67 * 301 * src.getChannels(); i < n; i++) {
+            ASSERT_EQ(a[i], b[i]);
+        }
+    }
+
+    // Cascaded miplevels have the same dimensions, and a constant image remains constant.
+    LinearImage gray(37, 20, 1);
+    clearToValue(gray, 0.25f);
+    const uint32_t count = getMipmapCount(gray);
+    vector<LinearImage> mips(count);
+    generateMipmaps(gray, Filter::BOX, mips.data(), count, MipmapMode::CASCADED, &js);
+    uint32_t width = gray.getWidth(), height = gray.getHeight();
+    for (const LinearImage& mip : mips) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        ASSERT_EQ(mip.getWidth(), width);
+        ASSERT_EQ(mip.getHeight(), height);
+        for (uint32_t i = 0; i < width * height; i++) {
+            EXPECT_FLOAT_EQ(mip.getPixelRef()[i], 0.25f);
+        }
+    }
+
+    js.emancipate();
+}
+
+TEST_F(ImageTest, BandResampling) { // NOLINT
+    // Feeding the source in uneven bands must give the exact same result as the whole image.
+    LinearImage src = resampleImage(createColorFromAscii("01234 56789 13579 02468"), 160, 90,
+            Filter::GAUSSIAN_SCALARS);
+    for (Filter filter : { Filter::LANCZOS, Filter::BOX, Filter::MINIMUM, Filter::DEFAULT }) {
+        for (uint32_t height : { 301u, 45u, 7u, 1u }) {
+            LinearImage whole = resampleImage(src, 67, height, filter);
+            BandResampler resampler(src.getWidth(), src.getHeight(), 67, height, filter);
+            vector<float> rows;
+            for (uint32_t y = 0, band = 1; y < src.getHeight(); y += band, band = band % 13 + 2) {
+                band = std::min(band, src.getHeight() - y);
+                LinearImage result = resampler.push(cropRegion(src, 0, y, src.getWidth(), y + band));
+                if (result.isValid()) {
+                    ASSERT_EQ(result.getWidth(), 67);
+                    const float* data = result.getPixelRef();
+                    rows.insert(rows.end(), data,
+                            data + result.getWidth() * result.getHeight() * result.getChannels());
+                }
+            }
+            ASSERT_EQ(resampler.getCompletedRows(), height);
+            ASSERT_EQ(rows.size(), 67 * height * src.getChannels());
+            for (size_t i = 0; i < rows.size(); i++) {
+                ASSERT_EQ(rows[i], whole.getPixelRef()[i]);
+            }
+        }
+    }
+}
+
+TEST_F(ImageTest, AstcRoundTrip) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // An odd-sized image spans partial blocks, and decoding rows in parallel must give the same
+    // result as decoding them serially. A smooth gradient keeps the compression error low.
+    LinearImage src(37, 29, 3);
+    for (uint32_t y = 0; y < 29; y++) {
+        for (uint32_t x = 0; x < 37; x++) {
+            float* texel = src.getPixelRef(x, y);
+            texel[0] = x / 36.0f;
+            texel[1] = y / 28.0f;
+            texel[2] = 0.5f;
+        }
+    }
+    AstcConfig config = astcParseOptionString("fast_ldr_5x4");
+    CompressedTexture texture = astcCompress(src, config, &js);
+    ASSERT_EQ(texture.format, CompressedFormat::RGBA_ASTC_5x4);
+
+    LinearImage parallel = astcDecompress(texture.data.get(), texture.size, texture.format,
+            37, 29, &js);
+    LinearImage serial = astcDecompress(texture.data.get(), texture.size, texture.format, 37, 29);
+    ASSERT_EQ(parallel.getWidth(), 37);
+    ASSERT_EQ(parallel.getHeight(), 29);
+    ASSERT_EQ(parallel.getChannels(), 4);
+    for (uint32_t y = 0; y < 29; y++) {
+        for (uint32_t x = 0; x < 37; x++) {
+            float const* expected = src.getPixelRef(x, y);
+            float const* actual = parallel.getPixelRef(x, y);
+            ASSERT_NEAR(actual[0], expected[0], 0.05f);
+            ASSERT_NEAR(actual[1], expected[1], 0.05f);
+            ASSERT_NEAR(actual[2], expected[2], 0.05f);
+            ASSERT_EQ(actual[3], 1.0f);
+            for (uint32_t c = 0; c < 4; c++) {
+                ASSERT_EQ(actual[c], serial.getPixelRef(x, y)[c]);
+            }
+        }
+    }
+
+    // Invalid formats and truncated data are rejected.
+    EXPECT_FALSE(astcDecompress(texture.data.get(), texture.size, CompressedFormat::RGB8_ETC2,
+            37, 29).isValid());
+    EXPECT_FALSE(astcDecompress(texture.data.get(), texture.size - 16, texture.format,
+            37, 29).isValid());
+
+    js.emancipate();
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
@@ -378,6 +493,43 @@ TEST_F(ImageTest, Ktx) { // NOLINT
 
     const uint32_t KTX_HEADER_SIZE = 16 * 4;
 
+    // The header alone is the beginning of the serialized bundle.
+    nascent.setBlob({1, 0, 0}, foo, sizeof(foo));
+    for (uint32_t face = 1; face < 6; face++) {
+        nascent.setBlob({0, 0, face}, foo, sizeof(foo));
+        nascent.setBlob({1, 0, face}, foo, sizeof(foo));
+    }
+    nascent.setMetadata("foo", "bar");
+    vector<uint8_t> whole(nascent.getSerializedLength());
+    ASSERT_TRUE(nascent.serialize(whole.data(), whole.size()));
+    vector<uint8_t> header(nascent.getSerializedHeaderLength());
+    ASSERT_EQ(header.size(), KTX_HEADER_SIZE + sizeof(uint32_t) + 8);
+    ASSERT_FALSE(nascent.serializeHeader(header.data(), header.size() - 1));
+    ASSERT_TRUE(nascent.serializeHeader(header.data(), header.size()));
+    ASSERT_TRUE(std::equal(header.begin(), header.end(), whole.begin()));
+
+    // A view refers to the serialized data rather than copying it.
+    KtxBundle view(whole.data(), whole.size(), KtxBundle::Storage::VIEW);
+    ASSERT_TRUE(view.isView());
+    ASSERT_FALSE(nascent.isView());
+    ASSERT_EQ(view.getNumMipLevels(), 2);
+    ASSERT_TRUE(view.isCubemap());
+    ASSERT_EQ(string(view.getMetadata("foo")), "bar");
+    for (uint32_t level = 0; level < 2; level++) {
+        for (uint32_t face = 0; face < 6; face++) {
+            ASSERT_TRUE(view.getBlob({level, 0, face}, &data, &size));
+            ASSERT_EQ(size, sizeof(foo));
+            ASSERT_GE(data, whole.data());
+            ASSERT_LT(data, whole.data() + whole.size());
+            ASSERT_EQ(memcmp(data, foo, sizeof(foo)), 0);
+        }
+    }
+    ASSERT_FALSE(view.setBlob({0, 0, 0}, foo, sizeof(foo)));
+    ASSERT_FALSE(view.allocateBlob({0, 0, 0}, 1));
+    vector<uint8_t> reserialized(view.getSerializedLength());
+    ASSERT_TRUE(view.serialize(reserialized.data(), reserialized.size()));
+    ASSERT_EQ(reserialized, whole);
+
     auto getFileSize = [](const char* filename) {
         std::ifstream in(filename, std::ifstream::ate | std::ifstream::binary);
         return in.tellg();
@@ -18,6 +18,7 @@
 #define IMAGE_IMAGEDECODER_H_
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 
 #include <image/LinearImage.h>
@@ -52,6 +53,26 @@ public:
         ColorSpace mColorSpace = ColorSpace::SRGB;
     };
 
+    // Decodes an image a band of rows at a time, from top to bottom, which allows images that
+    // don't fit in memory to be processed.
+    class RowDecoder {
+    public:
+        virtual ~RowDecoder() = default;
+
+        virtual uint32_t getWidth() const noexcept = 0;
+        virtual uint32_t getHeight() const noexcept = 0;
+        virtual uint32_t getChannels() const noexcept = 0;
+
+        // Returns linear floating-point data for the next rows, at most "count" of them, or a
+        // non-valid image once all rows have been decoded or if an error occured.
+        virtual LinearImage decodeRows(uint32_t count) = 0;
+    };
+
+    // Returns null if the format doesn't support decoding rows incrementally, or if an error
+    // occured while reading the header. Only non-interlaced PNG files are currently supported.
+    static std::unique_ptr<RowDecoder> createRowDecoder(std::istream& stream,
+            ColorSpace sourceSpace = ColorSpace::SRGB);
+
 private:
     enum class Format {
         NONE,
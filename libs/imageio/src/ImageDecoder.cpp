@@ -18,6 +18,7 @@
 
 #include <imageio/ImageDecoder.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring> // for memcmp
 #include <iostream> // for cerr
@@ -46,7 +47,7 @@
 
 namespace image {
 
-class PNGDecoder : public ImageDecoder::Decoder {
+class PNGDecoder : public ImageDecoder::Decoder, public ImageDecoder::RowDecoder {
 public:
     static PNGDecoder* create(std::istream& stream);
     static bool checkSignature(char const* buf);
@@ -54,15 +55,27 @@ public:
     PNGDecoder(const PNGDecoder&) = delete;
     PNGDecoder& operator=(const PNGDecoder&) = delete;
 
+    // Reads the header and sets up the conversions, returns false if the image cannot be
+    // decoded incrementally.
+    bool initRows();
+
 private:
     explicit PNGDecoder(std::istream& stream);
     ~PNGDecoder() override;
 
     void init();
+    void readHeader();
+    LinearImage toLinearRows(uint32_t rowCount, const uint8_t* data) const;
 
     // ImageDecoder::Decoder interface
     LinearImage decode() override;
 
+    // ImageDecoder::RowDecoder interface
+    uint32_t getWidth() const noexcept override { return mWidth; }
+    uint32_t getHeight() const noexcept override { return mHeight; }
+    uint32_t getChannels() const noexcept override { return mChannels; }
+    LinearImage decodeRows(uint32_t count) override;
+
     static void cb_error(png_structp, png_const_charp);
     static void cb_stream(png_structp png, png_bytep buffer, png_size_t size);
 
@@ -73,6 +86,11 @@ private:
     png_infop mInfo = nullptr;
     std::istream& mStream;
     std::streampos mStreamStartPos;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mChannels = 0;
+    uint32_t mNextRow = 0;
+    size_t mRowBytes = 0;
 };
 
 // -----------------------------------------------------------------------------------------------
@@ -191,6 +209,26 @@ LinearImage ImageDecoder::decode(std::istream& stream, const std::string& source
     return decoder->decode();
 }
 
+std::unique_ptr<ImageDecoder::RowDecoder> ImageDecoder::createRowDecoder(std::istream& stream,
+        ColorSpace sourceSpace) {
+    std::streampos pos = stream.tellg();
+    char buf[16];
+    stream.read(buf, sizeof(buf));
+    const bool isPNG = stream.good() && PNGDecoder::checkSignature(buf);
+    stream.seekg(pos);
+    if (!isPNG) {
+        return nullptr;
+    }
+
+    PNGDecoder* decoder = PNGDecoder::create(stream);
+    std::unique_ptr<RowDecoder> result(decoder);
+    decoder->setColorSpace(sourceSpace);
+    if (!decoder->initRows()) {
+        return nullptr;
+    }
+    return result;
+}
+
 // -----------------------------------------------------------------------------------------------
 
 static inline float read32(std::istream& istream) {
@@ -232,75 +270,84 @@ PNGDecoder::~PNGDecoder() {
     png_destroy_read_struct(&mPNG, &mInfo, nullptr);
 }
 
-LinearImage PNGDecoder::decode() {
-    std::unique_ptr<uint8_t[]> imageData;
-    try {
-        mInfo = png_create_info_struct(mPNG);
-        png_read_info(mPNG, mInfo);
+void PNGDecoder::readHeader() {
+    mInfo = png_create_info_struct(mPNG);
+    png_read_info(mPNG, mInfo);
 
-        int colorType = png_get_color_type(mPNG, mInfo);
-        int bitDepth = png_get_bit_depth(mPNG, mInfo);
+    int colorType = png_get_color_type(mPNG, mInfo);
+    int bitDepth = png_get_bit_depth(mPNG, mInfo);
 
-        if (colorType == PNG_COLOR_TYPE_PALETTE) {
-            png_set_palette_to_rgb(mPNG);
-        }
-        if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) {
-            if (bitDepth < 8) {
-                png_set_expand_gray_1_2_4_to_8(mPNG);
-            }
-            png_set_gray_to_rgb(mPNG);
-        }
-        if (png_get_valid(mPNG, mInfo, PNG_INFO_tRNS)) {
-            png_set_tRNS_to_alpha(mPNG);
+    if (colorType == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(mPNG);
+    }
+    if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        if (bitDepth < 8) {
+            png_set_expand_gray_1_2_4_to_8(mPNG);
         }
+        png_set_gray_to_rgb(mPNG);
+    }
+    if (png_get_valid(mPNG, mInfo, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(mPNG);
+    }
+    if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
+        png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_DEFAULT_sRGB);
+    } else {
+        png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_GAMMA_LINEAR);
+    }
+    if (bitDepth < 16) {
+        png_set_expand_16(mPNG);
+    }
+
+    png_read_update_info(mPNG, mInfo);
+
+    // Read updated color type since we may have asked for a conversion before
+    colorType = png_get_color_type(mPNG, mInfo);
+
+    mWidth  = png_get_image_width(mPNG, mInfo);
+    mHeight = png_get_image_height(mPNG, mInfo);
+    mChannels = colorType == PNG_COLOR_TYPE_RGBA ? 4 : 3;
+    mRowBytes = png_get_rowbytes(mPNG, mInfo);
+}
+
+LinearImage PNGDecoder::toLinearRows(uint32_t rowCount, const uint8_t* data) const {
+    if (mChannels == 4) {
         if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-            png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_DEFAULT_sRGB);
+            return toLinearWithAlpha<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    sRGBToLinear<filament::math::float4>);
         } else {
-            png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_GAMMA_LINEAR);
+            return toLinearWithAlpha<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    [](const filament::math::float4& color) ->  filament::math::float4 { return color; });
         }
-        if (bitDepth < 16) {
-            png_set_expand_16(mPNG);
+    } else {
+        // Convert to linear float (PNG 16 stores data in network order (big endian).
+        if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
+            return toLinear<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    sRGBToLinear< filament::math::float3>);
+        } else {
+            return toLinear<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    [](const filament::math::float3& color) ->  filament::math::float3 { return color; });
         }
+    }
+}
 
-        png_read_update_info(mPNG, mInfo);
-
-        // Read updated color type since we may have asked for a conversion before
-        colorType = png_get_color_type(mPNG, mInfo);
-
-        uint32_t width  = png_get_image_width(mPNG, mInfo);
-        uint32_t height = png_get_image_height(mPNG, mInfo);
-        size_t rowBytes = png_get_rowbytes(mPNG, mInfo);
+LinearImage PNGDecoder::decode() {
+    std::unique_ptr<uint8_t[]> imageData;
+    try {
+        readHeader();
 
-        imageData = std::make_unique<uint8_t[]>(height * rowBytes);
-        std::unique_ptr<png_bytep[]> rowPointers(new png_bytep[height]);
-        for (size_t y = 0 ; y < height ; y++) {
-            rowPointers[y] = &imageData[y * rowBytes];
+        imageData = std::make_unique<uint8_t[]>(mHeight * mRowBytes);
+        std::unique_ptr<png_bytep[]> rowPointers(new png_bytep[mHeight]);
+        for (size_t y = 0 ; y < mHeight ; y++) {
+            rowPointers[y] = &imageData[y * mRowBytes];
         }
         png_read_image(mPNG, rowPointers.get());
         png_read_end(mPNG, mInfo);
 
-        if (colorType == PNG_COLOR_TYPE_RGBA) {
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear<filament::math::float4>);
-            } else {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        [](const filament::math::float4& color) ->  filament::math::float4 { return color; });
-            }
-        } else {
-            // Convert to linear float (PNG 16 stores data in network order (big endian).
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear< filament::math::float3>);
-            } else {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        [](const filament::math::float3& color) ->  filament::math::float3 { return color; });
-            }
-        }
+        return toLinearRows(mHeight, imageData.get());
     } catch(std::runtime_error& e) {
         // reset the stream, like we found it
         std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
@@ -310,6 +357,39 @@ LinearImage PNGDecoder::decode() {
     return LinearImage();
 }
 
+bool PNGDecoder::initRows() {
+    try {
+        readHeader();
+    } catch(std::runtime_error& e) {
+        std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
+        return false;
+    }
+    // Interlaced images need all of their passes before any row is complete.
+    return png_get_interlace_type(mPNG, mInfo) == PNG_INTERLACE_NONE;
+}
+
+LinearImage PNGDecoder::decodeRows(uint32_t count) {
+    count = std::min(count, mHeight - mNextRow);
+    if (count == 0) {
+        return LinearImage();
+    }
+    try {
+        std::unique_ptr<uint8_t[]> rowData = std::make_unique<uint8_t[]>(count * mRowBytes);
+        for (size_t y = 0 ; y < count ; y++) {
+            png_read_row(mPNG, &rowData[y * mRowBytes], nullptr);
+        }
+        mNextRow += count;
+        if (mNextRow == mHeight) {
+            png_read_end(mPNG, mInfo);
+        }
+        return toLinearRows(count, rowData.get());
+    } catch(std::runtime_error& e) {
+        std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
+        mNextRow = mHeight;
+    }
+    return LinearImage();
+}
+
 void PNGDecoder::cb_stream(png_structp png, png_bytep buffer, png_size_t size) {
     PNGDecoder* that = static_cast<PNGDecoder*>(png_get_io_ptr(png));
     that->stream(buffer, size);
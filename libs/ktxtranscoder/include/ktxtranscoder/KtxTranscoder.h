@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KTXTRANSCODER_KTXTRANSCODER_H
+#define KTXTRANSCODER_KTXTRANSCODER_H
+
+#include <image/KtxBundle.h>
+
+#include <blockcompression/BlockCompression.h>
+
+#include <utils/Path.h>
+
+#include <memory>
+
+#include <stdint.h>
+
+namespace filament {
+class Engine;
+class Texture;
+} // namespace filament
+
+namespace image {
+
+/**
+ * KtxTranscoder converts ASTC-compressed KTX bundles to a compressed format that the device
+ * supports, so that assets can ship in a single format without falling back to RGBA8 in GPU
+ * memory on devices that lack ASTC.
+ *
+ * The target format is the first one supported by the engine in this order:
+ * - ETC2 (RGB8 when the texture is opaque, RGBA8 EAC otherwise)
+ * - BC (DXT1 when the texture is opaque, DXT5 otherwise)
+ * - uncompressed RGBA8, as a last resort
+ *
+ * sRGB sources produce sRGB variants of these formats. Each level is decoded and recompressed on
+ * the engine's JobSystem, therefore the KtxTranscoder must be used from a thread adopted by it,
+ * e.g. the thread that created the engine.
+ *
+ * When a cache directory is given, transcoded bundles are stored there in files named after a
+ * hash of the source's contents and the target format family, and they are loaded from there on
+ * subsequent runs instead of being transcoded again. The directory can be shared by several
+ * processes.
+ *
+ * Example:
+ *
+ * ```
+ * KtxTranscoder::Config config;
+ * config.cacheDirectory = utils::Path::getTemporaryDirectory() + "ktx";
+ * KtxTranscoder transcoder(*engine, config);
+ *
+ * auto* ktx = new image::KtxBundle(bytes, size);
+ * Texture* texture = transcoder.createTexture(ktx, false);
+ * ```
+ */
+class KtxTranscoder {
+public:
+    //! Families of formats that bundles can be transcoded to.
+    enum class Target {
+        ETC2,
+        BC,
+        RGBA8,
+    };
+
+    struct Config {
+        //! Where transcoded bundles are cached, created if needed. Empty disables the cache.
+        utils::Path cacheDirectory;
+        //! Quality / speed tradeoff of the encoders.
+        CompressionPreset preset = CompressionPreset::FASTEST;
+    };
+
+    KtxTranscoder(filament::Engine& engine, Config config);
+
+    //! Creates a KtxTranscoder with the default configuration, which has no cache.
+    explicit KtxTranscoder(filament::Engine& engine);
+
+    //! Returns true if the engine can create a texture from the given bundle as is.
+    bool isSupported(KtxBundle const& ktx) const noexcept;
+
+    /**
+     * Transcodes the given bundle to the best format supported by the engine.
+     *
+     * @return The transcoded bundle, or nullptr if the bundle is already supported, or if it
+     *         can't be transcoded because it isn't ASTC-compressed.
+     */
+    std::unique_ptr<KtxBundle> transcode(KtxBundle const& ktx) const;
+
+    /**
+     * Transcodes the given bundle to a format of the given family, whether or not the engine
+     * supports it, e.g. to prepare assets for another device.
+     *
+     * @return The transcoded bundle, or nullptr if the bundle isn't ASTC-compressed.
+     */
+    std::unique_ptr<KtxBundle> transcode(KtxBundle const& ktx, Target target) const;
+
+    /**
+     * Creates a Texture from the given bundle like ktx::createTexture(), transcoding it first if
+     * needed. The bundle is destroyed once it isn't needed anymore.
+     *
+     * @param ktx   bundle to create the texture from, ownership is transferred
+     * @param srgb  forces the KTX-specified format into an SRGB format if possible
+     * @return The texture, or nullptr if the bundle isn't supported and can't be transcoded.
+     */
+    filament::Texture* createTexture(KtxBundle* ktx, bool srgb) const;
+
+private:
+    filament::Engine& mEngine;
+    Config mConfig;
+};
+
+} // namespace image
+
+#endif // KTXTRANSCODER_KTXTRANSCODER_H
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ktxtranscoder/KtxTranscoder.h>
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <image/KtxUtility.h>
+#include <image/LinearImage.h>
+
+#include <utils/CacheFile.h>
+#include <utils/JobSystem.h>
+#include <utils/Log.h>
+#include <utils/Systrace.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace filament;
+using namespace utils;
+
+namespace image {
+
+namespace {
+
+using Target = KtxTranscoder::Target;
+
+// "KTXT", identifies the cache files of transcoded bundles.
+constexpr uint32_t CACHE_MAGIC = 0x5458544b;
+
+const char* const TARGET_NAMES[] = { "etc2", "bc", "rgba8" };
+
+// Each target has an opaque and a translucent variant of both color spaces.
+uint32_t getTargetFormat(Target target, bool srgb, bool opaque) {
+    switch (target) {
+        case Target::ETC2:
+            if (opaque) {
+                return srgb ? KtxBundle::SRGB8_ETC2 : KtxBundle::RGB8_ETC2;
+            }
+            return srgb ? KtxBundle::SRGB8_ALPHA8_ETC2_EAC : KtxBundle::RGBA8_ETC2_EAC;
+        case Target::BC:
+            if (opaque) {
+                return srgb ? KtxBundle::SRGB_S3TC_DXT1 : KtxBundle::RGB_S3TC_DXT1;
+            }
+            return srgb ? KtxBundle::SRGB_ALPHA_S3TC_DXT5 : KtxBundle::RGBA_S3TC_DXT5;
+        case Target::RGBA8:
+            return srgb ? KtxBundle::SRGB8_ALPHA8 : KtxBundle::RGBA8;
+    }
+    return 0;
+}
+
+bool isFormatSupported(Engine& engine, uint32_t glInternalFormat) {
+    KtxInfo info{};
+    info.glInternalFormat = glInternalFormat;
+    return Texture::isTextureFormatSupported(engine, ktx::toTextureFormat(info));
+}
+
+bool isAstc(KtxInfo const& info) {
+    const uint32_t format = info.glInternalFormat;
+    return (format >= KtxBundle::RGBA_ASTC_4x4 && format <= KtxBundle::RGBA_ASTC_12x12) ||
+            (format >= KtxBundle::SRGB8_ALPHA8_ASTC_4x4 &&
+                    format <= KtxBundle::SRGB8_ALPHA8_ASTC_12x12);
+}
+
+bool isSrgb(KtxInfo const& info) {
+    return info.glInternalFormat >= KtxBundle::SRGB8_ALPHA8_ASTC_4x4 &&
+            info.glInternalFormat <= KtxBundle::SRGB8_ALPHA8_ASTC_12x12;
+}
+
+// 64-bit FNV-1a, which is good enough to tell assets apart and doesn't need aligned data.
+uint64_t hashBytes(uint64_t hash, uint8_t const* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t hashBundle(KtxBundle const& ktx) {
+    KtxInfo const& info = ktx.getInfo();
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, (uint8_t const*) &info, sizeof(info));
+    const uint32_t nfaces = ktx.isCubemap() ? 6 : 1;
+    for (uint32_t level = 0; level < ktx.getNumMipLevels(); level++) {
+        for (uint32_t layer = 0; layer < ktx.getArrayLength(); layer++) {
+            for (uint32_t face = 0; face < nfaces; face++) {
+                uint8_t* data;
+                uint32_t size;
+                if (ktx.getBlob({ level, layer, face }, &data, &size)) {
+                    hash = hashBytes(hash, data, size);
+                }
+            }
+        }
+    }
+    return hash;
+}
+
+std::unique_ptr<KtxBundle> loadBundle(Path const& path, uint64_t key, KtxBundle const& source) {
+    std::vector<uint8_t> contents;
+    if (!CacheFile::read(path, CACHE_MAGIC, key, &contents)) {
+        return nullptr;
+    }
+    auto ktx = std::make_unique<KtxBundle>(contents.data(), uint32_t(contents.size()));
+    if (ktx->getNumMipLevels() != source.getNumMipLevels() ||
+            ktx->getArrayLength() != source.getArrayLength() ||
+            ktx->isCubemap() != source.isCubemap() ||
+            ktx->getInfo().pixelWidth != source.getInfo().pixelWidth ||
+            ktx->getInfo().pixelHeight != source.getInfo().pixelHeight) {
+        return nullptr;
+    }
+    return ktx;
+}
+
+void storeBundle(Path const& path, uint64_t key, KtxBundle const& ktx) {
+    std::vector<uint8_t> contents(ktx.getSerializedLength());
+    if (!ktx.serialize(contents.data(), uint32_t(contents.size()))) {
+        return;
+    }
+    const Path directory = path.getParent();
+    if (!directory.exists() && !directory.mkdirRecursive()) {
+        slog.w << "Unable to create the KTX cache directory " << directory << io::endl;
+        return;
+    }
+    if (!CacheFile::write(path, CACHE_MAGIC, key, contents.data(), contents.size())) {
+        slog.w << "Unable to write " << path << io::endl;
+    }
+}
+
+bool isOpaque(LinearImage const& image) {
+    float const* data = image.getPixelRef();
+    const size_t count = size_t(image.getWidth()) * image.getHeight();
+    for (size_t i = 0; i < count; i++) {
+        if (data[i * 4 + 3] < 1.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void toRGBA8(LinearImage const& image, uint8_t* dst) {
+    float const* src = image.getPixelRef();
+    const size_t count = size_t(image.getWidth()) * image.getHeight() * 4;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = uint8_t(std::min(std::max(src[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+} // anonymous namespace
+
+KtxTranscoder::KtxTranscoder(Engine& engine, Config config)
+        : mEngine(engine), mConfig(std::move(config)) {
+}
+
+KtxTranscoder::KtxTranscoder(Engine& engine) : KtxTranscoder(engine, Config{}) {
+}
+
+bool KtxTranscoder::isSupported(KtxBundle const& ktx) const noexcept {
+    return Texture::isTextureFormatSupported(mEngine, ktx::toTextureFormat(ktx.getInfo()));
+}
+
+std::unique_ptr<KtxBundle> KtxTranscoder::transcode(KtxBundle const& source) const {
+    KtxInfo const& info = source.getInfo();
+    if (isSupported(source) || !isAstc(info)) {
+        return nullptr;
+    }
+
+    // Pick the first target for which the engine supports both variants.
+    const bool srgb = isSrgb(info);
+    Target target = Target::RGBA8;
+    for (Target candidate : { Target::ETC2, Target::BC }) {
+        if (isFormatSupported(mEngine, getTargetFormat(candidate, srgb, true)) &&
+                isFormatSupported(mEngine, getTargetFormat(candidate, srgb, false))) {
+            target = candidate;
+            break;
+        }
+    }
+    return transcode(source, target);
+}
+
+std::unique_ptr<KtxBundle> KtxTranscoder::transcode(KtxBundle const& source, Target target) const {
+    SYSTRACE_CALL();
+
+    KtxInfo const& info = source.getInfo();
+    if (!isAstc(info)) {
+        return nullptr;
+    }
+    const bool srgb = isSrgb(info);
+
+    // Files are named after the hash of the source, which is also checked when they're read.
+    Path cachePath;
+    uint64_t key = 0;
+    if (!mConfig.cacheDirectory.isEmpty()) {
+        key = hashBundle(source);
+        char name[64];
+        snprintf(name, sizeof(name), "%016llx-%s-%d.ktx", (unsigned long long) key,
+                TARGET_NAMES[int(target)], int(mConfig.preset));
+        cachePath = mConfig.cacheDirectory + name;
+        if (cachePath.exists()) {
+            std::unique_ptr<KtxBundle> cached = loadBundle(cachePath, key, source);
+            if (cached) {
+                return cached;
+            }
+        }
+    }
+
+    JobSystem& js = mEngine.getJobSystem();
+    const uint32_t nlevels = source.getNumMipLevels();
+    const uint32_t nlayers = source.getArrayLength();
+    const uint32_t nfaces = source.isCubemap() ? 6 : 1;
+
+    auto decode = [&](uint32_t level, uint32_t layer, uint32_t face) {
+        uint8_t* data;
+        uint32_t size;
+        if (!source.getBlob({ level, layer, face }, &data, &size)) {
+            return LinearImage();
+        }
+        return astcDecompress(data, size, CompressedFormat(info.glInternalFormat),
+                std::max(info.pixelWidth >> level, 1u), std::max(info.pixelHeight >> level, 1u),
+                &js);
+    };
+
+    // The opaque variant is only chosen when the base level is opaque everywhere, so the base
+    // level is decoded up front.
+    std::vector<LinearImage> baseLevel;
+    bool opaque = true;
+    for (uint32_t layer = 0; layer < nlayers; layer++) {
+        for (uint32_t face = 0; face < nfaces; face++) {
+            baseLevel.push_back(decode(0, layer, face));
+            if (baseLevel.back().getWidth() == 0) {
+                return nullptr;
+            }
+            opaque = opaque && isOpaque(baseLevel.back());
+        }
+    }
+
+    const uint32_t format = getTargetFormat(target, srgb, opaque);
+    CompressionConfig config{};
+    if (target == Target::ETC2) {
+        config.type = CompressionConfig::ETC;
+        config.etc = { CompressedFormat(format),
+                opaque ? EtcErrorMetric::RGBX : EtcErrorMetric::RGBA, 0 };
+    } else if (target == Target::BC) {
+        config.type = CompressionConfig::S3TC;
+        config.s3tc = { CompressedFormat(format), srgb, false };
+    }
+    applyCompressionPreset(&config, mConfig.preset);
+
+    auto result = std::make_unique<KtxBundle>(nlevels, nlayers, source.isCubemap());
+    KtxInfo& dstInfo = result->info();
+    dstInfo = info;
+    dstInfo.glInternalFormat = format;
+    if (target == Target::RGBA8) {
+        dstInfo.glType = KtxBundle::UNSIGNED_BYTE;
+        dstInfo.glTypeSize = 1;
+        dstInfo.glFormat = dstInfo.glBaseInternalFormat = KtxBundle::RGBA;
+    } else {
+        // The KTX spec says the following for compressed textures: glTypeSize should 1,
+        // glFormat should be 0, and glBaseInternalFormat should be RED, RG, RGB, or RGBA.
+        dstInfo.glType = 0;
+        dstInfo.glTypeSize = 1;
+        dstInfo.glFormat = 0;
+        dstInfo.glBaseInternalFormat = opaque ? KtxBundle::RGB : KtxBundle::RGBA;
+    }
+
+    auto encode = [&](LinearImage const& image, KtxBlobIndex index) {
+        if (target == Target::RGBA8) {
+            std::vector<uint8_t> texels(size_t(image.getWidth()) * image.getHeight() * 4);
+            toRGBA8(image, texels.data());
+            return result->setBlob(index, texels.data(), uint32_t(texels.size()));
+        }
+        CompressedTexture texture = compressTexture(config, image, &js);
+        return texture.data && result->setBlob(index, texture.data.get(), texture.size);
+    };
+
+    for (uint32_t level = 0; level < nlevels; level++) {
+        for (uint32_t layer = 0; layer < nlayers; layer++) {
+            for (uint32_t face = 0; face < nfaces; face++) {
+                LinearImage image;
+                if (level == 0) {
+                    image = baseLevel[layer * nfaces + face];
+                } else {
+                    image = decode(level, layer, face);
+                }
+                if (image.getWidth() == 0 || !encode(image, { level, layer, face })) {
+                    return nullptr;
+                }
+            }
+        }
+        if (level == 0) {
+            baseLevel.clear();
+        }
+    }
+
+    if (!cachePath.isEmpty()) {
+        storeBundle(cachePath, key, *result);
+    }
+    return result;
+}
+
+Texture* KtxTranscoder::createTexture(KtxBundle* ktx, bool srgb) const {
+    std::unique_ptr<KtxBundle> transcoded = transcode(*ktx);
+    if (transcoded) {
+        delete ktx;
+        ktx = transcoded.release();
+    } else if (!isSupported(*ktx)) {
+        delete ktx;
+        return nullptr;
+    }
+    return ktx::createTexture(&mEngine, ktx, srgb);
+}
+
+} // namespace image
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ktxtranscoder/KtxTranscoder.h>
+
+#include <blockcompression/BlockCompression.h>
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <image/KtxBundle.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+#include <utils/Path.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+using namespace filament;
+using namespace image;
+
+using utils::Path;
+
+class KtxTranscoderTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+    }
+
+    void TearDown() override {
+        Engine::destroy(&mEngine);
+    }
+
+    Engine* mEngine = nullptr;
+};
+
+// Creates an ASTC 4x4 bundle with all the levels of a square gradient.
+static std::unique_ptr<KtxBundle> createAstcBundle(utils::JobSystem& js, uint32_t size,
+        float alpha) {
+    uint32_t levelCount = 1;
+    while ((size >> levelCount) > 0) {
+        levelCount++;
+    }
+    auto ktx = std::make_unique<KtxBundle>(levelCount, 1, false);
+    const AstcConfig config = astcParseOptionString("fast_ldr_4x4");
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const uint32_t dim = std::max(size >> level, 1u);
+        LinearImage image(dim, dim, 4);
+        for (uint32_t y = 0; y < dim; y++) {
+            for (uint32_t x = 0; x < dim; x++) {
+                float* texel = image.getPixelRef(x, y);
+                texel[0] = float(x) / dim;
+                texel[1] = float(y) / dim;
+                texel[2] = 0.5f;
+                texel[3] = alpha;
+            }
+        }
+        CompressedTexture texture = astcCompress(image, config, &js);
+        EXPECT_TRUE(ktx->setBlob({ level, 0, 0 }, texture.data.get(), texture.size));
+    }
+    KtxInfo& info = ktx->info();
+    info.endianness = KtxBundle::ENDIAN_DEFAULT;
+    info.glType = 0;
+    info.glTypeSize = 1;
+    info.glFormat = 0;
+    info.glInternalFormat = KtxBundle::RGBA_ASTC_4x4;
+    info.glBaseInternalFormat = KtxBundle::RGBA;
+    info.pixelWidth = size;
+    info.pixelHeight = size;
+    info.pixelDepth = 0;
+    return ktx;
+}
+
+static std::vector<uint8_t> serialize(KtxBundle const& ktx) {
+    std::vector<uint8_t> contents(ktx.getSerializedLength());
+    EXPECT_TRUE(ktx.serialize(contents.data(), uint32_t(contents.size())));
+    return contents;
+}
+
+TEST_F(KtxTranscoderTest, Targets) { // NOLINT
+    utils::JobSystem& js = mEngine->getJobSystem();
+    std::unique_ptr<KtxBundle> opaque = createAstcBundle(js, 32, 1.0f);
+    std::unique_ptr<KtxBundle> translucent = createAstcBundle(js, 32, 0.5f);
+    KtxTranscoder transcoder(*mEngine);
+
+    // The noop backend supports ASTC, so nothing needs to be transcoded.
+    EXPECT_TRUE(transcoder.isSupported(*opaque));
+    EXPECT_EQ(transcoder.transcode(*opaque), nullptr);
+
+    // ETC2 and BC use their opaque variant only when the texture is opaque, and all the levels
+    // are transcoded. Blocks are 8 bytes for the opaque variants and 16 bytes otherwise.
+    auto checkLevels = [](KtxBundle const& ktx, size_t blockSize) {
+        ASSERT_EQ(ktx.getNumMipLevels(), 6);
+        for (uint32_t level = 0; level < 6; level++) {
+            uint8_t* data;
+            uint32_t size;
+            ASSERT_TRUE(ktx.getBlob({ level, 0, 0 }, &data, &size));
+            const uint32_t blocks = std::max((32u >> level) / 4, 1u);
+            EXPECT_EQ(size, blocks * blocks * blockSize);
+        }
+    };
+
+    std::unique_ptr<KtxBundle> etc2 = transcoder.transcode(*opaque, KtxTranscoder::Target::ETC2);
+    ASSERT_NE(etc2, nullptr);
+    EXPECT_EQ(etc2->getInfo().glInternalFormat, KtxBundle::RGB8_ETC2);
+    EXPECT_EQ(etc2->getInfo().pixelWidth, 32);
+    checkLevels(*etc2, 8);
+
+    etc2 = transcoder.transcode(*translucent, KtxTranscoder::Target::ETC2);
+    ASSERT_NE(etc2, nullptr);
+    EXPECT_EQ(etc2->getInfo().glInternalFormat, KtxBundle::RGBA8_ETC2_EAC);
+    checkLevels(*etc2, 16);
+
+    std::unique_ptr<KtxBundle> bc = transcoder.transcode(*translucent, KtxTranscoder::Target::BC);
+    ASSERT_NE(bc, nullptr);
+    EXPECT_EQ(bc->getInfo().glInternalFormat, KtxBundle::RGBA_S3TC_DXT5);
+    checkLevels(*bc, 16);
+
+    // Uncompressed texels match the source, within the error of ASTC.
+    std::unique_ptr<KtxBundle> rgba8 =
+            transcoder.transcode(*translucent, KtxTranscoder::Target::RGBA8);
+    ASSERT_NE(rgba8, nullptr);
+    EXPECT_EQ(rgba8->getInfo().glInternalFormat, KtxBundle::RGBA8);
+    uint8_t* texels;
+    uint32_t size;
+    ASSERT_TRUE(rgba8->getBlob({ 0, 0, 0 }, &texels, &size));
+    ASSERT_EQ(size, 32 * 32 * 4);
+    for (uint32_t y = 0; y < 32; y++) {
+        for (uint32_t x = 0; x < 32; x++) {
+            uint8_t const* texel = texels + (y * 32 + x) * 4;
+            EXPECT_NEAR(texel[0], x * 255.0f / 32, 13.0f);
+            EXPECT_NEAR(texel[1], y * 255.0f / 32, 13.0f);
+            EXPECT_NEAR(texel[3], 128.0f, 13.0f);
+        }
+    }
+
+    // Only ASTC bundles can be transcoded.
+    EXPECT_EQ(transcoder.transcode(*rgba8, KtxTranscoder::Target::ETC2), nullptr);
+
+    // Textures are created from bundles the engine supports as they are.
+    Texture* texture = transcoder.createTexture(opaque.release(), false);
+    ASSERT_NE(texture, nullptr);
+    EXPECT_EQ(texture->getFormat(), Texture::InternalFormat::RGBA_ASTC_4x4);
+    EXPECT_EQ(texture->getLevels(), 6);
+    mEngine->destroy(texture);
+}
+
+TEST_F(KtxTranscoderTest, Cache) { // NOLINT
+    const Path directory = Path::getTemporaryDirectory() + "test_ktxtranscoder";
+    for (Path const& file : directory.listContents()) {
+        Path(file).unlinkFile();
+    }
+
+    utils::JobSystem& js = mEngine->getJobSystem();
+    std::unique_ptr<KtxBundle> source = createAstcBundle(js, 16, 0.5f);
+    KtxTranscoder::Config config;
+    config.cacheDirectory = directory;
+
+    // The directory is created, and the transcoded bundle is stored in a single file.
+    std::unique_ptr<KtxBundle> transcoded;
+    {
+        KtxTranscoder transcoder(*mEngine, config);
+        transcoded = transcoder.transcode(*source, KtxTranscoder::Target::BC);
+        ASSERT_NE(transcoded, nullptr);
+    }
+    std::vector<Path> files = directory.listContents();
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(files[0].getExtension(), "ktx");
+
+    // Another transcoder loads it instead of transcoding again, and the results are identical.
+    KtxTranscoder transcoder(*mEngine, config);
+    std::unique_ptr<KtxBundle> cached = transcoder.transcode(*source, KtxTranscoder::Target::BC);
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(serialize(*cached), serialize(*transcoded));
+
+    // Corrupted files are ignored and replaced.
+    {
+        std::ofstream out(files[0].c_str(), std::ios::binary | std::ios::trunc);
+        out << "garbage";
+    }
+    cached = transcoder.transcode(*source, KtxTranscoder::Target::BC);
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(serialize(*cached), serialize(*transcoded));
+    EXPECT_EQ(directory.listContents().size(), 1);
+
+    for (Path const& file : directory.listContents()) {
+        Path(file).unlinkFile();
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
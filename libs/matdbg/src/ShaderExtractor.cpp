@@ -63,6 +63,9 @@ ShaderExtractor::ShaderExtractor(Backend backend, const void* data, size_t size)
 
 bool ShaderExtractor::parse() noexcept {
     if (mChunkContainer.parse()) {
+        if (mDictionaryTag == ChunkType::DictionaryText) {
+            mDictionaryTag = DictionaryReader::getTextDictionaryTag(mChunkContainer);
+        }
         return mMaterialChunk.readIndex(mMaterialTag);
     }
     return false;
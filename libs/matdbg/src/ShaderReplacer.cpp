@@ -108,6 +108,11 @@ bool ShaderReplacer::replaceShaderSource(backend::ShaderModel shaderModel, uint8
     }
 
     ChunkContainer const& cc = mOriginalPackage;
+    if (cc.hasChunk(ChunkType::DictionaryTextCompressed)) {
+        slog.e << "Editing compressed materials is not yet supported." << io::endl;
+        return false;
+    }
+
     if (!cc.hasChunk(mMaterialTag) || !cc.hasChunk(mDictionaryTag)) {
         return false;
     }
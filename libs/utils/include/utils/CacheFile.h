@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_CACHEFILE_H
+#define TNT_UTILS_CACHEFILE_H
+
+#include <utils/compiler.h>
+#include <utils/Path.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace utils {
+
+/**
+ * Reads and writes the files of persistent caches that store each entry in its own file, in a
+ * directory that may be shared by several threads or processes.
+ *
+ * Files start with a small header that holds a magic number identifying the cache, the key of the
+ * entry and a checksum of the payload, so that truncated, stale or corrupted files are detected.
+ * Files are written under a unique temporary name and renamed into place, so readers never
+ * observe a partially written entry, even when several writers store the same entry at once.
+ */
+class UTILS_PUBLIC CacheFile {
+public:
+    //! Size of the header that precedes the payload in every file.
+    static constexpr size_t HEADER_SIZE = 24;
+
+    /**
+     * Reads the payload of a cache file.
+     * @return false if the file is missing, or if it doesn't hold a valid entry for the given
+     *         magic number and key, in which case data is cleared
+     */
+    static bool read(const Path& path, uint32_t magic, uint64_t key, std::vector<uint8_t>* data);
+
+    /**
+     * Writes a cache file, replacing any existing file at the same path.
+     * @return false if the file couldn't be written
+     */
+    static bool write(const Path& path, uint32_t magic, uint64_t key,
+            const uint8_t* data, size_t size);
+};
+
+} // namespace utils
+
+#endif // TNT_UTILS_CACHEFILE_H
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 namespace utils {
 namespace hash {
@@ -46,6 +47,49 @@ inline uint32_t murmur3(const uint32_t* key, size_t wordCount, uint32_t seed) no
     return h;
 }
 
+// 64-bit hash of any number of bytes, made of two murmur3 hashes with different seeds. The size
+// is hashed too, so that trailing zeros matter. Meant for keys that must be stable across runs,
+// e.g. of persistent caches.
+inline uint64_t murmur3_64(const void* data, size_t size) noexcept {
+    auto mix = [](uint32_t h, uint32_t k) {
+        k *= 0xcc9e2d51u;
+        k = (k << 15u) | (k >> 17u);
+        k *= 0x1b873593u;
+        h ^= k;
+        h = (h << 13u) | (h >> 19u);
+        return (h * 5u) + 0xe6546b64u;
+    };
+    auto finalize = [](uint32_t h, size_t wordCount) {
+        h ^= wordCount;
+        h ^= h >> 16u;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13u;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16u;
+        return h;
+    };
+
+    // The data can have any alignment and type, so words are loaded with memcpy.
+    const uint8_t* bytes = (const uint8_t*) data;
+    const size_t wordCount = size / 4;
+    uint32_t lo = 0;
+    uint32_t hi = 0x9e3779b9u;
+    for (size_t i = 0; i < wordCount; i++) {
+        uint32_t k;
+        memcpy(&k, bytes + i * 4, sizeof(k));
+        lo = mix(lo, k);
+        hi = mix(hi, k);
+    }
+    lo = wordCount ? finalize(lo, wordCount) : 0;
+    hi = wordCount ? finalize(hi, wordCount) : 0;
+
+    uint32_t tail[2] = { 0, uint32_t(size) };
+    memcpy(tail, bytes + wordCount * 4, size - wordCount * 4);
+    lo = murmur3(tail, 2, lo);
+    hi = murmur3(tail, 2, hi);
+    return (uint64_t(hi) << 32u) | lo;
+}
+
 template<typename T>
 struct MurmurHashFn {
     uint32_t operator()(const T& key) const noexcept {
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/CacheFile.h>
+
+#include <utils/Hash.h>
+
+#include <fstream>
+#include <random>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace utils {
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t size;
+    uint64_t key;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CacheHeader) == CacheFile::HEADER_SIZE, "CacheHeader has unexpected padding.");
+
+static uint32_t computeChecksum(const uint8_t* data, size_t size) {
+    const size_t wordCount = size / 4;
+    uint32_t tail = 0;
+    memcpy(&tail, data + wordCount * 4, size - wordCount * 4);
+    uint32_t h = wordCount ? hash::murmur3((const uint32_t*) data, wordCount, 0) : 0;
+    return hash::murmur3(&tail, 1, h);
+}
+
+bool CacheFile::read(const Path& path, uint32_t magic, uint64_t key, std::vector<uint8_t>* data) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    CacheHeader header;
+    bool valid = in && bool(in.read((char*) &header, sizeof(header)));
+    valid = valid && header.magic == magic && header.key == key && header.size > 0;
+    if (valid) {
+        data->resize(header.size);
+        valid = bool(in.read((char*) data->data(), header.size));
+        valid = valid && computeChecksum(data->data(), header.size) == header.checksum;
+    }
+    if (!valid) {
+        data->clear();
+    }
+    return valid;
+}
+
+bool CacheFile::write(const Path& path, uint32_t magic, uint64_t key,
+        const uint8_t* data, size_t size) {
+    const CacheHeader header {
+        .magic = magic,
+        .size = uint32_t(size),
+        .key = key,
+        .checksum = computeChecksum(data, size),
+        .reserved = 0
+    };
+
+    // The temporary name must be unique, since the same entry can be stored concurrently by
+    // several threads or processes.
+    static thread_local std::mt19937_64 generator{ std::random_device{}() };
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.tmp", (unsigned long long) generator());
+
+    Path temp = path.getPath() + suffix;
+    {
+        std::ofstream out(temp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.write((const char*) &header, sizeof(header)) ||
+                !out.write((const char*) data, size)) {
+            out.close();
+            temp.unlinkFile();
+            return false;
+        }
+    }
+
+    // Renaming over an existing file fails on Windows, elsewhere it atomically replaces it. If
+    // another writer stored the same entry in the meantime, losing the race is harmless.
+#if defined(WIN32)
+    Path(path).unlinkFile();
+#endif
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        temp.unlinkFile();
+        return path.exists();
+    }
+    return true;
+}
+
+} // namespace utils
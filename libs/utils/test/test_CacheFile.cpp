@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/CacheFile.h>
+
+#include <stdio.h>
+
+#include <vector>
+
+using namespace utils;
+
+static constexpr uint32_t MAGIC = 0x54534554; // "TEST"
+
+TEST(CacheFileTest, RoundTrip) {
+    Path path = Path::getTemporaryDirectory() + "test_cachefile_roundtrip.bin";
+    const std::vector<uint8_t> payload = { 1, 2, 3, 4, 5, 6, 7 };
+
+    ASSERT_TRUE(CacheFile::write(path, MAGIC, 42, payload.data(), payload.size()));
+    EXPECT_TRUE(path.exists());
+
+    std::vector<uint8_t> data;
+    EXPECT_TRUE(CacheFile::read(path, MAGIC, 42, &data));
+    EXPECT_EQ(payload, data);
+
+    // Another key or another cache must not accept the entry.
+    EXPECT_FALSE(CacheFile::read(path, MAGIC, 43, &data));
+    EXPECT_TRUE(data.empty());
+    EXPECT_FALSE(CacheFile::read(path, MAGIC + 1, 42, &data));
+
+    // Writing again replaces the entry.
+    const std::vector<uint8_t> other = { 9, 8, 7 };
+    ASSERT_TRUE(CacheFile::write(path, MAGIC, 42, other.data(), other.size()));
+    EXPECT_TRUE(CacheFile::read(path, MAGIC, 42, &data));
+    EXPECT_EQ(other, data);
+
+    path.unlinkFile();
+    EXPECT_FALSE(CacheFile::read(path, MAGIC, 42, &data));
+}
+
+TEST(CacheFileTest, Corrupted) {
+    Path path = Path::getTemporaryDirectory() + "test_cachefile_corrupted.bin";
+    const std::vector<uint8_t> payload(100, 0x5a);
+    ASSERT_TRUE(CacheFile::write(path, MAGIC, 7, payload.data(), payload.size()));
+
+    // Flip a byte of the payload, the checksum must no longer match.
+    FILE* file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    fseek(file, long(CacheFile::HEADER_SIZE + 10), SEEK_SET);
+    fputc(0xa5, file);
+    fclose(file);
+
+    std::vector<uint8_t> data;
+    EXPECT_FALSE(CacheFile::read(path, MAGIC, 7, &data));
+
+    // Truncated files are rejected too.
+    file = fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fwrite(payload.data(), 1, 8, file);
+    fclose(file);
+    EXPECT_FALSE(CacheFile::read(path, MAGIC, 7, &data));
+
+    path.unlinkFile();
+}
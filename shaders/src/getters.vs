@@ -26,10 +26,31 @@ mat3 getWorldFromModelNormalMatrix() {
 // Attributes access
 //------------------------------------------------------------------------------
 
+/** @public-api */
+int getVertexIndex() {
+#if defined(TARGET_METAL_ENVIRONMENT) || defined(TARGET_VULKAN_ENVIRONMENT)
+    return gl_VertexIndex;
+#else
+    return gl_VertexID;
+#endif
+}
+
 #if defined(HAS_SKINNING_OR_MORPHING)
+vec4 getBone(uint i) {
+#if defined(HAS_BONES_TEXTURE)
+    // Skeletons that don't fit in the bones UBO are stored in a texture instead, using the same
+    // layout of 4 texels per bone, BONE_TEXTURE_ROW_SIZE bones per row.
+    if (objectUniforms.skinningEnabled == 2) {
+        const uint rowTexelCount = uint(BONE_TEXTURE_ROW_SIZE) * 4u;
+        return texelFetch(bones_transforms, ivec2(i % rowTexelCount, i / rowTexelCount), 0);
+    }
+#endif
+    return bonesUniforms.bones[i];
+}
+
 vec3 mulBoneNormal(vec3 n, uint i) {
-    vec4 q  = bonesUniforms.bones[i + 0u];
-    vec3 is = bonesUniforms.bones[i + 3u].xyz;
+    vec4 q  = getBone(i + 0u);
+    vec3 is = getBone(i + 3u).xyz;
 
     // apply the inverse of the non-uniform scales
     n *= is;
@@ -40,9 +61,9 @@ vec3 mulBoneNormal(vec3 n, uint i) {
 }
 
 vec3 mulBoneVertex(vec3 v, uint i) {
-    vec4 q = bonesUniforms.bones[i + 0u];
-    vec3 t = bonesUniforms.bones[i + 1u].xyz;
-    vec3 s = bonesUniforms.bones[i + 2u].xyz;
+    vec4 q = getBone(i + 0u);
+    vec3 t = getBone(i + 1u).xyz;
+    vec3 s = getBone(i + 2u).xyz;
 
     // apply the non-uniform scales
     v *= s;
@@ -67,6 +88,57 @@ void skinPosition(inout vec3 p, const uvec4 ids, const vec4 weights) {
         + mulBoneVertex(p, ids.z * 4u) * weights.z
         + mulBoneVertex(p, ids.w * 4u) * weights.w;
 }
+
+#if defined(HAS_MORPH_TARGET_BUFFER)
+// Each layer of the morph target texture holds one target. The positions of all the vertices come
+// first, then the tangents, which start halfway through the layer.
+ivec3 getMorphTargetTexel(bool tangents) {
+    const uint width = uint(MORPH_TARGET_TEXTURE_WIDTH);
+    uint index = uint(getVertexIndex());
+    int y = int(index / width);
+    if (tangents) {
+        y += textureSize(morphTargetBuffer_targets, 0).y / 2;
+    }
+    return ivec3(int(index % width), y, 0);
+}
+
+// the weights can outnumber the targets of a given primitive
+uint getMorphTargetCount() {
+    return min(morphingUniforms.count, uint(textureSize(morphTargetBuffer_targets, 0).z));
+}
+
+float getMorphWeight(uint i) {
+    return morphingUniforms.weights[i / 4u][i % 4u];
+}
+
+void morphPosition(inout vec4 p) {
+    ivec3 texel = getMorphTargetTexel(false);
+    for (uint i = 0u, c = getMorphTargetCount(); i < c; i++) {
+        float w = getMorphWeight(i);
+        if (w != 0.0) {
+            texel.z = int(i);
+            p += w * texelFetch(morphTargetBuffer_targets, texel, 0);
+        }
+    }
+}
+
+void morphNormal(inout vec3 n) {
+    ivec3 texel = getMorphTargetTexel(true);
+    for (uint i = 0u, c = getMorphTargetCount(); i < c; i++) {
+        float w = getMorphWeight(i);
+        if (w != 0.0) {
+            texel.z = int(i);
+            // targets without tangents are left zeroed
+            vec4 q = texelFetch(morphTargetBuffer_targets, texel, 0);
+            if (q != vec4(0.0)) {
+                vec3 normal;
+                toTangentFrame(q, normal);
+                n += w * normal;
+            }
+        }
+    }
+}
+#endif
 #endif
 
 /** @public-api */
@@ -82,7 +154,13 @@ vec4 getPosition() {
         pos += objectUniforms.morphWeights.w * mesh_custom3;
     }
 
-    if (objectUniforms.skinningEnabled == 1) {
+#if defined(HAS_MORPH_TARGET_BUFFER)
+    if (objectUniforms.morphingEnabled == 2) {
+        morphPosition(pos);
+    }
+#endif
+
+    if (objectUniforms.skinningEnabled != 0) {
         skinPosition(pos.xyz, mesh_bone_indices, mesh_bone_weights);
     }
 
@@ -116,15 +194,6 @@ vec4 getCustom6() { return mesh_custom6; }
 vec4 getCustom7() { return mesh_custom7; }
 #endif
 
-/** @public-api */
-int getVertexIndex() {
-#if defined(TARGET_METAL_ENVIRONMENT) || defined(TARGET_VULKAN_ENVIRONMENT)
-    return gl_VertexIndex;
-#else
-    return gl_VertexID;
-#endif
-}
-
 //------------------------------------------------------------------------------
 // Helpers
 //------------------------------------------------------------------------------
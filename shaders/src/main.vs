@@ -25,7 +25,14 @@ void main() {
             material.worldNormal = normalize(material.worldNormal);
         }
 
-        if (objectUniforms.skinningEnabled == 1) {
+        #if defined(HAS_MORPH_TARGET_BUFFER)
+        if (objectUniforms.morphingEnabled == 2) {
+            morphNormal(material.worldNormal);
+            material.worldNormal = normalize(material.worldNormal);
+        }
+        #endif
+
+        if (objectUniforms.skinningEnabled != 0) {
             skinNormal(material.worldNormal, mesh_bone_indices, mesh_bone_weights);
             skinNormal(vertex_worldTangent.xyz, mesh_bone_indices, mesh_bone_weights);
         }
@@ -43,7 +50,7 @@ void main() {
         toTangentFrame(mesh_tangents, material.worldNormal);
 
         #if defined(HAS_SKINNING_OR_MORPHING)
-            if (objectUniforms.skinningEnabled == 1) {
+            if (objectUniforms.skinningEnabled != 0) {
                 skinNormal(material.worldNormal, mesh_bone_indices, mesh_bone_weights);
             }
         #endif
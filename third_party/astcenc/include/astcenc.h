@@ -103,6 +103,22 @@ extern void find_closest_blockdim_3d(
     int *z,
     int consider_illegal);
 
+// Decodes rows [first_block_row, first_block_row + block_row_count) of the given blocks into
+// output_image, which must cover the whole image. Blocks are 16 bytes in row-major order.
+extern void decode_astc_image(
+    const uint8_t* blocks,
+    int xdim,
+    int ydim,
+    astc_decode_mode decode_mode,
+    int first_block_row,
+    int block_row_count,
+    astc_codec_image* output_image);
+
+// Builds the block size descriptor and partition tables of a block size, which the encoder and the
+// decoder otherwise build lazily and without synchronization. Call it before coding blocks of that
+// size from several threads.
+extern void prepare_block_size_tables(int xdim, int ydim, int zdim);
+
 extern void destroy_image(astc_codec_image* img);
 
 extern astc_codec_image* allocate_image(int bitness, int xsize, int ysize, int zsize, int padding);
@@ -113,4 +129,5 @@ extern void build_quantization_mode_table();
 
 extern "C" {
     sf16 float_to_sf16(float, roundmode);
+    float sf16_to_float(sf16);
 }
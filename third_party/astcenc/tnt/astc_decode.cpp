@@ -0,0 +1,36 @@
+// -------------------------------------------------------------------------------------------------
+// Decodes a range of rows of ASTC blocks into an image, which the ARM encoder only does as part of
+// its standalone tool when loading a .astc file. This file is not part of the upstream sources.
+// -------------------------------------------------------------------------------------------------
+
+#include "astc_codec_internals.h"
+
+void decode_astc_image(
+    const uint8_t* blocks,
+    int xdim,
+    int ydim,
+    astc_decode_mode decode_mode,
+    int first_block_row,
+    int block_row_count,
+    astc_codec_image* output_image)
+{
+    const swizzlepattern swz_decode = { 0, 1, 2, 3 };
+    const int xblocks = (output_image->xsize + xdim - 1) / xdim;
+    imageblock pb;
+    for (int y = first_block_row; y < first_block_row + block_row_count; y++) {
+        for (int x = 0; x < xblocks; x++) {
+            const uint8_t* bp = blocks + (y * xblocks + x) * 16;
+            physical_compressed_block pcb = *(const physical_compressed_block*) bp;
+            symbolic_compressed_block scb;
+            physical_to_symbolic(xdim, ydim, 1, pcb, &scb);
+            decompress_symbolic_block(decode_mode, xdim, ydim, 1, x * xdim, y * ydim, 0, &scb, &pb);
+            write_imageblock(output_image, &pb, xdim, ydim, 1, x * xdim, y * ydim, 0, swz_decode);
+        }
+    }
+}
+
+void prepare_block_size_tables(int xdim, int ydim, int zdim)
+{
+    get_block_size_descriptor(xdim, ydim, zdim);
+    get_partition_table(xdim, ydim, zdim, 0);
+}
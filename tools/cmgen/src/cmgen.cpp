@@ -24,7 +24,7 @@
 #include <ibl/utilities.h>
 
 #ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
-#include <imageio/BlockCompression.h>
+#include <blockcompression/BlockCompression.h>
 #endif
 
 #include <imageio/ImageDecoder.h>
@@ -40,10 +40,15 @@
 #include <math/scalar.h>
 #include <math/vec4.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
 #include <string.h>
@@ -64,6 +69,7 @@ enum class ShFile {
 static const size_t DFG_LUT_DEFAULT_SIZE = 128;
 static const size_t IBL_DEFAULT_SIZE = 256;
 static const size_t IBL_DEFAULT_MIN_LOD_SIZE = 16;
+static const size_t BATCH_DEFAULT_INPUTS = 4;
 
 enum class OutputType {
     FACES, KTX, EQUIRECT, OCTAHEDRON
@@ -90,7 +96,6 @@ static float g_sh_window = 0.0f; // <0 none, 0=auto, or cutoff
 static bool g_noclamp = true;
 static ShFile g_sh_file = ShFile::SH_NONE;
 static utils::Path g_sh_filename;
-static std::unique_ptr<filament::math::float3[]> g_sh_coefficients;
 
 static bool g_is_mipmap = false;
 static utils::Path g_is_mipmap_dir;
@@ -109,18 +114,25 @@ static bool g_deploy = false;
 static utils::Path g_deploy_dir;
 
 static size_t g_num_samples = 1024;
+static CubemapIBL::Quality g_quality = CubemapIBL::Quality::HIGH;
 
 static bool g_mirror = false;
 
+static bool g_batch = false;
+static size_t g_batch_inputs = BATCH_DEFAULT_INPUTS;
+static bool g_timings = false;
+static std::mutex g_timings_lock;
+
 // -----------------------------------------------------------------------------------------------
 
 static void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
         std::vector<Image>& images);
-static void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname,
-        const Cubemap& inputCubemap);
+static std::unique_ptr<filament::math::float3[]> sphericalHarmonics(utils::JobSystem& js,
+        const utils::Path& iname, const Cubemap& inputCubemap, const utils::Path& shFilename);
 static void iblRoughnessPrefilter(
         utils::JobSystem& js, const utils::Path& iname, const std::vector<Cubemap>& levels,
-        bool prefilter, const utils::Path& dir);
+        bool prefilter, const utils::Path& dir,
+        const std::unique_ptr<filament::math::float3[]>& sh);
 static void iblDiffuseIrradiance(utils::JobSystem& js, const utils::Path& iname,
         const std::vector<Cubemap>& levels, const utils::Path& dir);
 static void iblMipmapPrefilter(utils::JobSystem& js, const utils::Path& iname,
@@ -151,6 +163,10 @@ static void printUsage(char* name) {
             "Usages:\n"
             "    CMGEN [options] <input-file>\n"
             "    CMGEN [options] <uv[N]>\n"
+            "    CMGEN [options] <input-file> <input-file>...\n"
+            "\n"
+            "With several inputs, cmgen runs in batch mode: the inputs are processed at the same\n"
+            "time and progress output is replaced by the time taken by each stage.\n"
             "\n"
             "Supported input formats:\n"
             "    PNG, 8 and 16 bits\n"
@@ -191,7 +207,10 @@ static void printUsage(char* name) {
             "       Size of the output cubemaps (base level), 256 by default\n"
             "       Also applies to DFG LUT\n\n"
             "   --deploy=dir, -x dir\n"
-            "       Generate everything needed for deployment into <dir>\n\n"
+            "       Generate everything needed for deployment into <dir>\n"
+            "       In batch mode, KTX files of each input go in a subfolder named after it\n\n"
+            "   --batch-inputs=N\n"
+            "       Number of inputs processed at the same time in batch mode (default 4)\n\n"
             "   --extract=dir\n"
             "       Extract faces of the cubemap into <dir>\n\n"
             "   --extract-blur=roughness\n"
@@ -202,6 +221,9 @@ static void printUsage(char* name) {
             "       Skip mirroring of generated cubemaps (for assets with mirroring already backed in)\n\n"
             "   --ibl-samples=numSamples\n"
             "       Number of samples to use for IBL integrations (default 1024)\n\n"
+            "   --ibl-quality=[low|medium|high]\n"
+            "       Use a 16th, a quarter or all of the IBL samples, trading quality for speed\n"
+            "       (default high)\n\n"
             "   --ibl-ld=dir\n"
             "       Roughness pre-filter into <dir>\n\n"
             "   --sh-shader\n"
@@ -278,7 +300,9 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "ibl-no-prefilter",           no_argument, nullptr, 'n' },
             { "ibl-min-lod-size",     required_argument, nullptr, 'S' },
             { "ibl-samples",          required_argument, nullptr, 'k' },
+            { "ibl-quality",          required_argument, nullptr, 'Q' },
             { "deploy",               required_argument, nullptr, 'x' },
+            { "batch-inputs",         required_argument, nullptr, 'B' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
             { "debug",                      no_argument, nullptr, 'd' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
@@ -448,10 +472,25 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             case 'k':
                 g_num_samples = (size_t)std::stoi(arg);
                 break;
+            case 'Q':
+                if (arg == "low") {
+                    g_quality = CubemapIBL::Quality::LOW;
+                } else if (arg == "medium") {
+                    g_quality = CubemapIBL::Quality::MEDIUM;
+                } else if (arg == "high") {
+                    g_quality = CubemapIBL::Quality::HIGH;
+                } else {
+                    std::cerr << "quality must be one of low, medium or high" << std::endl;
+                    exit(0);
+                }
+                break;
             case 'x':
                 g_deploy = true;
                 g_deploy_dir = arg;
                 break;
+            case 'B':
+                g_batch_inputs = std::max(size_t(std::stoul(arg)), size_t(1));
+                break;
             case 'd':
                 g_debug = true;
                 break;
@@ -480,60 +519,25 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
     return optind;
 }
 
-int main(int argc, char* argv[]) {
-    utils::JobSystem js;
-    js.adopt();
-
-    int option_index = handleCommandLineArgments(argc, argv);
-    int num_args = argc - option_index;
-    if (!g_dfg && num_args < 1) {
-        printUsage(argv[0]);
-        return 1;
-    }
-
-    if (g_dfg) {
-        if (!g_quiet) {
-            std::cout << "Generating IBL DFG LUT..." << std::endl;
-        }
-        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
-        iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
-        if (num_args < 1) return 0;
+// Per-stage timings are printed with the name of the input, since stages of several inputs can
+// run at the same time in batch mode.
+template<typename STAGE>
+static void runStage(const utils::Path& iname, const char* name, STAGE&& stage) {
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    stage();
+    if (g_timings) {
+        const std::chrono::duration<double, std::milli> duration = clock::now() - start;
+        std::lock_guard<std::mutex> lock(g_timings_lock);
+        std::cout << iname.getName() << ": " << name << " took "
+                  << std::fixed << std::setprecision(1) << duration.count() << " ms"
+                  << std::endl;
     }
+}
 
-    std::string command(argv[option_index]);
-    utils::Path iname(command);
-
-    if (g_deploy) {
-        utils::Path sh_dir = g_deploy_dir;
-
-        // KTX files are self-contained and do not need to live in a subfolder.
-        if (g_type != OutputType::KTX) {
-            sh_dir += iname.getNameWithoutExtension();
-        }
-
-        // generate pre-scaled irradiance sh to text file
-        g_sh_compute = 3;
-        g_sh_shader = true;
-        g_sh_irradiance = true;
-        g_sh_filename = sh_dir + "sh.txt";
-        g_sh_file = ShFile::SH_TEXT;
-        g_sh_output = true;
-
-        // faces
-        g_extract_dir = g_deploy_dir;
-        g_extract_faces = true;
-
-        // prefilter
-        g_prefilter = true;
-        g_prefilter_dir = g_deploy_dir;
-    }
-
-    // Images store the actual data
-    std::vector<Image> images;
-
-    // Cubemaps are just views on Images
-    std::vector<Cubemap> levels;
-
+// Loads or generates the base level of the environment. Returns false if the input is invalid.
+static bool loadEnvironment(utils::JobSystem& js, const utils::Path& iname,
+        std::vector<Image>& images, std::vector<Cubemap>& levels) {
     if (iname.exists()) {
         if (!g_quiet) {
             std::cout << "Decoding image..." << std::endl;
@@ -542,12 +546,12 @@ int main(int argc, char* argv[]) {
         LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
         if (!linputImage.isValid()) {
             std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
-            exit(1);
+            return false;
         }
         if (linputImage.getChannels() != 3) {
             std::cerr << "Input image must be RGB (3 channels)! This image has "
                       << linputImage.getChannels() << " channels." << std::endl;
-            exit(1);
+            return false;
         }
 
         // Convert from LinearImage to the deprecated Image object which is used throughout cmgen.
@@ -589,7 +593,7 @@ int main(int argc, char* argv[]) {
             std::cerr << "  2:1, lat/long or equirectangular" << std::endl;
             std::cerr << "  3:4, vertical cross (height must be power of two)" << std::endl;
             std::cerr << "  4:3, horizontal cross (width must be power of two)" << std::endl;
-            exit(0);
+            return false;
         }
     } else {
         if (!g_quiet) {
@@ -618,92 +622,238 @@ int main(int argc, char* argv[]) {
         images.push_back(std::move(temp));
         levels.push_back(std::move(cml));
     }
+    return true;
+}
 
-    // we mirror by default -- the mirror option in fact un-mirrors.
-    g_mirror = !g_mirror;
-    if (g_mirror) {
-        if (!g_quiet) {
-            std::cout << "Mirroring..." << std::endl;
-        }
-        Image temp;
-        Cubemap cml = CubemapUtils::create(temp, levels[0].getDimensions());
-        CubemapUtils::mirrorCubemap(js, cml, levels[0]);
-        std::swap(levels[0], cml);
-        std::swap(images[0], temp);
-    } else {
-        if (!g_quiet) {
-            std::cout << "Skipped mirroring." << std::endl;
-        }
+// Runs all the requested stages for one input. Returns false if the input is invalid.
+static bool processEnvironment(utils::JobSystem& js, const utils::Path& iname) {
+    const std::string basename = iname.getNameWithoutExtension();
+
+    // KTX outputs are named after their directory, in batch mode each input gets its own.
+    auto ktxOutputDir = [&basename](const utils::Path& dir) {
+        return (g_batch && g_type == OutputType::KTX) ? dir + basename : dir;
+    };
+
+    utils::Path shFilename = g_sh_filename;
+    if (g_deploy) {
+        // KTX files are self-contained and do not need to live in a subfolder.
+        utils::Path sh_dir = (g_type != OutputType::KTX) ?
+                g_deploy_dir + basename : ktxOutputDir(g_deploy_dir);
+        shFilename = sh_dir + "sh.txt";
+    } else if (g_batch && g_sh_file != ShFile::SH_NONE) {
+        shFilename = g_sh_filename.getParent() + basename + g_sh_filename.getName();
     }
 
-    // make the cubemap seamless
-    levels[0].makeSeamless();
+    // Images store the actual data
+    std::vector<Image> images;
 
-    // Now generate all the mipmap levels
-    generateMipmaps(js, levels, images);
+    // Cubemaps are just views on Images
+    std::vector<Cubemap> levels;
 
-    if (g_sh_compute) {
-        if (!g_quiet) {
-            std::cout << "Spherical harmonics..." << std::endl;
+    bool loaded = false;
+    runStage(iname, "decoding", [&]() {
+        loaded = loadEnvironment(js, iname, images, levels);
+    });
+    if (!loaded) {
+        return false;
+    }
+
+    runStage(iname, "mipmaps", [&]() {
+        if (g_mirror) {
+            if (!g_quiet) {
+                std::cout << "Mirroring..." << std::endl;
+            }
+            Image temp;
+            Cubemap cml = CubemapUtils::create(temp, levels[0].getDimensions());
+            CubemapUtils::mirrorCubemap(js, cml, levels[0]);
+            std::swap(levels[0], cml);
+            std::swap(images[0], temp);
+        } else {
+            if (!g_quiet) {
+                std::cout << "Skipped mirroring." << std::endl;
+            }
         }
-        Cubemap const& cm(levels[0]);
-        sphericalHarmonics(js, iname, cm);
+
+        // make the cubemap seamless
+        levels[0].makeSeamless();
+
+        // Now generate all the mipmap levels
+        generateMipmaps(js, levels, images);
+    });
+
+    // The KTX output of the prefilter needs the spherical harmonics, so they come first.
+    std::unique_ptr<filament::math::float3[]> sh;
+    if (g_sh_compute) {
+        runStage(iname, "spherical harmonics", [&]() {
+            if (!g_quiet) {
+                std::cout << "Spherical harmonics..." << std::endl;
+            }
+            Cubemap const& cm(levels[0]);
+            sh = sphericalHarmonics(js, iname, cm, shFilename);
+        });
     }
 
+    // The remaining stages only read the environment and are independent from each other.
+    std::vector<std::function<void()>> stages;
+
     if (g_is_mipmap) {
-        if (!g_quiet) {
-            std::cout << "IBL mipmaps for prefiltered importance sampling..." << std::endl;
-        }
-        iblMipmapPrefilter(js, iname, images, levels, g_is_mipmap_dir);
+        stages.emplace_back([&]() {
+            runStage(iname, "IBL mipmaps", [&]() {
+                if (!g_quiet) {
+                    std::cout << "IBL mipmaps for prefiltered importance sampling..." << std::endl;
+                }
+                iblMipmapPrefilter(js, iname, images, levels, g_is_mipmap_dir);
+            });
+        });
     }
 
     if (g_prefilter) {
-        if (!g_quiet) {
-            std::cout << "IBL prefiltering..." << std::endl;
-        }
-        iblRoughnessPrefilter(js, iname, levels, !g_ibl_no_prefilter, g_prefilter_dir);
+        stages.emplace_back([&]() {
+            runStage(iname, "IBL prefiltering", [&]() {
+                if (!g_quiet) {
+                    std::cout << "IBL prefiltering..." << std::endl;
+                }
+                iblRoughnessPrefilter(js, iname, levels, !g_ibl_no_prefilter,
+                        ktxOutputDir(g_prefilter_dir), sh);
+            });
+        });
     }
 
     if (g_ibl_irradiance) {
+        stages.emplace_back([&]() {
+            runStage(iname, "IBL diffuse irradiance", [&]() {
+                if (!g_quiet) {
+                    std::cout << "IBL diffuse irradiance..." << std::endl;
+                }
+                iblDiffuseIrradiance(js, iname, levels, g_ibl_irradiance_dir);
+            });
+        });
+    }
+
+    if (g_extract_faces) {
+        stages.emplace_back([&]() {
+            runStage(iname, "faces", [&]() {
+                Cubemap const& cm(levels[0]);
+                if (g_extract_blur != 0) {
+                    ProgressUpdater updater(1);
+                    if (!g_quiet) {
+                        std::cout << "Blurring..." << std::endl;
+                        updater.start();
+                    }
+                    const float linear_roughness = g_extract_blur * g_extract_blur;
+                    const size_t dim = g_output_size ? g_output_size : cm.getDimensions();
+                    Image image;
+                    Cubemap blurred = CubemapUtils::create(image, dim);
+                    CubemapIBL::roughnessFilter(js, blurred, levels, linear_roughness,
+                            g_num_samples, float3{ 1, 1, 1 }, !g_ibl_no_prefilter,
+                            [](size_t index, float v, void* userdata) {
+                                if (!g_quiet) {
+                                    ((ProgressUpdater*) userdata)->update(index, v);
+                                }
+                            }, &updater, g_quality);
+                    if (!g_quiet) {
+                        updater.stop();
+                        std::cout << "Extract faces..." << std::endl;
+                    }
+                    extractCubemapFaces(js, iname, blurred, ktxOutputDir(g_extract_dir));
+                } else {
+                    if (!g_quiet) {
+                        std::cout << "Extract faces..." << std::endl;
+                    }
+                    extractCubemapFaces(js, iname, cm, ktxOutputDir(g_extract_dir));
+                }
+            });
+        });
+    }
+
+    if (g_quiet) {
+        // nothing is printed while the stages run, so they can overlap
+        utils::JobSystem::Job* parent = js.createJob();
+        for (auto& stage : stages) {
+            js.run(utils::jobs::createJob(js, parent, std::ref(stage)));
+        }
+        js.runAndWait(parent);
+    } else {
+        for (auto& stage : stages) {
+            stage();
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    utils::JobSystem js;
+    js.adopt();
+
+    int option_index = handleCommandLineArgments(argc, argv);
+    int num_args = argc - option_index;
+    if (!g_dfg && num_args < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // the timings are printed even in batch mode, which is otherwise quiet
+    g_timings = !g_quiet;
+
+    if (g_dfg) {
         if (!g_quiet) {
-            std::cout << "IBL diffuse irradiance..." << std::endl;
+            std::cout << "Generating IBL DFG LUT..." << std::endl;
         }
-        iblDiffuseIrradiance(js, iname, levels, g_ibl_irradiance_dir);
+        // the LUT doesn't depend on the environment, it's only generated once in batch mode
+        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
+        runStage(g_dfg_filename, "DFG LUT", [&]() {
+            iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
+        });
+        if (num_args < 1) return 0;
     }
 
-    if (g_extract_faces) {
-        Cubemap const& cm(levels[0]);
-        if (g_extract_blur != 0) {
-            ProgressUpdater updater(1);
-            if (!g_quiet) {
-                std::cout << "Blurring..." << std::endl;
-                updater.start();
-            }
-            const float linear_roughness = g_extract_blur * g_extract_blur;
-            const size_t dim = g_output_size ? g_output_size : cm.getDimensions();
-            Image image;
-            Cubemap blurred = CubemapUtils::create(image, dim);
-            CubemapIBL::roughnessFilter(js, blurred, levels, linear_roughness, g_num_samples,
-                    float3{ 1, 1, 1 }, !g_ibl_no_prefilter,
-                    [](size_t index, float v, void* userdata) {
-                        if (!g_quiet) {
-                            ((ProgressUpdater*) userdata)->update(index, v);
-                        }
-                    }, &updater);
-            if (!g_quiet) {
-                updater.stop();
-                std::cout << "Extract faces..." << std::endl;
-            }
-            extractCubemapFaces(js, iname, blurred, g_extract_dir);
-        } else {
-            if (!g_quiet) {
-                std::cout << "Extract faces..." << std::endl;
+    if (g_deploy) {
+        // generate pre-scaled irradiance sh to text file
+        g_sh_compute = 3;
+        g_sh_shader = true;
+        g_sh_irradiance = true;
+        g_sh_file = ShFile::SH_TEXT;
+        g_sh_output = true;
+
+        // faces
+        g_extract_dir = g_deploy_dir;
+        g_extract_faces = true;
+
+        // prefilter
+        g_prefilter = true;
+        g_prefilter_dir = g_deploy_dir;
+    }
+
+    // we mirror by default -- the mirror option in fact un-mirrors.
+    g_mirror = !g_mirror;
+
+    if (num_args == 1) {
+        return processEnvironment(js, utils::Path(argv[option_index])) ? 0 : 1;
+    }
+
+    // Batch mode: a few inputs are processed at once, each by a job that picks the next input
+    // when it's done, so that their stages overlap on the JobSystem.
+    g_batch = true;
+    g_quiet = true;
+
+    const size_t count = size_t(num_args);
+    std::atomic<size_t> next{ 0 };
+    std::atomic<bool> failed{ false };
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            if (!processEnvironment(js, utils::Path(argv[option_index + i]))) {
+                failed = true;
             }
-            extractCubemapFaces(js, iname, cm, g_extract_dir);
         }
+    };
+
+    utils::JobSystem::Job* parent = js.createJob();
+    for (size_t i = 0, c = std::min(g_batch_inputs, count); i < c; i++) {
+        js.run(utils::jobs::createJob(js, parent, std::ref(worker)));
     }
+    js.runAndWait(parent);
 
-    return 0;
+    return failed ? 1 : 0;
 }
 
 void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
@@ -723,7 +873,8 @@ void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
     }
 }
 
-void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname, const Cubemap& inputCubemap) {
+std::unique_ptr<filament::math::float3[]> sphericalHarmonics(utils::JobSystem& js,
+        const utils::Path& iname, const Cubemap& inputCubemap, const utils::Path& shFilename) {
     std::unique_ptr<filament::math::float3[]> sh;
     if (g_sh_shader) {
         sh = CubemapSH::computeSH(js, inputCubemap, 3, true);
@@ -749,7 +900,7 @@ void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname, const Cu
         Cubemap cm = CubemapUtils::create(image, dim);
 
         if (g_sh_file != ShFile::SH_NONE) {
-            utils::Path outputDir(g_sh_filename.getAbsolutePath().getParent());
+            utils::Path outputDir(shFilename.getAbsolutePath().getParent());
             if (!outputDir.exists()) {
                 outputDir.mkdirRecursive();
             }
@@ -776,17 +927,17 @@ void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname, const Cu
                     CubemapUtils::cubemapToOctahedron(js, image, cm);
                 }
 
-                saveImage(g_sh_filename, ImageEncoder::chooseFormat(g_sh_filename.getName()),
+                saveImage(shFilename, ImageEncoder::chooseFormat(shFilename.getName()),
                         image, g_compression);
             }
             if (g_sh_file == ShFile::SH_TEXT) {
-                std::ofstream outputStream(g_sh_filename, std::ios::trunc);
+                std::ofstream outputStream(shFilename, std::ios::trunc);
                 outputSh(outputStream, sh, g_sh_compute);
             }
         }
 
         if (g_debug) {
-            utils::Path outputDir(g_sh_filename.getAbsolutePath().getParent());
+            utils::Path outputDir(shFilename.getAbsolutePath().getParent());
             if (!outputDir.exists()) {
                 outputDir.mkdirRecursive();
             }
@@ -811,8 +962,8 @@ void sphericalHarmonics(utils::JobSystem& js, const utils::Path& iname, const Cu
             }
         }
     }
-    // Stash the computed coefficients in case we need to use them at a later stage (e.g. KTX gen)
-    g_sh_coefficients = std::move(sh);
+    // Return the computed coefficients in case we need to use them at a later stage (e.g. KTX gen)
+    return sh;
 }
 
 void outputSh(std::ostream& out,
@@ -911,7 +1062,8 @@ static float lodToPerceptualRoughness(float lod) noexcept {
 
 void iblRoughnessPrefilter(
         utils::JobSystem& js, const utils::Path& iname, const std::vector<Cubemap>& levels,
-        bool prefilter, const utils::Path& dir) {
+        bool prefilter, const utils::Path& dir,
+        const std::unique_ptr<filament::math::float3[]>& sh) {
     utils::Path outputDir = dir.getAbsolutePath();
     if (g_type != OutputType::KTX) {
         outputDir += iname.getNameWithoutExtension();
@@ -984,7 +1136,7 @@ void iblRoughnessPrefilter(
                     if (!g_quiet) {
                         ((ProgressUpdater*) userdata)->update(index, v);
                     }
-                }, &updater);
+                }, &updater, g_quality);
         if (!g_quiet) {
             updater.stop();
         }
@@ -1031,11 +1183,11 @@ void iblRoughnessPrefilter(
     }
 
     if (g_type == OutputType::KTX) {
-        if (g_sh_coefficients) {
+        if (sh) {
             std::ostringstream sstr;
             for (ssize_t l = 0; l < g_sh_compute; l++) {
                 for (ssize_t m = -l; m <= l; m++) {
-                    auto v = g_sh_coefficients[CubemapSH::getShIndex(m, (size_t) l)];
+                    auto v = sh[CubemapSH::getShIndex(m, (size_t) l)];
                     sstr << v.r << " " << v.g << " " << v.b << "\n";
                 }
             }
@@ -1073,7 +1225,7 @@ void iblDiffuseIrradiance(utils::JobSystem& js, const utils::Path& iname,
                 if (!g_quiet) {
                     ((ProgressUpdater*) userdata)->update(index, v);
                 }
-            }, &updater);
+            }, &updater, g_quality);
     if (!g_quiet) {
         updater.stop();
     }
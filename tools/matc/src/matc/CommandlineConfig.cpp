@@ -22,6 +22,7 @@
 
 #include <utils/Path.h>
 
+#include <algorithm>
 #include <istream>
 #include <sstream>
 #include <string>
@@ -36,6 +37,7 @@ static void usage(char* name) {
             "MATC is a command-line tool to compile material definition.\n"
             "Usages:\n"
             "    MATC [options] <input-file>\n"
+            "    MATC [options] --batch <batch-file>\n"
             "\n"
             "Supported input formats:\n"
             "    Filament material definition (.mat)\n"
@@ -61,10 +63,23 @@ static void usage(char* name) {
             "           MATC -Dfoo=1 -Dbar -Dbuzz=100 ...\n\n"
             "   --reflect, -r\n"
             "       Reflect the specified metadata as JSON: parameters\n\n"
+            "   --cache=<dir>, -c <dir>\n"
+            "       Cache compiled shaders in the specified directory, and reuse them\n"
+            "       whenever the same shader is compiled again with the same options\n\n"
+            "   --batch=<file>, -b <file>\n"
+            "       Compile all the materials listed in the specified file, one per line:\n"
+            "           <input-file> <output-file>\n"
+            "       The other options apply to every material\n\n"
+            "   --compress, -z\n"
+            "       Compress the shader dictionary, to reduce the size of the package\n\n"
             "   --variant-filter=<filter>, -V <filter>\n"
             "       Filter out specified comma-separated variants:\n"
             "           directionalLighting, dynamicLighting, shadowReceiver, skinning, vsm, fog\n"
             "       This variant filter is merged with the filter from the material, if any\n\n"
+            "   --variant-usage=<file>, -u <file>\n"
+            "       Only generate the variants listed in the specified file, as exported by\n"
+            "       Material::exportVariantUsage(), plus the base and depth variants that\n"
+            "       the engine falls back to. Materials missing from the file keep all variants\n\n"
             "   --version, -v\n"
             "       Print the material version number\n\n"
             "Internal use and debugging only:\n"
@@ -152,8 +167,73 @@ static void parseDefine(std::string defineString,
     defines.emplace(def, "1");
 }
 
+bool CommandlineConfig::parseBatch(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Unable to open batch file '" << path << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::string input;
+        std::string output;
+        std::istringstream fields(line);
+        if (!(fields >> input) || input[0] == '#') {
+            continue;
+        }
+        if (!(fields >> output)) {
+            std::cerr << path << ":" << lineNumber << ": missing output file." << std::endl;
+            return false;
+        }
+        mBatch.push_back({
+                new FilesystemInput(input.c_str()), new FilesystemOutput(output.c_str()) });
+    }
+    return true;
+}
+
+bool CommandlineConfig::parseVariantUsage(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Unable to open variant usage file '" << path << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        // material names may contain colons, but variants never do
+        const size_t separator = line.rfind(':');
+        if (separator == std::string::npos) {
+            std::cerr << path << ":" << lineNumber << ": missing material name." << std::endl;
+            return false;
+        }
+        std::vector<uint8_t>& variants = mVariantUsage[line.substr(0, separator)];
+        std::istringstream fields(line.substr(separator + 1));
+        std::string field;
+        while (fields >> field) {
+            char* end = nullptr;
+            const unsigned long variant = strtoul(field.c_str(), &end, 0);
+            if (*end != '\0' || variant >= filament::VARIANT_COUNT) {
+                std::cerr << path << ":" << lineNumber << ": invalid variant '" << field << "'."
+                        << std::endl;
+                return false;
+            }
+            // the same material can appear several times when files are concatenated
+            if (std::find(variants.begin(), variants.end(), variant) == variants.end()) {
+                variants.push_back(uint8_t(variant));
+            }
+        }
+    }
+    return true;
+}
+
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtw";
+    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtwzc:b:u:";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'l' },
@@ -173,6 +253,10 @@ bool CommandlineConfig::parse() {
             { "print",                   no_argument, nullptr, 't' },
             { "version",                 no_argument, nullptr, 'v' },
             { "raw",                     no_argument, nullptr, 'w' },
+            { "compress",                no_argument, nullptr, 'z' },
+            { "cache",             required_argument, nullptr, 'c' },
+            { "batch",             required_argument, nullptr, 'b' },
+            { "variant-usage",     required_argument, nullptr, 'u' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
 
@@ -271,9 +355,30 @@ bool CommandlineConfig::parse() {
             case 'w':
                 mRawShaderMode = true;
                 break;
+            case 'z':
+                mCompress = true;
+                break;
+            case 'c':
+                mCacheDirectory = arg;
+                break;
+            case 'b':
+                if (!parseBatch(arg)) {
+                    return false;
+                }
+                break;
+            case 'u':
+                if (!parseVariantUsage(arg)) {
+                    return false;
+                }
+                break;
         }
     }
 
+    if (!mBatch.empty() && mArgc - optind > 0) {
+        std::cerr << "Input files cannot be specified on the command line in batch mode."
+                << std::endl;
+        return false;
+    }
     if (mArgc - optind > 1) {
         std::cerr << "Only one input file should be specified on the command line." << std::endl;
         return false;
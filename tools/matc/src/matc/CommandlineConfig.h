@@ -104,6 +104,10 @@ public:
     virtual ~CommandlineConfig() {
         delete mInput;
         delete mOutput;
+        for (BatchEntry& entry : mBatch) {
+            delete entry.input;
+            delete entry.output;
+        }
     };
 
     Output* getOutput()  const noexcept override  {
@@ -125,6 +129,8 @@ public:
 
 private:
     bool parse();
+    bool parseBatch(const std::string& path);
+    bool parseVariantUsage(const std::string& path);
 
     int mArgc = 0;
     char** mArgv = nullptr;
@@ -35,22 +35,24 @@ public:
     }
 
 protected:
-    bool writePackage(const filamat::Package& package, const Config& config) {
+    bool writePackage(const filamat::Package& package, const Config& config,
+            Config::Output* output) {
         if (config.getOutputFormat() == CommandlineConfig::OutputFormat::BLOB) {
-            return writeBlob(package, config);
+            return writeBlob(package, output);
         } else {
-            return writeBlobAsHeader(package, config);
+            return writeBlobAsHeader(package, config, output);
         }
     }
     virtual bool run(const Config& config) = 0;
     virtual bool checkParameters(const Config& config) = 0;
 
     // Write Package as binary to target filename
-    bool writeBlob(const filamat::Package& pkg, const Config& config) const noexcept;
+    bool writeBlob(const filamat::Package& pkg, Config::Output* output) const noexcept;
 
     // Write package as a C++ array content. Use this to include material
     // in your executable/library.
-    bool writeBlobAsHeader(const filamat::Package& pkg, const Config& config) const noexcept;
+    bool writeBlobAsHeader(const filamat::Package& pkg, const Config& config,
+            Config::Output* output) const noexcept;
 };
 
 } // namespace matc
@@ -25,6 +25,8 @@
 #include <memory>
 #include <unordered_map>
 #include <ostream>
+#include <string>
+#include <vector>
 
 #include <utils/compiler.h>
 
@@ -68,6 +70,17 @@ public:
     };
     virtual Input* getInput() const noexcept = 0;
 
+    // A material compiled in batch mode.
+    struct BatchEntry {
+        Input* input;
+        Output* output;
+    };
+
+    // The materials to compile in batch mode, in which case getInput() and getOutput() are unused.
+    const std::vector<BatchEntry>& getBatch() const noexcept {
+        return mBatch;
+    }
+
     virtual std::string toString() const noexcept = 0;
 
     bool isDebug() const noexcept {
@@ -102,6 +115,10 @@ public:
         return mTargetApi;
     }
 
+    bool isCompressed() const noexcept {
+        return mCompress;
+    }
+
     bool printShaders() const noexcept {
         return mPrintShaders;
     }
@@ -118,8 +135,19 @@ public:
         return mDefines;
     }
 
+    // Variants recorded at runtime for each material name, empty if no usage file was given.
+    const std::unordered_map<std::string, std::vector<uint8_t>>& getVariantUsage() const noexcept {
+        return mVariantUsage;
+    }
+
+    // Directory of the compiled shader cache, empty if the cache is disabled.
+    const std::string& getCacheDirectory() const noexcept {
+        return mCacheDirectory;
+    }
+
 protected:
     bool mDebug = false;
+    bool mCompress = false;
     bool mIsValid = true;
     bool mPrintShaders = false;
     bool mRawShaderMode = false;
@@ -130,6 +158,9 @@ protected:
     TargetApi mTargetApi = (TargetApi) 0;
     std::unordered_map<std::string, std::string> mDefines;
     uint8_t mVariantFilter = 0;
+    std::vector<BatchEntry> mBatch;
+    std::string mCacheDirectory;
+    std::unordered_map<std::string, std::vector<uint8_t>> mVariantUsage;
 };
 
 }
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FileShaderCache.h"
+
+#include <utils/CacheFile.h>
+
+#include <iostream>
+
+#include <stdio.h>
+
+using namespace utils;
+
+namespace matc {
+
+static constexpr uint32_t CACHE_MAGIC = 0x31435346; // "FSC1"
+
+FileShaderCache::FileShaderCache(const char* directory) : mDirectory(directory) {
+    mEnabled = mDirectory.mkdirRecursive();
+    if (!mEnabled) {
+        std::cerr << "Unable to create shader cache in " << mDirectory.c_str() << std::endl;
+    }
+}
+
+Path FileShaderCache::getPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.shader", (unsigned long long) key);
+    return mDirectory + name;
+}
+
+bool FileShaderCache::load(uint64_t key, std::vector<uint8_t>* data) {
+    return mEnabled && CacheFile::read(getPath(key), CACHE_MAGIC, key, data);
+}
+
+void FileShaderCache::store(uint64_t key, const uint8_t* data, size_t size) {
+    if (!mEnabled || size == 0) {
+        return;
+    }
+    Path path = getPath(key);
+    if (!CacheFile::write(path, CACHE_MAGIC, key, data, size)) {
+        std::cerr << "Unable to write shader cache entry " << path.c_str() << std::endl;
+    }
+}
+
+} // namespace matc
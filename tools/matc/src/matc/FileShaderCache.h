@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILESHADERCACHE_H
+#define TNT_FILESHADERCACHE_H
+
+#include <filamat/ShaderCache.h>
+
+#include <utils/Path.h>
+
+namespace matc {
+
+// Stores each compiled shader in its own file, named after its key, in a directory that can be
+// shared by several matc processes, e.g. on a build machine.
+//
+// Files are read and written with utils::CacheFile, so truncated or corrupted files are ignored
+// and readers never observe a partially written entry. Since entries are content-addressed they
+// never need to be invalidated, the directory can simply be deleted to reclaim space.
+class FileShaderCache : public filamat::ShaderCache {
+public:
+    explicit FileShaderCache(const char* directory);
+
+    bool load(uint64_t key, std::vector<uint8_t>* data) override;
+    void store(uint64_t key, const uint8_t* data, size_t size) override;
+
+private:
+    utils::Path getPath(uint64_t key) const;
+
+    const utils::Path mDirectory;
+    bool mEnabled = false;
+};
+
+} // namespace matc
+
+#endif // TNT_FILESHADERCACHE_H
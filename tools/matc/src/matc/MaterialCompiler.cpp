@@ -26,6 +26,7 @@
 #include <utils/JobSystem.h>
 
 #include "DirIncluder.h"
+#include "FileShaderCache.h"
 #include "MaterialLexeme.h"
 #include "MaterialLexer.h"
 #include "JsonishLexer.h"
@@ -256,17 +257,15 @@ bool MaterialCompiler::isValidJsonStart(const char* buffer, size_t size) const n
 }
 
 bool MaterialCompiler::run(const Config& config) {
-    Config::Input* input = config.getInput();
-    ssize_t size = input->open();
-    if (size <= 0) {
-        return false;
-    }
-    auto buffer = input->read();
-
-    utils::Path materialFilePath = utils::Path(input->getName()).getAbsolutePath();
-    assert(materialFilePath.isFile());
-
     if (config.rawShaderMode()) {
+        Config::Input* input = config.getInput();
+        ssize_t size = input->open();
+        if (size <= 0) {
+            return false;
+        }
+        auto buffer = input->read();
+
+        utils::Path materialFilePath = utils::Path(input->getName()).getAbsolutePath();
         const std::string extension = materialFilePath.getExtension();
         glslang::InitializeProcess();
         bool success = compileRawShader(buffer.get(), size, config.getOutput(), extension.c_str());
@@ -274,7 +273,44 @@ bool MaterialCompiler::run(const Config& config) {
         return success;
     }
 
+    std::unique_ptr<FileShaderCache> cache;
+    if (!config.getCacheDirectory().empty()) {
+        cache = std::make_unique<FileShaderCache>(config.getCacheDirectory().c_str());
+    }
+
     MaterialBuilder::init();
+
+    // All the materials of a batch share the same JobSystem, so its threads are created only once.
+    JobSystem js;
+    js.adopt();
+
+    bool success = true;
+    if (config.getBatch().empty()) {
+        success = compile(config, config.getInput(), config.getOutput(), js, cache.get());
+    } else {
+        // Keep going after an error, so that all the broken materials are reported at once.
+        for (const Config::BatchEntry& entry : config.getBatch()) {
+            success = compile(config, entry.input, entry.output, js, cache.get()) && success;
+        }
+    }
+
+    js.emancipate();
+    MaterialBuilder::shutdown();
+
+    return success;
+}
+
+bool MaterialCompiler::compile(const Config& config, Config::Input* input, Config::Output* output,
+        JobSystem& js, ShaderCache* cache) {
+    ssize_t size = input->open();
+    if (size <= 0) {
+        return false;
+    }
+    auto buffer = input->read();
+
+    utils::Path materialFilePath = utils::Path(input->getName()).getAbsolutePath();
+    assert(materialFilePath.isFile());
+
     MaterialBuilder builder;
     // Before attempting an expensive lex, let's find out if we were sent pure JSON.
     bool parsed;
@@ -285,6 +321,7 @@ bool MaterialCompiler::run(const Config& config) {
     }
 
     if (!parsed) {
+        std::cerr << "Could not parse material " << input->getName() << std::endl;
         return false;
     }
 
@@ -301,35 +338,51 @@ bool MaterialCompiler::run(const Config& config) {
 
     builder
         .includeCallback(includer)
+        .shaderCache(cache)
         .fileName(materialFilePath.getName().c_str())
         .platform(config.getPlatform())
         .targetApi(config.getTargetApi())
         .optimization(config.getOptimizationLevel())
         .printShaders(config.printShaders())
         .generateDebugInfo(config.isDebug())
+        .compression(config.isCompressed())
         .variantFilter(config.getVariantFilter() | builder.getVariantFilter());
 
     for (const auto& define : config.getDefines()) {
         builder.shaderDefine(define.first.c_str(), define.second.c_str());
     }
 
-    JobSystem js;
-    js.adopt();
+    const auto& variantUsage = config.getVariantUsage();
+    if (!variantUsage.empty()) {
+        auto pos = variantUsage.find(builder.getName().c_str_safe());
+        if (pos != variantUsage.end()) {
+            builder.usedVariants(pos->second.data(), pos->second.size());
+        } else {
+            std::cerr << "Warning: no variant usage for material '"
+                    << builder.getName().c_str_safe() << "', keeping all variants." << std::endl;
+        }
+    }
 
     // Write builder.build() to output.
     Package package = builder.build(js);
 
-    js.emancipate();
-    MaterialBuilder::shutdown();
-
     if (!package.isValid()) {
         std::cerr << "Could not compile material " << input->getName() << std::endl;
         return false;
     }
-    return writePackage(package, config);
+    return writePackage(package, config, output);
 }
 
 bool MaterialCompiler::checkParameters(const Config& config) {
+    // In batch mode, inputs and outputs come from the batch file.
+    if (!config.getBatch().empty()) {
+        if (config.rawShaderMode() || config.getReflectionTarget() != Config::Metadata::NONE) {
+            std::cerr << "Batch mode cannot be used with --raw or --reflect." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     // Check for input file.
     if (config.getInput() == nullptr) {
         std::cerr << "Missing input filename." << std::endl;
@@ -25,6 +25,10 @@
 
 namespace filamat {
 class MaterialBuilder;
+class ShaderCache;
+}
+namespace utils {
+class JobSystem;
 }
 class TestMaterialCompiler;
 
@@ -42,6 +46,9 @@ public:
 private:
     friend class ::TestMaterialCompiler;
 
+    bool compile(const Config& config, Config::Input* input, Config::Output* output,
+            utils::JobSystem& js, filamat::ShaderCache* cache);
+
     bool parseMaterial(const char* buffer, size_t size,
             filamat::MaterialBuilder& builder) const noexcept;
     bool processMaterial(const MaterialLexeme&,
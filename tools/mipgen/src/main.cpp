@@ -21,19 +21,24 @@
 #include <image/LinearImage.h>
 
 #ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
-#include <imageio/BlockCompression.h>
+#include <blockcompression/BlockCompression.h>
 #endif
 
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 using namespace image;
 using namespace std;
@@ -51,6 +56,8 @@ static bool g_ktxContainer = false;
 static bool g_linearized = false;
 static bool g_quietMode = false;
 static uint32_t g_mipLevelCount = 0;
+static MipmapMode g_mipmapMode = MipmapMode::FROM_SOURCE;
+static size_t g_memoryBudget = 0;
 
 static const char* USAGE = R"TXT(
 MIPGEN generates mipmaps for an image down to the 1x1 level.
@@ -90,6 +97,13 @@ Options:
    --mip-levels=N, -m N
        specifies the number of mip levels to generate
        if 0 (default), all levels are generated
+   --cascade, -C
+       generate each mip level from the previous one rather than from the original image,
+       this is much faster on large images at the cost of some quality
+   --memory-budget=MB, -M MB
+       process the image a band of rows at a time to keep the memory usage around MB megabytes,
+       each level is written as it is generated; requires a non-interlaced PNG input and a KTX
+       output
    --compression=COMPRESSION, -c COMPRESSION
        format specific compression:
 )TXT"
@@ -116,6 +130,7 @@ Examples:
     MIPGEN -g --kernel=hermite grassland.png mip_%03d.png
     MIPGEN -f ktx --compression=astc_fast_ldr_4x4 grassland.png mips.ktx
     MIPGEN -f ktx --compression=etc_rgb_rgba_40 grassland.png mips.ktx
+    MIPGEN -M 512 --compression=astc_fast_ldr_8x8 terrain.png terrain.ktx
 )TXT";
 
 static const char* HTML_PREFIX = R"HTML(<!DOCTYPE html>
@@ -159,7 +174,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:";
+    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:CM:";
     static const struct option OPTIONS[] = {
             { "help",                 no_argument, 0, 'h' },
             { "license",              no_argument, 0, 'L' },
@@ -173,6 +188,8 @@ static int handleArguments(int argc, char* argv[]) {
             { "add-alpha",            no_argument, 0, 'a' },
             { "quiet",                no_argument, 0, 'q' },
             { "mip-levels",     required_argument, 0, 'm' },
+            { "cascade",              no_argument, 0, 'C' },
+            { "memory-budget",  required_argument, 0, 'M' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -254,12 +271,309 @@ static int handleArguments(int argc, char* argv[]) {
                     // keep default value
                 }
                 break;
+            case 'C':
+                g_mipmapMode = MipmapMode::CASCADED;
+                break;
+            case 'M':
+                try {
+                    g_memoryBudget = size_t(std::max(std::stoi(arg), 0)) * 1024 * 1024;
+                } catch (std::invalid_argument &e) {
+                    // keep default value
+                }
+                break;
         }
     }
 
     return optind;
 }
 
+// Applies the channel options to the decoded image, and converts normal maps to vectors.
+static LinearImage prepareImage(LinearImage image) {
+    if (g_stripAlpha && image.getChannels() == 4) {
+        auto r = extractChannel(image, 0);
+        auto g = extractChannel(image, 1);
+        auto b = extractChannel(image, 2);
+        image = combineChannels({r, g, b});
+    }
+    if (g_addAlpha && image.getChannels() == 3) {
+        auto r = extractChannel(image, 0);
+        auto g = extractChannel(image, 1);
+        auto b = extractChannel(image, 2);
+        auto a = LinearImage(image.getWidth(), image.getHeight(), 1);
+        clearToValue(a, 1.0f);
+        image = combineChannels({r, g, b, a});
+    }
+    if (g_grayscale) {
+        image = extractChannel(image, 0);
+    }
+
+    if (g_filter == Filter::GAUSSIAN_NORMALS) {
+        image = colorsToVectors(image);
+    }
+    return image;
+}
+
+static void initKtxInfo(KtxInfo* info, uint32_t width, uint32_t height, size_t componentCount) {
+    *info = {
+        .endianness = KtxBundle::ENDIAN_DEFAULT,
+        .glType = KtxBundle::UNSIGNED_BYTE,
+        .glTypeSize = 1,
+        .pixelWidth = width,
+        .pixelHeight = height,
+        .pixelDepth = 0,
+    };
+    if (componentCount == 1) {
+        info->glFormat = info->glBaseInternalFormat = KtxBundle::RED;
+        info->glInternalFormat = KtxBundle::R8;
+    } else if (componentCount == 3) {
+        info->glFormat = info->glBaseInternalFormat = KtxBundle::RGB;
+        info->glInternalFormat = KtxBundle::RGB8;
+    } else if (componentCount == 4) {
+        info->glFormat = info->glBaseInternalFormat = KtxBundle::RGBA;
+        info->glInternalFormat = KtxBundle::RGBA8;
+    }
+}
+
+// Converts a linear image to the 8-bit pixels of an uncompressed KTX level.
+static std::unique_ptr<uint8_t[]> toKtxPixels(const LinearImage& image, size_t componentCount) {
+    if (g_grayscale && g_linearized) {
+        return fromLinearToGrayscale<uint8_t>(image);
+    } else if (g_grayscale) {
+        return fromLinearTosRGB<uint8_t, 1>(image);
+    } else if (g_linearized) {
+        if (componentCount == 3) {
+            return fromLinearToRGB<uint8_t, 3>(image);
+        } else {
+            return fromLinearToRGB<uint8_t, 4>(image);
+        }
+    } else {
+        if (componentCount == 3) {
+            return fromLinearTosRGB<uint8_t, 3>(image);
+        } else {
+            return fromLinearTosRGB<uint8_t, 4>(image);
+        }
+    }
+}
+
+// A miplevel that is written to the KTX file a band of rows at a time.
+struct StreamedLevel {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;     // position of the data in the file
+    uint32_t size;       // size of the data in bytes
+    uint32_t writtenRows = 0;
+    uint32_t writtenBytes = 0;
+    std::unique_ptr<BandResampler> resampler;
+    std::vector<float> pendingRows;  // rows that don't make up a complete row of blocks yet
+    uint32_t pendingCount = 0;
+};
+
+// Generates the miplevels while the image is being decoded, and writes them to the KTX file
+// without ever holding a whole level in memory: the position of each level in the file is known
+// upfront, so every band is written as soon as it is ready.
+static int streamMipmaps(const Path& inputPath, const std::string& outputPath) {
+    ifstream inputStream(inputPath.getPath(), ios::binary);
+    std::unique_ptr<ImageDecoder::RowDecoder> decoder = ImageDecoder::createRowDecoder(
+            inputStream,
+            g_linearized ? ImageDecoder::ColorSpace::LINEAR : ImageDecoder::ColorSpace::SRGB);
+    if (!decoder) {
+        cerr << "Streaming requires a non-interlaced PNG image: " << inputPath.getPath() << endl;
+        return 1;
+    }
+    const uint32_t width = decoder->getWidth();
+    const uint32_t height = decoder->getHeight();
+    const bool cascaded = g_mipmapMode == MipmapMode::CASCADED;
+
+    // Number of channels once the channel options are applied, see prepareImage().
+    size_t componentCount = decoder->getChannels();
+    if (g_stripAlpha && componentCount == 4) {
+        componentCount = 3;
+    }
+    if (g_addAlpha && componentCount == 3) {
+        componentCount = 4;
+    }
+    if (g_grayscale) {
+        componentCount = 1;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t w = width, h = height; w > 1 || h > 1; ++count) {
+        w = std::max(w >> 1u, 1u);
+        h = std::max(h >> 1u, 1u);
+    }
+    count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
+
+    KtxBundle container(1 + count, 1, false);
+    KtxInfo& info = container.info();
+    initKtxInfo(&info, width, height, componentCount);
+
+    // Bands that are compressed separately must be made of complete rows of blocks.
+    uint32_t blockHeight = 1;
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+    CompressionConfig config {};
+    if (!g_compression.empty()) {
+        if (!parseOptionString(g_compression, &config)) {
+            cerr << "Unrecognized compression: " << g_compression << endl;
+            return 1;
+        }
+        info.glFormat = 0;
+        blockHeight = getBlockDimensions(config).y;
+    }
+#else
+    if (!g_compression.empty()) {
+        cerr << "Compression not supported in this build." << endl;
+        return 1;
+    }
+#endif
+
+    vector<StreamedLevel> levels(1 + count);
+    uint64_t offset = container.getSerializedHeaderLength();
+    for (uint32_t n = 0; n <= count; n++) {
+        StreamedLevel& level = levels[n];
+        level.width = std::max(width >> n, 1u);
+        level.height = std::max(height >> n, 1u);
+        uint64_t size = uint64_t(level.width) * level.height * componentCount;
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+        if (config.type != CompressionConfig::INVALID) {
+            size = getCompressedSize(config, level.width, level.height);
+        }
+#endif
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            cerr << "The image is too large for a KTX file." << endl;
+            return 1;
+        }
+        level.size = uint32_t(size);
+        level.offset = offset + sizeof(uint32_t);
+        offset = level.offset + size;
+        if (n > 0) {
+            const StreamedLevel& parent = cascaded ? levels[n - 1] : levels[0];
+            level.resampler = std::make_unique<BandResampler>(parent.width, parent.height,
+                    level.width, level.height, g_filter);
+        }
+    }
+
+    // The budget is shared between a fixed cost, the source rows kept by the filters of each
+    // level (a few rows of the parent level in cascaded mode), and the cost of each row of the
+    // band: the decoded 16-bit row, the float row and its copies during the channel conversions
+    // and the compression.
+    const size_t filterRows = cascaded ? 16 : 8 * size_t(count);
+    const size_t fixedSize = filterRows * width * componentCount * sizeof(float);
+    const size_t rowSize = size_t(width) * (4 * sizeof(uint16_t) + 6 * 4 * sizeof(float));
+    size_t bandRows = g_memoryBudget > fixedSize ? (g_memoryBudget - fixedSize) / rowSize : 0;
+    bandRows = std::min(bandRows / blockHeight * blockHeight, size_t(height));
+    if (bandRows < std::min(blockHeight, height)) {
+        bandRows = std::min(blockHeight, height);
+        cerr << "Warning: the memory budget is too small, using bands of " << bandRows
+             << " rows." << endl;
+    }
+
+    Path(outputPath).getParent().mkdirRecursive();
+    ofstream outputStream(outputPath, ios::out | ios::binary | ios::trunc);
+    if (!outputStream) {
+        cerr << "The output file cannot be opened: " << outputPath << endl;
+        return 1;
+    }
+
+    auto writeData = [&](StreamedLevel& level, const uint8_t* data, uint32_t size) {
+        if (size > level.size - level.writtenBytes) {
+            return false;
+        }
+        outputStream.seekp(std::streamoff(level.offset + level.writtenBytes));
+        outputStream.write((const char*) data, size);
+        level.writtenBytes += size;
+        return bool(outputStream);
+    };
+
+    JobSystem js;
+    js.adopt();
+    auto writeRows = [&](StreamedLevel& level, LinearImage rows) {
+        if (g_filter == Filter::GAUSSIAN_NORMALS) {
+            rows = vectorsToColors(rows);
+        }
+        level.writtenRows += rows.getHeight();
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+        if (config.type != CompressionConfig::INVALID) {
+            const float* data = rows.getPixelRef();
+            level.pendingRows.insert(level.pendingRows.end(), data,
+                    data + rows.getWidth() * rows.getHeight() * componentCount);
+            level.pendingCount += rows.getHeight();
+            const bool last = level.writtenRows == level.height;
+            const uint32_t bandHeight = last ? level.pendingCount :
+                    level.pendingCount / blockHeight * blockHeight;
+            if (bandHeight == 0) {
+                return true;
+            }
+            const size_t bandSize = size_t(level.width) * bandHeight * componentCount;
+            LinearImage band(level.width, bandHeight, componentCount);
+            std::copy_n(level.pendingRows.data(), bandSize, band.getPixelRef());
+            level.pendingRows.erase(level.pendingRows.begin(),
+                    level.pendingRows.begin() + bandSize);
+            level.pendingCount -= bandHeight;
+            CompressedTexture tex = compressTexture(config, band, &js);
+            info.glInternalFormat = (uint32_t) tex.format;
+            return writeData(level, tex.data.get(), tex.size);
+        }
+#endif
+        std::unique_ptr<uint8_t[]> data = toKtxPixels(rows, componentCount);
+        return writeData(level, data.get(), rows.getWidth() * rows.getHeight() * componentCount);
+    };
+
+    if (!g_quietMode) {
+        printf("Streaming %s (%dx%d) in bands of %d rows...\n", inputPath.getName().c_str(),
+                width, height, int(bandRows));
+    }
+
+    bool success = true;
+    uint32_t decodedRows = 0;
+    while (success && decodedRows < height) {
+        LinearImage band = decoder->decodeRows(uint32_t(bandRows));
+        if (!band.isValid()) {
+            break;
+        }
+        decodedRows += band.getHeight();
+        band = prepareImage(band);
+        success = writeRows(levels[0], band);
+
+        // In cascaded mode each level consumes the rows produced by the previous one, otherwise
+        // they all consume the source rows.
+        LinearImage rows = band;
+        for (uint32_t n = 1; n <= count && success; n++) {
+            rows = levels[n].resampler->push(cascaded ? rows : band, &js);
+            if (rows.isValid()) {
+                success = writeRows(levels[n], rows);
+            } else if (cascaded) {
+                break;
+            }
+        }
+    }
+    for (const StreamedLevel& level : levels) {
+        success = success && level.writtenBytes == level.size;
+    }
+    if (!success || decodedRows != height) {
+        cerr << "An error occurred while streaming the image." << endl;
+        return 1;
+    }
+
+    // The header is written last, since the compressed format is only known at this point.
+    vector<uint8_t> header(container.getSerializedHeaderLength());
+    container.serializeHeader(header.data(), uint32_t(header.size()));
+    outputStream.seekp(0);
+    outputStream.write((const char*) header.data(), header.size());
+    for (const StreamedLevel& level : levels) {
+        outputStream.seekp(std::streamoff(level.offset - sizeof(uint32_t)));
+        outputStream.write((const char*) &level.size, sizeof(uint32_t));
+    }
+    outputStream.close();
+    if (!outputStream) {
+        cerr << "An error occurred while writing the output file: " << outputPath << endl;
+        return 1;
+    }
+    if (!g_quietMode) {
+        puts("Done.");
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     int optionIndex = handleArguments(argc, argv);
     int numArgs = argc - optionIndex;
@@ -276,6 +590,14 @@ int main(int argc, char* argv[]) {
         g_format = ImageEncoder::chooseFormat(outputPattern, g_linearized);
     }
 
+    if (g_memoryBudget > 0) {
+        if (!g_ktxContainer) {
+            cerr << "Streaming requires a KTX output." << endl;
+            return 1;
+        }
+        return streamMipmaps(inputPath, outputPattern);
+    }
+
     if (!g_quietMode) {
         puts("Reading image...");
     }
@@ -287,27 +609,7 @@ int main(int argc, char* argv[]) {
         cerr << "Unable to open image: " << inputPath.getPath() << endl;
         return 1;
     }
-    if (g_stripAlpha && sourceImage.getChannels() == 4) {
-        auto r = extractChannel(sourceImage, 0);
-        auto g = extractChannel(sourceImage, 1);
-        auto b = extractChannel(sourceImage, 2);
-        sourceImage = combineChannels({r, g, b});
-    }
-    if (g_addAlpha && sourceImage.getChannels() == 3) {
-        auto r = extractChannel(sourceImage, 0);
-        auto g = extractChannel(sourceImage, 1);
-        auto b = extractChannel(sourceImage, 2);
-        auto a = LinearImage(sourceImage.getWidth(), sourceImage.getHeight(), 1);
-        clearToValue(a, 1.0f);
-        sourceImage = combineChannels({r, g, b, a});
-    }
-    if (g_grayscale) {
-        sourceImage = extractChannel(sourceImage, 0);
-    }
-
-    if (g_filter == Filter::GAUSSIAN_NORMALS) {
-        sourceImage = colorsToVectors(sourceImage);
-    }
+    sourceImage = prepareImage(sourceImage);
 
     if (!g_quietMode) {
         puts("Generating miplevels...");
@@ -316,7 +618,9 @@ int main(int argc, char* argv[]) {
     uint32_t count = getMipmapCount(sourceImage);
     count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
     vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    JobSystem js;
+    js.adopt();
+    generateMipmaps(sourceImage, g_filter, miplevels.data(), count, g_mipmapMode, &js);
 
     if (g_ktxContainer) {
         if (!g_quietMode) {
@@ -328,25 +632,8 @@ int main(int argc, char* argv[]) {
         // bundle, we want to include level 0, so add 1 to the KTX level count.
         KtxBundle container(1 + miplevels.size(), 1, false);
         auto& info = container.info();
-        info = {
-            .endianness = KtxBundle::ENDIAN_DEFAULT,
-            .glType = KtxBundle::UNSIGNED_BYTE,
-            .glTypeSize = 1,
-            .pixelWidth = sourceImage.getWidth(),
-            .pixelHeight = sourceImage.getHeight(),
-            .pixelDepth = 0,
-        };
         size_t componentCount = sourceImage.getChannels();
-        if (componentCount == 1) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RED;
-            info.glInternalFormat = KtxBundle::R8;
-        } else if (componentCount == 3) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RGB;
-            info.glInternalFormat = KtxBundle::RGB8;
-        } else if (componentCount == 4) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RGBA;
-            info.glInternalFormat = KtxBundle::RGBA8;
-        }
+        initKtxInfo(&info, sourceImage.getWidth(), sourceImage.getHeight(), componentCount);
 #ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
         CompressionConfig config {};
         if (!g_compression.empty()) {
@@ -381,29 +668,13 @@ int main(int argc, char* argv[]) {
                     printf("Starting compression for %s (%dx%d)\n", inputPath.getName().c_str(),
                             image.getWidth(), image.getHeight());
                 }
-                CompressedTexture tex = compressTexture(config, image);
+                CompressedTexture tex = compressTexture(config, image, &js);
                 container.setBlob({mip++}, tex.data.get(), tex.size);
                 info.glInternalFormat = (uint32_t) tex.format;
                 return;
             }
 #endif
-            if (g_grayscale && g_linearized) {
-                data = fromLinearToGrayscale<uint8_t>(image);
-            } else if (g_grayscale) {
-                data = fromLinearTosRGB<uint8_t, 1>(image);
-            } else if (g_linearized) {
-                if (componentCount == 3) {
-                    data = fromLinearToRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearToRGB<uint8_t, 4>(image);
-                }
-            } else {
-                if (componentCount == 3) {
-                    data = fromLinearTosRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearTosRGB<uint8_t, 4>(image);
-                }
-            }
+            data = toKtxPixels(image, componentCount);
             container.setBlob({mip++, 0, 0}, data.get(), image.getWidth() * image.getHeight() *
                     container.info().glTypeSize * componentCount);
         };